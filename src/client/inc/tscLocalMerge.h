@@ -35,6 +35,7 @@ typedef struct SLocalDataSource {
   int32_t        flushoutIdx;
   int32_t        pageId;
   int32_t        rowIdx;
+  char *         pKeys;  // normalized sort keys of the rows in filePage
   tFilePage      filePage;
 } SLocalDataSource;
 
@@ -244,6 +244,7 @@ typedef struct {
 
   int8_t       dataSourceType;     // load data from file or not
   int8_t       submitSchema;  // submit block is built with table schema
+  int8_t       submitFormat;  // TAOS_STMT_FORMAT_*, the layout of the submit blocks
   SHashObj    *pTableList;   // referred table involved in sql
   SArray      *pDataBlocks;  // SArray<STableDataBlocks*> submit data blocks after parsing sql
 } SSqlCmd;
@@ -313,6 +314,8 @@ typedef struct SSqlObj {
   char *           sqlstr;
   char             retry;
   char             maxRetry;
+  int16_t          throttled;   // times the insertion is throttled by the vnode and retried
+  void *           pThrottleTimer;  // the timer to resend the throttled insertion
   SRpcEpSet        epSet;
   char             listed;
   tsem_t           rspSem;
@@ -396,6 +399,7 @@ void tscPartiallyFreeSqlObj(SSqlObj *pObj);
  * response buffer, object itself
  */
 void tscFreeSqlObj(SSqlObj *pObj);
+void tscDoFreeSqlObj(SSqlObj *pObj);
 
 void tscCloseTscObj(STscObj *pObj);
 
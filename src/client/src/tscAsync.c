@@ -291,7 +291,10 @@ void taos_fetch_row_a(TAOS_RES *taosa, void (*fp)(void *, TAOS_RES *, TAOS_ROW),
     schedMsg.ahandle = pSql;
     schedMsg.thandle = pRes->tsrow;
     schedMsg.msg = NULL;
-    taosScheduleTask(tscQhandle, &schedMsg);
+    if (taosScheduleTask(tscQhandle, &schedMsg) != 0) {
+      tscError("%p failed to schedule the fetch of row since %s, fetch it directly", pSql, tstrerror(terrno));
+      tscProcessFetchRow(&schedMsg);
+    }
   }
 }
 
@@ -382,11 +385,20 @@ void tscProcessAsyncRes(SSchedMsg *pMsg) {
 
 static void tscProcessAsyncError(SSchedMsg *pMsg) {
   void (*fp)() = pMsg->ahandle;
-  (*fp)(pMsg->thandle, NULL, *(int32_t*)pMsg->msg);
+  int32_t code = *(int32_t*)pMsg->msg;
+
+  taosTFree(pMsg->msg);
+  (*fp)(pMsg->thandle, NULL, code);
 }
 
 void tscQueueAsyncError(void(*fp), void *param, int32_t code) {
   int32_t* c = malloc(sizeof(int32_t));
+  if (c == NULL) {
+    tscError("%p failed to queue the async error:%s since no enough memory, report it directly", param, tstrerror(code));
+    (*(void (*)())fp)(param, NULL, code);
+    return;
+  }
+
   *c = code;
   
   SSchedMsg schedMsg = { 0 };
@@ -394,7 +406,11 @@ void tscQueueAsyncError(void(*fp), void *param, int32_t code) {
   schedMsg.ahandle = fp;
   schedMsg.thandle = param;
   schedMsg.msg = c;
-  taosScheduleTask(tscQhandle, &schedMsg);
+  if (taosScheduleTask(tscQhandle, &schedMsg) != 0) {
+    tscError("%p failed to queue the async error:%s since %s, report it directly", param, tstrerror(code),
+             tstrerror(terrno));
+    tscProcessAsyncError(&schedMsg);
+  }
 }
 
 void tscQueueAsyncRes(SSqlObj *pSql) {
@@ -410,7 +426,10 @@ void tscQueueAsyncRes(SSqlObj *pSql) {
   schedMsg.ahandle = pSql;
   schedMsg.thandle = (void *)1;
   schedMsg.msg = NULL;
-  taosScheduleTask(tscQhandle, &schedMsg);
+  if (taosScheduleTask(tscQhandle, &schedMsg) != 0) {
+    tscError("%p failed to queue async res since %s, process it directly", pSql, tstrerror(terrno));
+    tscProcessAsyncRes(&schedMsg);
+  }
 }
 
 void tscProcessAsyncFree(SSchedMsg *pMsg) {
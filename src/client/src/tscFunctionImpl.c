@@ -17,9 +17,10 @@
 #include "qAst.h"
 #include "qExtbuffer.h"
 #include "qFill.h"
-#include "qHistogram.h"
+#include "qHyperLogLog.h"
 #include "qPercentile.h"
 #include "qSyntaxtreefunction.h"
+#include "qTDigest.h"
 #include "qTsbuf.h"
 #include "taosdef.h"
 #include "taosmsg.h"
@@ -131,7 +132,7 @@ typedef struct SLeastsquareInfo {
 } SLeastsquareInfo;
 
 typedef struct SAPercentileInfo {
-  SHistogramInfo *pHisto;
+  STDigest *pDigest;
 } SAPercentileInfo;
 
 typedef struct STSCompInfo {
@@ -233,7 +234,13 @@ int32_t getResultDataInfo(int32_t dataType, int32_t dataBytes, int32_t functionI
       return TSDB_CODE_SUCCESS;
     } else if (functionId == TSDB_FUNC_APERCT) {
       *type = TSDB_DATA_TYPE_BINARY;
-      *bytes = sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1) + sizeof(SHistogramInfo) + sizeof(SAPercentileInfo);
+      *bytes = (int16_t)(sizeof(SAPercentileInfo) + TDIGEST_SIZE(TDIGEST_DEFAULT_COMPRESSION));
+      *interBytes = *bytes;
+      
+      return TSDB_CODE_SUCCESS;
+    } else if (functionId == TSDB_FUNC_HLL) {
+      *type = TSDB_DATA_TYPE_BINARY;
+      *bytes = sizeof(SHyperLogLog);
       *interBytes = *bytes;
       
       return TSDB_CODE_SUCCESS;
@@ -264,14 +271,18 @@ int32_t getResultDataInfo(int32_t dataType, int32_t dataBytes, int32_t functionI
   } else if (functionId == TSDB_FUNC_APERCT) {
     *type = TSDB_DATA_TYPE_DOUBLE;
     *bytes = sizeof(double);
-    *interBytes =
-        sizeof(SAPercentileInfo) + sizeof(SHistogramInfo) + sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1);
+    *interBytes = (int16_t)(sizeof(SAPercentileInfo) + TDIGEST_SIZE(TDIGEST_DEFAULT_COMPRESSION));
     return TSDB_CODE_SUCCESS;
   } else if (functionId == TSDB_FUNC_TWA) {
     *type = TSDB_DATA_TYPE_DOUBLE;
     *bytes = sizeof(double);
     *interBytes = sizeof(STwaInfo);
     return TSDB_CODE_SUCCESS;
+  } else if (functionId == TSDB_FUNC_HLL) {
+    *type = TSDB_DATA_TYPE_BIGINT;
+    *bytes = sizeof(int64_t);
+    *interBytes = sizeof(SHyperLogLog);
+    return TSDB_CODE_SUCCESS;
   }
   
   if (functionId == TSDB_FUNC_AVG) {
@@ -439,6 +450,17 @@ static void count_func_merge(SQLFunctionCtx *pCtx) {
   SET_VAL(pCtx, pCtx->size, 1);
 }
 
+static void count_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  if (pPaneResInfo->hasResult != DATA_SET_FLAG) {
+    return;
+  }
+  
+  *((int64_t *)pCtx->aOutputBuf) += *(int64_t *)pPaneOutput;
+  
+  SET_VAL(pCtx, 1, 1);
+  GET_RES_INFO(pCtx)->hasResult = DATA_SET_FLAG;
+}
+
 /**
  * 1. If the column value for filter exists, we need to load the SFields, which serves
  *    as the pre-filter to decide if the actual data block is required or not.
@@ -663,6 +685,28 @@ static void sum_func_second_merge(SQLFunctionCtx *pCtx) {
   }
 }
 
+static void sum_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  if (pPaneResInfo->hasResult != DATA_SET_FLAG) {
+    return;
+  }
+  
+  if (pCtx->inputType >= TSDB_DATA_TYPE_TINYINT && pCtx->inputType <= TSDB_DATA_TYPE_BIGINT) {
+    *(int64_t *)pCtx->aOutputBuf += *(int64_t *)pPaneOutput;
+  } else {
+    *(double *)pCtx->aOutputBuf += *(double *)pPaneOutput;
+  }
+  
+  SET_VAL(pCtx, 1, 1);
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    SSumInfo *pSum = (SSumInfo *)pCtx->aOutputBuf;
+    pSum->hasResult = DATA_SET_FLAG;
+  }
+}
+
 static int32_t statisRequired(SQLFunctionCtx *pCtx, TSKEY start, TSKEY end, int32_t colId) {
   return BLK_DATA_STATIS_NEEDED;
 }
@@ -875,6 +919,26 @@ static void avg_func_second_merge(SQLFunctionCtx *pCtx) {
   }
 }
 
+static void avg_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  SAvgInfo *pInput = (SAvgInfo *)pPaneResInfo->interResultBuf;
+  if (pInput->num == 0) {  // all data in this pane are null
+    return;
+  }
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  SAvgInfo *   pAvgInfo = (SAvgInfo *)pResInfo->interResultBuf;
+  
+  pAvgInfo->sum += pInput->sum;
+  pAvgInfo->num += pInput->num;
+  
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    memcpy(pCtx->aOutputBuf, pResInfo->interResultBuf, sizeof(SAvgInfo));
+  }
+}
+
 /*
  * the average value is calculated in finalize routine, since current routine does not know the exact number of points
  */
@@ -1235,6 +1299,62 @@ static void max_func_second_merge(SQLFunctionCtx *pCtx) {
   }
 }
 
+#define MINMAX_PANE_UPDATE(type, output, input, isMin)                                     \
+  do {                                                                                     \
+    type _v = *(type *)(input);                                                            \
+    if (((isMin) && _v < *(type *)(output)) || ((!(isMin)) && _v > *(type *)(output))) {  \
+      *(type *)(output) = _v;                                                              \
+    }                                                                                      \
+  } while (0)
+
+static void minMax_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput, bool isMin) {
+  if (pPaneResInfo->hasResult != DATA_SET_FLAG) {
+    return;
+  }
+  
+  switch (pCtx->inputType) {
+    case TSDB_DATA_TYPE_TINYINT:
+      MINMAX_PANE_UPDATE(int8_t, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      MINMAX_PANE_UPDATE(int16_t, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      MINMAX_PANE_UPDATE(int32_t, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+      MINMAX_PANE_UPDATE(int64_t, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+      MINMAX_PANE_UPDATE(float, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      MINMAX_PANE_UPDATE(double, pCtx->aOutputBuf, pPaneOutput, isMin);
+      break;
+    default:
+      tscError("illegal data type:%d in min/max query", pCtx->inputType);
+      return;
+  }
+  
+  SET_VAL(pCtx, 1, 1);
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  // set the flag for super table query
+  if (pResInfo->superTableQ) {
+    *(pCtx->aOutputBuf + pCtx->inputBytes) = DATA_SET_FLAG;
+  }
+}
+
+static void min_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  minMax_pane_merge(pCtx, pPaneResInfo, pPaneOutput, true);
+}
+
+static void max_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  minMax_pane_merge(pCtx, pPaneResInfo, pPaneOutput, false);
+}
+
 static void minMax_function_f(SQLFunctionCtx *pCtx, int32_t index, int32_t isMin) {
   char *pData = GET_INPUT_CHAR_INDEX(pCtx, index);
   TSKEY key = pCtx->ptsList[index];
@@ -1315,7 +1435,71 @@ static void min_function_f(SQLFunctionCtx *pCtx, int32_t index) {
     (r) += POW2(((type *)d)[i] - (delta));                             \
   }
 
+#define STDDEV_STAGE_PANE  2  // the result is merged from panes in the master scan, see stddev_pane_merge
+
+// add a value to the pane by Welford's method, the res of the pane is the sum of the squared differences from avg
+static FORCE_INLINE void stddev_pane_add(SStddevInfo *pStd, double v) {
+  double delta = v - pStd->avg;
+
+  pStd->num += 1;
+  pStd->avg += delta / pStd->num;
+  pStd->res += delta * (v - pStd->avg);
+}
+
+#define LOOP_STDDEV_PANE_IMPL(type, pStd, d, ctx, tsdbType)            \
+  for (int32_t i = 0; i < (ctx)->size; ++i) {                          \
+    if ((ctx)->hasNull && isNull((char *)&((type *)d)[i], tsdbType)) { \
+      continue;                                                        \
+    }                                                                  \
+    stddev_pane_add(pStd, (double)((type *)d)[i]);                     \
+  }
+
+static void stddev_pane_function(SQLFunctionCtx *pCtx) {
+  SStddevInfo *pStd = GET_RES_INFO(pCtx)->interResultBuf;
+  int64_t      num = pStd->num;
+
+  void *pData = GET_INPUT_CHAR(pCtx);
+
+  switch (pCtx->inputType) {
+    case TSDB_DATA_TYPE_INT: {
+      LOOP_STDDEV_PANE_IMPL(int32_t, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    case TSDB_DATA_TYPE_FLOAT: {
+      LOOP_STDDEV_PANE_IMPL(float, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    case TSDB_DATA_TYPE_DOUBLE: {
+      LOOP_STDDEV_PANE_IMPL(double, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    case TSDB_DATA_TYPE_BIGINT: {
+      LOOP_STDDEV_PANE_IMPL(int64_t, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    case TSDB_DATA_TYPE_SMALLINT: {
+      LOOP_STDDEV_PANE_IMPL(int16_t, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    case TSDB_DATA_TYPE_TINYINT: {
+      LOOP_STDDEV_PANE_IMPL(int8_t, pStd, pData, pCtx, pCtx->inputType);
+      break;
+    }
+    default:
+      tscError("stddev function not support data type:%d", pCtx->inputType);
+  }
+
+  pStd->stage = STDDEV_STAGE_PANE;
+  SET_VAL(pCtx, pStd->num - num, 1);
+}
+
 static void stddev_function(SQLFunctionCtx *pCtx) {
+  // the rows of a pane are aggregated in one pass
+  if (GET_RES_INFO(pCtx)->paneQ) {
+    stddev_pane_function(pCtx);
+    return;
+  }
+
   // the second stage to calculate standard deviation
   SStddevInfo *pStd = GET_RES_INFO(pCtx)->interResultBuf;
   
@@ -1371,6 +1555,31 @@ static void stddev_function_f(SQLFunctionCtx *pCtx, int32_t index) {
   SResultInfo *pResInfo = GET_RES_INFO(pCtx);
   SStddevInfo *pStd = pResInfo->interResultBuf;
   
+  if (pResInfo->paneQ) {
+    void *pData = GET_INPUT_CHAR_INDEX(pCtx, index);
+    if (pCtx->hasNull && isNull(pData, pCtx->inputType)) {
+      return;
+    }
+
+    double v = 0;
+    switch (pCtx->inputType) {
+      case TSDB_DATA_TYPE_INT:      v = GET_INT32_VAL(pData); break;
+      case TSDB_DATA_TYPE_FLOAT:    v = GET_FLOAT_VAL(pData); break;
+      case TSDB_DATA_TYPE_DOUBLE:   v = GET_DOUBLE_VAL(pData); break;
+      case TSDB_DATA_TYPE_BIGINT:   v = (double)GET_INT64_VAL(pData); break;
+      case TSDB_DATA_TYPE_SMALLINT: v = GET_INT16_VAL(pData); break;
+      case TSDB_DATA_TYPE_TINYINT:  v = GET_INT8_VAL(pData); break;
+      default:
+        tscError("stddev function not support data type:%d", pCtx->inputType);
+        return;
+    }
+
+    stddev_pane_add(pStd, v);
+    pStd->stage = STDDEV_STAGE_PANE;
+    SET_VAL(pCtx, 1, 1);
+    return;
+  }
+
   /* the first stage is to calculate average value */
   if (pStd->stage == 0) {
     avg_function_f(pCtx, index);
@@ -1423,6 +1632,12 @@ static void stddev_next_step(SQLFunctionCtx *pCtx) {
   SResultInfo *pResInfo = GET_RES_INFO(pCtx);
   SStddevInfo *pStd = pResInfo->interResultBuf;
   
+  // the panes carry the sum of squared differences, so no second stage is required
+  if (pStd->stage == STDDEV_STAGE_PANE) {
+    pResInfo->complete = true;
+    return;
+  }
+
   if (pStd->stage == 0) {
     /*
      * stddev is calculated in two stage:
@@ -1459,6 +1674,33 @@ static void stddev_finalizer(SQLFunctionCtx *pCtx) {
   doFinalizer(pCtx);
 }
 
+/*
+ * Each pane keeps its number of values, their average and the sum of squared differences from the average, and the
+ * panes are combined pairwise (Chan et al.), so the window is completed in the master scan without the second stage.
+ */
+static void stddev_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  SStddevInfo *pStd = pResInfo->interResultBuf;
+  SStddevInfo *pInput = (SStddevInfo *)pPaneResInfo->interResultBuf;
+
+  assert(pStd->stage == 0 || pStd->stage == STDDEV_STAGE_PANE);
+  pStd->stage = STDDEV_STAGE_PANE;
+
+  if (pInput->num == 0) {  // all data in this pane are null
+    return;
+  }
+
+  int64_t num = pStd->num + pInput->num;
+  double  delta = pInput->avg - pStd->avg;
+
+  pStd->res += pInput->res + POW2(delta) * ((double)pStd->num * pInput->num / num);
+  pStd->avg += delta * pInput->num / num;
+  pStd->num = num;
+
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////
 static bool first_last_function_setup(SQLFunctionCtx *pCtx) {
   if (!function_setup(pCtx)) {
@@ -2439,7 +2681,7 @@ static bool percentile_function_setup(SQLFunctionCtx *pCtx) {
   tOrderDescriptor *pDesc = tOrderDesCreate(&orderIdx, NUMOFCOLS, pModel, TSDB_ORDER_DESC);
   
   ((SPercentileInfo *)(pResInfo->interResultBuf))->pMemBucket =
-      tMemBucketCreate(1024, MAX_AVAILABLE_BUFFER_SIZE, pCtx->inputBytes, pCtx->inputType, pDesc);
+      tMemBucketCreate(1024, MAX_AVAILABLE_BUFFER_SIZE, pCtx->inputBytes, pCtx->inputType, pDesc, pCtx->pMemBudget);
   
   return true;
 }
@@ -2450,14 +2692,20 @@ static void percentile_function(SQLFunctionCtx *pCtx) {
   SResultInfo *    pResInfo = GET_RES_INFO(pCtx);
   SPercentileInfo *pInfo = pResInfo->interResultBuf;
   
-  for (int32_t i = 0; i < pCtx->size; ++i) {
-    char *data = GET_INPUT_CHAR_INDEX(pCtx, i);
-    if (pCtx->hasNull && isNull(data, pCtx->inputType)) {
-      continue;
+  // no null value in current block, put all data into the bucket together
+  if (!pCtx->hasNull) {
+    tMemBucketPut(pInfo->pMemBucket, GET_INPUT_CHAR(pCtx), pCtx->size);
+    notNullElems = pCtx->size;
+  } else {
+    for (int32_t i = 0; i < pCtx->size; ++i) {
+      char *data = GET_INPUT_CHAR_INDEX(pCtx, i);
+      if (isNull(data, pCtx->inputType)) {
+        continue;
+      }
+  
+      notNullElems += 1;
+      tMemBucketPut(pInfo->pMemBucket, data, 1);
     }
-    
-    notNullElems += 1;
-    tMemBucketPut(pInfo->pMemBucket, data, 1);
   }
   
   SET_VAL(pCtx, notNullElems, 1);
@@ -2499,12 +2747,35 @@ static void percentile_finalizer(SQLFunctionCtx *pCtx) {
 
 //////////////////////////////////////////////////////////////////////////////////
 static SAPercentileInfo *getAPerctInfo(SQLFunctionCtx *pCtx) {
-  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
+  SAPercentileInfo *pInfo = NULL;
   
   if (pResInfo->superTableQ && pCtx->currentStage != SECONDARY_STAGE_MERGE) {
-    return (SAPercentileInfo*) pCtx->aOutputBuf;
+    pInfo = (SAPercentileInfo*) pCtx->aOutputBuf;
   } else {
-    return pResInfo->interResultBuf;
+    pInfo = pResInfo->interResultBuf;
+  }
+  
+  // the output buffer may be relocated in the result buffer, so the inner pointers are always reset before use
+  pInfo->pDigest = (STDigest *)((char *)pInfo + sizeof(SAPercentileInfo));
+  tDigestAutoFill(pInfo->pDigest);
+  return pInfo;
+}
+
+/*
+ * The result row keeps the compact digest only. The values are buffered in the buffer of the caller, which is not in
+ * the row, and compressed into the centroids before the call returns.
+ */
+#define APERCT_BUFFER_LEN TDIGEST_BUFFER_LEN(TDIGEST_DEFAULT_COMPRESSION)
+
+static FORCE_INLINE double getApercentileVal(char *data, int16_t type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:   return GET_INT8_VAL(data);
+    case TSDB_DATA_TYPE_SMALLINT:  return GET_INT16_VAL(data);
+    case TSDB_DATA_TYPE_BIGINT:    return (double)(GET_INT64_VAL(data));
+    case TSDB_DATA_TYPE_FLOAT:     return GET_FLOAT_VAL(data);
+    case TSDB_DATA_TYPE_DOUBLE:    return GET_DOUBLE_VAL(data);
+    default:                       return GET_INT32_VAL(data);
   }
 }
 
@@ -2516,7 +2787,7 @@ static bool apercentile_function_setup(SQLFunctionCtx *pCtx) {
   SAPercentileInfo *pInfo = getAPerctInfo(pCtx);
   
   char *tmp = (char *)pInfo + sizeof(SAPercentileInfo);
-  pInfo->pHisto = tHistogramCreateFrom(tmp, MAX_HISTOGRAM_BIN);
+  pInfo->pDigest = tDigestCreateFrom(tmp, TDIGEST_DEFAULT_COMPRESSION);
   return true;
 }
 
@@ -2525,6 +2796,12 @@ static void apercentile_function(SQLFunctionCtx *pCtx) {
   
   SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
   SAPercentileInfo *pInfo = getAPerctInfo(pCtx);
+  SCentroid         buffer[APERCT_BUFFER_LEN];
+  tDigestSetBuffer(pInfo->pDigest, buffer);
+  
+  // convert the values of the data block into double in batch, and add them into t-digest together
+  double  buf[512];
+  int32_t num = 0;
   
   for (int32_t i = 0; i < pCtx->size; ++i) {
     char *data = GET_INPUT_CHAR_INDEX(pCtx, i);
@@ -2532,33 +2809,21 @@ static void apercentile_function(SQLFunctionCtx *pCtx) {
       continue;
     }
     
-    notNullElems += 1;
-    double v = 0;
-    
-    switch (pCtx->inputType) {
-      case TSDB_DATA_TYPE_TINYINT:
-        v = GET_INT8_VAL(data);
-        break;
-      case TSDB_DATA_TYPE_SMALLINT:
-        v = GET_INT16_VAL(data);
-        break;
-      case TSDB_DATA_TYPE_BIGINT:
-        v = (double)(GET_INT64_VAL(data));
-        break;
-      case TSDB_DATA_TYPE_FLOAT:
-        v = GET_FLOAT_VAL(data);
-        break;
-      case TSDB_DATA_TYPE_DOUBLE:
-        v = GET_DOUBLE_VAL(data);
-        break;
-      default:
-        v = GET_INT32_VAL(data);
-        break;
+    buf[num++] = getApercentileVal(data, pCtx->inputType);
+    if (num == tListLen(buf)) {
+      tDigestAddBatch(pInfo->pDigest, buf, num);
+      notNullElems += num;
+      num = 0;
     }
-    
-    tHistogramAdd(&pInfo->pHisto, v);
   }
   
+  if (num > 0) {
+    tDigestAddBatch(pInfo->pDigest, buf, num);
+    notNullElems += num;
+  }
+  
+  tDigestCompress(pInfo->pDigest);
+  
   if (!pCtx->hasNull) {
     assert(pCtx->size == notNullElems);
   }
@@ -2578,30 +2843,11 @@ static void apercentile_function_f(SQLFunctionCtx *pCtx, int32_t index) {
   
   SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
   SAPercentileInfo *pInfo = getAPerctInfo(pCtx);  // pResInfo->interResultBuf;
+  SCentroid         buffer[APERCT_BUFFER_LEN];
   
-  double v = 0;
-  switch (pCtx->inputType) {
-    case TSDB_DATA_TYPE_TINYINT:
-      v = GET_INT8_VAL(pData);
-      break;
-    case TSDB_DATA_TYPE_SMALLINT:
-      v = GET_INT16_VAL(pData);
-      break;
-    case TSDB_DATA_TYPE_BIGINT:
-      v = (double)(GET_INT64_VAL(pData));
-      break;
-    case TSDB_DATA_TYPE_FLOAT:
-      v = GET_FLOAT_VAL(pData);
-      break;
-    case TSDB_DATA_TYPE_DOUBLE:
-      v = GET_DOUBLE_VAL(pData);
-      break;
-    default:
-      v = GET_INT32_VAL(pData);
-      break;
-  }
-  
-  tHistogramAdd(&pInfo->pHisto, v);
+  tDigestSetBuffer(pInfo->pDigest, buffer);
+  tDigestAdd(pInfo->pDigest, getApercentileVal(pData, pCtx->inputType), 1);
+  tDigestCompress(pInfo->pDigest);
   
   SET_VAL(pCtx, 1, 1);
   pResInfo->hasResult = DATA_SET_FLAG;
@@ -2613,30 +2859,19 @@ static void apercentile_func_merge(SQLFunctionCtx *pCtx) {
   
   SAPercentileInfo *pInput = (SAPercentileInfo *)GET_INPUT_CHAR(pCtx);
   
-  pInput->pHisto = (SHistogramInfo*) ((char *)pInput + sizeof(SAPercentileInfo));
-  pInput->pHisto->elems = (SHistBin*) ((char *)pInput->pHisto + sizeof(SHistogramInfo));
+  pInput->pDigest = (STDigest *)((char *)pInput + sizeof(SAPercentileInfo));
+  tDigestAutoFill(pInput->pDigest);
   
-  if (pInput->pHisto->numOfElems <= 0) {
+  if (pInput->pDigest->total <= 0) {
     return;
   }
   
-  size_t size = sizeof(SHistogramInfo) + sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1);
-  
   SAPercentileInfo *pOutput = getAPerctInfo(pCtx);  //(SAPercentileInfo *)pCtx->aOutputBuf;
-  SHistogramInfo *  pHisto = pOutput->pHisto;
+  SCentroid         buffer[APERCT_BUFFER_LEN];
   
-  if (pHisto->numOfElems <= 0) {
-    memcpy(pHisto, pInput->pHisto, size);
-    pHisto->elems = (SHistBin*) ((char *)pHisto + sizeof(SHistogramInfo));
-  } else {
-    pHisto->elems = (SHistBin*) ((char *)pHisto + sizeof(SHistogramInfo));
-    
-    SHistogramInfo *pRes = tHistogramMerge(pHisto, pInput->pHisto, MAX_HISTOGRAM_BIN);
-    memcpy(pHisto, pRes, sizeof(SHistogramInfo) + sizeof(SHistBin) * MAX_HISTOGRAM_BIN);
-    pHisto->elems = (SHistBin*) ((char *)pHisto + sizeof(SHistogramInfo));
-    
-    tHistogramDestroy(&pRes);
-  }
+  tDigestSetBuffer(pOutput->pDigest, buffer);
+  tDigestMerge(pOutput->pDigest, pInput->pDigest);
+  tDigestCompress(pOutput->pDigest);
   
   SET_VAL(pCtx, 1, 1);
   pResInfo->hasResult = DATA_SET_FLAG;
@@ -2645,26 +2880,19 @@ static void apercentile_func_merge(SQLFunctionCtx *pCtx) {
 static void apercentile_func_second_merge(SQLFunctionCtx *pCtx) {
   SAPercentileInfo *pInput = (SAPercentileInfo *)GET_INPUT_CHAR(pCtx);
   
-  pInput->pHisto = (SHistogramInfo*) ((char *)pInput + sizeof(SAPercentileInfo));
-  pInput->pHisto->elems = (SHistBin*) ((char *)pInput->pHisto + sizeof(SHistogramInfo));
+  pInput->pDigest = (STDigest *)((char *)pInput + sizeof(SAPercentileInfo));
+  tDigestAutoFill(pInput->pDigest);
   
-  if (pInput->pHisto->numOfElems <= 0) {
+  if (pInput->pDigest->total <= 0) {
     return;
   }
   
   SAPercentileInfo *pOutput = getAPerctInfo(pCtx);
-  SHistogramInfo *  pHisto = pOutput->pHisto;
+  SCentroid         buffer[APERCT_BUFFER_LEN];
   
-  if (pHisto->numOfElems <= 0) {
-    memcpy(pHisto, pInput->pHisto, sizeof(SHistogramInfo) + sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1));
-    pHisto->elems = (SHistBin*) ((char *)pHisto + sizeof(SHistogramInfo));
-  } else {
-    pHisto->elems = (SHistBin*) ((char *)pHisto + sizeof(SHistogramInfo));
-    
-    SHistogramInfo *pRes = tHistogramMerge(pHisto, pInput->pHisto, MAX_HISTOGRAM_BIN);
-    tHistogramDestroy(&pOutput->pHisto);
-    pOutput->pHisto = pRes;
-  }
+  tDigestSetBuffer(pOutput->pDigest, buffer);
+  tDigestMerge(pOutput->pDigest, pInput->pDigest);
+  tDigestCompress(pOutput->pDigest);
   
   SResultInfo *pResInfo = GET_RES_INFO(pCtx);
   pResInfo->hasResult = DATA_SET_FLAG;
@@ -2677,26 +2905,23 @@ static void apercentile_finalizer(SQLFunctionCtx *pCtx) {
   SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
   SAPercentileInfo *pOutput = pResInfo->interResultBuf;
   
+  pOutput->pDigest = (STDigest *)((char *)pOutput + sizeof(SAPercentileInfo));
+  tDigestAutoFill(pOutput->pDigest);
+  
   if (pCtx->currentStage == SECONDARY_STAGE_MERGE) {
     if (pResInfo->hasResult == DATA_SET_FLAG) {  // check for null
-      assert(pOutput->pHisto->numOfElems > 0);
-      
-      double  ratio[] = {v};
-      double *res = tHistogramUniform(pOutput->pHisto, ratio, 1);
+      assert(pOutput->pDigest->total > 0);
       
-      memcpy(pCtx->aOutputBuf, res, sizeof(double));
-      free(res);
+      double res = tDigestQuantile(pOutput->pDigest, v / 100);
+      memcpy(pCtx->aOutputBuf, &res, sizeof(double));
     } else {
       setNull(pCtx->aOutputBuf, pCtx->outputType, pCtx->outputBytes);
       return;
     }
   } else {
-    if (pOutput->pHisto->numOfElems > 0) {
-      double ratio[] = {v};
-      
-      double *res = tHistogramUniform(pOutput->pHisto, ratio, 1);
-      memcpy(pCtx->aOutputBuf, res, sizeof(double));
-      free(res);
+    if (pOutput->pDigest->total > 0) {
+      double res = tDigestQuantile(pOutput->pDigest, v / 100);
+      memcpy(pCtx->aOutputBuf, &res, sizeof(double));
     } else {  // no need to free
       setNull(pCtx->aOutputBuf, pCtx->outputType, pCtx->outputBytes);
       return;
@@ -2904,6 +3129,11 @@ static FORCE_INLINE void date_col_output_function_f(SQLFunctionCtx *pCtx, int32_
   date_col_output_function(pCtx);
 }
 
+static void date_col_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  SET_VAL(pCtx, 1, 1);
+  *(int64_t *)(pCtx->aOutputBuf) = pCtx->nStartQueryTimestamp;
+}
+
 static void col_project_function(SQLFunctionCtx *pCtx) {
   INC_INIT_VAL(pCtx, pCtx->size);
   
@@ -3480,6 +3710,32 @@ static void spread_function_f(SQLFunctionCtx *pCtx, int32_t index) {
   }
 }
 
+static void spread_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  SSpreadInfo *pInput = (SSpreadInfo *)pPaneResInfo->interResultBuf;
+  if (pInput->hasResult != DATA_SET_FLAG) {
+    return;
+  }
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  SSpreadInfo *pInfo = pResInfo->interResultBuf;
+  
+  if (pInfo->min > pInput->min) {
+    pInfo->min = pInput->min;
+  }
+  
+  if (pInfo->max < pInput->max) {
+    pInfo->max = pInput->max;
+  }
+  
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  pInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    memcpy(pCtx->aOutputBuf, pResInfo->interResultBuf, sizeof(SSpreadInfo));
+  }
+}
+
 void spread_func_merge(SQLFunctionCtx *pCtx) {
   SResultInfo *pResInfo = GET_RES_INFO(pCtx);
   assert(pResInfo->superTableQ);
@@ -4393,6 +4649,118 @@ static void sumrate_finalizer(SQLFunctionCtx *pCtx) {
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ * hyperloglog function, the approximate number of distinct values.
+ * The registers are kept in the intermediate buffer, and copied to the output buffer for super table query
+ */
+static FORCE_INLINE void hll_add_value(SHyperLogLog *pHLL, char *data, int16_t type, int16_t bytes) {
+  if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+    tHLLAdd(pHLL, varDataVal(data), varDataLen(data));
+  } else {
+    tHLLAdd(pHLL, data, bytes);
+  }
+}
+
+static void hll_function(SQLFunctionCtx *pCtx) {
+  int32_t notNullElems = 0;
+  
+  SResultInfo * pResInfo = GET_RES_INFO(pCtx);
+  SHyperLogLog *pHLL = pResInfo->interResultBuf;
+  
+  for (int32_t i = 0; i < pCtx->size; ++i) {
+    char *data = GET_INPUT_CHAR_INDEX(pCtx, i);
+    if (pCtx->hasNull && isNull(data, pCtx->inputType)) {
+      continue;
+    }
+    
+    hll_add_value(pHLL, data, pCtx->inputType, pCtx->inputBytes);
+    notNullElems += 1;
+  }
+  
+  SET_VAL(pCtx, notNullElems, 1);
+  
+  if (notNullElems > 0) {
+    pResInfo->hasResult = DATA_SET_FLAG;
+    
+    if (pResInfo->superTableQ) {
+      memcpy(pCtx->aOutputBuf, pHLL, sizeof(SHyperLogLog));
+    }
+  }
+}
+
+static void hll_function_f(SQLFunctionCtx *pCtx, int32_t index) {
+  char *pData = GET_INPUT_CHAR_INDEX(pCtx, index);
+  if (pCtx->hasNull && isNull(pData, pCtx->inputType)) {
+    return;
+  }
+  
+  SResultInfo * pResInfo = GET_RES_INFO(pCtx);
+  SHyperLogLog *pHLL = pResInfo->interResultBuf;
+  
+  hll_add_value(pHLL, pData, pCtx->inputType, pCtx->inputBytes);
+  
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    memcpy(pCtx->aOutputBuf, pHLL, sizeof(SHyperLogLog));
+  }
+}
+
+static void hll_func_merge(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  
+  for (int32_t i = 0; i < pCtx->size; ++i) {
+    SHyperLogLog *pInput = (SHyperLogLog *)GET_INPUT_CHAR_INDEX(pCtx, i);
+    tHLLMerge(pResInfo->interResultBuf, pInput);
+  }
+  
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    memcpy(pCtx->aOutputBuf, pResInfo->interResultBuf, sizeof(SHyperLogLog));
+  }
+}
+
+static void hll_func_second_merge(SQLFunctionCtx *pCtx) {
+  SHyperLogLog *pInput = (SHyperLogLog *)GET_INPUT_CHAR(pCtx);
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  tHLLMerge(pResInfo->interResultBuf, pInput);
+  
+  pResInfo->hasResult = DATA_SET_FLAG;
+  SET_VAL(pCtx, 1, 1);
+}
+
+static void hll_pane_merge(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput) {
+  if (pPaneResInfo->hasResult != DATA_SET_FLAG) {
+    return;
+  }
+  
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  tHLLMerge(pResInfo->interResultBuf, pPaneResInfo->interResultBuf);
+  
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+  
+  if (pResInfo->superTableQ) {
+    memcpy(pCtx->aOutputBuf, pResInfo->interResultBuf, sizeof(SHyperLogLog));
+  }
+}
+
+static void hll_finalizer(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  
+  // the number of distinct values is 0 rather than null if there is no data, which is the same as count
+  *(int64_t *)pCtx->aOutputBuf = tHLLCount(pResInfo->interResultBuf);
+  
+  pResInfo->numOfRes = 1;
+  doFinalizer(pCtx);
+}
+
+
 /*
  * function compatible list.
  * tag and ts are not involved in the compatibility check
@@ -4411,8 +4779,8 @@ int32_t functionCompatList[] = {
     4,         -1,       -1,         1,        1,      1,          1,           1,        1,     -1,
     //  tag,       colprj,  tagprj,   arithmetic, diff, first_dist, last_dist,    interp      rate   irate
     1,          1,        1,         1,       -1,      1,          1,           5,        1,      1,
-    // sum_rate, sum_irate, avg_rate, avg_irate
-    1,          1,        1,         1,
+    // sum_rate, sum_irate, avg_rate, avg_irate, tid_tag, hyperloglog
+    1,          1,        1,         1,         1,       1,
 };
 
 SQLAggFuncElem aAggs[] = {{
@@ -4429,6 +4797,7 @@ SQLAggFuncElem aAggs[] = {{
                               count_func_merge,
                               count_func_merge,
                               count_load_data_info,
+                              count_pane_merge,
                           },
                           {
                               // 1
@@ -4444,6 +4813,7 @@ SQLAggFuncElem aAggs[] = {{
                               sum_func_merge,
                               sum_func_second_merge,
                               statisRequired,
+                              sum_pane_merge,
                           },
                           {
                               // 2
@@ -4459,6 +4829,7 @@ SQLAggFuncElem aAggs[] = {{
                               avg_func_merge,
                               avg_func_second_merge,
                               statisRequired,
+                              avg_pane_merge,
                           },
                           {
                               // 3
@@ -4474,6 +4845,7 @@ SQLAggFuncElem aAggs[] = {{
                               min_func_merge,
                               min_func_second_merge,
                               statisRequired,
+                              min_pane_merge,
                           },
                           {
                               // 4
@@ -4489,6 +4861,7 @@ SQLAggFuncElem aAggs[] = {{
                               max_func_merge,
                               max_func_second_merge,
                               statisRequired,
+                              max_pane_merge,
                           },
                           {
                               // 5
@@ -4504,6 +4877,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                              stddev_pane_merge,
                           },
                           {
                               // 6
@@ -4519,6 +4893,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 7
@@ -4534,6 +4909,7 @@ SQLAggFuncElem aAggs[] = {{
                               apercentile_func_merge,
                               apercentile_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 8
@@ -4549,6 +4925,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               firstFuncRequired,
+                              NULL,
                           },
                           {
                               // 9
@@ -4564,6 +4941,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               lastFuncRequired,
+                              NULL,
                           },
                           {
                               // 10
@@ -4580,6 +4958,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               last_dist_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 11
@@ -4596,6 +4975,7 @@ SQLAggFuncElem aAggs[] = {{
                               top_func_merge,
                               top_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 12
@@ -4612,6 +4992,7 @@ SQLAggFuncElem aAggs[] = {{
                               bottom_func_merge,
                               bottom_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 13
@@ -4627,6 +5008,7 @@ SQLAggFuncElem aAggs[] = {{
                               spread_func_merge,
                               spread_func_sec_merge,
                               count_load_data_info,
+                              spread_pane_merge,
                           },
                           {
                               // 14
@@ -4642,6 +5024,7 @@ SQLAggFuncElem aAggs[] = {{
                               twa_func_merge,
                               twa_function_copy,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 15
@@ -4657,6 +5040,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 16
@@ -4672,6 +5056,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               no_data_info,
+                              date_col_pane_merge,
                           },
                           {
                               // 17
@@ -4687,6 +5072,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 18
@@ -4702,6 +5088,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               no_data_info,
+                              NULL,
                           },
                           {
                               // 19
@@ -4717,6 +5104,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 20
@@ -4732,6 +5120,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               no_data_info,
+                              NULL,
                           },
                           {
                               // 21, column project sql function
@@ -4747,6 +5136,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 22, multi-output, tag function has only one result
@@ -4762,6 +5152,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               no_data_info,
+                              NULL,
                           },
                           {
                               // 23
@@ -4777,6 +5168,7 @@ SQLAggFuncElem aAggs[] = {{
                               copy_function,
                               copy_function,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 24
@@ -4792,6 +5184,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                              NULL,
                           },
     // distributed version used in two-stage aggregation processes
                           {
@@ -4808,6 +5201,7 @@ SQLAggFuncElem aAggs[] = {{
                               first_dist_func_merge,
                               first_dist_func_second_merge,
                               firstDistFuncRequired,
+                              NULL,
                           },
                           {
                               // 26
@@ -4823,6 +5217,7 @@ SQLAggFuncElem aAggs[] = {{
                               last_dist_func_merge,
                               last_dist_func_second_merge,
                               lastDistFuncRequired,
+                              NULL,
                           },
                           {
                               // 27
@@ -4838,6 +5233,7 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               copy_function,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 28
@@ -4853,6 +5249,7 @@ SQLAggFuncElem aAggs[] = {{
                               rate_func_merge,
                               rate_func_copy,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 29
@@ -4868,6 +5265,7 @@ SQLAggFuncElem aAggs[] = {{
                               rate_func_merge,
                               rate_func_copy,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 30
@@ -4883,6 +5281,7 @@ SQLAggFuncElem aAggs[] = {{
                               sumrate_func_merge,
                               sumrate_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 31
@@ -4898,6 +5297,7 @@ SQLAggFuncElem aAggs[] = {{
                               sumrate_func_merge,
                               sumrate_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 32
@@ -4913,6 +5313,7 @@ SQLAggFuncElem aAggs[] = {{
                               sumrate_func_merge,
                               sumrate_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 33
@@ -4928,6 +5329,7 @@ SQLAggFuncElem aAggs[] = {{
                               sumrate_func_merge,
                               sumrate_func_second_merge,
                               dataBlockRequired,
+                              NULL,
                           },
                           {
                               // 34
@@ -4943,4 +5345,21 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                              NULL,
+                          },
+                          {
+                              // 35
+                              "hyperloglog",
+                              TSDB_FUNC_HLL,
+                              TSDB_FUNC_HLL,
+                              TSDB_FUNCSTATE_SO | TSDB_FUNCSTATE_STREAM | TSDB_FUNCSTATE_OF | TSDB_FUNCSTATE_STABLE,
+                              function_setup,
+                              hll_function,
+                              hll_function_f,
+                              no_next_step,
+                              hll_finalizer,
+                              hll_func_merge,
+                              hll_func_second_merge,
+                              dataBlockRequired,
+                              hll_pane_merge,
                           }};
@@ -14,6 +14,7 @@
  */
 
 #include "os.h"
+#include "qSort.h"
 #include "tlosertree.h"
 #include "tscUtil.h"
 #include "tschemautil.h"
@@ -27,6 +28,8 @@ typedef struct SCompareParam {
   tOrderDescriptor * pDesc;
   int32_t            num;
   int32_t            groupOrderType;
+  int32_t            keyWidth;
+  bool               exactKey;
 } SCompareParam;
 
 int32_t treeComparator(const void *pLeft, const void *pRight, void *param) {
@@ -46,6 +49,20 @@ int32_t treeComparator(const void *pLeft, const void *pRight, void *param) {
     return -1;
   }
 
+  // compare the normalized keys first, the rows are compared column by column only if the keys are identical
+  if (pParam->keyWidth > 0) {
+    int32_t ret = memcmp(pLocalData[pLeftIdx]->pKeys + pLocalData[pLeftIdx]->rowIdx * pParam->keyWidth,
+                         pLocalData[pRightIdx]->pKeys + pLocalData[pRightIdx]->rowIdx * pParam->keyWidth,
+                         pParam->keyWidth);
+    if (ret != 0) {
+      return (ret < 0) ? -1 : 1;
+    }
+
+    if (pParam->exactKey) {
+      return 0;
+    }
+  }
+
   if (pParam->groupOrderType == TSDB_ORDER_DESC) {  // desc
     return compare_d(pDesc, pParam->num, pLocalData[pLeftIdx]->rowIdx, pLocalData[pLeftIdx]->filePage.data,
                      pParam->num, pLocalData[pRightIdx]->rowIdx, pLocalData[pRightIdx]->filePage.data);
@@ -98,6 +115,9 @@ static void tscInitSqlContext(SSqlCmd *pCmd, SLocalReducer *pReducer, tOrderDesc
       pCtx->param[2].i64Key = pQueryInfo->order.order;
       pCtx->param[2].nType  = TSDB_DATA_TYPE_BIGINT;
       pCtx->param[1].i64Key = pQueryInfo->order.orderColId;
+    } else if (functionId == TSDB_FUNC_APERCT) {  // the percentile is required by the finalizer
+      pCtx->param[0].dKey = pExpr->param[0].dKey;
+      pCtx->param[0].nType = pExpr->param[0].nType;
     }
 
     SResultInfo *pResInfo = &pReducer->pResInfo[i];
@@ -221,12 +241,19 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
   pReducer->pDesc = pDesc;
   tscDebug("%p the number of merged leaves is: %d", pSql, pReducer->numOfBuffer);
 
+  SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
+
+  bool    exactKey = false;
+  int32_t keyWidth = tOrderDescKeyWidth(pDesc, &exactKey);
+  int32_t numOfElemsPerPage = pMemBuffer[0]->numOfElemsPerPage;
+
   int32_t idx = 0;
   for (int32_t i = 0; i < numOfBuffer; ++i) {
     int32_t numOfFlushoutInFile = pMemBuffer[i]->fileMeta.flushoutData.nLength;
 
     for (int32_t j = 0; j < numOfFlushoutInFile; ++j) {
-      SLocalDataSource *ds = (SLocalDataSource *)malloc(sizeof(SLocalDataSource) + pMemBuffer[0]->pageSize);
+      size_t keySize = (size_t)keyWidth * numOfElemsPerPage;
+      SLocalDataSource *ds = (SLocalDataSource *)malloc(sizeof(SLocalDataSource) + pMemBuffer[0]->pageSize + keySize);
       if (ds == NULL) {
         tscError("%p failed to create merge structure", pSql);
         pRes->code = TSDB_CODE_TSC_OUT_OF_MEMORY;
@@ -241,9 +268,12 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
       ds->filePage.num = 0;
       ds->pageId = 0;
       ds->rowIdx = 0;
+      ds->pKeys = (char *)ds + sizeof(SLocalDataSource) + pMemBuffer[0]->pageSize;
 
       tscDebug("%p load data from disk into memory, orderOfVnode:%d, total:%d", pSql, i + 1, idx + 1);
       tExtMemBufferLoadData(pMemBuffer[i], &(ds->filePage), j, 0);
+      tColDataEncodeKeys(pDesc, pQueryInfo->groupbyExpr.orderType, numOfElemsPerPage, ds->filePage.data, 0,
+                         (int32_t)ds->filePage.num, ds->pKeys);
 #ifdef _DEBUG_VIEW
       printf("load data page into mem for build loser tree: %" PRIu64 " rows\n", ds->filePage.num);
       SSrcColumnInfo colInfo[256] = {0};
@@ -281,9 +311,9 @@ void tscCreateLocalReducer(tExtMemBuffer **pMemBuffer, int32_t numOfBuffer, tOrd
   param->pLocalData = pReducer->pLocalDataSrc;
   param->pDesc = pReducer->pDesc;
   param->num = pReducer->pLocalDataSrc[0]->pMemBuffer->numOfElemsPerPage;
-  SQueryInfo *pQueryInfo = tscGetQueryInfoDetail(pCmd, pCmd->clauseIndex);
-
   param->groupOrderType = pQueryInfo->groupbyExpr.orderType;
+  param->keyWidth = keyWidth;
+  param->exactKey = exactKey;
   pReducer->orderPrjOnSTable = tscOrderedProjectionQueryOnSTable(pQueryInfo, 0);
 
   pRes->code = tLoserTreeCreate(&pReducer->pLoserTree, pReducer->numOfBuffer, param, treeComparator);
@@ -690,6 +720,11 @@ int32_t tscLocalReducerEnvCreate(SSqlObj *pSql, tExtMemBuffer ***pMemBuffer, tOr
   }
   
   pModel = createColumnModel(pSchema, (int32_t)size, capacity);
+  if (pModel == NULL) {
+    taosTFree(pSchema);
+    pRes->code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    return pRes->code;
+  }
 
   int32_t pg = DEFAULT_PAGE_SIZE;
   int32_t overhead = sizeof(tFilePage);
@@ -785,6 +820,10 @@ int32_t loadNewDataFromDiskFor(SLocalReducer *pLocalReducer, SLocalDataSource *p
     tExtMemBufferLoadData(pOneInterDataSrc->pMemBuffer, &(pOneInterDataSrc->filePage), pOneInterDataSrc->flushoutIdx,
                           pOneInterDataSrc->pageId);
 
+    SCompareParam *param = (SCompareParam *)pLocalReducer->pLoserTree->param;
+    tColDataEncodeKeys(pLocalReducer->pDesc, param->groupOrderType, param->num, pOneInterDataSrc->filePage.data, 0,
+                       (int32_t)pOneInterDataSrc->filePage.num, pOneInterDataSrc->pKeys);
+
 #if defined(_DEBUG_VIEW)
     printf("new page load to buffer\n");
     tColModelDisplay(pOneInterDataSrc->pMemBuffer->pColumnModel, pOneInterDataSrc->filePage.data,
@@ -49,6 +49,7 @@ typedef struct SNormalStmt {
 
 typedef struct STscStmt {
   bool isInsert;
+  int8_t format;  // TAOS_STMT_FORMAT_*
   STscObj* taos;
   SSqlObj* pSql;
   SNormalStmt normal;
@@ -430,6 +431,7 @@ static int insertStmtExecute(STscStmt* stmt) {
 
   if (taosArrayGetSize(pCmd->pDataBlocks) > 0) {
     // merge according to vgid
+    pCmd->submitFormat = stmt->format;
     int code = tscMergeTableDataBlocks(stmt->pSql, pCmd->pDataBlocks);
     if (code != TSDB_CODE_SUCCESS) {
       return code;
@@ -503,6 +505,23 @@ TAOS_STMT* taos_stmt_init(TAOS* taos) {
   return pStmt;
 }
 
+int taos_stmt_set_format(TAOS_STMT* stmt, int format) {
+  STscStmt* pStmt = (STscStmt*)stmt;
+
+  if (stmt == NULL || pStmt->taos == NULL) {
+    terrno = TSDB_CODE_TSC_DISCONNECTED;
+    return TSDB_CODE_TSC_DISCONNECTED;
+  }
+
+  if (format < TAOS_STMT_FORMAT_ROW || format > TAOS_STMT_FORMAT_COL_COMPRESSED) {
+    tscError("invalid statement format %d", format);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  pStmt->format = (int8_t)format;
+  return TSDB_CODE_SUCCESS;
+}
+
 int taos_stmt_prepare(TAOS_STMT* stmt, const char* sql, unsigned long length) {
   STscStmt* pStmt = (STscStmt*)stmt;
 
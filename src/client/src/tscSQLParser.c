@@ -40,6 +40,9 @@
 #define COLUMN_INDEX_VALIDE(index) (((index).tableIndex >= 0) && ((index).columnIndex >= TSDB_TBNAME_COLUMN_INDEX))
 #define TBNAME_LIST_SEP ","
 
+#define TK_IS_FUNCTION(optr) \
+  (((optr) >= TK_COUNT && (optr) <= TK_AVG_IRATE) || (optr) == TK_HYPERLOGLOG)
+
 typedef struct SColumnList {  // todo refactor
   int32_t      num;
   SColumnIndex ids[TSDB_MAX_COLUMNS];
@@ -1114,6 +1117,7 @@ int32_t parseSelectClause(SSqlCmd* pCmd, int32_t clauseIndex, tSQLExprList* pSel
   const char* msg3 = "not support query expression";
   const char* msg4 = "columns from different table mixed up in arithmetic expression";
   const char* msg5 = "invalid function name";
+  const char* msg6 = "intermediate result row is too large, e.g., too many apercentile functions";
 
   SQueryInfo* pQueryInfo = tscGetQueryInfoDetail(pCmd, clauseIndex);
   
@@ -1140,7 +1144,8 @@ int32_t parseSelectClause(SSqlCmd* pCmd, int32_t clauseIndex, tSQLExprList* pSel
       if (addProjectionExprAndResultField(pCmd, pQueryInfo, pItem) != TSDB_CODE_SUCCESS) {
         return TSDB_CODE_TSC_INVALID_SQL;
       }
-    } else if (pItem->pNode->nSQLOptr >= TK_COUNT && pItem->pNode->nSQLOptr <= TK_TBID) {
+    } else if ((pItem->pNode->nSQLOptr >= TK_COUNT && pItem->pNode->nSQLOptr <= TK_TBID) ||
+               pItem->pNode->nSQLOptr == TK_HYPERLOGLOG) {
       // sql function in selection clause, append sql function info in pSqlCmd structure sequentially
       if (addExprAndResultField(pCmd, pQueryInfo, outputIndex, pItem, true) != TSDB_CODE_SUCCESS) {
         return TSDB_CODE_TSC_INVALID_SQL;
@@ -1264,6 +1269,17 @@ int32_t parseSelectClause(SSqlCmd* pCmd, int32_t clauseIndex, tSQLExprList* pSel
     if (hasUnsupportFunctionsForSTableQuery(pCmd, pQueryInfo)) {
       return TSDB_CODE_TSC_INVALID_SQL;
     }
+
+    // the intermediate results of all vnodes are merged in a column model, of which the row size is an int16_t
+    int32_t rowSize = 0;
+    size_t  numOfExprs = tscSqlExprNumOfExprs(pQueryInfo);
+    for (int32_t i = 0; i < numOfExprs; ++i) {
+      rowSize += tscSqlExprGet(pQueryInfo, i)->resBytes;
+    }
+
+    if (rowSize > INT16_MAX) {
+      return invalidSqlErrMsg(tscGetErrorMsgPayload(pCmd), msg6);
+    }
   }
 
   return TSDB_CODE_SUCCESS;
@@ -1598,6 +1614,7 @@ int32_t addExprAndResultField(SSqlCmd* pCmd, SQueryInfo* pQueryInfo, int32_t col
     case TK_MAX:
     case TK_DIFF:
     case TK_STDDEV:
+    case TK_HYPERLOGLOG:
     case TK_LEASTSQUARES: {
       // 1. valid the number of parameters
       if (pItem->pNode->pParam == NULL || (optr != TK_LEASTSQUARES && pItem->pNode->pParam->nExpr != 1) ||
@@ -1622,7 +1639,8 @@ int32_t addExprAndResultField(SSqlCmd* pCmd, SQueryInfo* pQueryInfo, int32_t col
       SSchema* pSchema = tscGetTableColumnSchema(pTableMetaInfo->pTableMeta, index.columnIndex);
       int16_t  colType = pSchema->type;
 
-      if (colType <= TSDB_DATA_TYPE_BOOL || colType >= TSDB_DATA_TYPE_BINARY) {
+      // the distinct values of any data type can be counted
+      if (optr != TK_HYPERLOGLOG && (colType <= TSDB_DATA_TYPE_BOOL || colType >= TSDB_DATA_TYPE_BINARY)) {
         return invalidSqlErrMsg(tscGetErrorMsgPayload(pCmd), msg1);
       }
 
@@ -1918,6 +1936,7 @@ int32_t addExprAndResultField(SSqlCmd* pCmd, SQueryInfo* pQueryInfo, int32_t col
         }
       }
 
+      tscInsertPrimaryTSSourceColumn(pQueryInfo, &index);
       return TSDB_CODE_SUCCESS;
     };
     
@@ -2194,6 +2213,9 @@ int32_t changeFunctionID(int32_t optr, int16_t* functionId) {
     case TK_APERCENTILE:
       *functionId = TSDB_FUNC_APERCT;
       break;
+    case TK_HYPERLOGLOG:
+      *functionId = TSDB_FUNC_HLL;
+      break;
     case TK_FIRST:
       *functionId = TSDB_FUNC_FIRST;
       break;
@@ -2382,7 +2404,7 @@ int32_t tscTansformSQLFuncForSTableQuery(SQueryInfo* pQueryInfo) {
     
     if ((functionId >= TSDB_FUNC_SUM && functionId <= TSDB_FUNC_TWA) ||
         (functionId >= TSDB_FUNC_FIRST_DST && functionId <= TSDB_FUNC_LAST_DST) ||
-        (functionId >= TSDB_FUNC_RATE && functionId <= TSDB_FUNC_AVG_IRATE)) {
+        (functionId >= TSDB_FUNC_RATE && functionId <= TSDB_FUNC_AVG_IRATE) || functionId == TSDB_FUNC_HLL) {
       if (getResultDataInfo(pSrcSchema->type, pSrcSchema->bytes, functionId, (int32_t)pExpr->param[0].i64Key, &type, &bytes,
                             &interBytes, 0, true) != TSDB_CODE_SUCCESS) {
         return TSDB_CODE_TSC_INVALID_SQL;
@@ -2724,7 +2746,7 @@ static int32_t tSQLExprNodeToString(tSQLExpr* pExpr, char** str) {
   } else if (pExpr->nSQLOptr >= TK_BOOL && pExpr->nSQLOptr <= TK_STRING) {  // value
     *str += tVariantToString(&pExpr->val, *str);
 
-  } else if (pExpr->nSQLOptr >= TK_COUNT && pExpr->nSQLOptr <= TK_AVG_IRATE) {
+  } else if (TK_IS_FUNCTION(pExpr->nSQLOptr)) {
     /*
      * arithmetic expression of aggregation, such as count(ts) + count(ts) *2
      */
@@ -3137,7 +3159,7 @@ static int32_t validateSQLExpr(SSqlCmd* pCmd, tSQLExpr* pExpr, SQueryInfo* pQuer
     pList->ids[pList->num++] = index;
   } else if (pExpr->nSQLOptr == TK_FLOAT && (isnan(pExpr->val.dKey) || isinf(pExpr->val.dKey))) {
     return TSDB_CODE_TSC_INVALID_SQL;
-  } else if (pExpr->nSQLOptr >= TK_COUNT && pExpr->nSQLOptr <= TK_AVG_IRATE) {
+  } else if (TK_IS_FUNCTION(pExpr->nSQLOptr)) {
     if (*type == NON_ARITHMEIC_EXPR) {
       *type = AGG_ARIGHTMEIC;
     } else if (*type == NORMAL_ARITHMETIC) {
@@ -3204,7 +3226,7 @@ static bool isValidExpr(tSQLExpr* pLeft, tSQLExpr* pRight, int32_t optr) {
    *
    * However, columnA < 4+12 is valid
    */
-  if (pLeft->nSQLOptr >= TK_COUNT && pLeft->nSQLOptr <= TK_AVG_IRATE) {
+  if (TK_IS_FUNCTION(pLeft->nSQLOptr)) {
     return false;
   }
 
@@ -3212,7 +3234,7 @@ static bool isValidExpr(tSQLExpr* pLeft, tSQLExpr* pRight, int32_t optr) {
     return true;
   }
 
-  if (pRight->nSQLOptr >= TK_COUNT && pRight->nSQLOptr <= TK_AVG_IRATE) {
+  if (TK_IS_FUNCTION(pRight->nSQLOptr)) {
     return false;
   }
   
@@ -6097,7 +6119,7 @@ int32_t exprTreeFromSqlExpr(SSqlCmd* pCmd, tExprNode **pExpr, const tSQLExpr* pS
       
       tVariantAssign((*pExpr)->pVal, &pSqlExpr->val);
       return TSDB_CODE_SUCCESS;
-    } else if (pSqlExpr->nSQLOptr >= TK_COUNT && pSqlExpr->nSQLOptr <= TK_AVG_IRATE) {
+    } else if (TK_IS_FUNCTION(pSqlExpr->nSQLOptr)) {
       // arithmetic expression on the results of aggregation functions
       *pExpr = calloc(1, sizeof(tExprNode));
       (*pExpr)->nodeType = TSQL_NODE_COL;
@@ -219,6 +219,9 @@ void tscProcessActivityTimer(void *handle, void *tmrId) {
   tscProcessSql(pObj->pHb);
 }
 
+#define TSDB_MAX_THROTTLE_RETRY     50
+#define TSDB_DEFAULT_THROTTLE_DELAY 100  // ms, used when the vnode suggests no delay
+
 int tscSendMsgToServer(SSqlObj *pSql) {
   STscObj* pObj = pSql->pTscObj;
   SSqlCmd* pCmd = &pSql->cmd;
@@ -253,6 +256,45 @@ int tscSendMsgToServer(SSqlObj *pSql) {
   return TSDB_CODE_SUCCESS;
 }
 
+static void tscRetryThrottledWrite(void *param, void *tmrId) {
+  SSqlObj *pSql = (SSqlObj *)param;
+
+  // tscFreeSqlObj has taken the timer but failed to stop it, the sql object is left to be freed here
+  if (atomic_val_compare_exchange_ptr(&pSql->pThrottleTimer, tmrId, NULL) != tmrId) {
+    tscDebug("%p sql object is freed while the throttled write is to be resent", pSql);
+    tscDoFreeSqlObj(pSql);
+    return;
+  }
+
+  int32_t code = tscSendMsgToServer(pSql);
+  if (code != TSDB_CODE_SUCCESS) {
+    pSql->res.code = code;
+    tscQueueAsyncRes(pSql);
+  }
+}
+
+/*
+ * The submit is rejected by the vnode since its memory buffer is under pressure, and the write is sent again after
+ * the delay suggested by the vnode.
+ */
+static bool tscThrottleWrite(SSqlObj *pSql, SRpcMsg *rpcMsg) {
+  if (pSql->throttled >= TSDB_MAX_THROTTLE_RETRY) {
+    tscError("%p max throttle retry %d reached, give up", pSql, pSql->throttled);
+    return false;
+  }
+
+  int32_t delay = TSDB_DEFAULT_THROTTLE_DELAY;
+  if (rpcMsg->pCont != NULL && rpcMsg->contLen >= sizeof(SWriteThrottleRspMsg)) {
+    delay = htonl(((SWriteThrottleRspMsg *)rpcMsg->pCont)->delay);
+  }
+
+  pSql->throttled++;
+  tscDebug("%p write is throttled, retry:%d after %d ms", pSql, pSql->throttled, delay);
+
+  taosTmrReset(tscRetryThrottledWrite, delay, pSql, tscTmr, &pSql->pThrottleTimer);
+  return true;
+}
+
 void tscProcessMsgFromServer(SRpcMsg *rpcMsg, SRpcEpSet *pEpSet) {
   SSqlObj *pSql = (SSqlObj *)rpcMsg->ahandle;
   if (pSql == NULL || pSql->signature != pSql) {
@@ -321,6 +363,11 @@ void tscProcessMsgFromServer(SRpcMsg *rpcMsg, SRpcEpSet *pEpSet) {
     }
   }
 
+  if (cmd == TSDB_SQL_INSERT && rpcMsg->code == TSDB_CODE_VND_WRITE_THROTTLED && tscThrottleWrite(pSql, rpcMsg)) {
+    rpcFreeCont(rpcMsg->pCont);
+    return;
+  }
+
   pRes->rspLen = 0;
   
   if (pRes->code != TSDB_CODE_TSC_QUERY_CANCELLED) {
@@ -332,6 +379,7 @@ void tscProcessMsgFromServer(SRpcMsg *rpcMsg, SRpcEpSet *pEpSet) {
   if (pRes->code == TSDB_CODE_SUCCESS) {
     tscDebug("%p reset retry counter to be 0 due to success rsp, old:%d", pSql, pSql->retry);
     pSql->retry = 0;
+    pSql->throttled = 0;
   }
 
   if (pRes->code != TSDB_CODE_TSC_QUERY_CANCELLED) {
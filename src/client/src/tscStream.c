@@ -143,7 +143,11 @@ static void tscProcessStreamTimer(void *handle, void *tmrId) {
   schedMsg.ahandle = pStream;
   schedMsg.thandle = (void *)1;
   schedMsg.msg = NULL;
-  taosScheduleTask(tscQhandle, &schedMsg);
+  if (taosScheduleTask(tscQhandle, &schedMsg) != 0) {
+    tscError("%p stream:%p, failed to schedule the stream query since %s, launch it directly", pStream->pSql, pStream,
+             tstrerror(terrno));
+    tscProcessStreamLaunchQuery(&schedMsg);
+  }
 }
 
 static void tscProcessStreamQueryCallback(void *param, TAOS_RES *tres, int numOfRows) {
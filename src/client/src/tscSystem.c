@@ -147,7 +147,8 @@ void taos_init_imp(void) {
   refreshTime = refreshTime < 10 ? 10 : refreshTime;
 
   if (tscCacheHandle == NULL) {
-    tscCacheHandle = taosCacheInit(TSDB_DATA_TYPE_BINARY, refreshTime, false, NULL, "tableMeta");
+    tscCacheHandle = taosCacheInitSharded(TSDB_DATA_TYPE_BINARY, refreshTime, false, NULL, "tableMeta",
+                                          (int64_t)tsTableMetaCacheSize * 1024 * 1024);
   }
 
   tscDebug("client is initialized successfully");
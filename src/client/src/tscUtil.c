@@ -21,6 +21,7 @@
 #include "tcache.h"
 #include "tkey.h"
 #include "tmd5.h"
+#include "tscompression.h"
 #include "tscLocalMerge.h"
 #include "tscLog.h"
 #include "tscProfile.h"
@@ -375,6 +376,18 @@ void tscFreeSqlObj(SSqlObj* pSql) {
   }
   
   tscDebug("%p start to free sql object", pSql);
+
+  // the resend of a throttled write holds the sql object, it frees the object if its timer is already fired
+  void *pTimer = atomic_exchange_ptr(&pSql->pThrottleTimer, NULL);
+  if (pTimer != NULL && !taosTmrStop(pTimer)) {
+    tscDebug("%p throttled write is being resent, the sql object is freed by the resend", pSql);
+    return;
+  }
+
+  tscDoFreeSqlObj(pSql);
+}
+
+void tscDoFreeSqlObj(SSqlObj* pSql) {
   tscPartiallyFreeSqlObj(pSql);
 
   pSql->signature = NULL;
@@ -625,6 +638,114 @@ static int trimDataBlock(void* pDataBlock, STableDataBlocks* pTableDataBlock, bo
   return len;
 }
 
+/*
+ * convert the rows of the table data block into one column after another, each column is a SSubmitColHead, the null
+ * bitmap and the values. The values of each column are compressed by the algorithm of its type if compress is true.
+ *
+ * @return the length of the data part, or -1 if out of memory
+ */
+static int trimDataBlockToCols(void* pDataBlock, STableDataBlocks* pTableDataBlock, bool includeSchema, bool compress) {
+  STableMeta*   pTableMeta = pTableDataBlock->pTableMeta;
+  STableComInfo tinfo = tscGetTableInfo(pTableMeta);
+  SSchema*      pSchema = tscGetTableSchema(pTableMeta);
+
+  SSubmitBlk* pBlock = pDataBlock;
+  memcpy(pDataBlock, pTableDataBlock->pData, sizeof(SSubmitBlk));
+  pDataBlock = (char*)pDataBlock + sizeof(SSubmitBlk);
+  pBlock->format = htons(TSDB_SUBMIT_BLK_COL);
+  pBlock->schemaLen = 0;
+
+  if (includeSchema) {
+    for (int32_t j = 0; j < tinfo.numOfColumns; ++j) {
+      STColumn* pCol = (STColumn*)pDataBlock;
+      pCol->colId = htons(pSchema[j].colId);
+      pCol->type = pSchema[j].type;
+      pCol->bytes = htons(pSchema[j].bytes);
+      pCol->offset = 0;
+
+      pDataBlock = (char*)pDataBlock + sizeof(STColumn);
+    }
+
+    pBlock->schemaLen = sizeof(STColumn) * tinfo.numOfColumns;
+  }
+
+  int32_t numOfRows = htons(pBlock->numOfRows);
+  int32_t bitmapLen = (numOfRows + 7) / 8;
+  char*   pRows = pTableDataBlock->pData + sizeof(SSubmitBlk);
+  char*   buffer = NULL;  // the values of one column before compression
+
+  if (compress) {
+    int32_t maxBytes = 0;
+    for (int32_t j = 0; j < tinfo.numOfColumns; ++j) {
+      maxBytes = MAX(maxBytes, pSchema[j].bytes);
+    }
+
+    buffer = malloc((size_t)maxBytes * numOfRows);
+    if (buffer == NULL) return -1;
+  }
+
+  pBlock->dataLen = 0;
+  int32_t offset = 0;  // offset of the column in the row
+
+  for (int32_t j = 0; j < tinfo.numOfColumns; ++j) {
+    int32_t         type = pSchema[j].type;
+    SSubmitColHead* pHead = (SSubmitColHead*)pDataBlock;
+    char*           bitmap = (char*)pDataBlock + sizeof(SSubmitColHead);
+    char*           pVal = bitmap + bitmapLen;
+    char*           dst = compress ? buffer : pVal;
+    int32_t         rawLen = 0;
+    int32_t         numOfElems = 0;
+
+    memset(bitmap, 0, bitmapLen);
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      char* p = pRows + pTableDataBlock->rowSize * i + offset;
+      bool  null = isNull(p, type);
+      if (null) bitmap[i >> 3] |= (1 << (i & 7));
+
+      if (IS_VAR_DATA_TYPE(type)) {
+        if (null) continue;
+        memcpy(dst + rawLen, p, varDataTLen(p));
+        rawLen += varDataTLen(p);
+      } else {
+        memcpy(dst + rawLen, p, TYPE_BYTES[type]);
+        rawLen += TYPE_BYTES[type];
+      }
+      numOfElems++;
+    }
+
+    int32_t len = rawLen;
+    pHead->comp = NO_COMPRESSION;
+    if (compress && rawLen > 0) {
+      len = (*(tDataTypeDesc[type].compFunc))(buffer, rawLen, numOfElems, pVal, rawLen + COMP_OVERFLOW_BYTES,
+                                              ONE_STAGE_COMP, NULL, 0);
+      if (len > 0 && len < rawLen) {
+        pHead->comp = ONE_STAGE_COMP;
+      } else {  // not compressible, the raw values are sent
+        memcpy(pVal, buffer, rawLen);
+        len = rawLen;
+      }
+    }
+
+    pHead->colId = htons(pSchema[j].colId);
+    pHead->type = (int8_t)type;
+    pHead->rawLen = htonl(rawLen);
+    pHead->len = htonl(len);
+
+    int32_t colLen = sizeof(SSubmitColHead) + bitmapLen + len;
+    pDataBlock = (char*)pDataBlock + colLen;
+    pBlock->dataLen += colLen;
+    offset += pSchema[j].bytes;
+  }
+
+  taosTFree(buffer);
+
+  int32_t len = pBlock->dataLen + pBlock->schemaLen;
+  pBlock->dataLen = htonl(pBlock->dataLen);
+  pBlock->schemaLen = htonl(pBlock->schemaLen);
+
+  return len;
+}
+
 static int32_t getRowExpandSize(STableMeta* pTableMeta) {
   int32_t result = TD_DATA_ROW_HEAD_SIZE;
   int32_t columns = tscGetNumOfColumns(pTableMeta);
@@ -663,7 +784,15 @@ int32_t tscMergeTableDataBlocks(SSqlObj* pSql, SArray* pTableDataBlockList) {
     }
 
     SSubmitBlk* pBlocks = (SSubmitBlk*) pOneTableBlock->pData;
-    int64_t destSize = dataBuf->size + pOneTableBlock->size + pBlocks->numOfRows * expandSize + sizeof(STColumn) * tscGetNumOfColumns(pOneTableBlock->pTableMeta);
+    int32_t numOfCols = tscGetNumOfColumns(pOneTableBlock->pTableMeta);
+
+    // the column heads, null bitmaps and compression overflow of a columnar block
+    int32_t colExtraSize = 0;
+    if (pCmd->submitFormat != TAOS_STMT_FORMAT_ROW) {
+      colExtraSize = numOfCols * (sizeof(SSubmitColHead) + (pBlocks->numOfRows + 7) / 8 + COMP_OVERFLOW_BYTES);
+    }
+
+    int64_t destSize = dataBuf->size + pOneTableBlock->size + pBlocks->numOfRows * expandSize + sizeof(STColumn) * numOfCols + colExtraSize;
 
     if (dataBuf->nAllocSize < destSize) {
       while (dataBuf->nAllocSize < destSize) {
@@ -691,7 +820,7 @@ int32_t tscMergeTableDataBlocks(SSqlObj* pSql, SArray* pTableDataBlockList) {
     tscDebug("%p tableId:%s, sid:%d rows:%d sversion:%d skey:%" PRId64 ", ekey:%" PRId64, pSql, pOneTableBlock->tableId,
         pBlocks->tid, pBlocks->numOfRows, pBlocks->sversion, GET_INT64_VAL(pBlocks->data), GET_INT64_VAL(ekey));
 
-    int32_t len = pBlocks->numOfRows * (pOneTableBlock->rowSize + expandSize) + sizeof(STColumn) * tscGetNumOfColumns(pOneTableBlock->pTableMeta);
+    int32_t len = pBlocks->numOfRows * (pOneTableBlock->rowSize + expandSize) + sizeof(STColumn) * numOfCols + colExtraSize;
 
     pBlocks->tid = htonl(pBlocks->tid);
     pBlocks->uid = htobe64(pBlocks->uid);
@@ -700,7 +829,19 @@ int32_t tscMergeTableDataBlocks(SSqlObj* pSql, SArray* pTableDataBlockList) {
     pBlocks->schemaLen = 0;
 
     // erase the empty space reserved for binary data
-    int32_t finalLen = trimDataBlock(dataBuf->pData + dataBuf->size, pOneTableBlock, pCmd->submitSchema);
+    int32_t finalLen = 0;
+    if (pCmd->submitFormat != TAOS_STMT_FORMAT_ROW) {
+      finalLen = trimDataBlockToCols(dataBuf->pData + dataBuf->size, pOneTableBlock, pCmd->submitSchema,
+                                     pCmd->submitFormat == TAOS_STMT_FORMAT_COL_COMPRESSED);
+      if (finalLen < 0) {
+        tscError("%p failed to allocate memory for compressing submit block", pSql);
+        taosHashCleanup(pVnodeDataBlockHashList);
+        tscDestroyBlockArrayList(pVnodeDataBlockList);
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+    } else {
+      finalLen = trimDataBlock(dataBuf->pData + dataBuf->size, pOneTableBlock, pCmd->submitSchema);
+    }
     assert(finalLen <= len);
 
     dataBuf->size += (finalLen + sizeof(SSubmitBlk));
@@ -43,6 +43,15 @@ extern int32_t  tsShellActivityTimer;
 extern uint32_t tsMaxTmrCtrl;
 extern float    tsNumOfThreadsPerCore;
 extern float    tsRatioOfQueryThreads;
+extern float    tsRatioOfLongQueryThreads;
+extern int32_t  tsQueryTimeSlice;
+extern char     tsRpcCores[];
+extern char     tsWriteCores[];
+extern char     tsReadCores[];
+extern char     tsCommitCores[];
+extern char     tsSyncCores[];
+extern int32_t  tsPinWriteThreads;
+extern int32_t  tsIsolateRpcCores;
 extern int8_t   tsDaylight;
 extern char     tsTimezone[];
 extern char     tsLocale[];
@@ -52,9 +61,11 @@ extern int32_t  tsCompressMsgSize;
 
 // client
 extern int32_t tsTableMetaKeepTimer;
+extern int32_t tsTableMetaCacheSize;
 extern int32_t tsMaxSQLStringLen;
 extern int32_t tsTscEnableRecordSql;
 extern int32_t tsMaxNumOfOrderedResults;
+extern int32_t tsPercentileMemSize;
 extern int32_t tsMinSlidingTime;
 extern int32_t tsMinIntervalTime;
 extern int32_t tsMaxStreamComputDelay;
@@ -67,6 +78,9 @@ extern int64_t tsMaxRetentWindow;
 // db parameters in client
 extern int32_t tsCacheBlockSize;
 extern int32_t tsBlocksPerVnode;
+extern int32_t tsMemtableBudget;
+extern int32_t tsMemtableHugePage;
+extern int32_t tsMemtableNumaBind;
 extern int32_t tsMinTablePerVnode;
 extern int32_t tsMaxTablePerVnode;
 extern int32_t tsTableIncStepPerVnode;
@@ -80,6 +94,7 @@ extern int32_t tsTimePrecision;
 extern int16_t tsCompression;
 extern int16_t tsWAL;
 extern int32_t tsFsyncPeriod;
+extern int32_t tsWalGroupCommit;
 extern int32_t tsReplications;
 extern int32_t tsQuorum;
 
@@ -151,6 +166,7 @@ extern char buildinfo[];
 
 // log
 extern int32_t tsAsyncLog;
+extern int32_t tsBinaryLog;
 extern int32_t tsNumOfLogLines;
 extern int32_t dDebugFlag;
 extern int32_t vDebugFlag;
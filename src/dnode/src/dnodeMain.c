@@ -16,9 +16,11 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 #include "taos.h"
+#include "taoserror.h"
 #include "tutil.h"
 #include "tconfig.h"
 #include "tglobal.h"
+#include "tplacement.h"
 #include "dnode.h"
 #include "dnodeInt.h"
 #include "dnodeMgmt.h"
@@ -34,6 +36,8 @@
 
 static int32_t dnodeInitStorage();
 static void dnodeCleanupStorage();
+static int32_t dnodeInitPlacement();
+static void dnodeCleanupPlacement();
 static void dnodeSetRunStatus(SDnodeRunStatus status);
 static void dnodeCheckDataDirOpenned(char *dir);
 static SDnodeRunStatus tsDnodeRunStatus = TSDB_DNODE_RUN_STATUS_STOPPED;
@@ -49,6 +53,7 @@ typedef struct {
 
 static const SDnodeComponent tsDnodeComponents[] = {
   {"storage",   dnodeInitStorage,    dnodeCleanupStorage},
+  {"placement", dnodeInitPlacement,  dnodeCleanupPlacement},
   {"vread",     dnodeInitVnodeRead,  dnodeCleanupVnodeRead},
   {"vwrite",    dnodeInitVnodeWrite, dnodeCleanupVnodeWrite},
   {"mread",     dnodeInitMnodeRead,  dnodeCleanupMnodeRead},
@@ -202,6 +207,25 @@ static int32_t dnodeInitStorage() {
 
 static void dnodeCleanupStorage() {}
 
+// the thread pools are placed when their threads start, so it is initialized before the pools
+static int32_t dnodeInitPlacement() {
+  SThreadPlacementCfg cfg = {
+    .cores      = {tsRpcCores, tsWriteCores, tsReadCores, tsCommitCores, tsSyncCores},
+    .numOfCores = tsNumOfCores,
+    .pinWrite   = (int8_t)tsPinWriteThreads,
+    .isolateRpc = (int8_t)tsIsolateRpcCores
+  };
+
+  if (taosInitThreadPlacement(&cfg) != 0) {
+    dError("failed to init thread placement since %s", tstrerror(terrno));
+    return -1;
+  }
+
+  return 0;
+}
+
+static void dnodeCleanupPlacement() { taosCleanupThreadPlacement(); }
+
 bool  dnodeIsFirstDeploy() {
   return strcmp(tsFirst, tsLocalEp) == 0;
 }
@@ -34,6 +34,7 @@
 #include "dnodeVRead.h"
 #include "dnodeVWrite.h"
 #include "dnodeModule.h"
+#include "tplacement.h"
 
 #define MPEER_CONTENT_LEN 2000
 
@@ -714,6 +715,7 @@ static void dnodeSendStatusMsg(void *handle, void *tmrId) {
   strcpy(pStatus->clusterCfg.timezone, tsTimezone);
   strcpy(pStatus->clusterCfg.locale, tsLocale);
   strcpy(pStatus->clusterCfg.charset, tsCharset);  
+  taosGetThreadPlacement(pStatus->placement, TSDB_PLACEMENT_LEN);
   
   vnodeBuildStatusMsg(pStatus);
   contLen = sizeof(SDMStatusMsg) + pStatus->openVnodes * sizeof(SVnodeLoad);
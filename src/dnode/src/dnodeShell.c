@@ -22,6 +22,7 @@
 #include "tutil.h"
 #include "http.h"
 #include "mnode.h"
+#include "vnode.h"
 #include "dnode.h"
 #include "dnodeInt.h"
 #include "dnodeVRead.h"
@@ -217,6 +218,7 @@ SDnodeStatisInfo dnodeGetStatisInfo() {
     info.httpReqNum   = httpGetReqCount();
     info.queryReqNum  = atomic_exchange_32(&tsDnodeQueryReqNum, 0);
     info.submitReqNum = atomic_exchange_32(&tsDnodeSubmitReqNum, 0);
+    info.throttledReqNum = vnodeGetThrottledWriteNum();
   }
 
   return info;
@@ -24,67 +24,98 @@
 #include "dnodeInt.h"
 #include "dnodeMgmt.h"
 #include "dnodeVRead.h"
+#include "tplacement.h"
 #include "vnode.h"
 
 typedef struct {
   pthread_t  thread;    // thread
   int32_t    workerId;  // worker ID
+  struct SReadWorkerPool *pPool;
 } SReadWorker;
 
-typedef struct {
+typedef struct SReadWorkerPool {
   int32_t    max;       // max number of workers
   int32_t    min;       // min number of workers
   int32_t    num;       // current number of workers
   SReadWorker *readWorker;
+  taos_qset  qset;
+  const char *name;
   pthread_mutex_t mutex;
 } SReadWorkerPool;
 
 static void *dnodeProcessReadQueue(void *param);
 static void  dnodeHandleIdleReadWorker(SReadWorker *);
+static int32_t dnodeInitReadPool(SReadWorkerPool *pPool, const char *name, int32_t min, int32_t max);
+static void    dnodeCleanupReadPool(SReadWorkerPool *pPool);
+static void   *dnodeAllocateReadQueue(SReadWorkerPool *pPool, void *pVnode);
 
 // module global variable
 static SReadWorkerPool readPool;
-static taos_qset       readQset;
+static SReadWorkerPool longPool;  // runs the long queries, so that the short ones are not queued behind them
 
 int32_t dnodeInitVnodeRead() {
-  readQset = taosOpenQset();
+  int32_t min = tsNumOfCores;
+  int32_t max = tsNumOfCores * tsNumOfThreadsPerCore;
+  if (max <= min * 2) max = 2 * min;
 
-  readPool.min = tsNumOfCores;
-  readPool.max = tsNumOfCores * tsNumOfThreadsPerCore;
-  if (readPool.max <= readPool.min * 2) readPool.max = 2 * readPool.min;
-  readPool.readWorker = (SReadWorker *)calloc(sizeof(SReadWorker), readPool.max);
-  pthread_mutex_init(&readPool.mutex, NULL);
+  if (dnodeInitReadPool(&readPool, "read", min, max) != 0) return -1;
 
-  if (readPool.readWorker == NULL) return -1;
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
-    pWorker->workerId = i;
+  if (tsRatioOfLongQueryThreads > 0) {
+    int32_t longMin = MAX(1, (int32_t)(min * tsRatioOfLongQueryThreads));
+    int32_t longMax = MAX(longMin, (int32_t)(max * tsRatioOfLongQueryThreads));
+    if (dnodeInitReadPool(&longPool, "long query", longMin, longMax) != 0) return -1;
   }
 
-  dInfo("dnode read is opened, min worker:%d max worker:%d", readPool.min, readPool.max);
   return 0;
 }
 
 void dnodeCleanupVnodeRead() {
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
+  dnodeCleanupReadPool(&longPool);
+  dnodeCleanupReadPool(&readPool);
+}
+
+static int32_t dnodeInitReadPool(SReadWorkerPool *pPool, const char *name, int32_t min, int32_t max) {
+  pPool->name = name;
+  pPool->min = min;
+  pPool->max = max;
+  pPool->qset = taosOpenQset();
+  pPool->readWorker = (SReadWorker *)calloc(sizeof(SReadWorker), pPool->max);
+  pthread_mutex_init(&pPool->mutex, NULL);
+
+  if (pPool->qset == NULL || pPool->readWorker == NULL) return -1;
+  for (int i = 0; i < pPool->max; ++i) {
+    SReadWorker *pWorker = pPool->readWorker + i;
+    pWorker->workerId = i;
+    pWorker->pPool = pPool;
+  }
+
+  dInfo("dnode %s is opened, min worker:%d max worker:%d", pPool->name, pPool->min, pPool->max);
+  return 0;
+}
+
+static void dnodeCleanupReadPool(SReadWorkerPool *pPool) {
+  if (pPool->qset == NULL) return;
+
+  for (int i = 0; i < pPool->max; ++i) {
+    SReadWorker *pWorker = pPool->readWorker + i;
     if (pWorker->thread) {
-      taosQsetThreadResume(readQset);
+      taosQsetThreadResume(pPool->qset);
     }
   }
 
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
+  for (int i = 0; i < pPool->max; ++i) {
+    SReadWorker *pWorker = pPool->readWorker + i;
     if (pWorker->thread) {
       pthread_join(pWorker->thread, NULL);
     }
   }
 
-  free(readPool.readWorker);
-  taosCloseQset(readQset);
-  pthread_mutex_destroy(&readPool.mutex);
+  taosTFree(pPool->readWorker);
+  taosCloseQset(pPool->qset);
+  pPool->qset = NULL;
+  pthread_mutex_destroy(&pPool->mutex);
 
-  dInfo("dnode read is closed");
+  dInfo("dnode %s is closed", pPool->name);
 }
 
 void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
@@ -133,46 +164,59 @@ void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
 }
 
 void *dnodeAllocateVnodeRqueue(void *pVnode) {
-  pthread_mutex_lock(&readPool.mutex);
+  return dnodeAllocateReadQueue(&readPool, pVnode);
+}
+
+void dnodeFreeVnodeRqueue(void *rqueue) {
+  taosCloseQueue(rqueue);
+
+  // dynamically adjust the number of threads
+}
+
+void *dnodeAllocateVnodeLqueue(void *pVnode) {
+  if (longPool.qset == NULL) return NULL;
+  return dnodeAllocateReadQueue(&longPool, pVnode);
+}
+
+void dnodeFreeVnodeLqueue(void *lqueue) {
+  taosCloseQueue(lqueue);
+}
+
+static void *dnodeAllocateReadQueue(SReadWorkerPool *pPool, void *pVnode) {
+  pthread_mutex_lock(&pPool->mutex);
   taos_queue queue = taosOpenQueue();
   if (queue == NULL) {
-    pthread_mutex_unlock(&readPool.mutex);
+    pthread_mutex_unlock(&pPool->mutex);
     return NULL;
   }
 
-  taosAddIntoQset(readQset, queue, pVnode);
+  taosAddIntoQset(pPool->qset, queue, pVnode);
 
   // spawn a thread to process queue
-  if (readPool.num < readPool.max) {
+  if (pPool->num < pPool->max) {
     do {
-      SReadWorker *pWorker = readPool.readWorker + readPool.num;
+      SReadWorker *pWorker = pPool->readWorker + pPool->num;
 
       pthread_attr_t thAttr;
       pthread_attr_init(&thAttr);
       pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
 
       if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessReadQueue, pWorker) != 0) {
-        dError("failed to create thread to process read queue, reason:%s", strerror(errno));
+        dError("failed to create thread to process %s queue, reason:%s", pPool->name, strerror(errno));
       }
 
       pthread_attr_destroy(&thAttr);
-      readPool.num++;
-      dDebug("read worker:%d is launched, total:%d", pWorker->workerId, readPool.num);
-    } while (readPool.num < readPool.min);
+      pPool->num++;
+      dDebug("%s worker:%d is launched, total:%d", pPool->name, pWorker->workerId, pPool->num);
+    } while (pPool->num < pPool->min);
   }
 
-  pthread_mutex_unlock(&readPool.mutex);
-  dDebug("pVnode:%p, read queue:%p is allocated", pVnode, queue);
+  pthread_mutex_unlock(&pPool->mutex);
+  dDebug("pVnode:%p, %s queue:%p is allocated", pVnode, pPool->name, queue);
 
   return queue;
 }
 
-void dnodeFreeVnodeRqueue(void *rqueue) {
-  taosCloseQueue(rqueue);
-
-  // dynamically adjust the number of threads
-}
-
 void dnodeSendRpcReadRsp(void *pVnode, SReadMsg *pRead, int32_t code) {
   SRpcMsg rpcRsp = {
     .handle  = pRead->rpcMsg.handle,
@@ -192,12 +236,15 @@ void dnodeDispatchNonRspMsg(void *pVnode, SReadMsg *pRead, int32_t code) {
 }
 
 static void *dnodeProcessReadQueue(void *param) {
+  SReadWorker *pWorker = (SReadWorker *)param;
   SReadMsg    *pReadMsg;
   int          type;
   void        *pVnode;
 
+  taosPlaceThread(TAOS_THREAD_POOL_READ);
+
   while (1) {
-    if (taosReadQitemFromQset(readQset, &type, (void **)&pReadMsg, &pVnode) == 0) {
+    if (taosReadQitemFromQset(pWorker->pPool->qset, &type, (void **)&pReadMsg, &pVnode) == 0) {
       dDebug("dnodeProcessReadQueee: got no message from qset, exiting...");
       break;
     }
@@ -225,11 +272,12 @@ static void *dnodeProcessReadQueue(void *param) {
 
 UNUSED_FUNC
 static void dnodeHandleIdleReadWorker(SReadWorker *pWorker) {
-  int32_t num = taosGetQueueNumber(readQset);
+  SReadWorkerPool *pPool = pWorker->pPool;
+  int32_t          num = taosGetQueueNumber(pPool->qset);
 
-  if (num == 0 || (num <= readPool.min && readPool.num > readPool.min)) {
-    readPool.num--;
-    dDebug("read worker:%d is released, total:%d", pWorker->workerId, readPool.num);
+  if (num == 0 || (num <= pPool->min && pPool->num > pPool->min)) {
+    pPool->num--;
+    dDebug("%s worker:%d is released, total:%d", pPool->name, pWorker->workerId, pPool->num);
     pthread_exit(NULL);
   } else {
     usleep(30000);
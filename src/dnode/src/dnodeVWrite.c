@@ -28,12 +28,17 @@
 #include "dnodeInt.h"
 #include "dnodeVWrite.h"
 #include "dnodeMgmt.h"
+#include "tplacement.h"
 
 typedef struct {
   taos_qall  qall;
-  taos_qset  qset;      // queue set
   pthread_t  thread;    // thread
   int32_t    workerId;  // worker ID
+  int64_t    busyTime;  // time spent on processing messages, in microseconds
+  int64_t    numOfBatches;
+  int64_t    numOfMsgs;
+  int32_t    maxBatch;  // max number of messages processed in one batch
+  int64_t    statTime;  // the statistics are reported and reset periodically
 } SWriteWorker;
 
 typedef struct {
@@ -47,13 +52,18 @@ typedef struct {
 
 typedef struct {
   int32_t        max;        // max number of workers
-  int32_t        nextId;     // from 0 to max-1, cyclic
+  int32_t        num;        // number of launched workers
+  int8_t         stop;
+  taos_qset      qset;       // all write queues are shared by all workers
   SWriteWorker  *writeWorker;
   pthread_mutex_t mutex;
 } SWriteWorkerPool;
 
-static void *dnodeProcessWriteQueue(void *param);
-static void  dnodeHandleIdleWorker(SWriteWorker *pWorker);
+#define WRITE_WORKER_STAT_INTERVAL 60000000  // report the statistics of worker every 60 seconds
+
+static void   *dnodeProcessWriteQueue(void *param);
+static int32_t dnodeLaunchWriteWorkers();
+static void    dnodeUpdateWriteWorkerStat(SWriteWorker *pWorker, int32_t numOfMsgs, int64_t startTime);
 
 SWriteWorkerPool wWorkerPool;
 
@@ -61,6 +71,13 @@ int32_t dnodeInitVnodeWrite() {
   wWorkerPool.max = tsNumOfCores;
   wWorkerPool.writeWorker = (SWriteWorker *)calloc(sizeof(SWriteWorker), wWorkerPool.max);
   if (wWorkerPool.writeWorker == NULL) return -1;
+
+  wWorkerPool.qset = taosOpenQset();
+  if (wWorkerPool.qset == NULL) {
+    taosTFree(wWorkerPool.writeWorker);
+    return -1;
+  }
+
   pthread_mutex_init(&wWorkerPool.mutex, NULL);
 
   for (int32_t i = 0; i < wWorkerPool.max; ++i) {
@@ -72,22 +89,19 @@ int32_t dnodeInitVnodeWrite() {
 }
 
 void dnodeCleanupVnodeWrite() {
-  for (int32_t i = 0; i < wWorkerPool.max; ++i) {
-    SWriteWorker *pWorker = wWorkerPool.writeWorker + i;
-    if (pWorker->thread) {
-      taosQsetThreadResume(pWorker->qset);
-    }
+  wWorkerPool.stop = 1;
+
+  for (int32_t i = 0; i < wWorkerPool.num; ++i) {
+    taosQsetThreadResume(wWorkerPool.qset);
   }
 
-  for (int32_t i = 0; i < wWorkerPool.max; ++i) {
+  for (int32_t i = 0; i < wWorkerPool.num; ++i) {
     SWriteWorker *pWorker = wWorkerPool.writeWorker + i;
-    if (pWorker->thread) {
-      pthread_join(pWorker->thread, NULL);
-      taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
-    }
+    pthread_join(pWorker->thread, NULL);
+    taosFreeQall(pWorker->qall);
   }
 
+  taosCloseQset(wWorkerPool.qset);
   pthread_mutex_destroy(&wWorkerPool.mutex);
   free(wWorkerPool.writeWorker);
   dInfo("dnode write is closed");
@@ -128,62 +142,61 @@ void dnodeDispatchToVnodeWriteQueue(SRpcMsg *pMsg) {
   }
 }
 
+/*
+ * Every write queue is added into the qset shared by all workers, any idle worker picks up the next vnode that has
+ * messages, and a vnode is processed by one worker at a time, so the load of busy vnodes is spread over all workers
+ * instead of the worker the vnode is bound to.
+ */
 void *dnodeAllocateVnodeWqueue(void *pVnode) {
   pthread_mutex_lock(&wWorkerPool.mutex);
-  SWriteWorker *pWorker = wWorkerPool.writeWorker + wWorkerPool.nextId;
+
   void *queue = taosOpenQueue();
   if (queue == NULL) {
     pthread_mutex_unlock(&wWorkerPool.mutex);
     return NULL;
   }
 
-  if (pWorker->qset == NULL) {
-    pWorker->qset = taosOpenQset();
-    if (pWorker->qset == NULL) {
-      taosCloseQueue(queue);
-      pthread_mutex_unlock(&wWorkerPool.mutex);
-      return NULL;
-    }
-
-    taosAddIntoQset(pWorker->qset, queue, pVnode);
-    pWorker->qall = taosAllocateQall();
-    if (pWorker->qall == NULL) {
-      taosCloseQset(pWorker->qset);
-      taosCloseQueue(queue);
-      pthread_mutex_unlock(&wWorkerPool.mutex);
-      return NULL;
-    }
-    pthread_attr_t thAttr;
-    pthread_attr_init(&thAttr);
-    pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
-
-    if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessWriteQueue, pWorker) != 0) {
-      dError("failed to create thread to process read queue, reason:%s", strerror(errno));
-      taosFreeQall(pWorker->qall);
-      taosCloseQset(pWorker->qset);
-      taosCloseQueue(queue);
-      queue = NULL;
-    } else {
-      dDebug("write worker:%d is launched", pWorker->workerId);
-      wWorkerPool.nextId = (wWorkerPool.nextId + 1) % wWorkerPool.max;
-    }
-
-    pthread_attr_destroy(&thAttr);
-  } else {
-    taosAddIntoQset(pWorker->qset, queue, pVnode);
-    wWorkerPool.nextId = (wWorkerPool.nextId + 1) % wWorkerPool.max;
+  if (dnodeLaunchWriteWorkers() <= 0) {
+    taosCloseQueue(queue);
+    pthread_mutex_unlock(&wWorkerPool.mutex);
+    return NULL;
   }
 
+  taosAddIntoQset(wWorkerPool.qset, queue, pVnode);
+
   pthread_mutex_unlock(&wWorkerPool.mutex);
   dDebug("pVnode:%p, write queue:%p is allocated", pVnode, queue);
 
   return queue;
 }
 
+// launch a worker for each new vnode until the max number is reached, return the number of workers
+static int32_t dnodeLaunchWriteWorkers() {
+  if (wWorkerPool.num >= wWorkerPool.max) return wWorkerPool.num;
+
+  SWriteWorker *pWorker = wWorkerPool.writeWorker + wWorkerPool.num;
+  pWorker->qall = taosAllocateQall();
+  if (pWorker->qall == NULL) return wWorkerPool.num;
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessWriteQueue, pWorker) != 0) {
+    dError("failed to create thread to process write queue, reason:%s", strerror(errno));
+    taosFreeQall(pWorker->qall);
+    pWorker->qall = NULL;
+  } else {
+    dDebug("write worker:%d is launched", pWorker->workerId);
+    wWorkerPool.num++;
+  }
+
+  pthread_attr_destroy(&thAttr);
+  return wWorkerPool.num;
+}
+
 void dnodeFreeVnodeWqueue(void *wqueue) {
   taosCloseQueue(wqueue);
-
-  // dynamically adjust the number of threads
 }
 
 void dnodeSendRpcVnodeWriteRsp(void *pVnode, void *param, int32_t code) {
@@ -216,16 +229,27 @@ static void *dnodeProcessWriteQueue(void *param) {
   int           type;
   void         *pVnode, *item;
   SRspRet      *pRspRet;
+  taos_queue    queue;
+  int64_t       startTime;
 
+  taosPlaceThread(TAOS_THREAD_POOL_WRITE);
   dDebug("write worker:%d is running", pWorker->workerId);
+  pWorker->statTime = taosGetTimestampUs();
 
   while (1) {
-    numOfMsgs = taosReadAllQitemsFromQset(pWorker->qset, pWorker->qall, &pVnode);
+    numOfMsgs = taosAcquireAllQitemsFromQset(wWorkerPool.qset, pWorker->qall, &pVnode, &queue);
     if (numOfMsgs == 0) {
-      dDebug("dnodeProcessWriteQueee: got no message from qset, exiting...");
-      break;
+      if (wWorkerPool.stop) {
+        dDebug("write worker:%d got no message from qset, exiting...", pWorker->workerId);
+        break;
+      }
+
+      // the vnode which has messages is being processed by another worker
+      continue;
     }
 
+    startTime = taosGetTimestampUs();
+
     for (int32_t i = 0; i < numOfMsgs; ++i) {
       pWrite = NULL;
       pRspRet = NULL;
@@ -250,7 +274,10 @@ static void *dnodeProcessWriteQueue(void *param) {
       }
     }
 
-    walFsync(vnodeGetWal(pVnode));
+    int32_t fsyncCode = walFsync(vnodeGetWal(pVnode));
+
+    // the messages left in queue can be processed by other workers now, the vnode is still referenced by the items
+    taosReleaseQueue(queue);
 
     // browse all items, and process them one by one
     taosResetQitems(pWorker->qall);
@@ -258,10 +285,11 @@ static void *dnodeProcessWriteQueue(void *param) {
       taosGetQitem(pWorker->qall, &type, &item);
       if (type == TAOS_QTYPE_RPC) {
         pWrite = (SWriteMsg *)item;
+        if (fsyncCode != 0) pWrite->rpcMsg.code = fsyncCode;
         dnodeSendRpcVnodeWriteRsp(pVnode, item, pWrite->rpcMsg.code); 
       } else if (type == TAOS_QTYPE_FWD) {
         pHead = (SWalHead *)item;
-        vnodeConfirmForward(pVnode, pHead->version, 0);
+        vnodeConfirmForward(pVnode, pHead->version, fsyncCode);
         taosFreeQitem(item);
         vnodeRelease(pVnode);
       } else {
@@ -269,23 +297,33 @@ static void *dnodeProcessWriteQueue(void *param) {
         vnodeRelease(pVnode);
       }
     }
+
+    dnodeUpdateWriteWorkerStat(pWorker, numOfMsgs, startTime);
   }
 
   return NULL;
 }
 
-UNUSED_FUNC
-static void dnodeHandleIdleWorker(SWriteWorker *pWorker) {
-  int32_t num = taosGetQueueNumber(pWorker->qset);
+static void dnodeUpdateWriteWorkerStat(SWriteWorker *pWorker, int32_t numOfMsgs, int64_t startTime) {
+  int64_t now = taosGetTimestampUs();
 
-  if (num > 0) {
-     usleep(30000);
-     sched_yield();
-  } else {
-     taosFreeQall(pWorker->qall);
-     taosCloseQset(pWorker->qset);
-     pWorker->qset = NULL;
-     dDebug("write worker:%d is released", pWorker->workerId);
-     pthread_exit(NULL);
-  }
+  pWorker->busyTime += now - startTime;
+  pWorker->numOfBatches++;
+  pWorker->numOfMsgs += numOfMsgs;
+  if (numOfMsgs > pWorker->maxBatch) pWorker->maxBatch = numOfMsgs;
+
+  dTrace("write worker:%d, %d msgs are processed in %" PRId64 " us", pWorker->workerId, numOfMsgs, now - startTime);
+
+  int64_t elapsed = now - pWorker->statTime;
+  if (elapsed < WRITE_WORKER_STAT_INTERVAL) return;
+
+  dInfo("write worker:%d, utilization:%.1f%%, batches:%" PRId64 " msgs:%" PRId64 " avgBatch:%.1f maxBatch:%d",
+        pWorker->workerId, pWorker->busyTime * 100.0 / elapsed, pWorker->numOfBatches, pWorker->numOfMsgs,
+        (double)pWorker->numOfMsgs / pWorker->numOfBatches, pWorker->maxBatch);
+
+  pWorker->busyTime = 0;
+  pWorker->numOfBatches = 0;
+  pWorker->numOfMsgs = 0;
+  pWorker->maxBatch = 0;
+  pWorker->statTime = now;
 }
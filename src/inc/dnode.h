@@ -26,6 +26,7 @@ typedef struct {
   int32_t queryReqNum;
   int32_t submitReqNum;
   int32_t httpReqNum;
+  int32_t throttledReqNum;  // submit requests throttled for the memory pressure of vnodes
 } SDnodeStatisInfo;
 
 typedef enum {
@@ -53,6 +54,8 @@ void *dnodeAllocateVnodeWqueue(void *pVnode);
 void  dnodeFreeVnodeWqueue(void *queue);
 void *dnodeAllocateVnodeRqueue(void *pVnode);
 void  dnodeFreeVnodeRqueue(void *rqueue);
+void *dnodeAllocateVnodeLqueue(void *pVnode);
+void  dnodeFreeVnodeLqueue(void *lqueue);
 void  dnodeSendRpcVnodeWriteRsp(void *pVnode, void *param, int32_t code);
 
 int32_t dnodeAllocateMnodePqueue();
@@ -69,6 +69,20 @@ int32_t qDumpRetrieveResult(qinfo_t qinfo, SRetrieveTableRsp** pRsp, int32_t* co
  */
 void* qGetResultRetrieveMsg(qinfo_t qinfo);
 
+/**
+ * the query gives up the thread after its time slice runs out, no result is ready and it needs to be executed again
+ * @param qinfo
+ * @return
+ */
+bool qIsQueryYielded(qinfo_t qinfo);
+
+/**
+ * the query is long if it has run out of a time slice, or has scanned many blocks
+ * @param qinfo
+ * @return
+ */
+bool qIsLongQuery(qinfo_t qinfo);
+
 /**
  * kill current ongoing query and free query handle automatically
  * @param qinfo  qhandle
@@ -79,7 +79,15 @@ typedef struct TAOS_BIND {
   int *          error;        // unused
 } TAOS_BIND;
 
+// the layout of the data sent by an insert statement, the columnar ones need the server to support them
+typedef enum {
+  TAOS_STMT_FORMAT_ROW,
+  TAOS_STMT_FORMAT_COL,             // column by column with a null bitmap
+  TAOS_STMT_FORMAT_COL_COMPRESSED,  // column by column, the values are compressed by the codec of the column type
+} TAOS_STMT_FORMAT;
+
 TAOS_STMT *taos_stmt_init(TAOS *taos);
+int        taos_stmt_set_format(TAOS_STMT *stmt, int format);
 int        taos_stmt_prepare(TAOS_STMT *stmt, const char *sql, unsigned long length);
 int        taos_stmt_bind_param(TAOS_STMT *stmt, TAOS_BIND *bind);
 int        taos_stmt_add_batch(TAOS_STMT *stmt);
@@ -257,6 +257,8 @@ void tsDataSwap(void *pLeft, void *pRight, int32_t type, int32_t size);
 #define TSDB_CLUSTER_ID_LEN       40
 #define TSDB_FQDN_LEN             128
 #define TSDB_EP_LEN               (TSDB_FQDN_LEN+6)
+#define TSDB_CORE_LIST_LEN        64   // list of cores like "0-3,8"
+#define TSDB_PLACEMENT_LEN        128  // placement of the thread pools of a dnode
 #define TSDB_IPv4ADDR_LEN      	  16
 #define TSDB_FILENAME_LEN         128
 #define TSDB_METER_VNODE_BITS     20
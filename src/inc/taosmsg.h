@@ -193,7 +193,8 @@ typedef struct SMsgHead {
 typedef struct SSubmitBlk {
   uint64_t uid;        // table unique id
   int32_t  tid;        // table id
-  int32_t  padding;    // TODO just for padding here
+  int16_t  format;     // TSDB_SUBMIT_BLK_ROW or TSDB_SUBMIT_BLK_COL
+  int16_t  padding;    // TODO just for padding here
   int32_t  sversion;   // data schema version
   int32_t  dataLen;    // data part length, not including the SSubmitBlk head
   int32_t  schemaLen;  // schema length, if length is 0, no schema exists
@@ -201,6 +202,19 @@ typedef struct SSubmitBlk {
   char     data[];
 } SSubmitBlk;
 
+#define TSDB_SUBMIT_BLK_ROW 0  // data part is a series of SDataRow
+#define TSDB_SUBMIT_BLK_COL 1  // data part is a SSubmitColHead, null bitmap and values for each column of the schema
+
+// Column head of a columnar submit block, the null bitmap of numOfRows bits follows. The values of a fixed length
+// column are stored for all rows, the values of a binary or nchar column are stored for the non-null rows only.
+typedef struct SSubmitColHead {
+  int16_t colId;
+  int8_t  type;
+  int8_t  comp;    // NO_COMPRESSION or ONE_STAGE_COMP
+  int32_t rawLen;  // length of the values before compression
+  int32_t len;     // length of the values in the block
+} SSubmitColHead;
+
 // Submit message for this TSDB
 typedef struct SSubmitMsg {
   SMsgHead   header;
@@ -225,6 +239,11 @@ typedef struct {
   SShellSubmitRspBlock failedBlocks[];
 } SShellSubmitRspMsg;
 
+// the response of the write rejected with TSDB_CODE_VND_WRITE_THROTTLED
+typedef struct {
+  int32_t delay;  // suggested delay before the write is retried, in milliseconds
+} SWriteThrottleRspMsg;
+
 typedef struct SSchema {
   uint8_t type;
   char    name[TSDB_COL_NAME_LEN];
@@ -593,6 +612,7 @@ typedef struct {
   uint8_t     alternativeRole;
   uint8_t     reserve2[15];
   SClusterCfg clusterCfg;
+  char        placement[TSDB_PLACEMENT_LEN];  // cores of the thread pools
   SVnodeLoad  load[];
 } SDMStatusMsg;
 
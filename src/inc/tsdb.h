@@ -146,6 +146,48 @@ STableInfo *tsdbGetTableInfo(TSDB_REPO_T *pRepo, STableId tid);
  */
 int32_t tsdbInsertData(TSDB_REPO_T *repo, SSubmitMsg *pMsg, SShellSubmitRspMsg *pRsp);
 
+// the pressure of the memory buffer of a repository
+#define TSDB_BUF_PRESSURE_NONE 0
+#define TSDB_BUF_PRESSURE_HIGH 1  // the writes would wait for a commit or a free buffer block
+
+typedef struct {
+  int8_t  level;
+  int32_t delay;        // suggested delay of new writes in milliseconds, 0 if no delay is needed
+  int32_t totalBlocks;  // blocks of the buffer pool
+  int32_t freeBlocks;   // free blocks in the buffer pool
+  int32_t memBlocks;    // blocks used by the memtable being written
+  int64_t extraBytes;   // bytes of the memtable allocated out of the buffer pool
+  int8_t  committing;
+} STsdbBufPressure;
+
+/**
+ * Get the pressure of the memory buffer, so that the writes can be delayed before they block in the repository
+ */
+void tsdbGetBufPressure(TSDB_REPO_T *repo, STsdbBufPressure *pPressure);
+
+/**
+ * Init the memory budget shared by the buffer pools of all the repositories in the dnode. Besides the blocks
+ * configured for it, a repository borrows blocks from the budget when its memtable is full, and the memtables holding
+ * most borrowed blocks are asked to commit when the budget runs low.
+ *
+ * @param budget  bytes of the budget, 0 if the repositories do not share the memory
+ */
+int  tsdbInitBufMgr(int64_t budget);
+void tsdbCleanupBufMgr();
+
+// the placement of the buffer pools of all the repositories, see memtableHugePage and memtableNumaBind
+typedef struct {
+  int64_t regionBytes;     // bytes of the buffer pools mapped in regions
+  int64_t hugePageBytes;   // bytes of the regions backed by huge pages
+  int64_t numaBoundBytes;  // bytes of the regions bound to a NUMA node
+  int64_t prefaultMs;      // time spent to pre-fault the regions
+  int64_t numaRebinds;     // times the regions are moved to another NUMA node
+  int64_t localBlocks;     // blocks taken by the write threads on the NUMA node of the region
+  int64_t remoteBlocks;    // blocks taken by the write threads on other NUMA nodes
+} STsdbBufPoolStatis;
+
+void tsdbGetBufPoolStatis(STsdbBufPoolStatis *pStatis);
+
 // -- FOR QUERY TIME SERIES DATA
 
 typedef void *TsdbQueryHandleT;  // Use void to hide implementation details
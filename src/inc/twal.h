@@ -38,6 +38,7 @@ typedef struct {
   int32_t   fsyncPeriod; // millisecond
   int8_t    wals;      // number of WAL files;
   int8_t    keep;      // keep the wal file when closed
+  int8_t    groupCommit; // records are written by walFsync in batch, and fsync is coalesced by a shared flusher
 } SWalCfg;
 
 typedef void* twalh;  // WAL HANDLE
@@ -47,7 +48,7 @@ twalh   walOpen(const char *path, const SWalCfg *pCfg);
 void    walClose(twalh);
 int     walRenew(twalh);
 int     walWrite(twalh, SWalHead *);
-void    walFsync(twalh);
+int     walFsync(twalh);
 int     walRestore(twalh, void *pVnode, FWalWrite writeFp);
 int     walGetWalFile(twalh, char *name, uint32_t *index);
 
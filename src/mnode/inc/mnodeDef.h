@@ -70,6 +70,7 @@ typedef struct SDnodeObj {
   int16_t    memoryAvgUsage;   // calc from sys.mem
   int16_t    bandwidthUsage;   // calc from sys.band
   int8_t     reserved2[2];
+  char       placement[TSDB_PLACEMENT_LEN];  // from dnode status msg
 } SDnodeObj;
 
 typedef struct SMnodeObj {
@@ -74,6 +74,9 @@ extern "C" {
 #define TAOS_OS_FUNC_FILE_SENDIFLE
   #define taosFSendFile(outfile, infile, offset, count) taosFSendFileImp(outfile, infile, offset, size)
   #define taosTSendFile(dfd, sfd, offset, size) taosTSendFileImp(dfd, sfd, offset, size)
+#define TAOS_OS_FUNC_FILE_FALLOCATE
+
+#define TAOS_OS_FUNC_MEMORY_REGION
 
 #define TAOS_OS_FUNC_SEMPHONE
   #define tsem_t dispatch_semaphore_t
@@ -85,6 +88,7 @@ extern "C" {
 #define TAOS_OS_FUNC_SOCKET_SETSOCKETOPT
 #define TAOS_OS_FUNC_STRING_STR2INT64
 #define TAOS_OS_FUNC_SYSINFO
+#define TAOS_OS_FUNC_SYSINFO_AFFINITY
 #define TAOS_OS_FUNC_TIMER
 
 // specific
@@ -72,6 +72,10 @@ void taosGetTmpfilePath(const char *fileNamePrefix, char *dstPath);
   #define taosFtruncate ftruncate
 #endif
 
+// TAOS_OS_FUNC_FILE_FALLOCATE
+// allocate disk space for the range without changing the file size, 0 is returned if not supported
+int32_t taosFallocate(int fd, int64_t offset, int64_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,6 +46,24 @@ void   taosTMemset(void *ptr, int c);
     }                    \
   } while (0);
 
+// TAOS_OS_FUNC_MEMORY_REGION
+#define TAOS_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef enum {
+  TAOS_HUGE_PAGE_NONE = 0,
+  TAOS_HUGE_PAGE_TRANSPARENT = 1,
+  TAOS_HUGE_PAGE_EXPLICIT = 2
+} ETaosHugePageMode;
+
+// the size of the region must be a multiple of TAOS_HUGE_PAGE_SIZE, the huge page mode taken is set in pHugePage
+void *  taosMapRegion(size_t size, int32_t hugePage, int32_t *pHugePage);
+void    taosUnmapRegion(void *addr, size_t size);
+void    taosPrefaultRegion(void *addr, size_t size);
+// the NUMA node of the CPU the caller runs on, -1 if unknown
+int32_t taosGetNumaNode();
+// prefer the node for the pages faulted in later, and move the pages already faulted in if move is set
+int32_t taosBindRegionToNode(void *addr, size_t size, int32_t node, bool move);
+
 #define taosMalloc(size) malloc(size)
 #define taosCalloc(num, size) calloc(num, size)
 #define taosRealloc(ptr, size) realloc(ptr, size)
@@ -36,6 +36,16 @@ bool taosGetSystemUid(char *uid);
 // TAOS_OS_FUNC_SYSINFO_CORE
 void taosSetCoreDump();
 
+// TAOS_OS_FUNC_SYSINFO_AFFINITY
+#define TAOS_MAX_CPU_CORES 1024
+
+// bind the calling thread to the cores, 0 is returned if it is not supported
+int32_t taosSetThreadAffinity(const int32_t *cores, int32_t numOfCores);
+// the cores the calling thread may run on, -1 if it is not supported
+int32_t taosGetThreadAffinity(int32_t *cores, int32_t maxCores);
+// the NUMA node of the core, -1 if unknown
+int32_t taosGetNumaNodeOfCore(int32_t core);
+
 #ifdef __cplusplus
 }
 #endif
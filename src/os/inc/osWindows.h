@@ -69,6 +69,9 @@ extern "C" {
 #define TAOS_OS_FUNC_FILE_GETTMPFILEPATH
 #define TAOS_OS_FUNC_FILE_FTRUNCATE
   extern int taosFtruncate(int fd, int64_t length); 
+#define TAOS_OS_FUNC_FILE_FALLOCATE
+
+#define TAOS_OS_FUNC_MEMORY_REGION
 
 #define TAOS_OS_FUNC_MATH
   #define SWAP(a, b, c)      \
@@ -111,6 +114,7 @@ char *stpcpy (char *dest, const char *src);
 char *stpncpy (char *dest, const char *src, size_t n);
 
 #define TAOS_OS_FUNC_SYSINFO
+#define TAOS_OS_FUNC_SYSINFO_AFFINITY
 
 #define TAOS_OS_FUNC_TIME_DEF
   #ifdef _TD_GO_DLL_
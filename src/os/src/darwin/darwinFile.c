@@ -57,4 +57,8 @@ int taosFSendFileImp(FILE* out_file, FILE* in_file, int64_t* offset, int32_t cou
 ssize_t taosTSendFileImp(int dfd, int sfd, off_t *offset, size_t size) {
   uError("not implemented yet");
   return -1;
-}
\ No newline at end of file
+}
+
+int32_t taosFallocate(int fd, int64_t offset, int64_t len) {
+  return 0;
+}
@@ -101,4 +101,10 @@ int taosSystem(const char *cmd) {
   return -1;
 }
 
-void taosSetCoreDump() {}
\ No newline at end of file
+void taosSetCoreDump() {}
+
+int32_t taosSetThreadAffinity(const int32_t *cores, int32_t numOfCores) { return 0; }
+
+int32_t taosGetThreadAffinity(int32_t *cores, int32_t maxCores) { return -1; }
+
+int32_t taosGetNumaNodeOfCore(int32_t core) { return -1; }
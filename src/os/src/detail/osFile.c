@@ -14,6 +14,7 @@
  */
 
 #define _DEFAULT_SOURCE
+#define _GNU_SOURCE
 #include "os.h"
 
 #ifndef TAOS_OS_FUNC_FILE_GETTMPFILEPATH
@@ -134,4 +135,16 @@ ssize_t taosTSendFileImp(int dfd, int sfd, off_t *offset, size_t size) {
 
   return size;
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifndef TAOS_OS_FUNC_FILE_FALLOCATE
+int32_t taosFallocate(int fd, int64_t offset, int64_t len) {
+  if (fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)len) < 0) {
+    // the file system does not support it, no space is allocated in advance
+    if (errno == EOPNOTSUPP || errno == ENOSYS) return 0;
+    return -1;
+  }
+
+  return 0;
+}
+#endif
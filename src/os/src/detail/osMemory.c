@@ -516,4 +516,87 @@ void taosTZfree(void *ptr) {
   if (ptr) {
     free((void *)((char *)ptr - sizeof(size_t)));
   }
-}
\ No newline at end of file
+}
+
+#ifndef TAOS_OS_FUNC_MEMORY_REGION
+
+#define TAOS_MPOL_PREFERRED 1
+#define TAOS_MPOL_MF_MOVE (1 << 1)
+#define TAOS_MAX_NUMA_NODES 64
+
+void *taosMapRegion(size_t size, int32_t hugePage, int32_t *pHugePage) {
+  *pHugePage = TAOS_HUGE_PAGE_NONE;
+
+#ifdef MAP_HUGETLB
+  if (hugePage == TAOS_HUGE_PAGE_EXPLICIT) {
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      *pHugePage = TAOS_HUGE_PAGE_EXPLICIT;
+      return addr;
+    }
+    // no huge pages are reserved, try the transparent ones
+    uWarn("failed to map %zu bytes of explicit huge pages, reason:%s", size, strerror(errno));
+  }
+#endif
+
+  if (hugePage == TAOS_HUGE_PAGE_NONE) {
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (addr == MAP_FAILED) ? NULL : addr;
+  }
+
+  // the transparent huge pages are only taken by the ranges aligned to the huge page size
+  size_t mapSize = size + TAOS_HUGE_PAGE_SIZE;
+  char * base = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) return NULL;
+
+  char * addr = (char *)(((uintptr_t)base + TAOS_HUGE_PAGE_SIZE - 1) & ~((uintptr_t)TAOS_HUGE_PAGE_SIZE - 1));
+  size_t head = addr - base;
+  size_t tail = mapSize - head - size;
+  if (head > 0) munmap(base, head);
+  if (tail > 0) munmap(addr + size, tail);
+
+#ifdef MADV_HUGEPAGE
+  if (madvise(addr, size, MADV_HUGEPAGE) == 0) {
+    *pHugePage = TAOS_HUGE_PAGE_TRANSPARENT;
+  } else {
+    uWarn("failed to advise %zu bytes of transparent huge pages, reason:%s", size, strerror(errno));
+  }
+#endif
+
+  return addr;
+}
+
+void taosUnmapRegion(void *addr, size_t size) {
+  if (addr != NULL) munmap(addr, size);
+}
+
+void taosPrefaultRegion(void *addr, size_t size) {
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize <= 0) pageSize = 4096;
+
+  for (size_t offset = 0; offset < size; offset += pageSize) {
+    ((volatile char *)addr)[offset] = 0;
+  }
+}
+
+int32_t taosGetNumaNode() {
+#ifdef SYS_getcpu
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) return (int32_t)node;
+#endif
+  return -1;
+}
+
+int32_t taosBindRegionToNode(void *addr, size_t size, int32_t node, bool move) {
+#ifdef SYS_mbind
+  if (node < 0 || node >= TAOS_MAX_NUMA_NODES) return 0;
+
+  unsigned long nodeMask[2] = {1UL << node, 0};
+  return (int32_t)syscall(SYS_mbind, addr, size, TAOS_MPOL_PREFERRED, nodeMask, TAOS_MAX_NUMA_NODES + 1,
+                          move ? TAOS_MPOL_MF_MOVE : 0);
+#else
+  return 0;
+#endif
+}
+
+#endif
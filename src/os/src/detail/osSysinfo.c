@@ -658,4 +658,51 @@ bool taosGetSystemUid(char *uid) {
   return false;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+#ifndef TAOS_OS_FUNC_SYSINFO_AFFINITY
+
+int32_t taosSetThreadAffinity(const int32_t *cores, int32_t numOfCores) {
+  uint64_t mask[TAOS_MAX_CPU_CORES / 64] = {0};
+
+  for (int32_t i = 0; i < numOfCores; ++i) {
+    if (cores[i] < 0 || cores[i] >= TAOS_MAX_CPU_CORES) continue;
+    mask[cores[i] / 64] |= (1ULL << (cores[i] % 64));
+  }
+
+  // the pid 0 is the calling thread
+  return (int32_t)syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask);
+}
+
+int32_t taosGetThreadAffinity(int32_t *cores, int32_t maxCores) {
+  uint64_t mask[TAOS_MAX_CPU_CORES / 64] = {0};
+
+  if (syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask) < 0) return -1;
+
+  int32_t num = 0;
+  for (int32_t core = 0; core < TAOS_MAX_CPU_CORES && num < maxCores; ++core) {
+    if (mask[core / 64] & (1ULL << (core % 64))) cores[num++] = core;
+  }
+
+  return num;
+}
+
+int32_t taosGetNumaNodeOfCore(int32_t core) {
+  char path[64] = {0};
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", core);
+
+  DIR *dir = opendir(path);
+  if (dir == NULL) return -1;
+
+  int32_t        node = -1;
+  struct dirent *de = NULL;
+  while ((de = readdir(dir)) != NULL) {
+    if (strncmp(de->d_name, "node", 4) == 0 && sscanf(de->d_name + 4, "%d", &node) == 1) break;
+    node = -1;
+  }
+
+  closedir(dir);
+  return node;
+}
+
+#endif
@@ -83,4 +83,8 @@ ssize_t taosTSendFileImp(int dfd, int sfd, off_t *offset, size_t size) {
 int taosFtruncate(int fd, int64_t length) {
   uError("taosFtruncate no implemented yet");
   return 0;
-}
\ No newline at end of file
+}
+
+int32_t taosFallocate(int fd, int64_t offset, int64_t len) {
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+// the regions are not mapped, the callers allocate the memory from the heap
+void *taosMapRegion(size_t size, int32_t hugePage, int32_t *pHugePage) {
+  *pHugePage = TAOS_HUGE_PAGE_NONE;
+  return NULL;
+}
+
+void taosUnmapRegion(void *addr, size_t size) {}
+
+void taosPrefaultRegion(void *addr, size_t size) {}
+
+int32_t taosGetNumaNode() { return -1; }
+
+int32_t taosBindRegionToNode(void *addr, size_t size, int32_t node, bool move) { return 0; }
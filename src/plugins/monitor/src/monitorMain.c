@@ -21,6 +21,7 @@
 #include "ttimer.h"
 #include "tutil.h"
 #include "tsystem.h"
+#include "tslab.h"
 #include "tscUtil.h"
 #include "tsclient.h"
 #include "dnode.h"
@@ -44,6 +45,10 @@ typedef enum {
   MONITOR_CMD_CREATE_MT_DN,
   MONITOR_CMD_CREATE_MT_ACCT,
   MONITOR_CMD_CREATE_TB_DN,
+  MONITOR_CMD_CREATE_MT_SLAB,
+  MONITOR_CMD_CREATE_TB_SLAB,
+  MONITOR_CMD_CREATE_MT_THROTTLE,
+  MONITOR_CMD_CREATE_TB_THROTTLE,
   MONITOR_CMD_CREATE_TB_ACCT_ROOT,
   MONITOR_CMD_CREATE_TB_SLOWQUERY,
   MONITOR_CMD_MAX
@@ -166,6 +171,23 @@ static void dnodeBuildMonitorSql(char *sql, int32_t cmd) {
   } else if (cmd == MONITOR_CMD_CREATE_TB_DN) {
     snprintf(sql, SQL_LENGTH, "create table if not exists %s.dn%d using %s.dn tags(%d, '%s')", tsMonitorDbName,
              dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_SLAB) {
+    int32_t pos = snprintf(sql, SQL_LENGTH, "create table if not exists %s.slab(ts timestamp", tsMonitorDbName);
+    for (int8_t module = 0; module < TAOS_SLAB_MAX_MODULES; ++module) {
+      pos += snprintf(sql + pos, SQL_LENGTH - pos, ", %s_kb bigint", taosSlabModuleName(module));
+    }
+    snprintf(sql + pos, SQL_LENGTH - pos, ", pooled_kb bigint) tags (dnodeid int, fqdn binary(%d))", TSDB_FQDN_LEN);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_SLAB) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.slab_dn%d using %s.slab tags(%d, '%s')", tsMonitorDbName,
+             dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MONITOR_CMD_CREATE_MT_THROTTLE) {
+    // the monitor tables can not be altered, so the throttled requests are not added into the dn table
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.throttle(ts timestamp, req_throttled int) tags (dnodeid int, fqdn binary(%d))",
+             tsMonitorDbName, TSDB_FQDN_LEN);
+  } else if (cmd == MONITOR_CMD_CREATE_TB_THROTTLE) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.throttle_dn%d using %s.throttle tags(%d, '%s')",
+             tsMonitorDbName, dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
   } else if (cmd == MONITOR_CMD_CREATE_MT_ACCT) {
     snprintf(sql, SQL_LENGTH,
              "create table if not exists %s.acct(ts timestamp "
@@ -307,9 +329,8 @@ static int32_t monitorBuildBandSql(char *sql) {
   return sprintf(sql, ", %f", bandSpeedKb);
 }
 
-static int32_t monitorBuildReqSql(char *sql) {
-  SDnodeStatisInfo info = dnodeGetStatisInfo(); 
-  return sprintf(sql, ", %d, %d, %d)", info.httpReqNum, info.queryReqNum, info.submitReqNum);
+static int32_t monitorBuildReqSql(char *sql, SDnodeStatisInfo *pInfo) {
+  return sprintf(sql, ", %d, %d, %d)", pInfo->httpReqNum, pInfo->queryReqNum, pInfo->submitReqNum);
 }
 
 static int32_t monitorBuildIoSql(char *sql) {
@@ -322,6 +343,32 @@ static int32_t monitorBuildIoSql(char *sql) {
   return sprintf(sql, ", %f, %f", readKB, writeKB);
 }
 
+// the memory of the RPC messages and the queue items allocated from the slab, see tslab.h
+static void monitorSaveSlabInfo(int64_t ts) {
+  char        sql[SQL_LENGTH + 1] = {0};
+  SSlabStatis statis;
+  taosSlabGetStatis(&statis);
+
+  int32_t pos = snprintf(sql, SQL_LENGTH, "insert into %s.slab_dn%d values(%" PRId64, tsMonitorDbName,
+                         dnodeGetDnodeId(), ts);
+  for (int8_t module = 0; module < TAOS_SLAB_MAX_MODULES; ++module) {
+    pos += snprintf(sql + pos, SQL_LENGTH - pos, ", %" PRId64, statis.liveBytes[module] / 1024);
+  }
+  snprintf(sql + pos, SQL_LENGTH - pos, ", %" PRId64 ")", statis.pooledBytes / 1024);
+
+  monitorDebug("monitor:%p, save slab info, sql:%s", tsMonitorConn.conn, sql);
+  taos_query_a(tsMonitorConn.conn, sql, dnodeMontiorLogCallback, "slab");
+}
+
+static void monitorSaveThrottleInfo(int64_t ts, int32_t throttledReqNum) {
+  char sql[SQL_LENGTH + 1] = {0};
+  snprintf(sql, SQL_LENGTH, "insert into %s.throttle_dn%d values(%" PRId64 ", %d)", tsMonitorDbName,
+           dnodeGetDnodeId(), ts, throttledReqNum);
+
+  monitorDebug("monitor:%p, save throttle info, sql:%s", tsMonitorConn.conn, sql);
+  taos_query_a(tsMonitorConn.conn, sql, dnodeMontiorLogCallback, "throttle");
+}
+
 static void monitorSaveSystemInfo() {
   if (tsMonitorConn.state != MONITOR_STATE_INITIALIZED) {
     monitorStartTimer();
@@ -337,11 +384,16 @@ static void monitorSaveSystemInfo() {
   pos += monitorBuildDiskSql(sql + pos);
   pos += monitorBuildBandSql(sql + pos);
   pos += monitorBuildIoSql(sql + pos);
-  pos += monitorBuildReqSql(sql + pos);
+
+  SDnodeStatisInfo info = dnodeGetStatisInfo();
+  pos += monitorBuildReqSql(sql + pos, &info);
 
   monitorDebug("monitor:%p, save system info, sql:%s", tsMonitorConn.conn, sql);
   taos_query_a(tsMonitorConn.conn, sql, dnodeMontiorLogCallback, "sys");
 
+  monitorSaveSlabInfo(ts);
+  monitorSaveThrottleInfo(ts, info.throttledReqNum);
+
   if (tsMonitorConn.timer != NULL && tsMonitorConn.state != MONITOR_STATE_STOPPED) {
     monitorStartTimer();
   }
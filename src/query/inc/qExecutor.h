@@ -24,6 +24,7 @@
 #include "qTsbuf.h"
 #include "query.h"
 #include "taosdef.h"
+#include "tarena.h"
 #include "tarray.h"
 #include "tlockfree.h"
 #include "tsdb.h"
@@ -81,6 +82,30 @@ typedef struct SWindowResInfo {
   int64_t        threshold;  // threshold to halt query and return the generated results.
 } SWindowResInfo;
 
+typedef struct SPaneResult {
+  SResultInfo* resultInfo;  // intermediate result of the pane, one for each output column
+  char*        pOutput;     // output buffer of the pane
+} SPaneResult;
+
+/*
+ * Sliding window query is evaluated pane by pane, and each pane covers rows of one sliding time range. The rows
+ * in one pane are aggregated only once. The panes of the time windows that are not completed yet are kept in two
+ * stacks: the panes are pushed to the back stack and its aggregate is maintained, and when the front stack is empty,
+ * the back stack is moved to it as the suffix aggregates, so the oldest pane is evicted by a pop. Each time window
+ * is then merged from the front top and the back aggregate only.
+ */
+typedef struct SSlidingPaneInfo {
+  bool         enabled;      // functions in this query are all able to be composed from panes
+  int32_t      numOfPanes;   // number of panes in one time window, intervalTime/slidingTime
+  int32_t      numOfBack;    // panes in the back stack, the last one is current pane
+  int32_t      numOfFront;   // panes in the front stack, the last one is the oldest pane
+  TSKEY*       paneKey;      // start key of each pane in the back stack, followed by the front stack
+  SPaneResult* pResult;      // the back stack, the front stack and the aggregate of the back stack
+  TSKEY        lastPaneKey;  // start key of the last pane in current data block
+  TSKEY        nextWinKey;   // start key of the next time window to be merged from panes
+  char*        buf;          // buffer of all pane results
+} SSlidingPaneInfo;
+
 typedef struct SColumnFilterElem {
   int16_t           bytes;  // column length
   __filter_func_t   fp;
@@ -122,6 +147,7 @@ typedef struct SQueryCostInfo {
   uint32_t discardBlocks;
   uint64_t elapsedTime;
   uint64_t computTime;
+  uint32_t numOfSlices;  // times the query yields the thread after its time slice runs out
 } SQueryCostInfo;
 
 typedef struct SQuery {
@@ -163,6 +189,7 @@ typedef struct SQueryRuntimeEnv {
   uint16_t             scanFlag;         // denotes reversed scan of data or not
   SFillInfo*           pFillInfo;
   SWindowResInfo       windowResInfo;
+  SSlidingPaneInfo     paneInfo;         // pane based aggregation for sliding window query
   STSBuf*              pTSBuf;
   STSCursor            cur;
   SQueryCostInfo       summary;
@@ -175,6 +202,7 @@ typedef struct SQueryRuntimeEnv {
   int32_t              interBufSize;     // intermediate buffer sizse
   int32_t              prevGroupId;      // previous executed group id
   SDiskbasedResultBuf* pResultBuf;       // query result buffer based on blocked-wised disk file
+  int64_t              percentileMemBudget;  // bytes left for the values kept in memory by percentile of all groups
 } SQueryRuntimeEnv;
 
 enum {
@@ -206,10 +234,14 @@ typedef struct SQInfo {
   int32_t          tableIndex;
   int32_t          numOfGroupResultPages;
   void*            pBuf;        // allocated buffer for STableQueryInfo, sizeof(STableQueryInfo)*numOfTables;
+  SArena*          pArena;      // objects of the query decoded from the query msg, released with the query
 
   pthread_mutex_t  lock;        // used to synchronize the rsp/query threads
   int32_t          dataReady;   // denote if query result is ready or not
   void*            rspContext;  // response context
+
+  int64_t          sliceStart;  // ms, when the query takes the thread
+  int8_t           yielded;     // the scan is suspended to give up the thread, and continues in the next execution
 } SQInfo;
 
 #endif  // TDENGINE_QUERYEXECUTOR_H
@@ -87,6 +87,9 @@ typedef struct SColumnModel {
   SSchemaEx *pFields;
 } SColumnModel;
 
+#define COLMODEL_GET_VAL(data, schema, allrow, rowId, colId) \
+  (data + (schema)->pFields[colId].offset * (allrow) + (rowId) * (schema)->pFields[colId].field.bytes)
+
 typedef struct SColumnOrderInfo {
   int32_t numOfCols;
   int16_t pData[];
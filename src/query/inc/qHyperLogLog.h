@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_HYPERLOGLOG_H
+#define TDENGINE_HYPERLOGLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 2^12 registers of one byte, the standard error is 1.04 / sqrt(2^12), about 1.6% */
+#define HLL_BUCKET_BITS 12
+#define HLL_BUCKETS     (1 << HLL_BUCKET_BITS)
+
+/* the registers are the whole state, so it can be copied and transferred directly */
+typedef struct SHyperLogLog {
+  uint8_t buckets[HLL_BUCKETS];
+} SHyperLogLog;
+
+uint64_t tHLLHash(const void *data, int32_t len);
+
+void    tHLLAdd(SHyperLogLog *pHLL, const void *data, int32_t len);
+void    tHLLAddHash(SHyperLogLog *pHLL, uint64_t hash);
+void    tHLLMerge(SHyperLogLog *pHLL, const SHyperLogLog *pOther);
+int64_t tHLLCount(const SHyperLogLog *pHLL);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_HYPERLOGLOG_H
@@ -16,6 +16,10 @@
 #ifndef TDENGINE_QPERCENTILE_H
 #define TDENGINE_QPERCENTILE_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "qExtbuffer.h"
 
 typedef struct MinMaxEntry {
@@ -58,11 +62,21 @@ typedef struct tMemBucket {
   
   MinMaxEntry nRange;
   
+  /*
+   * all values are kept in a compact typed array until the number of values exceeds maxInMemElems, and the exact
+   * percentile is calculated by selection. Otherwise, the values are moved into the disk-based buckets.
+   */
+  int32_t  maxInMemElems;
+  int32_t  inMemCapacity;
+  char *   pInMemBuf;
+  int64_t *pMemBudget;  // bytes left of the budget shared by the buckets of a query, the array is reserved from it
+  int64_t  ownBudget;   // the budget of the bucket if it is not given one
+  
   void (*HashFunc)(struct tMemBucket *pBucket, void *value, int16_t *segIdx, int16_t *slotIdx);
 } tMemBucket;
 
 tMemBucket *tMemBucketCreate(int32_t totalSlots, int32_t nBufferSize, int16_t nElemSize, int16_t dataType,
-                             tOrderDescriptor *pDesc);
+                             tOrderDescriptor *pDesc, int64_t *pMemBudget);
 
 void tMemBucketDestroy(tMemBucket *pBucket);
 
@@ -74,4 +88,8 @@ void tBucketIntHash(tMemBucket *pBucket, void *value, int16_t *segIdx, int16_t *
 
 void tBucketDoubleHash(tMemBucket *pBucket, void *value, int16_t *segIdx, int16_t *slotIdx);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif  // TDENGINE_QPERCENTILE_H
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QSORT_H
+#define TDENGINE_QSORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "qExtbuffer.h"
+
+#define TSORT_MAX_KEY_BYTES    32       // max length of the normalized key of one row
+#define TSORT_BINARY_KEY_BYTES 8        // length and prefix of the binary value kept in the normalized key
+#define TSORT_PARALLEL_ROWS    65536    // the input is sorted by multiple threads when it has more rows than this
+#define TSORT_MAX_THREADS      8
+
+/**
+ * the length of the normalized key generated for the order columns of the descriptor
+ *
+ * @param pDesc
+ * @param exact  false if the keys of two rows may be identical while the rows are not, the rows need to be compared
+ *               by compare_a/compare_d when their keys are identical
+ * @return       0 if no order column can be normalized
+ */
+int32_t tOrderDescKeyWidth(tOrderDescriptor *pDesc, bool *exact);
+
+/**
+ * generate the normalized keys of rows [start, start + num) into pKeys, so that memcmp on the keys gives the same
+ * order as compare_a (TSDB_ORDER_ASC) or compare_d (TSDB_ORDER_DESC)
+ *
+ * @param numOfRows  the capacity of the column model page, used to locate the column data
+ */
+void tColDataEncodeKeys(tOrderDescriptor *pDesc, int32_t orderType, int32_t numOfRows, char *data, int32_t start,
+                        int32_t num, char *pKeys);
+
+/**
+ * sort rows [start, end] of the column model page by the normalized keys. The single integer or timestamp key is
+ * sorted by radix sort, and the rows are moved only once after the order is determined.
+ *
+ * @return  0 if sorted, -1 if out of memory and nothing has been changed
+ */
+int32_t tColDataSort(tOrderDescriptor *pDesc, int32_t numOfRows, int32_t start, int32_t end, char *data,
+                     int32_t orderType);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QSORT_H
@@ -22,6 +22,7 @@ extern "C" {
 
 #include <tstrbuild.h>
 #include "taos.h"
+#include "tarena.h"
 #include "taosmsg.h"
 #include "tstoken.h"
 #include "tvariant.h"
@@ -186,6 +187,7 @@ typedef struct SSqlInfo {
   
   SSubclauseInfo subclauseInfo;
   char           pzErrMsg[256];
+  SArena        *pArena;  // the parser and the expression nodes of the statement, released by SQLInfoDestroy
 } SSqlInfo;
 
 typedef struct tSQLExpr {
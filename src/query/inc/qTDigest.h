@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TDIGEST_H
+#define TDENGINE_TDIGEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A digest is about 1.7KB with the default compression. It is kept in the output row of apercentile, and the row size
+ * of the column model is an int16_t, so several digests must fit into 32KB.
+ */
+#define TDIGEST_DEFAULT_COMPRESSION 100
+
+/* the number of centroids never exceeds compression + 1 with the k1 scale function */
+#define TDIGEST_MAX_CENTROIDS(c) ((c) + 2)
+
+/* incoming values are buffered and merged into centroids in batch */
+#define TDIGEST_BUFFER_SIZE(c) ((c) * 2)
+
+/* the header and the centroids of one t-digest reside in one continuous buffer, it can be copied and transferred
+ * directly once the buffered values are compressed */
+#define TDIGEST_SIZE(c) (sizeof(STDigest) + sizeof(SCentroid) * TDIGEST_MAX_CENTROIDS(c))
+
+/* number of the centroids of the buffer, the centroids are appended to the buffered values during compress */
+#define TDIGEST_BUFFER_LEN(c) (TDIGEST_BUFFER_SIZE(c) + TDIGEST_MAX_CENTROIDS(c))
+
+typedef struct SCentroid {
+  double  mean;
+  int64_t weight;
+} SCentroid;
+
+typedef struct STDigest {
+  int32_t    compression;
+  int32_t    numOfCentroids;
+  int32_t    numOfBuffered;
+  int32_t    maxBuffered;
+  int64_t    total;       // total weight, including the buffered values
+  double     min;
+  double     max;
+  SCentroid* centroids;
+  SCentroid* buffer;      // buffered values, the centroids are appended here during compress, not in the digest
+} STDigest;
+
+/* the digest is created with a buffer of its own */
+STDigest* tDigestCreate(int32_t compression);
+
+/* the digest is created in pBuf of TDIGEST_SIZE(compression) bytes without a buffer */
+STDigest* tDigestCreateFrom(void* pBuf, int32_t compression);
+
+/* reset the inner pointers after the t-digest has been copied to a new buffer, the buffer is not set */
+void tDigestAutoFill(STDigest* pDigest);
+
+/* set the buffer of TDIGEST_BUFFER_LEN(compression) centroids to add values, the digest must be compressed before it
+ * is copied or the buffer is released */
+void tDigestSetBuffer(STDigest* pDigest, SCentroid* pBuffer);
+
+void   tDigestAdd(STDigest* pDigest, double val, int64_t weight);
+void   tDigestAddBatch(STDigest* pDigest, const double* val, int32_t num);
+void   tDigestCompress(STDigest* pDigest);
+void   tDigestMerge(STDigest* pDigest, STDigest* pOther);
+double tDigestQuantile(STDigest* pDigest, double q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TDIGEST_H
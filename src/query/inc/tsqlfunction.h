@@ -69,6 +69,7 @@ extern "C" {
 #define TSDB_FUNC_AVG_IRATE    33
 
 #define TSDB_FUNC_TID_TAG      34
+#define TSDB_FUNC_HLL          35
 
 #define TSDB_FUNCSTATE_SO           0x1u    // single output
 #define TSDB_FUNCSTATE_MO           0x2u    // dynamic number of output, not multinumber of output e.g., TOP/BOTTOM
@@ -141,6 +142,7 @@ typedef struct SResultInfo {
   bool    initialized;     // output buffer has been initialized
   bool    complete;        // query has completed
   bool    superTableQ;     // is super table query
+  bool    paneQ;           // aggregates the rows of one pane, see xPaneMerge
   int32_t numOfRes;        // num of output result in current buffer
   int32_t bufLen;          // buffer size
   void*   interResultBuf;  // output result buffer
@@ -180,6 +182,7 @@ typedef struct SQLFunctionCtx {
   SQLPreAggVal preAggVals;
   tVariant     tag;
   SResultInfo *resultInfo;
+  int64_t *    pMemBudget;    // bytes left of the memory budget shared by the functions of a query, NULL if none
 
   SExtTagsInfo tagInfo;
 } SQLFunctionCtx;
@@ -210,6 +213,12 @@ typedef struct SQLAggFuncElem {
   void (*distSecondaryMergeFunc)(SQLFunctionCtx *pCtx);
 
   int32_t (*dataReqFunc)(SQLFunctionCtx *pCtx, TSKEY start, TSKEY end, int32_t colId);
+
+  /*
+   * merge the intermediate result of one sliding window pane into current output buffer, NULL if the result
+   * of this function can not be composed from the results of panes.
+   */
+  void (*xPaneMerge)(SQLFunctionCtx *pCtx, SResultInfo *pPaneResInfo, char *pPaneOutput);
 } SQLAggFuncElem;
 
 #define GET_RES_INFO(ctx) ((ctx)->resultInfo)
@@ -49,6 +49,12 @@
 
 #define SDATA_BLOCK_INITIALIZER (SDataBlockInfo) {{0}, 0}
 
+// the time slice of the query is checked every so many blocks
+#define QUERY_SLICE_CHECK_BLOCKS 16
+
+// a query is put into the long query queue after it scans so many blocks
+#define QUERY_LONG_QUERY_BLOCKS  4096
+
 #define TIME_WINDOW_COPY(_dst, _src)  do {\
    _dst.skey = _src.skey;\
    _dst.ekey = _src.ekey;\
@@ -806,6 +812,243 @@ static FORCE_INLINE TSKEY reviseWindowEkey(SQuery *pQuery, STimeWindow *pWindow)
   return ekey;
 }
 
+/*
+ * The pane based aggregation is only applied to the master scan of the ascending sliding window query. The functions
+ * merged from panes complete their results in the master scan, e.g., stddev needs no second stage.
+ */
+static FORCE_INLINE bool usePaneAggregation(SQueryRuntimeEnv *pRuntimeEnv) {
+  return pRuntimeEnv->paneInfo.enabled && IS_MASTER_SCAN(pRuntimeEnv) && QUERY_IS_ASC_QUERY(pRuntimeEnv->pQuery);
+}
+
+// the pane is aligned with the time window start key, and each time window consists of intervalTime/slidingTime panes
+static FORCE_INLINE STimeWindow getPaneWindow(SQuery *pQuery, TSKEY alignKey, TSKEY ts) {
+  STimeWindow w = {0};
+
+  w.skey = alignKey + ((ts - alignKey) / pQuery->slidingTime) * pQuery->slidingTime;
+  w.ekey = w.skey + pQuery->slidingTime - 1;
+  return w;
+}
+
+#define PANE_BACK(_p, _i)  (&(_p)->pResult[(_i)])
+#define PANE_FRONT(_p, _i) (&(_p)->pResult[(_p)->numOfPanes + (_i)])
+#define PANE_BACK_AGG(_p)  (&(_p)->pResult[(_p)->numOfPanes * 2])
+
+static void setPaneOutputBufCtx(SQueryRuntimeEnv *pRuntimeEnv, SPaneResult *pPane, TSKEY skey, bool init) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    SQLFunctionCtx *pCtx = &pRuntimeEnv->pCtx[i];
+
+    pCtx->aOutputBuf = pPane->pOutput + pRuntimeEnv->offset[i];
+    pCtx->resultInfo = &pPane->resultInfo[i];
+    pCtx->nStartQueryTimestamp = skey;
+
+    if (init) {
+      pCtx->resultInfo->superTableQ = pRuntimeEnv->stableQuery;
+      pCtx->currentStage = 0;
+
+      RESET_RESULT_INFO(pCtx->resultInfo);
+      aAggs[pQuery->pSelectExpr[i].base.functionId].init(pCtx);
+    }
+  }
+}
+
+// merge the pane, or the aggregate of panes, into the output buffer of the function context
+static void mergePaneResult(SQueryRuntimeEnv *pRuntimeEnv, SPaneResult *pPane) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+
+  for (int32_t k = 0; k < pQuery->numOfOutput; ++k) {
+    SQLFunctionCtx *pCtx = &pRuntimeEnv->pCtx[k];
+
+    int32_t functionId = pQuery->pSelectExpr[k].base.functionId;
+    if (functionNeedToExecute(pRuntimeEnv, pCtx, functionId)) {
+      aAggs[functionId].xPaneMerge(pCtx, &pPane->resultInfo[k], pPane->pOutput + pRuntimeEnv->offset[k]);
+    }
+  }
+}
+
+static FORCE_INLINE void resetPaneStacks(SSlidingPaneInfo *pPaneInfo) {
+  pPaneInfo->numOfBack = 0;
+  pPaneInfo->numOfFront = 0;
+  pPaneInfo->lastPaneKey = TSKEY_INITIAL_VAL;
+  pPaneInfo->nextWinKey = TSKEY_INITIAL_VAL;
+}
+
+/*
+ * move the panes in the back stack to the front stack from the newest one, and each pane is merged with the one
+ * below it in the front stack, so the front top is the aggregate of all panes in the front stack.
+ */
+static void moveBackPanesToFront(SQueryRuntimeEnv *pRuntimeEnv) {
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+  assert(pPaneInfo->numOfFront == 0);
+
+  for (int32_t i = pPaneInfo->numOfBack - 1; i >= 0; --i) {
+    SPaneResult *pBack = PANE_BACK(pPaneInfo, i);
+    if (pPaneInfo->numOfFront > 0) {
+      setPaneOutputBufCtx(pRuntimeEnv, pBack, pPaneInfo->paneKey[i], false);
+      mergePaneResult(pRuntimeEnv, PANE_FRONT(pPaneInfo, pPaneInfo->numOfFront - 1));
+    }
+
+    SPaneResult *pFront = PANE_FRONT(pPaneInfo, pPaneInfo->numOfFront);
+    SPaneResult  t = *pFront;
+    *pFront = *pBack;
+    *pBack = t;
+
+    pPaneInfo->paneKey[pPaneInfo->numOfPanes + pPaneInfo->numOfFront] = pPaneInfo->paneKey[i];
+    pPaneInfo->numOfFront += 1;
+  }
+
+  pPaneInfo->numOfBack = 0;
+}
+
+// evict the panes that start before the given key, and they are always the oldest ones
+static void evictPanes(SQueryRuntimeEnv *pRuntimeEnv, TSKEY skey) {
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+
+  while (1) {
+    if (pPaneInfo->numOfFront == 0) {
+      if (pPaneInfo->numOfBack == 0) {
+        break;
+      }
+
+      moveBackPanesToFront(pRuntimeEnv);
+    }
+
+    if (pPaneInfo->paneKey[pPaneInfo->numOfPanes + pPaneInfo->numOfFront - 1] >= skey) {
+      break;
+    }
+
+    pPaneInfo->numOfFront -= 1;
+  }
+}
+
+/*
+ * merge the panes of the time window starting at the given key. Panes of the window after current one are not
+ * pushed yet, and the panes before it are evicted, so the window is the front top merged with the back aggregate.
+ * Every window merged from panes covers rows of current data block, so it is not closed yet.
+ */
+static void mergePanesIntoTimeWindow(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int32_t tid,
+                                     TSKEY skey, int32_t *index) {
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+
+  evictPanes(pRuntimeEnv, skey);
+
+  STimeWindow w = {.skey = skey, .ekey = skey + pQuery->intervalTime - 1};
+  if (w.ekey > pQuery->window.ekey) {
+    w.ekey = pQuery->window.ekey;
+  }
+
+  bool hasTimeWindow = false;
+  if (setWindowOutputBufByKey(pRuntimeEnv, pWindowResInfo, tid, &w, true, &hasTimeWindow) != TSDB_CODE_SUCCESS) {
+    return;
+  }
+
+  assert(!pWindowResInfo->pResult[pWindowResInfo->curIndex].status.closed);
+  if (*index == -1) {
+    *index = pWindowResInfo->curIndex;
+  }
+
+  for (int32_t k = 0; k < pQuery->numOfOutput; ++k) {
+    pRuntimeEnv->pCtx[k].nStartQueryTimestamp = w.skey;
+  }
+
+  if (pPaneInfo->numOfFront > 0) {
+    mergePaneResult(pRuntimeEnv, PANE_FRONT(pPaneInfo, pPaneInfo->numOfFront - 1));
+  }
+
+  if (pPaneInfo->numOfBack > 0) {
+    mergePaneResult(pRuntimeEnv, PANE_BACK_AGG(pPaneInfo));
+  }
+}
+
+/*
+ * Before a new pane is opened, merge the time windows that end before it, in the ascending order of the window start
+ * key, since no more panes will be pushed into them. The windows covering no pane of current data block are skipped.
+ * Then the pane is pushed to the back stack and set to be the output buffer of the function context.
+ */
+static void openPane(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int32_t tid, STimeWindow *pPane,
+                     int32_t *index) {
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+
+  TSKEY firstWinKey = pPane->skey - pQuery->intervalTime + pQuery->slidingTime;
+  TSKEY skey = pPaneInfo->nextWinKey;
+
+  if (pPaneInfo->lastPaneKey != TSKEY_INITIAL_VAL) {
+    for (; skey <= pPaneInfo->lastPaneKey && skey < firstWinKey; skey += pQuery->slidingTime) {
+      mergePanesIntoTimeWindow(pRuntimeEnv, pWindowResInfo, tid, skey, index);
+    }
+  }
+
+  pPaneInfo->nextWinKey = (skey < firstWinKey) ? firstWinKey : skey;
+  evictPanes(pRuntimeEnv, pPaneInfo->nextWinKey);
+
+  assert(pPaneInfo->numOfBack < pPaneInfo->numOfPanes);
+  pPaneInfo->paneKey[pPaneInfo->numOfBack] = pPane->skey;
+  pPaneInfo->lastPaneKey = pPane->skey;
+
+  setPaneOutputBufCtx(pRuntimeEnv, PANE_BACK(pPaneInfo, pPaneInfo->numOfBack), pPane->skey, true);
+}
+
+// all rows of current pane are aggregated, update the aggregate of the back stack with it
+static void closePane(SQueryRuntimeEnv *pRuntimeEnv) {
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+
+  SPaneResult *pPane = PANE_BACK(pPaneInfo, pPaneInfo->numOfBack);
+  setPaneOutputBufCtx(pRuntimeEnv, PANE_BACK_AGG(pPaneInfo), pPaneInfo->lastPaneKey, pPaneInfo->numOfBack == 0);
+  mergePaneResult(pRuntimeEnv, pPane);
+
+  pPaneInfo->numOfBack += 1;
+}
+
+// merge the remained time windows covering the panes of current data block, and the panes are discarded
+static void flushPanes(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int32_t tid, int32_t *index) {
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+
+  if (pPaneInfo->lastPaneKey != TSKEY_INITIAL_VAL) {
+    for (TSKEY skey = pPaneInfo->nextWinKey; skey <= pPaneInfo->lastPaneKey; skey += pQuery->slidingTime) {
+      mergePanesIntoTimeWindow(pRuntimeEnv, pWindowResInfo, tid, skey, index);
+    }
+  }
+
+  resetPaneStacks(pPaneInfo);
+}
+
+static void blockwisePaneApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataBlockInfo *pDataBlockInfo,
+                                        SWindowResInfo *pWindowResInfo, __block_search_fn_t searchFn, TSKEY *tsCols) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+  assert(QUERY_IS_ASC_QUERY(pQuery) && tsCols != NULL);
+
+  int32_t     startPos = pQuery->pos;
+  STimeWindow win = getActiveTimeWindow(pWindowResInfo, tsCols[startPos], pQuery);
+
+  TSKEY   alignKey = win.skey;
+  int32_t index = -1;
+
+  SWindowStatus status = {.closed = false};
+  resetPaneStacks(&pRuntimeEnv->paneInfo);
+
+  while (startPos < pDataBlockInfo->rows && tsCols[startPos] <= pQuery->window.ekey) {
+    STimeWindow pane = getPaneWindow(pQuery, alignKey, tsCols[startPos]);
+
+    TSKEY   ekey = reviseWindowEkey(pQuery, &pane);
+    int32_t forwardStep = getNumOfRowsInTimeWindow(pQuery, pDataBlockInfo, tsCols, startPos, ekey, searchFn, true);
+
+    openPane(pRuntimeEnv, pWindowResInfo, pDataBlockInfo->tid, &pane, &index);
+    doBlockwiseApplyFunctions(pRuntimeEnv, &status, &pane, startPos, forwardStep, tsCols, pDataBlockInfo->rows);
+    closePane(pRuntimeEnv);
+
+    startPos += forwardStep;
+  }
+
+  flushPanes(pRuntimeEnv, pWindowResInfo, pDataBlockInfo->tid, &index);
+  if (index != -1) {
+    pWindowResInfo->curIndex = index;
+  }
+}
+
 //todo binary search
 static void* getDataBlockImpl(SArray* pDataBlock, int32_t colId) {
   int32_t numOfCols = (int32_t)taosArrayGetSize(pDataBlock);
@@ -920,7 +1163,9 @@ static void blockwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *
   }
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
-  if (QUERY_IS_INTERVAL_QUERY(pQuery)/* && tsCols != NULL*/) {
+  if (QUERY_IS_INTERVAL_QUERY(pQuery) && tsCols != NULL && usePaneAggregation(pRuntimeEnv)) {
+    blockwisePaneApplyFunctions(pRuntimeEnv, pDataBlockInfo, pWindowResInfo, searchFn, tsCols);
+  } else if (QUERY_IS_INTERVAL_QUERY(pQuery)/* && tsCols != NULL*/) {
     TSKEY ts = TSKEY_INITIAL_VAL;
 
     if (tsCols == NULL) {
@@ -1198,6 +1443,15 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
            pQuery->order.order, pRuntimeEnv->pTSBuf->cur.order);
   }
 
+  // rows of one pane are accumulated in the pane output buffer, and merged into time windows when the pane is changed
+  bool          paneQuery = QUERY_IS_INTERVAL_QUERY(pQuery) && pRuntimeEnv->pTSBuf == NULL &&
+                            usePaneAggregation(pRuntimeEnv);
+  bool          paneOpened = false;
+  STimeWindow   pane = TSWINDOW_INITIALIZER;
+  TSKEY         alignKey = TSKEY_INITIAL_VAL;
+  int32_t       paneIndex = -1;
+  SWindowStatus paneStatus = {.closed = false};
+
   int32_t j = 0;
   int32_t offset = -1;
 
@@ -1220,7 +1474,24 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
     }
 
     // interval window query, decide the time window according to the primary timestamp
-    if (QUERY_IS_INTERVAL_QUERY(pQuery)) {
+    if (paneQuery) {
+      int64_t ts = tsCols[offset];
+
+      if (!paneOpened) {
+        alignKey = getActiveTimeWindow(pWindowResInfo, ts, pQuery).skey;
+        resetPaneStacks(&pRuntimeEnv->paneInfo);
+      } else if (ts > pane.ekey) {
+        closePane(pRuntimeEnv);
+      }
+
+      if (!paneOpened || ts > pane.ekey) {
+        pane = getPaneWindow(pQuery, alignKey, ts);
+        openPane(pRuntimeEnv, pWindowResInfo, pDataBlockInfo->tid, &pane, &paneIndex);
+        paneOpened = true;
+      }
+
+      doRowwiseApplyFunctions(pRuntimeEnv, &paneStatus, &pane, offset);
+    } else if (QUERY_IS_INTERVAL_QUERY(pQuery)) {
       int64_t     ts = tsCols[offset];
       STimeWindow win = getActiveTimeWindow(pWindowResInfo, ts, pQuery);
 
@@ -1292,6 +1563,14 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
     }
   }
 
+  if (paneOpened) {
+    closePane(pRuntimeEnv);
+    flushPanes(pRuntimeEnv, pWindowResInfo, pDataBlockInfo->tid, &paneIndex);
+    if (paneIndex != -1) {
+      pWindowResInfo->curIndex = paneIndex;
+    }
+  }
+
   assert(offset >= 0);
   if (tsCols != NULL) {
     item->lastKey = tsCols[offset] + step;
@@ -1487,6 +1766,28 @@ static FORCE_INLINE void setWindowResultInfo(SResultInfo *pResultInfo, SQuery *p
   }
 }
 
+/*
+ * When the sliding time is much smaller than the interval time, each row is aggregated by many overlapped time windows.
+ * If all functions are decomposable, aggregate the rows of each pane only once and merge panes into time windows.
+ */
+static bool isPaneAggregationQuery(SQueryRuntimeEnv *pRuntimeEnv) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+
+  if (!QUERY_IS_INTERVAL_QUERY(pQuery) || pRuntimeEnv->groupbyNormalCol || pQuery->slidingTime <= 0 ||
+      pQuery->slidingTime >= pQuery->intervalTime || (pQuery->intervalTime % pQuery->slidingTime) != 0) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    int32_t functionId = pQuery->pSelectExpr[i].base.functionId;
+    if (aAggs[functionId].xPaneMerge == NULL) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int16_t order) {
   qDebug("QInfo:%p setup runtime env", GET_QINFO_ADDR(pRuntimeEnv));
   SQuery *pQuery = pRuntimeEnv->pQuery;
@@ -1501,11 +1802,14 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int16_t order
   }
 
   pRuntimeEnv->offset[0] = 0;
+  pRuntimeEnv->percentileMemBudget = (int64_t)tsPercentileMemSize << 20;
+
   for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
     SSqlFuncMsg *pSqlFuncMsg = &pQuery->pSelectExpr[i].base;
 
     SQLFunctionCtx *pCtx = &pRuntimeEnv->pCtx[i];
     SColIndex* pIndex = &pSqlFuncMsg->colInfo;
+    pCtx->pMemBudget = &pRuntimeEnv->percentileMemBudget;
 
     int32_t index = pSqlFuncMsg->colInfo.colIndex;
     if (TSDB_COL_IS_TAG(pIndex->flag)) {
@@ -1576,12 +1880,52 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int16_t order
 
   setCtxTagColumnInfo(pRuntimeEnv, pRuntimeEnv->pCtx);
 
+  if (isPaneAggregationQuery(pRuntimeEnv)) {
+    SSlidingPaneInfo *pPaneInfo = &pRuntimeEnv->paneInfo;
+    int32_t           last = pQuery->numOfOutput - 1;
+
+    // the back stack and the front stack keep at most numOfPanes panes each, and one more for the back aggregate
+    int32_t numOfPanes = (int32_t)(pQuery->intervalTime / pQuery->slidingTime);
+    int32_t numOfResults = numOfPanes * 2 + 1;
+    size_t  resultSize = ALIGN8(size);
+    size_t  paneSize = resultSize + ALIGN8(pRuntimeEnv->offset[last] + pRuntimeEnv->pCtx[last].outputBytes);
+
+    pPaneInfo->numOfPanes = numOfPanes;
+    pPaneInfo->paneKey = calloc(numOfPanes * 2, sizeof(TSKEY));
+    pPaneInfo->pResult = calloc(numOfResults, sizeof(SPaneResult));
+    pPaneInfo->buf = calloc(numOfResults, paneSize);
+    if (pPaneInfo->paneKey == NULL || pPaneInfo->pResult == NULL || pPaneInfo->buf == NULL) {
+      goto _clean;
+    }
+
+    for (int32_t j = 0; j < numOfResults; ++j) {
+      SPaneResult *pPane = &pPaneInfo->pResult[j];
+
+      pPane->resultInfo = (SResultInfo *)(pPaneInfo->buf + paneSize * j);
+      pPane->pOutput = (char *)pPane->resultInfo + resultSize;
+
+      buf = (char *)pPane->resultInfo + sizeof(SResultInfo) * pQuery->numOfOutput;
+      setWindowResultInfo(pPane->resultInfo, pQuery, pRuntimeEnv->stableQuery, buf);
+      for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+        pPane->resultInfo[i].paneQ = true;
+      }
+    }
+
+    pPaneInfo->enabled = true;
+
+    qDebug("QInfo:%p sliding window query evaluated by panes, interval:%" PRId64 ", sliding:%" PRId64,
+           GET_QINFO_ADDR(pRuntimeEnv), pQuery->intervalTime, pQuery->slidingTime);
+  }
+
   qDebug("QInfo:%p init runtime completed", GET_QINFO_ADDR(pRuntimeEnv));
   return TSDB_CODE_SUCCESS;
 
 _clean:
   taosTFree(pRuntimeEnv->resultInfo);
   taosTFree(pRuntimeEnv->pCtx);
+  taosTFree(pRuntimeEnv->paneInfo.paneKey);
+  taosTFree(pRuntimeEnv->paneInfo.pResult);
+  taosTFree(pRuntimeEnv->paneInfo.buf);
 
   return TSDB_CODE_QRY_OUT_OF_MEMORY;
 }
@@ -1613,6 +1957,10 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
     taosTFree(pRuntimeEnv->pCtx);
   }
 
+  taosTFree(pRuntimeEnv->paneInfo.paneKey);
+  taosTFree(pRuntimeEnv->paneInfo.pResult);
+  taosTFree(pRuntimeEnv->paneInfo.buf);
+
   pRuntimeEnv->pFillInfo = taosDestoryFillInfo(pRuntimeEnv->pFillInfo);
 
   destroyResultBuf(pRuntimeEnv->pResultBuf);
@@ -3923,9 +4271,9 @@ static void queryCostStatis(SQInfo *pQInfo) {
   SQueryCostInfo *pSummary = &pRuntimeEnv->summary;
 
   qDebug("QInfo:%p :cost summary: elapsed time:%"PRId64" us, total blocks:%d, load block statis:%d,"
-         " load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64,
+         " load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64 ", slices:%d",
          pQInfo, pSummary->elapsedTime, pSummary->totalBlocks, pSummary->loadBlockStatis,
-         pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
+         pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows, pSummary->numOfSlices);
 }
 
 static void updateOffsetVal(SQueryRuntimeEnv *pRuntimeEnv, SDataBlockInfo *pBlockInfo) {
@@ -4336,6 +4684,10 @@ static FORCE_INLINE void setEnvForEachBlock(SQInfo* pQInfo, STableQueryInfo* pTa
   }
 }
 
+static bool isQuerySliceExhausted(SQInfo *pQInfo) {
+  return tsQueryTimeSlice > 0 && taosGetTimestampMs() - pQInfo->sliceStart >= tsQueryTimeSlice;
+}
+
 static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQuery*           pQuery = pRuntimeEnv->pQuery;
@@ -4347,8 +4699,17 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
   SDataBlockInfo blockInfo = SDATA_BLOCK_INITIALIZER;
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
+  int32_t numOfBlocks = 0;
 
   while (true) {
+    // the master scan keeps its position in the query handle, so it can be suspended before the next block
+    if (IS_MASTER_SCAN(pRuntimeEnv) && numOfBlocks > 0 && numOfBlocks % QUERY_SLICE_CHECK_BLOCKS == 0 &&
+        isQuerySliceExhausted(pQInfo)) {
+      pQInfo->yielded = 1;
+      summary->numOfSlices += 1;
+      break;
+    }
+
     if (!tsdbNextDataBlock(pQueryHandle)) {
       if (terrno != TSDB_CODE_SUCCESS) {
         longjmp(pRuntimeEnv->env, terrno);
@@ -4357,6 +4718,7 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
     }
 
     summary->totalBlocks += 1;
+    numOfBlocks += 1;
     
     if (IS_QUERY_KILLED(pQInfo)) {
       longjmp(pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
@@ -4844,6 +5206,12 @@ static void multiTableQueryProcess(SQInfo *pQInfo) {
 
   // do check all qualified data blocks
   int64_t el = scanMultiTableDataBlocks(pQInfo);
+  if (pQInfo->yielded) {
+    qDebug("QInfo:%p master scan yields after %" PRId64 "ms, %d blocks checked", pQInfo, el,
+           pRuntimeEnv->summary.totalBlocks);
+    return;
+  }
+
   qDebug("QInfo:%p master scan completed, elapsed time: %" PRId64 "ms, reverse scan start", pQInfo, el);
 
   // query error occurred or query is killed, abort current execution
@@ -5264,7 +5632,11 @@ static char *createTableIdList(SQueryTableMsg *pQueryMsg, char *pMsg, SArray **p
  * @param pExpr
  * @return
  */
-static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList, SSqlFuncMsg ***pExpr,
+/*
+ * the buffers decoded from the query msg are allocated from the arena of the query, they are released together with
+ * the query, or by the caller if the query is not created.
+ */
+static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArena *pArena, SArray **pTableIdList, SSqlFuncMsg ***pExpr,
                                char **tagCond, char** tbnameCond, SColIndex **groupbyCols, SColumnInfo** tagCols) {
   int32_t code = TSDB_CODE_SUCCESS;
 
@@ -5311,7 +5683,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
 
     int32_t numOfFilters = pColInfo->numOfFilters;
     if (numOfFilters > 0) {
-      pColInfo->filters = calloc(numOfFilters, sizeof(SColumnFilterInfo));
+      pColInfo->filters = taosArenaCalloc(pArena, numOfFilters, sizeof(SColumnFilterInfo));
     }
 
     for (int32_t f = 0; f < numOfFilters; ++f) {
@@ -5325,7 +5697,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
       if (pColFilter->filterstr) {
         pColFilter->len = htobe64(pFilterMsg->len);
 
-        pColFilter->pz = (int64_t) calloc(1, pColFilter->len + 1 * TSDB_NCHAR_SIZE); // note: null-terminator
+        pColFilter->pz = (int64_t) taosArenaCalloc(pArena, 1, pColFilter->len + 1 * TSDB_NCHAR_SIZE); // note: null-terminator
         memcpy((void *)pColFilter->pz, pMsg, pColFilter->len);
         pMsg += (pColFilter->len + 1);
       } else {
@@ -5338,7 +5710,12 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
     }
   }
 
-  *pExpr = calloc(pQueryMsg->numOfOutput, POINTER_BYTES);
+  *pExpr = taosArenaCalloc(pArena, pQueryMsg->numOfOutput, POINTER_BYTES);
+  if (*pExpr == NULL) {
+    code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+    goto _cleanup;
+  }
+
   SSqlFuncMsg *pExprMsg = (SSqlFuncMsg *)pMsg;
 
   for (int32_t i = 0; i < pQueryMsg->numOfOutput; ++i) {
@@ -5387,7 +5764,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
   pMsg = createTableIdList(pQueryMsg, pMsg, pTableIdList);
 
   if (pQueryMsg->numOfGroupCols > 0) {  // group by tag columns
-    *groupbyCols = malloc(pQueryMsg->numOfGroupCols * sizeof(SColIndex));
+    *groupbyCols = taosArenaMalloc(pArena, pQueryMsg->numOfGroupCols * sizeof(SColIndex));
     if (*groupbyCols == NULL) {
       code = TSDB_CODE_QRY_OUT_OF_MEMORY;
       goto _cleanup;
@@ -5424,7 +5801,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
   }
 
   if (pQueryMsg->numOfTags > 0) {
-    (*tagCols) = calloc(1, sizeof(SColumnInfo) * pQueryMsg->numOfTags);
+    (*tagCols) = taosArenaCalloc(pArena, 1, sizeof(SColumnInfo) * pQueryMsg->numOfTags);
     for (int32_t i = 0; i < pQueryMsg->numOfTags; ++i) {
       SColumnInfo* pTagCol = (SColumnInfo*) pMsg;
 
@@ -5440,7 +5817,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
 
   // the tag query condition expression string is located at the end of query msg
   if (pQueryMsg->tagCondLen > 0) {
-    *tagCond = calloc(1, pQueryMsg->tagCondLen);
+    *tagCond = taosArenaCalloc(pArena, 1, pQueryMsg->tagCondLen);
     memcpy(*tagCond, pMsg, pQueryMsg->tagCondLen);
     pMsg += pQueryMsg->tagCondLen;
   }
@@ -5448,7 +5825,7 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
   if (*pMsg != 0) {
     size_t len = strlen(pMsg) + 1;
 
-    *tbnameCond = malloc(len);
+    *tbnameCond = taosArenaMalloc(pArena, len);
     if (*tbnameCond == NULL) {
       code = TSDB_CODE_QRY_OUT_OF_MEMORY;
       goto _cleanup;
@@ -5467,13 +5844,13 @@ static int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SArray **pTableIdList,
   return TSDB_CODE_SUCCESS;
 
 _cleanup:
-  taosTFree(*pExpr);
   taosArrayDestroy(*pTableIdList);
   *pTableIdList = NULL;
-  taosTFree(*tbnameCond);
-  taosTFree(*groupbyCols);
-  taosTFree(*tagCols);
-  taosTFree(*tagCond);
+  *pExpr = NULL;
+  *tbnameCond = NULL;
+  *groupbyCols = NULL;
+  *tagCols = NULL;
+  *tagCond = NULL;
 
   return code;
 }
@@ -5499,12 +5876,12 @@ static int32_t buildAirthmeticExprFromMsg(SExprInfo *pArithExprInfo, SQueryTable
   return TSDB_CODE_SUCCESS;
 }
 
-static int32_t createQFunctionExprFromMsg(SQueryTableMsg *pQueryMsg, SExprInfo **pExprInfo, SSqlFuncMsg **pExprMsg,
-    SColumnInfo* pTagCols) {
+static int32_t createQFunctionExprFromMsg(SQueryTableMsg *pQueryMsg, SArena *pArena, SExprInfo **pExprInfo,
+                                          SSqlFuncMsg **pExprMsg, SColumnInfo *pTagCols) {
   *pExprInfo = NULL;
   int32_t code = TSDB_CODE_SUCCESS;
 
-  SExprInfo *pExprs = (SExprInfo *)calloc(pQueryMsg->numOfOutput, sizeof(SExprInfo));
+  SExprInfo *pExprs = (SExprInfo *)taosArenaCalloc(pArena, pQueryMsg->numOfOutput, sizeof(SExprInfo));
   if (pExprs == NULL) {
     return TSDB_CODE_QRY_OUT_OF_MEMORY;
   }
@@ -5524,7 +5901,6 @@ static int32_t createQFunctionExprFromMsg(SQueryTableMsg *pQueryMsg, SExprInfo *
       code = buildAirthmeticExprFromMsg(&pExprs[i], pQueryMsg);
 
       if (code != TSDB_CODE_SUCCESS) {
-        taosTFree(pExprs);
         return code;
       }
 
@@ -5553,7 +5929,6 @@ static int32_t createQFunctionExprFromMsg(SQueryTableMsg *pQueryMsg, SExprInfo *
     int32_t param = (int32_t)pExprs[i].base.arg[0].argValue.i64;
     if (getResultDataInfo(type, bytes, pExprs[i].base.functionId, param, &pExprs[i].type, &pExprs[i].bytes,
                           &pExprs[i].interBytes, 0, isSuperTable) != TSDB_CODE_SUCCESS) {
-      taosTFree(pExprs);
       return TSDB_CODE_QRY_INVALID_MSG;
     }
 
@@ -5585,13 +5960,14 @@ static int32_t createQFunctionExprFromMsg(SQueryTableMsg *pQueryMsg, SExprInfo *
   return TSDB_CODE_SUCCESS;
 }
 
-static SSqlGroupbyExpr *createGroupbyExprFromMsg(SQueryTableMsg *pQueryMsg, SColIndex *pColIndex, int32_t *code) {
+static SSqlGroupbyExpr *createGroupbyExprFromMsg(SQueryTableMsg *pQueryMsg, SArena *pArena, SColIndex *pColIndex,
+                                                  int32_t *code) {
   if (pQueryMsg->numOfGroupCols == 0) {
     return NULL;
   }
 
   // using group by tag columns
-  SSqlGroupbyExpr *pGroupbyExpr = (SSqlGroupbyExpr *)calloc(1, sizeof(SSqlGroupbyExpr));
+  SSqlGroupbyExpr *pGroupbyExpr = (SSqlGroupbyExpr *)taosArenaCalloc(pArena, 1, sizeof(SSqlGroupbyExpr));
   if (pGroupbyExpr == NULL) {
     *code = TSDB_CODE_QRY_OUT_OF_MEMORY;
     return NULL;
@@ -5609,7 +5985,7 @@ static SSqlGroupbyExpr *createGroupbyExprFromMsg(SQueryTableMsg *pQueryMsg, SCol
   return pGroupbyExpr;
 }
 
-static int32_t createFilterInfo(void *pQInfo, SQuery *pQuery) {
+static int32_t createFilterInfo(SQInfo *pQInfo, SQuery *pQuery) {
   for (int32_t i = 0; i < pQuery->numOfCols; ++i) {
     if (pQuery->colList[i].numOfFilters > 0) {
       pQuery->numOfFilterCols++;
@@ -5620,7 +5996,10 @@ static int32_t createFilterInfo(void *pQInfo, SQuery *pQuery) {
     return TSDB_CODE_SUCCESS;
   }
 
-  pQuery->pFilterInfo = calloc(1, sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+  pQuery->pFilterInfo = taosArenaCalloc(pQInfo->pArena, 1, sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+  if (pQuery->pFilterInfo == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
 
   for (int32_t i = 0, j = 0; i < pQuery->numOfCols; ++i) {
     if (pQuery->colList[i].numOfFilters > 0) {
@@ -5630,7 +6009,10 @@ static int32_t createFilterInfo(void *pQInfo, SQuery *pQuery) {
       pFilterInfo->info = pQuery->colList[i];
 
       pFilterInfo->numOfFilters = pQuery->colList[i].numOfFilters;
-      pFilterInfo->pFilters = calloc(pFilterInfo->numOfFilters, sizeof(SColumnFilterElem));
+      pFilterInfo->pFilters = taosArenaCalloc(pQInfo->pArena, pFilterInfo->numOfFilters, sizeof(SColumnFilterElem));
+      if (pFilterInfo->pFilters == NULL) {
+        return TSDB_CODE_QRY_OUT_OF_MEMORY;
+      }
 
       for (int32_t f = 0; f < pFilterInfo->numOfFilters; ++f) {
         SColumnFilterElem *pSingleColFilter = &pFilterInfo->pFilters[f];
@@ -5760,21 +6142,26 @@ static void calResultBufSize(SQuery* pQuery) {
   }
 }
 
-static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList, SSqlGroupbyExpr *pGroupbyExpr, SExprInfo *pExprs,
-                               STableGroupInfo *pTableGroupInfo, SColumnInfo* pTagCols) {
+/*
+ * the arena, and the buffers allocated from it by convertQueryMsg, are owned by the QInfo once it is created. The
+ * QInfo allocates its own fixed size structures from the arena as well, they are released in one shot by freeQInfo.
+ */
+static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArena *pArena, SArray* pTableIdList, SSqlGroupbyExpr *pGroupbyExpr,
+                               SExprInfo *pExprs, STableGroupInfo *pTableGroupInfo, SColumnInfo* pTagCols) {
   int16_t numOfCols = pQueryMsg->numOfCols;
   int16_t numOfOutput = pQueryMsg->numOfOutput;
 
   SQInfo *pQInfo = (SQInfo *)calloc(1, sizeof(SQInfo));
   if (pQInfo == NULL) {
-    goto _cleanup_qinfo;
+    goto _cleanup_query;
   }
 
   // to make sure third party won't overwrite this structure
   pQInfo->signature = pQInfo;
   pQInfo->tableGroupInfo = *pTableGroupInfo;
+  pQInfo->pArena = pArena;
 
-  SQuery *pQuery = calloc(1, sizeof(SQuery));
+  SQuery *pQuery = taosArenaCalloc(pArena, 1, sizeof(SQuery));
   if (pQuery == NULL) {
     goto _cleanup_query;
   }
@@ -5795,14 +6182,14 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   pQuery->numOfTags       = pQueryMsg->numOfTags;
   pQuery->tagColList      = pTagCols;
 
-  pQuery->colList = calloc(numOfCols, sizeof(SSingleColumnFilterInfo));
+  pQuery->colList = taosArenaCalloc(pArena, numOfCols, sizeof(SSingleColumnFilterInfo));
   if (pQuery->colList == NULL) {
     goto _cleanup;
   }
 
+  // the filters decoded from the query msg are in the arena as well, they are not cloned
   for (int16_t i = 0; i < numOfCols; ++i) {
     pQuery->colList[i] = pQueryMsg->colList[i];
-    pQuery->colList[i].filters = tscFilterInfoClone(pQueryMsg->colList[i].filters, pQuery->colList[i].numOfFilters);
   }
 
   // calculate the result row size
@@ -5819,7 +6206,7 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   }
 
   // prepare the result buffer
-  pQuery->sdata = (tFilePage **)calloc(pQuery->numOfOutput, POINTER_BYTES);
+  pQuery->sdata = (tFilePage **)taosArenaCalloc(pArena, pQuery->numOfOutput, POINTER_BYTES);
   if (pQuery->sdata == NULL) {
     goto _cleanup;
   }
@@ -5838,7 +6225,7 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   }
 
   if (pQuery->fillType != TSDB_FILL_NONE) {
-    pQuery->fillVal = malloc(sizeof(int64_t) * pQuery->numOfOutput);
+    pQuery->fillVal = taosArenaMalloc(pArena, sizeof(int64_t) * pQuery->numOfOutput);
     if (pQuery->fillVal == NULL) {
       goto _cleanup;
     }
@@ -5862,7 +6249,7 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   taosArraySort(pTableIdList, compareTableIdInfo);
 
   pQInfo->runtimeEnv.interBufSize = getOutputInterResultBufSize(pQuery);
-  pQInfo->pBuf = calloc(pTableGroupInfo->numOfTables, sizeof(STableQueryInfo));
+  pQInfo->pBuf = taosArenaCalloc(pArena, pTableGroupInfo->numOfTables, sizeof(STableQueryInfo));
   int32_t index = 0;
 
   for(int32_t i = 0; i < numOfGroups; ++i) {
@@ -5910,22 +6297,20 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SArray* pTableIdList,
   qDebug("qmsg:%p QInfo:%p created", pQueryMsg, pQInfo);
   return pQInfo;
 
-_cleanup_qinfo:
-  tsdbDestroyTableGroup(pTableGroupInfo);
-
 _cleanup_query:
+  tsdbDestroyTableGroup(pTableGroupInfo);
   if (pGroupbyExpr != NULL) {
     taosArrayDestroy(pGroupbyExpr->columnInfo);
-    free(pGroupbyExpr);
   }
-  taosTFree(pTagCols);
   for (int32_t i = 0; i < numOfOutput; ++i) {
     SExprInfo* pExprInfo = &pExprs[i];
     if (pExprInfo->pExpr != NULL) {
       tExprTreeDestroy(&pExprInfo->pExpr, NULL);
     }
   }
-  taosTFree(pExprs);
+  taosTFree(pQInfo);
+  taosArenaDestroy(pArena);
+  return NULL;
 
 _cleanup:
   freeQInfo(pQInfo);
@@ -5988,18 +6373,6 @@ _error:
   return code;
 }
 
-static void freeColumnFilterInfo(SColumnFilterInfo* pFilter, int32_t numOfFilters) {
-    if (pFilter == NULL) {
-      return;
-    }
-    for (int32_t i = 0; i < numOfFilters; i++) {
-      if (pFilter[i].filterstr) {
-        free((void*)(pFilter[i].pz));
-      }
-    }
-    free(pFilter);
-}
-
 static void freeQInfo(SQInfo *pQInfo) {
   if (!isValidQInfo(pQInfo)) {
     return;
@@ -6015,13 +6388,6 @@ static void freeQInfo(SQInfo *pQInfo) {
 
   teardownQueryRuntimeEnv(&pQInfo->runtimeEnv);
 
-  for (int32_t i = 0; i < pQuery->numOfFilterCols; ++i) {
-    SSingleColumnFilterInfo *pColFilter = &pQuery->pFilterInfo[i];
-    if (pColFilter->numOfFilters > 0) {
-      taosTFree(pColFilter->pFilters);
-    }
-  }
-
   if (pQuery->pSelectExpr != NULL) {
     for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
       SExprInfo* pExprInfo = &pQuery->pSelectExpr[i];
@@ -6030,12 +6396,6 @@ static void freeQInfo(SQInfo *pQInfo) {
         tExprTreeDestroy(&pExprInfo->pExpr, NULL);
       }
     }
-
-    taosTFree(pQuery->pSelectExpr);
-  }
-
-  if (pQuery->fillVal != NULL) {
-    taosTFree(pQuery->fillVal);
   }
 
   // todo refactor, extract method to destroytableDataInfo
@@ -6054,7 +6414,6 @@ static void freeQInfo(SQInfo *pQInfo) {
     }
   }
 
-  taosTFree(pQInfo->pBuf);
   taosArrayDestroy(pQInfo->tableqinfoGroupInfo.pGroupList);
   taosHashCleanup(pQInfo->tableqinfoGroupInfo.map);
   tsdbDestroyTableGroup(&pQInfo->tableGroupInfo);
@@ -6062,23 +6421,11 @@ static void freeQInfo(SQInfo *pQInfo) {
   
   if (pQuery->pGroupbyExpr != NULL) {
     taosArrayDestroy(pQuery->pGroupbyExpr->columnInfo);
-    taosTFree(pQuery->pGroupbyExpr);
   }
 
-  taosTFree(pQuery->tagColList);
-  taosTFree(pQuery->pFilterInfo);
-
-  if (pQuery->colList != NULL) {
-    for (int32_t i = 0; i < pQuery->numOfCols; i++) {
-      SColumnInfo* column = pQuery->colList + i;
-      freeColumnFilterInfo(column->filters, column->numOfFilters);
-    }
-    taosTFree(pQuery->colList);
-  }
-
-  taosTFree(pQuery->sdata);
-  taosTFree(pQuery);
+  // the query, its columns, filters and expressions are released with the arena
   pQInfo->signature = 0;
+  taosArenaDestroy(pQInfo->pArena);
 
   qDebug("QInfo:%p QInfo is freed", pQInfo);
 
@@ -6178,7 +6525,13 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
   SColumnInfo     *pTagColumnInfo = NULL;
   SSqlGroupbyExpr *pGroupbyExpr   = NULL;
 
-  code = convertQueryMsg(pQueryMsg, &pTableIdList, &pExprMsg, &tagCond, &tbnameCond, &pGroupColIndex, &pTagColumnInfo);
+  SArena *pArena = taosArenaInit(TAOS_ARENA_DEFAULT_CHUNK_SIZE);
+  if (pArena == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  code = convertQueryMsg(pQueryMsg, pArena, &pTableIdList, &pExprMsg, &tagCond, &tbnameCond, &pGroupColIndex,
+                         &pTagColumnInfo);
   if (code != TSDB_CODE_SUCCESS) {
     goto _over;
   }
@@ -6195,11 +6548,11 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
     goto _over;
   }
 
-  if ((code = createQFunctionExprFromMsg(pQueryMsg, &pExprs, pExprMsg, pTagColumnInfo)) != TSDB_CODE_SUCCESS) {
+  if ((code = createQFunctionExprFromMsg(pQueryMsg, pArena, &pExprs, pExprMsg, pTagColumnInfo)) != TSDB_CODE_SUCCESS) {
     goto _over;
   }
 
-  pGroupbyExpr = createGroupbyExprFromMsg(pQueryMsg, pGroupColIndex, &code);
+  pGroupbyExpr = createGroupbyExprFromMsg(pQueryMsg, pArena, pGroupColIndex, &code);
   if ((pGroupbyExpr == NULL && pQueryMsg->numOfGroupCols != 0) || code != TSDB_CODE_SUCCESS) {
     goto _over;
   }
@@ -6250,10 +6603,9 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
     assert(0);
   }
 
-  (*pQInfo) = createQInfoImpl(pQueryMsg, pTableIdList, pGroupbyExpr, pExprs, &tableGroupInfo, pTagColumnInfo);
-  pExprs = NULL;
+  (*pQInfo) = createQInfoImpl(pQueryMsg, pArena, pTableIdList, pGroupbyExpr, pExprs, &tableGroupInfo, pTagColumnInfo);
+  pArena = NULL;
   pGroupbyExpr = NULL;
-  pTagColumnInfo = NULL;
   
   if ((*pQInfo) == NULL) {
     code = TSDB_CODE_QRY_OUT_OF_MEMORY;
@@ -6263,22 +6615,13 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
   code = initQInfo(pQueryMsg, tsdb, vgId, *pQInfo, isSTableQuery);
 
 _over:
-  free(tagCond);
-  free(tbnameCond);
-  free(pGroupColIndex);
   if (pGroupbyExpr != NULL) {
     taosArrayDestroy(pGroupbyExpr->columnInfo);
-    free(pGroupbyExpr);
   } 
-  free(pTagColumnInfo);
-  free(pExprs);
-  free(pExprMsg);
   taosArrayDestroy(pTableIdList);
 
-  for (int32_t i = 0; i < pQueryMsg->numOfCols; i++) {
-    SColumnInfo* column = pQueryMsg->colList + i;
-    freeColumnFilterInfo(column->filters, column->numOfFilters);
-  }
+  // the buffers decoded from the msg are released here if the query is not created, or with the query
+  taosArenaDestroy(pArena);
 
   //pQInfo already freed in initQInfo, but *pQInfo may not pointer to null;
   if (code != TSDB_CODE_SUCCESS) {
@@ -6321,8 +6664,10 @@ bool qTableQuery(qinfo_t qinfo) {
     return false;
   }
 
+  // a yielded query may be killed before it is executed again, the pending retrieve still needs the response
   if (IS_QUERY_KILLED(pQInfo)) {
     qDebug("QInfo:%p it is already killed, abort", pQInfo);
+    pQInfo->yielded = 0;
     return doBuildResCheck(pQInfo);
   }
 
@@ -6342,6 +6687,9 @@ bool qTableQuery(qinfo_t qinfo) {
 
   qDebug("QInfo:%p query task is launched", pQInfo);
 
+  pQInfo->sliceStart = taosGetTimestampMs();
+  pQInfo->yielded = 0;
+
   SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
   if (onlyQueryTags(pQInfo->runtimeEnv.pQuery)) {
     assert(pQInfo->runtimeEnv.pQueryHandle == NULL);
@@ -6355,6 +6703,11 @@ bool qTableQuery(qinfo_t qinfo) {
   SQuery* pQuery = pRuntimeEnv->pQuery;
   if (IS_QUERY_KILLED(pQInfo)) {
     qDebug("QInfo:%p query is killed", pQInfo);
+    pQInfo->yielded = 0;
+  } else if (pQInfo->yielded) {
+    // no result is ready, the query continues after it is put back into the queue
+    qDebug("QInfo:%p query yields, slices:%d", pQInfo, pRuntimeEnv->summary.numOfSlices);
+    return false;
   } else if (pQuery->rec.rows == 0) {
     qDebug("QInfo:%p over, %zu tables queried, %"PRId64" rows are returned", pQInfo, pQInfo->tableqinfoGroupInfo.numOfTables, pQuery->rec.total);
   } else {
@@ -6482,6 +6835,28 @@ int32_t qDumpRetrieveResult(qinfo_t qinfo, SRetrieveTableRsp **pRsp, int32_t *co
   return code;
 }
 
+bool qIsQueryYielded(qinfo_t qinfo) {
+  SQInfo *pQInfo = (SQInfo *)qinfo;
+
+  if (pQInfo == NULL || !isValidQInfo(pQInfo)) {
+    return false;
+  }
+
+  // a query killed after it yields is still put back into the queue, the next execution builds the response
+  return pQInfo->yielded != 0;
+}
+
+bool qIsLongQuery(qinfo_t qinfo) {
+  SQInfo *pQInfo = (SQInfo *)qinfo;
+
+  if (pQInfo == NULL || !isValidQInfo(pQInfo)) {
+    return false;
+  }
+
+  SQueryCostInfo *pSummary = &pQInfo->runtimeEnv.summary;
+  return pSummary->numOfSlices > 0 || pSummary->totalBlocks >= QUERY_LONG_QUERY_BLOCKS;
+}
+
 int32_t qKillQuery(qinfo_t qinfo) {
   SQInfo *pQInfo = (SQInfo *)qinfo;
 
@@ -6660,7 +7035,8 @@ void* qOpenQueryMgmt(int32_t vgId) {
 
   SQueryMgmt* pQueryMgmt = calloc(1, sizeof(SQueryMgmt));
 
-  pQueryMgmt->qinfoPool = taosCacheInit(TSDB_DATA_TYPE_BIGINT, REFRESH_HANDLE_INTERVAL, true, freeqinfoFn, cacheName);
+  // the handles are acquired by the query threads concurrently, they are never evicted by size
+  pQueryMgmt->qinfoPool = taosCacheInitSharded(TSDB_DATA_TYPE_BIGINT, REFRESH_HANDLE_INTERVAL, true, freeqinfoFn, cacheName, 0);
   pQueryMgmt->closed    = false;
   pQueryMgmt->vgId      = vgId;
 
@@ -14,6 +14,7 @@
  */
 #include "qExtbuffer.h"
 #include "os.h"
+#include "qSort.h"
 #include "queryLog.h"
 #include "taos.h"
 #include "taosdef.h"
@@ -22,9 +23,6 @@
 #include "tulog.h"
 #include "tutil.h"
 
-#define COLMODEL_GET_VAL(data, schema, allrow, rowId, colId) \
-  (data + (schema)->pFields[colId].offset * (allrow) + (rowId) * (schema)->pFields[colId].field.bytes)
-
 /*
  * SColumnModel is deeply copy
  */
@@ -629,8 +627,8 @@ static UNUSED_FUNC void tRowModelDisplay(tOrderDescriptor *pDescriptor, int32_t
 
 static int32_t qsort_call = 0;
 
-void tColDataQSort(tOrderDescriptor *pDescriptor, int32_t numOfRows, int32_t start, int32_t end, char *data,
-                   int32_t orderType) {
+static void doColDataQSort(tOrderDescriptor *pDescriptor, int32_t numOfRows, int32_t start, int32_t end, char *data,
+                           int32_t orderType) {
   // short array sort, incur another sort procedure instead of quick sort process
   __col_compar_fn_t compareFn = (orderType == TSDB_ORDER_ASC) ? compare_sa : compare_sd;
 
@@ -732,12 +730,22 @@ void tColDataQSort(tOrderDescriptor *pDescriptor, int32_t numOfRows, int32_t sta
   }
 
   if (leftx > start) {
-    tColDataQSort(pDescriptor, numOfRows, start, leftx, data, orderType);
+    doColDataQSort(pDescriptor, numOfRows, start, leftx, data, orderType);
   }
 
   if (rightx < end) {
-    tColDataQSort(pDescriptor, numOfRows, rightx, end, data, orderType);
+    doColDataQSort(pDescriptor, numOfRows, rightx, end, data, orderType);
+  }
+}
+
+void tColDataQSort(tOrderDescriptor *pDescriptor, int32_t numOfRows, int32_t start, int32_t end, char *data,
+                   int32_t orderType) {
+  // sort by the normalized keys, the quick sort on the column model is used only if out of memory
+  if (end - start + 1 > 8 && tColDataSort(pDescriptor, numOfRows, start, end, data, orderType) == 0) {
+    return;
   }
+
+  doColDataQSort(pDescriptor, numOfRows, start, end, data, orderType);
 }
 
 /*
@@ -751,14 +759,24 @@ SColumnModel *createColumnModel(SSchema *fields, int32_t numOfCols, int32_t bloc
 
   pColumnModel->pFields = (SSchemaEx *)(&pColumnModel[1]);
   
+  int32_t rowSize = 0;
   for(int32_t i = 0; i < numOfCols; ++i) {
     SSchemaEx* pSchemaEx = &pColumnModel->pFields[i];
     pSchemaEx->field = fields[i];
-    pSchemaEx->offset = pColumnModel->rowSize;
+    pSchemaEx->offset = (int16_t)rowSize;
     
-    pColumnModel->rowSize += pSchemaEx->field.bytes;
+    rowSize += pSchemaEx->field.bytes;
   }
 
+  // the offset and row size are int16_t
+  if (rowSize > INT16_MAX) {
+    uError("row size:%d of column model exceeds the limit:%d", rowSize, INT16_MAX);
+    free(pColumnModel);
+    return NULL;
+  }
+
+  pColumnModel->rowSize = (int16_t)rowSize;
+
   pColumnModel->numOfCols = numOfCols;
   pColumnModel->capacity = blockCapacity;
 
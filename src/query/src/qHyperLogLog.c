@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qHyperLogLog.h"
+
+/**
+ *
+ * implement the HyperLogLog based on the paper:
+ * Philippe Flajolet, et al. HyperLogLog: the analysis of a near-optimal cardinality estimation algorithm.
+ *
+ * The lowest HLL_BUCKET_BITS bits of the 64-bit hash select the register, and the register keeps the max position
+ * of the first set bit in the remaining bits. Two HyperLogLogs are merged by taking the max of each register, so the
+ * partial results of vnodes, panes and groups can be combined without any loss of accuracy.
+ *
+ */
+
+/* MurmurHash64A by Austin Appleby, the 32-bit hash is not enough when counting billions of distinct values */
+uint64_t tHLLHash(const void *data, int32_t len) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int32_t  r = 47;
+
+  uint64_t h = 0x9747b28cULL ^ (len * m);
+
+  const uint8_t *p = (const uint8_t *)data;
+  const uint8_t *end = p + (len - (len & 7));
+
+  for (; p != end; p += 8) {
+    uint64_t k = 0;
+    memcpy(&k, p, sizeof(uint64_t));
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+
+    h ^= k;
+    h *= m;
+  }
+
+  switch (len & 7) {
+    case 7: h ^= (uint64_t)p[6] << 48;  // fall through
+    case 6: h ^= (uint64_t)p[5] << 40;  // fall through
+    case 5: h ^= (uint64_t)p[4] << 32;  // fall through
+    case 4: h ^= (uint64_t)p[3] << 24;  // fall through
+    case 3: h ^= (uint64_t)p[2] << 16;  // fall through
+    case 2: h ^= (uint64_t)p[1] << 8;   // fall through
+    case 1: h ^= (uint64_t)p[0];
+            h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+void tHLLAddHash(SHyperLogLog *pHLL, uint64_t hash) {
+  int32_t index = (int32_t)(hash & (HLL_BUCKETS - 1));
+
+  // the sentinel bit guarantees the rank never exceeds 64 - HLL_BUCKET_BITS + 1
+  uint64_t bits = (hash >> HLL_BUCKET_BITS) | (1ULL << (64 - HLL_BUCKET_BITS));
+  uint8_t  rank = (uint8_t)(BUILDIN_CTZL(bits) + 1);
+
+  if (rank > pHLL->buckets[index]) {
+    pHLL->buckets[index] = rank;
+  }
+}
+
+void tHLLAdd(SHyperLogLog *pHLL, const void *data, int32_t len) { tHLLAddHash(pHLL, tHLLHash(data, len)); }
+
+void tHLLMerge(SHyperLogLog *pHLL, const SHyperLogLog *pOther) {
+  for (int32_t i = 0; i < HLL_BUCKETS; ++i) {
+    if (pOther->buckets[i] > pHLL->buckets[i]) {
+      pHLL->buckets[i] = pOther->buckets[i];
+    }
+  }
+}
+
+int64_t tHLLCount(const SHyperLogLog *pHLL) {
+  double  sum = 0;
+  int32_t numOfZeros = 0;
+
+  for (int32_t i = 0; i < HLL_BUCKETS; ++i) {
+    sum += 1.0 / ((uint64_t)1 << pHLL->buckets[i]);
+    numOfZeros += (pHLL->buckets[i] == 0);
+  }
+
+  double m = HLL_BUCKETS;
+  double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+
+  // small range correction, the linear counting is more accurate when there are empty registers
+  if (estimate <= 2.5 * m && numOfZeros > 0) {
+    estimate = m * log(m / numOfZeros);
+  }
+
+  return (int64_t)(estimate + 0.5);
+}
@@ -17,6 +17,7 @@
 #include "qSqlparser.h"
 #include "queryLog.h"
 #include "taosdef.h"
+#include "taoserror.h"
 #include "taosmsg.h"
 #include "tcmdtype.h"
 #include "tglobal.h"
@@ -25,10 +26,37 @@
 #include "ttokendef.h"
 #include "tutil.h"
 
-SSqlInfo qSQLParse(const char *pStr) {
-  void *pParser = ParseAlloc(malloc);
+// the parser and the stack of it, and the nodes of a common statement fit in the first chunk of the arena
+#define PARSER_ARENA_CHUNK_SIZE (32 * 1024)
+
+/*
+ * arena of the statement being parsed and validated by this thread. The nodes created by the grammar actions, and the
+ * ones created by the client when the statement is converted to the command, are allocated from it until the
+ * statement is destroyed by SQLInfoDestroy.
+ */
+static threadlocal SArena *tsParserArena = NULL;
+
+static void *parserMalloc(size_t size) { return taosArenaMalloc(tsParserArena, size); }
+
+static void parserFree(void *p) { UNUSED(p); }
 
+static tSQLExpr *tSQLExprNodeAlloc() {
+  assert(tsParserArena != NULL);
+  return taosArenaCalloc(tsParserArena, 1, sizeof(tSQLExpr));
+}
+
+SSqlInfo qSQLParse(const char *pStr) {
   SSqlInfo sqlInfo = {0};
+
+  sqlInfo.pArena = taosArenaInit(PARSER_ARENA_CHUNK_SIZE);
+  if (sqlInfo.pArena == NULL) {
+    snprintf(sqlInfo.pzErrMsg, tListLen(sqlInfo.pzErrMsg), "%s", tstrerror(TSDB_CODE_TSC_OUT_OF_MEMORY));
+    return sqlInfo;
+  }
+
+  tsParserArena = sqlInfo.pArena;
+  void *pParser = ParseAlloc(parserMalloc);
+
   sqlInfo.valid = true;
 
   int32_t i = 0;
@@ -60,6 +88,15 @@ SSqlInfo qSQLParse(const char *pStr) {
         sqlInfo.valid = false;
         goto abort_parse;
       }
+
+      // not a token of the grammar, the function name is parsed as an ID and keeps its own token type
+      case TK_HYPERLOGLOG: {
+        Parse(pParser, TK_ID, t0, &sqlInfo);
+        if (sqlInfo.valid == false) {
+          goto abort_parse;
+        }
+        break;
+      }
       default:
         Parse(pParser, t0.type, t0, &sqlInfo);
         if (sqlInfo.valid == false) {
@@ -69,7 +106,7 @@ SSqlInfo qSQLParse(const char *pStr) {
   }
 
 abort_parse:
-  ParseFree(pParser, free);
+  ParseFree(pParser, parserFree);
   return sqlInfo;
 }
 
@@ -118,7 +155,7 @@ void tSQLExprListDestroy(tSQLExprList *pList) {
 }
 
 tSQLExpr *tSQLExprIdValueCreate(SSQLToken *pAliasToken, int32_t optrType) {
-  tSQLExpr *nodePtr = calloc(1, sizeof(tSQLExpr));
+  tSQLExpr *nodePtr = tSQLExprNodeAlloc();
 
   if (optrType == TK_INTEGER || optrType == TK_STRING || optrType == TK_FLOAT || optrType == TK_BOOL) {
     toTSDBType(pAliasToken->type);
@@ -154,7 +191,7 @@ tSQLExpr *tSQLExprIdValueCreate(SSQLToken *pAliasToken, int32_t optrType) {
 tSQLExpr *tSQLExprCreateFunction(tSQLExprList *pList, SSQLToken *pFuncToken, SSQLToken *endToken, int32_t optType) {
   if (pFuncToken == NULL) return NULL;
 
-  tSQLExpr *pExpr = calloc(1, sizeof(tSQLExpr));
+  tSQLExpr *pExpr = tSQLExprNodeAlloc();
   pExpr->nSQLOptr = optType;
   pExpr->pParam = pList;
 
@@ -171,7 +208,7 @@ tSQLExpr *tSQLExprCreateFunction(tSQLExprList *pList, SSQLToken *pFuncToken, SSQ
  * if the expr is arithmetic, calculate the result and set it to tSQLExpr Object
  */
 tSQLExpr *tSQLExprCreate(tSQLExpr *pLeft, tSQLExpr *pRight, int32_t optrType) {
-  tSQLExpr *pExpr = calloc(1, sizeof(tSQLExpr));
+  tSQLExpr *pExpr = tSQLExprNodeAlloc();
 
   if (optrType == TK_PLUS || optrType == TK_MINUS || optrType == TK_STAR || optrType == TK_DIVIDE ||
       optrType == TK_REM) {
@@ -255,7 +292,7 @@ tSQLExpr *tSQLExprCreate(tSQLExpr *pLeft, tSQLExpr *pRight, int32_t optrType) {
     pExpr->nSQLOptr = optrType;
     pExpr->pLeft = pLeft;
 
-    tSQLExpr *pRSub = calloc(1, sizeof(tSQLExpr));
+    tSQLExpr *pRSub = tSQLExprNodeAlloc();
     pRSub->nSQLOptr = TK_SET;  // TODO refactor .....
     pRSub->pParam = (tSQLExprList *)pRight;
 
@@ -278,9 +315,8 @@ void tSQLExprNodeDestroy(tSQLExpr *pExpr) {
     tVariantDestroy(&pExpr->val);
   }
 
+  // the node itself is released with the arena of the statement
   tSQLExprListDestroy(pExpr->pParam);
-
-  free(pExpr);
 }
 
 void tSQLExprDestroy(tSQLExpr *pExpr) {
@@ -695,6 +731,13 @@ void SQLInfoDestroy(SSqlInfo *pInfo) {
 
     taosTFree(pInfo->pDCLInfo);
   }
+
+  if (tsParserArena == pInfo->pArena) {
+    tsParserArena = NULL;
+  }
+
+  taosArenaDestroy(pInfo->pArena);
+  pInfo->pArena = NULL;
 }
 
 SSubclauseInfo* setSubclause(SSubclauseInfo* pSubclause, void *pSqlExprInfo) {
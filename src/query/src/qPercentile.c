@@ -18,8 +18,14 @@
 #include "queryLog.h"
 #include "taosdef.h"
 #include "taosmsg.h"
+#include "tglobal.h"
 #include "tulog.h"
 
+// the values are converted to double during selection, so the memory of the double array is counted in
+#define TMEM_BUCKET_IN_MEM_ELEM_BYTES(_b) ((_b)->nElemSize + sizeof(double))
+
+static void tMemBucketReleaseInMemBuf(tMemBucket *pBucket);
+
 tExtMemBuffer *releaseBucketsExceptFor(tMemBucket *pMemBucket, int16_t segIdx, int16_t slotIdx) {
   tExtMemBuffer *pBuffer = NULL;
   
@@ -239,7 +245,7 @@ void tBucketDoubleHash(tMemBucket *pBucket, void *value, int16_t *segIdx, int16_
 }
 
 tMemBucket *tMemBucketCreate(int32_t totalSlots, int32_t nBufferSize, int16_t nElemSize, int16_t dataType,
-                             tOrderDescriptor *pDesc) {
+                             tOrderDescriptor *pDesc, int64_t *pMemBudget) {
   tMemBucket *pBucket = (tMemBucket *)malloc(sizeof(tMemBucket));
   pBucket->nTotalSlots = totalSlots;
   pBucket->nSlotsOfSeg = 1 << 6;  // 64 Segments, 16 slots each seg.
@@ -260,6 +266,14 @@ tMemBucket *tMemBucketCreate(int32_t totalSlots, int32_t nBufferSize, int16_t nE
   pBucket->pSegs = NULL;
   pBucket->pOrderDesc = pDesc;
 
+  // a bucket takes the whole budget of the query at most
+  pBucket->maxInMemElems =
+      (int32_t)MIN(((int64_t)tsPercentileMemSize << 20) / TMEM_BUCKET_IN_MEM_ELEM_BYTES(pBucket), INT32_MAX);
+  pBucket->inMemCapacity = 0;
+  pBucket->pInMemBuf = NULL;
+  pBucket->ownBudget = (int64_t)tsPercentileMemSize << 20;
+  pBucket->pMemBudget = (pMemBudget != NULL) ? pMemBudget : &pBucket->ownBudget;
+
   switch (pBucket->dataType) {
     case TSDB_DATA_TYPE_INT:
     case TSDB_DATA_TYPE_SMALLINT:
@@ -344,6 +358,7 @@ void tMemBucketDestroy(tMemBucket *pBucket) {
     }
   }
 
+  tMemBucketReleaseInMemBuf(pBucket);
   taosTFree(pBucket->pSegs);
   taosTFree(pBucket);
 }
@@ -481,8 +496,7 @@ void tMemBucketUpdateBoundingBox(MinMaxEntry *r, char *data, int32_t dataType) {
  * in memory bucket, we only accept the simple data consecutive put in a row/column
  * no column-model in this case.
  */
-void tMemBucketPut(tMemBucket *pBucket, void *data, int32_t numOfRows) {
-  pBucket->numOfElems += numOfRows;
+static void tMemBucketPutImpl(tMemBucket *pBucket, void *data, int32_t numOfRows) {
   int16_t segIdx = 0, slotIdx = 0;
 
   for (int32_t i = 0; i < numOfRows; ++i) {
@@ -577,6 +591,73 @@ void tMemBucketPut(tMemBucket *pBucket, void *data, int32_t numOfRows) {
   }
 }
 
+static bool tMemBucketEnsureInMemCapacity(tMemBucket *pBucket, int32_t numOfElems) {
+  if (numOfElems <= pBucket->inMemCapacity) {
+    return true;
+  }
+
+  int32_t newCapacity = (pBucket->inMemCapacity == 0) ? 4096 : pBucket->inMemCapacity;
+  while (newCapacity < numOfElems) {
+    newCapacity = (int32_t)MIN((int64_t)newCapacity << 1u, pBucket->maxInMemElems);
+  }
+
+  // the values of all buckets of a query kept in memory are limited by the budget shared by them
+  int64_t bytes = (int64_t)(newCapacity - pBucket->inMemCapacity) * TMEM_BUCKET_IN_MEM_ELEM_BYTES(pBucket);
+  if (*pBucket->pMemBudget < bytes) {
+    uDebug("MemBucket:%p,budget left:%" PRId64 " is not enough for %d elems", pBucket, *pBucket->pMemBudget,
+           newCapacity);
+    return false;
+  }
+
+  char *tmp = realloc(pBucket->pInMemBuf, (size_t)newCapacity * pBucket->nElemSize);
+  if (tmp == NULL) {
+    return false;
+  }
+
+  *pBucket->pMemBudget -= bytes;
+  pBucket->pInMemBuf = tmp;
+  pBucket->inMemCapacity = newCapacity;
+  return true;
+}
+
+// free the array of the values kept in memory, and return its bytes to the budget
+static void tMemBucketReleaseInMemBuf(tMemBucket *pBucket) {
+  *pBucket->pMemBudget += (int64_t)pBucket->inMemCapacity * TMEM_BUCKET_IN_MEM_ELEM_BYTES(pBucket);
+  pBucket->inMemCapacity = 0;
+  taosTFree(pBucket->pInMemBuf);
+}
+
+/*
+ * move all values kept in memory into the disk-based buckets, and the values put afterwards go to the buckets directly
+ */
+static void tMemBucketSpill(tMemBucket *pBucket) {
+  if (pBucket->pInMemBuf != NULL) {
+    uDebug("MemBucket:%p,%d elems exceed the in-memory limit, spilled into buckets", pBucket, pBucket->numOfElems);
+    tMemBucketPutImpl(pBucket, pBucket->pInMemBuf, pBucket->numOfElems);
+  }
+
+  tMemBucketReleaseInMemBuf(pBucket);
+  pBucket->maxInMemElems = 0;
+}
+
+void tMemBucketPut(tMemBucket *pBucket, void *data, int32_t numOfRows) {
+  int64_t total = (int64_t)pBucket->numOfElems + numOfRows;
+
+  if (total <= pBucket->maxInMemElems && tMemBucketEnsureInMemCapacity(pBucket, (int32_t)total)) {
+    memcpy(pBucket->pInMemBuf + (size_t)pBucket->numOfElems * pBucket->nElemSize, data,
+           (size_t)numOfRows * pBucket->nElemSize);
+    pBucket->numOfElems += numOfRows;
+    return;
+  }
+
+  if (pBucket->maxInMemElems > 0) {
+    tMemBucketSpill(pBucket);
+  }
+
+  pBucket->numOfElems += numOfRows;
+  tMemBucketPutImpl(pBucket, data, numOfRows);
+}
+
 void releaseBucket(tMemBucket *pMemBucket, int32_t segIdx, int32_t slotIdx) {
   if (segIdx < 0 || segIdx > pMemBucket->numOfSegs || slotIdx < 0) {
     return;
@@ -904,11 +985,144 @@ double getPercentileImpl(tMemBucket *pMemBucket, int32_t count, double fraction)
   return 0;
 }
 
+static int32_t compareDoubleVal(const void *pLeft, const void *pRight) {
+  double l = *(const double *)pLeft;
+  double r = *(const double *)pRight;
+
+  if (l == r) {
+    return 0;
+  }
+
+  return (l < r) ? -1 : 1;
+}
+
+static FORCE_INLINE void swapDoubleVal(double *pList, int32_t i, int32_t j) {
+  double t = pList[i];
+  pList[i] = pList[j];
+  pList[j] = t;
+}
+
+/*
+ * introselect: quick select with the median-of-three pivot, and switch to sort once the partition goes too deep.
+ * When returned, the k-th smallest value is at position k, no larger values before it and no smaller values after it.
+ */
+static void doubleNthElement(double *pList, int32_t num, int32_t k) {
+  int32_t left = 0;
+  int32_t right = num - 1;
+
+  int32_t depth = 0;
+  for (int32_t n = num; n > 0; n >>= 1u) {
+    depth += 2;
+  }
+
+  while (right > left) {
+    if (--depth < 0) {
+      qsort(&pList[left], right - left + 1, sizeof(double), compareDoubleVal);
+      return;
+    }
+
+    int32_t mid = left + ((right - left) >> 1u);
+    if (pList[mid] < pList[left]) {
+      swapDoubleVal(pList, mid, left);
+    }
+    if (pList[right] < pList[left]) {
+      swapDoubleVal(pList, right, left);
+    }
+    if (pList[right] < pList[mid]) {
+      swapDoubleVal(pList, right, mid);
+    }
+
+    double  pivot = pList[mid];
+    int32_t i = left;
+    int32_t j = right;
+
+    while (i <= j) {
+      while (pList[i] < pivot) {
+        ++i;
+      }
+      while (pList[j] > pivot) {
+        --j;
+      }
+
+      if (i <= j) {
+        swapDoubleVal(pList, i, j);
+        ++i;
+        --j;
+      }
+    }
+
+    // values in [j + 1, i - 1] all equal to the pivot
+    if (k <= j) {
+      right = j;
+    } else if (k >= i) {
+      left = i;
+    } else {
+      return;
+    }
+  }
+}
+
+static double getPercentileInMem(tMemBucket *pMemBucket, double percent) {
+  int32_t num = pMemBucket->numOfElems;
+  double *pList = NULL;
+
+  if (pMemBucket->dataType == TSDB_DATA_TYPE_DOUBLE) {
+    pList = (double *)pMemBucket->pInMemBuf;
+  } else {
+    pList = malloc(sizeof(double) * num);
+    if (pList == NULL) {
+      tMemBucketSpill(pMemBucket);
+      return getPercentile(pMemBucket, percent);
+    }
+
+    for (int32_t i = 0; i < num; ++i) {
+      char *d = pMemBucket->pInMemBuf + (size_t)i * pMemBucket->nElemSize;
+
+      switch (pMemBucket->dataType) {
+        case TSDB_DATA_TYPE_TINYINT:  pList[i] = GET_INT8_VAL(d); break;
+        case TSDB_DATA_TYPE_SMALLINT: pList[i] = GET_INT16_VAL(d); break;
+        case TSDB_DATA_TYPE_INT:      pList[i] = GET_INT32_VAL(d); break;
+        case TSDB_DATA_TYPE_BIGINT:   pList[i] = (double)GET_INT64_VAL(d); break;
+        case TSDB_DATA_TYPE_FLOAT:    pList[i] = GET_FLOAT_VAL(d); break;
+      }
+    }
+  }
+
+  double  percentVal = (percent * (num - 1)) / ((double)100.0);
+  int32_t orderIdx = (int32_t)percentVal;
+  double  fraction = percentVal - orderIdx;
+
+  doubleNthElement(pList, num, orderIdx);
+  double val = pList[orderIdx];
+
+  // the next value in order is the minimum value after the selected one
+  if (orderIdx < num - 1 && fraction > 0) {
+    double nextVal = pList[orderIdx + 1];
+    for (int32_t i = orderIdx + 2; i < num; ++i) {
+      if (pList[i] < nextVal) {
+        nextVal = pList[i];
+      }
+    }
+
+    val = (1 - fraction) * val + fraction * nextVal;
+  }
+
+  if (pList != (double *)pMemBucket->pInMemBuf) {
+    free(pList);
+  }
+
+  return val;
+}
+
 double getPercentile(tMemBucket *pMemBucket, double percent) {
   if (pMemBucket->numOfElems == 0) {
     return 0.0;
   }
 
+  if (pMemBucket->pInMemBuf != NULL) {
+    return getPercentileInMem(pMemBucket, fabs(percent));
+  }
+
   if (pMemBucket->numOfElems == 1) {  // return the only element
     return findOnlyResult(pMemBucket);
   }
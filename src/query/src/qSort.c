@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qSort.h"
+#include "queryLog.h"
+#include "taosdef.h"
+#include "tglobal.h"
+#include "tutil.h"
+
+/**
+ *
+ * The normalized key of one row is the concatenation of the encoded order columns. The integers are stored in big
+ * endian with the sign bit flipped, and the float point values are mapped to unsigned integers of the same order, so
+ * two keys are compared by memcmp instead of dispatching on the column type for every comparison. The bits of a
+ * column in descending order are inverted.
+ *
+ * Only the length and the first bytes of a binary column are kept, so the rows with identical keys are compared by
+ * the column model comparator, and the columns after it are not encoded.
+ *
+ */
+
+typedef struct SSortPair {
+  uint64_t prefix;  // the first 8 bytes of the normalized key, compared as integer
+  int32_t  index;   // row index in the column model page
+} SSortPair;
+
+typedef struct SSortContext {
+  tOrderDescriptor *pDesc;
+  __col_compar_fn_t compareFn;
+  int32_t           numOfRows;
+  char *            data;
+  char *            pKeys;
+  int32_t           keyWidth;
+  bool              exact;
+} SSortContext;
+
+typedef struct SSortTask {
+  SSortContext *pCtx;
+  SSortPair *   pSrc;
+  SSortPair *   pDst;
+  int32_t       num;     // number of pairs of the task
+  int32_t       middle;  // the end of the first sorted run in the merge task
+} SSortTask;
+
+static int32_t sortKeyColumnWidth(SSchema *pSchema, bool *exact) {
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:   return sizeof(int8_t);
+    case TSDB_DATA_TYPE_SMALLINT:  return sizeof(int16_t);
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_FLOAT:     return sizeof(int32_t);
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+    case TSDB_DATA_TYPE_DOUBLE:    return sizeof(int64_t);
+    case TSDB_DATA_TYPE_BINARY: {
+      *exact = false;
+      return TSORT_BINARY_KEY_BYTES;
+    }
+    default: {  // the nchar value can not be normalized
+      *exact = false;
+      return 0;
+    }
+  }
+}
+
+int32_t tOrderDescKeyWidth(tOrderDescriptor *pDesc, bool *exact) {
+  int32_t width = 0;
+  *exact = true;
+
+  for (int32_t i = 0; i < pDesc->orderInfo.numOfCols; ++i) {
+    SSchema *pSchema = &pDesc->pColumnModel->pFields[pDesc->orderInfo.pData[i]].field;
+
+    bool    exactCol = true;
+    int32_t bytes = sortKeyColumnWidth(pSchema, &exactCol);
+    if (width + bytes > TSORT_MAX_KEY_BYTES) {
+      *exact = false;
+      break;
+    }
+
+    width += bytes;
+    if (!exactCol) {
+      *exact = false;
+      break;
+    }
+  }
+
+  return width;
+}
+
+static FORCE_INLINE void sortKeyPut(char *pKey, uint64_t val, int32_t bytes, bool desc) {
+  if (desc) {
+    val = ~val;
+  }
+
+  for (int32_t i = bytes - 1; i >= 0; --i) {
+    pKey[i] = (char)(val & 0xFF);
+    val >>= 8;
+  }
+}
+
+static void encodeKeyColumn(char *pKey, char *val, SSchema *pSchema, int32_t bytes, bool desc) {
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+      sortKeyPut(pKey, (uint64_t)(GET_INT8_VAL(val)) ^ 0x80u, bytes, desc);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      sortKeyPut(pKey, (uint64_t)(GET_INT16_VAL(val)) ^ 0x8000u, bytes, desc);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      sortKeyPut(pKey, (uint64_t)(GET_INT32_VAL(val)) ^ 0x80000000u, bytes, desc);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      sortKeyPut(pKey, (uint64_t)(GET_INT64_VAL(val)) ^ 0x8000000000000000ull, bytes, desc);
+      break;
+    case TSDB_DATA_TYPE_FLOAT: {
+      float    f = GET_FLOAT_VAL(val);
+      uint32_t u = 0;
+      if (f != 0) {  // -0.0 is identical to 0.0
+        memcpy(&u, &f, sizeof(uint32_t));
+      }
+
+      u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+      sortKeyPut(pKey, u, bytes, desc);
+      break;
+    }
+    case TSDB_DATA_TYPE_DOUBLE: {
+      double   d = GET_DOUBLE_VAL(val);
+      uint64_t u = 0;
+      if (d != 0) {
+        memcpy(&u, &d, sizeof(uint64_t));
+      }
+
+      u = (u & 0x8000000000000000ull) ? ~u : (u | 0x8000000000000000ull);
+      sortKeyPut(pKey, u, bytes, desc);
+      break;
+    }
+    case TSDB_DATA_TYPE_BINARY: {
+      // the binary values are ordered by the length first, and then the content
+      int32_t len = varDataLen(val);
+      sortKeyPut(pKey, (uint64_t)len, sizeof(VarDataLenT), desc);
+
+      int32_t prefix = bytes - sizeof(VarDataLenT);
+      memset(pKey + sizeof(VarDataLenT), 0, prefix);
+      memcpy(pKey + sizeof(VarDataLenT), varDataVal(val), MIN(len, prefix));
+
+      if (desc) {
+        for (int32_t i = sizeof(VarDataLenT); i < bytes; ++i) {
+          pKey[i] = ~pKey[i];
+        }
+      }
+      break;
+    }
+    default:
+      assert(bytes == 0);
+  }
+}
+
+void tColDataEncodeKeys(tOrderDescriptor *pDesc, int32_t orderType, int32_t numOfRows, char *data, int32_t start,
+                        int32_t num, char *pKeys) {
+  SColumnModel *pModel = pDesc->pColumnModel;
+
+  bool    exact = true;
+  int32_t width = tOrderDescKeyWidth(pDesc, &exact);
+
+  int32_t offset = 0;
+  for (int32_t i = 0; i < pDesc->orderInfo.numOfCols && offset < width; ++i) {
+    int32_t  colIdx = pDesc->orderInfo.pData[i];
+    SSchema *pSchema = &pModel->pFields[colIdx].field;
+
+    bool    exactCol = true;
+    int32_t bytes = sortKeyColumnWidth(pSchema, &exactCol);
+
+    // the same as compare_a/compare_d, the timestamp column is in descending order only if it is the primary column
+    bool desc = false;
+    if (pSchema->type == TSDB_DATA_TYPE_TIMESTAMP) {
+      desc = (colIdx == 0 && pDesc->tsOrder == TSDB_ORDER_DESC);
+    } else {
+      desc = (orderType == TSDB_ORDER_DESC);
+    }
+
+    for (int32_t j = 0; j < num; ++j) {
+      char *val = COLMODEL_GET_VAL(data, pModel, numOfRows, start + j, colIdx);
+      encodeKeyColumn(pKeys + j * width + offset, val, pSchema, bytes, desc);
+    }
+
+    offset += bytes;
+  }
+}
+
+static FORCE_INLINE uint64_t sortKeyPrefix(const char *pKey, int32_t width) {
+  int32_t n = MIN(width, (int32_t)sizeof(uint64_t));
+  if (n == 0) {
+    return 0;
+  }
+
+  uint64_t v = 0;
+  for (int32_t i = 0; i < n; ++i) {
+    v = (v << 8) | (uint8_t)pKey[i];
+  }
+
+  return v << ((sizeof(uint64_t) - n) * 8);
+}
+
+static int32_t sortPairCompare(const void *p1, const void *p2, const void *param) {
+  const SSortPair *   pLeft = (const SSortPair *)p1;
+  const SSortPair *   pRight = (const SSortPair *)p2;
+  const SSortContext *pCtx = (const SSortContext *)param;
+
+  if (pLeft->prefix != pRight->prefix) {
+    return (pLeft->prefix < pRight->prefix) ? -1 : 1;
+  }
+
+  int32_t width = pCtx->keyWidth;
+  if (width > sizeof(uint64_t)) {
+    int32_t ret = memcmp(pCtx->pKeys + pLeft->index * width + sizeof(uint64_t),
+                         pCtx->pKeys + pRight->index * width + sizeof(uint64_t), width - sizeof(uint64_t));
+    if (ret != 0) {
+      return (ret < 0) ? -1 : 1;
+    }
+  }
+
+  if (pCtx->exact) {
+    return 0;
+  }
+
+  return pCtx->compareFn(pCtx->pDesc, pCtx->numOfRows, pLeft->index, pRight->index, pCtx->data);
+}
+
+/*
+ * LSD radix sort on the bytes of the prefix, the passes in which all keys have the same byte are skipped. Only the
+ * first keyWidth bytes of the prefix are not zero.
+ */
+static void sortPairRadix(SSortPair *pPairs, SSortPair *pTmp, int32_t num, int32_t keyWidth) {
+  SSortPair *pSrc = pPairs;
+  SSortPair *pDst = pTmp;
+
+  int32_t count[256];
+  for (int32_t shift = (int32_t)(sizeof(uint64_t) - keyWidth) * 8; shift < 64; shift += 8) {
+    memset(count, 0, sizeof(count));
+    for (int32_t i = 0; i < num; ++i) {
+      count[(pSrc[i].prefix >> shift) & 0xFF] += 1;
+    }
+
+    if (count[(pSrc[0].prefix >> shift) & 0xFF] == num) {
+      continue;
+    }
+
+    int32_t pos = 0;
+    for (int32_t i = 0; i < 256; ++i) {
+      int32_t c = count[i];
+      count[i] = pos;
+      pos += c;
+    }
+
+    for (int32_t i = 0; i < num; ++i) {
+      pDst[count[(pSrc[i].prefix >> shift) & 0xFF]++] = pSrc[i];
+    }
+
+    SSortPair *p = pSrc;
+    pSrc = pDst;
+    pDst = p;
+  }
+
+  if (pSrc != pPairs) {
+    memcpy(pPairs, pSrc, sizeof(SSortPair) * num);
+  }
+}
+
+static void *sortPairRun(void *param) {
+  SSortTask *   pTask = (SSortTask *)param;
+  SSortContext *pCtx = pTask->pCtx;
+
+  if (pCtx->exact && pCtx->keyWidth <= sizeof(uint64_t)) {
+    sortPairRadix(pTask->pSrc, pTask->pDst, pTask->num, pCtx->keyWidth);
+  } else {
+    taosqsort(pTask->pSrc, pTask->num, sizeof(SSortPair), pCtx, sortPairCompare);
+  }
+
+  return NULL;
+}
+
+static void *sortPairMerge(void *param) {
+  SSortTask *   pTask = (SSortTask *)param;
+  SSortContext *pCtx = pTask->pCtx;
+
+  SSortPair *pLeft = pTask->pSrc;
+  SSortPair *pRight = pTask->pSrc + pTask->middle;
+  SSortPair *pLeftEnd = pRight;
+  SSortPair *pRightEnd = pTask->pSrc + pTask->num;
+  SSortPair *pDst = pTask->pDst;
+
+  while (pLeft < pLeftEnd && pRight < pRightEnd) {
+    if (sortPairCompare(pRight, pLeft, pCtx) < 0) {
+      *pDst++ = *pRight++;
+    } else {
+      *pDst++ = *pLeft++;
+    }
+  }
+
+  memcpy(pDst, pLeft, (pLeftEnd - pLeft) * sizeof(SSortPair));
+  pDst += (pLeftEnd - pLeft);
+  memcpy(pDst, pRight, (pRightEnd - pRight) * sizeof(SSortPair));
+  return NULL;
+}
+
+static void runSortTasks(SSortTask *pTasks, int32_t numOfTasks, void *(*fp)(void *)) {
+  pthread_t threads[TSORT_MAX_THREADS];
+  bool      created[TSORT_MAX_THREADS] = {0};
+
+  // the first task is executed by the current thread
+  for (int32_t i = 1; i < numOfTasks; ++i) {
+    created[i] = (pthread_create(&threads[i], NULL, fp, &pTasks[i]) == 0);
+    if (!created[i]) {
+      (*fp)(&pTasks[i]);
+    }
+  }
+
+  (*fp)(&pTasks[0]);
+
+  for (int32_t i = 1; i < numOfTasks; ++i) {
+    if (created[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+}
+
+/*
+ * the runs are generated by multiple threads, and then merged pairwise, the merges of one round are also executed
+ * in parallel. The sorted pairs are in pPairs when returns.
+ */
+static void sortPairParallel(SSortContext *pCtx, SSortPair *pPairs, SSortPair *pTmp, int32_t num, int32_t numOfThreads) {
+  SSortTask tasks[TSORT_MAX_THREADS];
+  int32_t   runStart[TSORT_MAX_THREADS + 1];
+
+  int32_t step = num / numOfThreads;
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    runStart[i] = i * step;
+    tasks[i] = (SSortTask){.pCtx = pCtx, .pSrc = pPairs + runStart[i], .pDst = pTmp + runStart[i], .num = step};
+  }
+
+  runStart[numOfThreads] = num;
+  tasks[numOfThreads - 1].num = num - runStart[numOfThreads - 1];
+
+  runSortTasks(tasks, numOfThreads, sortPairRun);
+
+  SSortPair *pSrc = pPairs;
+  SSortPair *pDst = pTmp;
+
+  int32_t numOfRuns = numOfThreads;
+  while (numOfRuns > 1) {
+    int32_t numOfTasks = 0;
+    int32_t i = 0;
+
+    for (; i + 1 < numOfRuns; i += 2) {
+      int32_t s = runStart[i];
+      tasks[numOfTasks++] = (SSortTask){.pCtx = pCtx, .pSrc = pSrc + s, .pDst = pDst + s,
+                                        .num = runStart[i + 2] - s, .middle = runStart[i + 1] - s};
+    }
+
+    // the last run has no partner in this round
+    if (i < numOfRuns) {
+      memcpy(pDst + runStart[i], pSrc + runStart[i], (runStart[i + 1] - runStart[i]) * sizeof(SSortPair));
+    }
+
+    runSortTasks(tasks, numOfTasks, sortPairMerge);
+
+    int32_t n = 0;
+    for (int32_t j = 0; j < numOfRuns; j += 2) {
+      runStart[n++] = runStart[j];
+    }
+
+    runStart[n] = num;
+    numOfRuns = n;
+
+    SSortPair *p = pSrc;
+    pSrc = pDst;
+    pDst = p;
+  }
+
+  if (pSrc != pPairs) {
+    memcpy(pPairs, pSrc, sizeof(SSortPair) * num);
+  }
+}
+
+static int32_t getSortThreads(int32_t num) {
+  if (num < TSORT_PARALLEL_ROWS || tsNumOfCores <= 1) {
+    return 1;
+  }
+
+  int32_t numOfThreads = MIN(tsNumOfCores, TSORT_MAX_THREADS);
+  return MIN(numOfThreads, num / (TSORT_PARALLEL_ROWS / 2));
+}
+
+int32_t tColDataSort(tOrderDescriptor *pDesc, int32_t numOfRows, int32_t start, int32_t end, char *data,
+                     int32_t orderType) {
+  int32_t num = end - start + 1;
+  if (num <= 1) {
+    return 0;
+  }
+
+  SColumnModel *pModel = pDesc->pColumnModel;
+
+  SSortContext ctx = {.pDesc = pDesc, .numOfRows = numOfRows, .data = data};
+  ctx.compareFn = (orderType == TSDB_ORDER_ASC) ? compare_sa : compare_sd;
+  ctx.keyWidth = tOrderDescKeyWidth(pDesc, &ctx.exact);
+
+  int32_t maxBytes = 0;
+  for (int32_t i = 0; i < pModel->numOfCols; ++i) {
+    maxBytes = MAX(maxBytes, pModel->pFields[i].field.bytes);
+  }
+
+  // the keys are indexed by the row index in the page
+  ctx.pKeys = malloc((size_t)ctx.keyWidth * (end + 1) + 1);
+  SSortPair *pPairs = malloc(sizeof(SSortPair) * num * 2);
+  char *     pBuf = malloc((size_t)maxBytes * num);
+
+  if (ctx.pKeys == NULL || pPairs == NULL || pBuf == NULL) {
+    taosTFree(ctx.pKeys);
+    taosTFree(pPairs);
+    taosTFree(pBuf);
+    return -1;
+  }
+
+  tColDataEncodeKeys(pDesc, orderType, numOfRows, data, start, num, ctx.pKeys + (size_t)ctx.keyWidth * start);
+
+  for (int32_t i = 0; i < num; ++i) {
+    pPairs[i].index = start + i;
+    pPairs[i].prefix = sortKeyPrefix(ctx.pKeys + (size_t)ctx.keyWidth * (start + i), ctx.keyWidth);
+  }
+
+  int32_t numOfThreads = getSortThreads(num);
+  if (numOfThreads > 1) {
+    qDebug("sort %d rows by %d threads, key width:%d", num, numOfThreads, ctx.keyWidth);
+    sortPairParallel(&ctx, pPairs, pPairs + num, num, numOfThreads);
+  } else {
+    SSortTask task = {.pCtx = &ctx, .pSrc = pPairs, .pDst = pPairs + num, .num = num};
+    sortPairRun(&task);
+  }
+
+  // move the rows to the final position column by column
+  for (int32_t i = 0; i < pModel->numOfCols; ++i) {
+    int32_t bytes = pModel->pFields[i].field.bytes;
+    char *  pCol = data + pModel->pFields[i].offset * numOfRows;
+
+    for (int32_t j = 0; j < num; ++j) {
+      memcpy(pBuf + j * bytes, pCol + pPairs[j].index * bytes, bytes);
+    }
+
+    memcpy(pCol + start * bytes, pBuf, (size_t)bytes * num);
+  }
+
+  free(ctx.pKeys);
+  free(pPairs);
+  free(pBuf);
+  return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qTDigest.h"
+
+/**
+ *
+ * implement the merging t-digest based on the paper:
+ * Ted Dunning, Otmar Ertl. Computing Extremely Accurate Quantiles Using t-Digests.
+ * https://arxiv.org/abs/1902.04023
+ *
+ * The values are appended into a buffer, and merged with the existing centroids when the buffer is full. The size
+ * of each centroid is limited by the scale function k1(q) = compression / (2 * PI) * asin(2 * q - 1), so the
+ * centroids near both tails are much smaller than those in the middle, which gives the accurate p99/p999.
+ *
+ */
+
+static int32_t centroidCompare(const void* pLeft, const void* pRight) {
+  double l = ((const SCentroid*)pLeft)->mean;
+  double r = ((const SCentroid*)pRight)->mean;
+
+  if (l == r) {
+    return 0;
+  }
+
+  return (l < r) ? -1 : 1;
+}
+
+/* the max quantile that can be covered by the centroid starting at quantile q0 */
+static FORCE_INLINE double quantileLimit(double q0, int32_t compression) {
+  double k = asin(2 * q0 - 1) + 2 * M_PI / compression;
+  if (k >= M_PI / 2) {
+    return 1.0;
+  }
+
+  return (sin(k) + 1) / 2;
+}
+
+STDigest* tDigestCreate(int32_t compression) {
+  void* pBuf = malloc(TDIGEST_SIZE(compression) + sizeof(SCentroid) * TDIGEST_BUFFER_LEN(compression));
+  if (pBuf == NULL) {
+    return NULL;
+  }
+
+  STDigest* pDigest = tDigestCreateFrom(pBuf, compression);
+  tDigestSetBuffer(pDigest, (SCentroid*)((char*)pBuf + TDIGEST_SIZE(compression)));
+  return pDigest;
+}
+
+STDigest* tDigestCreateFrom(void* pBuf, int32_t compression) {
+  memset(pBuf, 0, TDIGEST_SIZE(compression));
+
+  STDigest* pDigest = (STDigest*)pBuf;
+  pDigest->compression = compression;
+  pDigest->maxBuffered = TDIGEST_BUFFER_SIZE(compression);
+
+  pDigest->min = DBL_MAX;
+  pDigest->max = -DBL_MAX;
+
+  tDigestAutoFill(pDigest);
+  return pDigest;
+}
+
+void tDigestAutoFill(STDigest* pDigest) {
+  pDigest->centroids = (SCentroid*)((char*)pDigest + sizeof(STDigest));
+  pDigest->buffer = NULL;
+}
+
+void tDigestSetBuffer(STDigest* pDigest, SCentroid* pBuffer) { pDigest->buffer = pBuffer; }
+
+void tDigestCompress(STDigest* pDigest) {
+  if (pDigest->numOfBuffered == 0) {
+    return;
+  }
+
+  // the buffer is large enough to hold all centroids, the sorted buffered values and the sorted centroids are merged
+  SCentroid* pList = pDigest->buffer;
+  int32_t    nb = pDigest->numOfBuffered;
+  int32_t    num = nb + pDigest->numOfCentroids;
+  int32_t    ib = 0;
+  int32_t    ic = nb;
+
+  qsort(pList, nb, sizeof(SCentroid), centroidCompare);
+  memcpy(&pList[nb], pDigest->centroids, sizeof(SCentroid) * pDigest->numOfCentroids);
+
+  int32_t maxCentroids = TDIGEST_MAX_CENTROIDS(pDigest->compression);
+  double  total = (double)pDigest->total;
+  int64_t weightSoFar = 0;
+  double  limit = quantileLimit(0, pDigest->compression) * total;
+
+  int32_t   n = 0;
+  SCentroid cur = (ic == num || pList[ib].mean <= pList[ic].mean) ? pList[ib++] : pList[ic++];
+
+  for (int32_t i = 1; i < num; ++i) {
+    SCentroid* p = (ic == num || (ib < nb && pList[ib].mean <= pList[ic].mean)) ? &pList[ib++] : &pList[ic++];
+
+    if (weightSoFar + cur.weight + p->weight <= limit || n >= maxCentroids - 1) {
+      cur.weight += p->weight;
+      cur.mean += (p->mean - cur.mean) * p->weight / cur.weight;
+    } else {
+      weightSoFar += cur.weight;
+      pDigest->centroids[n++] = cur;
+
+      limit = quantileLimit(weightSoFar / total, pDigest->compression) * total;
+      cur = *p;
+    }
+  }
+
+  pDigest->centroids[n++] = cur;
+  pDigest->numOfCentroids = n;
+  pDigest->numOfBuffered = 0;
+}
+
+void tDigestAdd(STDigest* pDigest, double val, int64_t weight) {
+  if (weight <= 0) {
+    return;
+  }
+
+  SCentroid* p = &pDigest->buffer[pDigest->numOfBuffered++];
+  p->mean = val;
+  p->weight = weight;
+
+  pDigest->total += weight;
+
+  if (val < pDigest->min) {
+    pDigest->min = val;
+  }
+
+  if (val > pDigest->max) {
+    pDigest->max = val;
+  }
+
+  if (pDigest->numOfBuffered >= pDigest->maxBuffered) {
+    tDigestCompress(pDigest);
+  }
+}
+
+void tDigestAddBatch(STDigest* pDigest, const double* val, int32_t num) {
+  int32_t i = 0;
+
+  while (i < num) {
+    int32_t remain = pDigest->maxBuffered - pDigest->numOfBuffered;
+    int32_t end = (num - i < remain) ? num : i + remain;
+
+    SCentroid* p = &pDigest->buffer[pDigest->numOfBuffered];
+    for (; i < end; ++i, ++p) {
+      p->mean = val[i];
+      p->weight = 1;
+
+      if (val[i] < pDigest->min) {
+        pDigest->min = val[i];
+      }
+
+      if (val[i] > pDigest->max) {
+        pDigest->max = val[i];
+      }
+    }
+
+    pDigest->total += (p - &pDigest->buffer[pDigest->numOfBuffered]);
+    pDigest->numOfBuffered = (int32_t)(p - pDigest->buffer);
+
+    if (pDigest->numOfBuffered >= pDigest->maxBuffered) {
+      tDigestCompress(pDigest);
+    }
+  }
+}
+
+void tDigestMerge(STDigest* pDigest, STDigest* pOther) {
+  for (int32_t i = 0; i < pOther->numOfCentroids; ++i) {
+    tDigestAdd(pDigest, pOther->centroids[i].mean, pOther->centroids[i].weight);
+  }
+
+  for (int32_t i = 0; i < pOther->numOfBuffered; ++i) {
+    tDigestAdd(pDigest, pOther->buffer[i].mean, pOther->buffer[i].weight);
+  }
+
+  // the min/max of the other digest may be not the mean of any centroid
+  if (pOther->total > 0) {
+    pDigest->min = (pOther->min < pDigest->min) ? pOther->min : pDigest->min;
+    pDigest->max = (pOther->max > pDigest->max) ? pOther->max : pDigest->max;
+  }
+}
+
+double tDigestQuantile(STDigest* pDigest, double q) {
+  tDigestCompress(pDigest);
+
+  int32_t    n = pDigest->numOfCentroids;
+  SCentroid* c = pDigest->centroids;
+
+  if (n == 0) {
+    return NAN;
+  } else if (q <= 0) {
+    return pDigest->min;
+  } else if (q >= 1) {
+    return pDigest->max;
+  } else if (n == 1) {
+    return c[0].mean;
+  }
+
+  double index = q * pDigest->total;
+
+  // the first half of the first centroid, interpolate between the min value and the centroid
+  if (index < c[0].weight / 2.0) {
+    return pDigest->min + 2 * index / c[0].weight * (c[0].mean - pDigest->min);
+  }
+
+  double weightSoFar = c[0].weight / 2.0;
+  for (int32_t i = 0; i < n - 1; ++i) {
+    double dw = (c[i].weight + c[i + 1].weight) / 2.0;
+
+    if (weightSoFar + dw > index) {
+      double z1 = index - weightSoFar;
+      double z2 = weightSoFar + dw - index;
+      return (c[i].mean * z2 + c[i + 1].mean * z1) / dw;
+    }
+
+    weightSoFar += dw;
+  }
+
+  // the second half of the last centroid, interpolate between the centroid and the max value
+  double z1 = index - weightSoFar;
+  double half = c[n - 1].weight / 2.0;
+  if (z1 >= half) {
+    return pDigest->max;
+  }
+
+  return c[n - 1].mean + z1 / half * (pDigest->max - c[n - 1].mean);
+}
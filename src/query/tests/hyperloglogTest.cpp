@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "taos.h"
+#include "tsdb.h"
+
+#include "qHyperLogLog.h"
+
+namespace {
+double relativeError(int64_t v, int64_t expect) { return fabs((double)(v - expect)) / expect; }
+}  // namespace
+
+TEST(testCase, hll_small_range) {
+  SHyperLogLog hll = {{0}};
+  EXPECT_EQ(tHLLCount(&hll), 0);
+
+  for (int32_t i = 0; i < 100; ++i) {
+    for (int64_t j = 0; j < 1000; ++j) {
+      tHLLAdd(&hll, &j, sizeof(int64_t));
+    }
+  }
+
+  EXPECT_LT(relativeError(tHLLCount(&hll), 1000), 0.02);
+}
+
+TEST(testCase, hll_large_range) {
+  SHyperLogLog hll = {{0}};
+
+  const int64_t num = 10000000;
+  for (int64_t i = 0; i < num; ++i) {
+    tHLLAdd(&hll, &i, sizeof(int64_t));
+  }
+
+  EXPECT_LT(relativeError(tHLLCount(&hll), num), 0.05);
+}
+
+TEST(testCase, hll_merge) {
+  SHyperLogLog hll1 = {{0}};
+  SHyperLogLog hll2 = {{0}};
+
+  char buf[32] = {0};
+  for (int32_t i = 0; i < 200000; ++i) {
+    int32_t len = sprintf(buf, "device_%d", i);
+    tHLLAdd(&hll1, buf, len);
+  }
+
+  // half of the values are overlapped
+  for (int32_t i = 100000; i < 300000; ++i) {
+    int32_t len = sprintf(buf, "device_%d", i);
+    tHLLAdd(&hll2, buf, len);
+  }
+
+  tHLLMerge(&hll1, &hll2);
+  EXPECT_LT(relativeError(tHLLCount(&hll1), 300000), 0.05);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "taos.h"
+#include "tsdb.h"
+
+#include "qPercentile.h"
+#include "tglobal.h"
+
+namespace {
+tMemBucket* createBucket(int16_t type, int16_t bytes, int64_t* pMemBudget = NULL) {
+  SSchema field[1] = {{(uint8_t)type, "dummyCol", 0, bytes}};
+
+  SColumnModel* pModel = createColumnModel(field, 1, 1000);
+  int32_t       orderIdx = 0;
+
+  tOrderDescriptor* pDesc = tOrderDesCreate(&orderIdx, 1, pModel, TSDB_ORDER_DESC);
+  return tMemBucketCreate(1024, 1 << 20, bytes, type, pDesc, pMemBudget);
+}
+
+void destroyBucket(tMemBucket* pBucket) {
+  tOrderDescDestroy(pBucket->pOrderDesc);
+  tMemBucketDestroy(pBucket);
+}
+
+double exactPercentile(std::vector<double> v, double percent) {
+  std::sort(v.begin(), v.end());
+
+  double  percentVal = (percent * (v.size() - 1)) / 100.0;
+  int32_t idx = (int32_t)percentVal;
+  if (idx == (int32_t)v.size() - 1) {
+    return v[idx];
+  }
+
+  double fraction = percentVal - idx;
+  return (1 - fraction) * v[idx] + fraction * v[idx + 1];
+}
+}  // namespace
+
+TEST(testCase, percentile_in_memory) {
+  tMemBucket* pBucket = createBucket(TSDB_DATA_TYPE_INT, sizeof(int32_t));
+
+  std::vector<double> v;
+  for (int32_t i = 0; i < 100000; ++i) {
+    int32_t val = (i * 7919) % 100003;
+    v.push_back(val);
+    tMemBucketPut(pBucket, &val, 1);
+  }
+
+  ASSERT_TRUE(pBucket->pInMemBuf != NULL);
+
+  double percents[] = {0, 1, 25, 50, 90, 99, 99.9, 100};
+  for (int32_t i = 0; i < (int32_t)(sizeof(percents) / sizeof(percents[0])); ++i) {
+    EXPECT_DOUBLE_EQ(getPercentile(pBucket, percents[i]), exactPercentile(v, percents[i]));
+  }
+
+  destroyBucket(pBucket);
+}
+
+TEST(testCase, percentile_duplicated_values) {
+  tMemBucket* pBucket = createBucket(TSDB_DATA_TYPE_DOUBLE, sizeof(double));
+
+  std::vector<double> v;
+  double              vals[1000] = {0};
+  for (int32_t i = 0; i < 1000; ++i) {
+    vals[i] = i % 3;
+    v.push_back(vals[i]);
+  }
+
+  tMemBucketPut(pBucket, vals, 1000);
+
+  EXPECT_DOUBLE_EQ(getPercentile(pBucket, 50), exactPercentile(v, 50));
+  EXPECT_DOUBLE_EQ(getPercentile(pBucket, 66.7), exactPercentile(v, 66.7));
+
+  destroyBucket(pBucket);
+}
+
+TEST(testCase, percentile_spill_to_bucket) {
+  int32_t size = tsPercentileMemSize;
+  tsPercentileMemSize = 1;  // 1MB, about 87k values of int
+
+  tMemBucket* pBucket = createBucket(TSDB_DATA_TYPE_INT, sizeof(int32_t));
+
+  std::vector<double> v;
+  for (int64_t i = 0; i < 200000; ++i) {
+    int32_t val = (int32_t)((i * 7919) % 200003);
+    v.push_back((double)val);
+    tMemBucketPut(pBucket, &val, 1);
+  }
+
+  ASSERT_TRUE(pBucket->pInMemBuf == NULL);
+  EXPECT_EQ(pBucket->numOfElems, 200000);
+  EXPECT_DOUBLE_EQ(getPercentile(pBucket, 50), exactPercentile(v, 50));
+
+  destroyBucket(pBucket);
+  tsPercentileMemSize = size;
+}
+
+// the buckets of a query share one budget, the bucket failing to reserve memory from it is spilled
+TEST(testCase, percentile_shared_budget) {
+  int64_t budget = 1 << 20;  // about 87k values of int
+
+  tMemBucket* pBucket1 = createBucket(TSDB_DATA_TYPE_INT, sizeof(int32_t), &budget);
+  tMemBucket* pBucket2 = createBucket(TSDB_DATA_TYPE_INT, sizeof(int32_t), &budget);
+
+  std::vector<double> v;
+  for (int32_t i = 0; i < 60000; ++i) {
+    int32_t val = (i * 7919) % 60013;
+    v.push_back(val);
+    tMemBucketPut(pBucket1, &val, 1);
+  }
+
+  for (int32_t i = 0; i < 60000; ++i) {
+    int32_t val = (int32_t)v[i];
+    tMemBucketPut(pBucket2, &val, 1);
+  }
+
+  ASSERT_TRUE(pBucket1->pInMemBuf != NULL);
+  ASSERT_TRUE(pBucket2->pInMemBuf == NULL);
+  EXPECT_LT(budget, 1 << 20);
+  EXPECT_GE(budget, 0);
+
+  EXPECT_DOUBLE_EQ(getPercentile(pBucket1, 50), exactPercentile(v, 50));
+  EXPECT_DOUBLE_EQ(getPercentile(pBucket2, 50), exactPercentile(v, 50));
+
+  destroyBucket(pBucket1);
+  destroyBucket(pBucket2);
+  EXPECT_EQ(budget, 1 << 20);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "taos.h"
+#include "tsdb.h"
+
+#include "qExtbuffer.h"
+#include "qSort.h"
+#include "tglobal.h"
+
+namespace {
+// check the page is sorted according to the comparator of the column model
+void checkSorted(tOrderDescriptor* pDesc, int32_t numOfRows, char* data, int32_t num, int32_t order) {
+  for (int32_t i = 1; i < num; ++i) {
+    int32_t ret = (order == TSDB_ORDER_ASC) ? compare_sa(pDesc, numOfRows, i - 1, i, data)
+                                            : compare_sd(pDesc, numOfRows, i - 1, i, data);
+    ASSERT_LE(ret, 0) << "row " << i;
+  }
+}
+}  // namespace
+
+TEST(testCase, sort_int_radix) {
+  SSchema field[2] = {{TSDB_DATA_TYPE_INT, "k", 0, sizeof(int32_t)}, {TSDB_DATA_TYPE_DOUBLE, "v", 1, sizeof(double)}};
+
+  const int32_t num = 10000;
+  SColumnModel* pModel = createColumnModel(field, 2, num);
+
+  int32_t           orderIdx = 0;
+  tOrderDescriptor* pDesc = tOrderDesCreate(&orderIdx, 1, pModel, TSDB_ORDER_ASC);
+
+  char* data = (char*)calloc(num, pModel->rowSize);
+  for (int32_t i = 0; i < num; ++i) {
+    int32_t k = (i * 7919) % 10007 - 5000;
+    double  v = k * 2.0;
+    memcpy(data + i * sizeof(int32_t), &k, sizeof(int32_t));
+    memcpy(data + num * sizeof(int32_t) + i * sizeof(double), &v, sizeof(double));
+  }
+
+  ASSERT_EQ(tColDataSort(pDesc, num, 0, num - 1, data, TSDB_ORDER_DESC), 0);
+  checkSorted(pDesc, num, data, num, TSDB_ORDER_DESC);
+
+  // the other columns are moved together with the order column
+  for (int32_t i = 0; i < num; ++i) {
+    int32_t k = *(int32_t*)(data + i * sizeof(int32_t));
+    double  v = *(double*)(data + num * sizeof(int32_t) + i * sizeof(double));
+    ASSERT_EQ(v, k * 2.0);
+  }
+
+  free(data);
+  tOrderDescDestroy(pDesc);
+}
+
+TEST(testCase, sort_multi_columns) {
+  SSchema field[3] = {{TSDB_DATA_TYPE_BINARY, "s", 0, 20 + VARSTR_HEADER_SIZE},
+                      {TSDB_DATA_TYPE_FLOAT, "f", 1, sizeof(float)},
+                      {TSDB_DATA_TYPE_TINYINT, "t", 2, sizeof(int8_t)}};
+
+  const int32_t num = 5000;
+  SColumnModel* pModel = createColumnModel(field, 3, num);
+
+  int32_t           orderIdx[3] = {0, 1, 2};
+  tOrderDescriptor* pDesc = tOrderDesCreate(orderIdx, 3, pModel, TSDB_ORDER_ASC);
+
+  char* data = (char*)calloc(num, pModel->rowSize);
+  for (int32_t i = 0; i < num; ++i) {
+    char* s = data + i * field[0].bytes;
+    varDataSetLen(s, sprintf((char*)varDataVal(s), "device_%d", i % 37));
+
+    float f = (float)((i % 11) - 5) / 3;
+    memcpy(data + num * field[0].bytes + i * sizeof(float), &f, sizeof(float));
+
+    int8_t t = (int8_t)(i % 256 - 128);
+    memcpy(data + num * (field[0].bytes + sizeof(float)) + i, &t, sizeof(int8_t));
+  }
+
+  ASSERT_EQ(tColDataSort(pDesc, num, 0, num - 1, data, TSDB_ORDER_ASC), 0);
+  checkSorted(pDesc, num, data, num, TSDB_ORDER_ASC);
+
+  ASSERT_EQ(tColDataSort(pDesc, num, 0, num - 1, data, TSDB_ORDER_DESC), 0);
+  checkSorted(pDesc, num, data, num, TSDB_ORDER_DESC);
+
+  free(data);
+  tOrderDescDestroy(pDesc);
+}
+
+TEST(testCase, sort_parallel) {
+  int32_t cores = tsNumOfCores;
+  tsNumOfCores = 4;
+
+  SSchema field[2] = {{TSDB_DATA_TYPE_TIMESTAMP, "ts", 0, sizeof(int64_t)},
+                      {TSDB_DATA_TYPE_DOUBLE, "v", 1, sizeof(double)}};
+
+  const int32_t num = 300000;
+  SColumnModel* pModel = createColumnModel(field, 2, num);
+
+  // order by the double column first, the timestamp column
+  int32_t           orderIdx[2] = {1, 0};
+  tOrderDescriptor* pDesc = tOrderDesCreate(orderIdx, 2, pModel, TSDB_ORDER_DESC);
+
+  char* data = (char*)calloc(num, pModel->rowSize);
+  for (int32_t i = 0; i < num; ++i) {
+    int64_t ts = 1500000000000L + i;
+    double  v = (i * 7919) % 1000 - 500.5;
+    memcpy(data + i * sizeof(int64_t), &ts, sizeof(int64_t));
+    memcpy(data + num * sizeof(int64_t) + i * sizeof(double), &v, sizeof(double));
+  }
+
+  ASSERT_EQ(tColDataSort(pDesc, num, 0, num - 1, data, TSDB_ORDER_ASC), 0);
+  checkSorted(pDesc, num, data, num, TSDB_ORDER_ASC);
+
+  free(data);
+  tOrderDescDestroy(pDesc);
+  tsNumOfCores = cores;
+}
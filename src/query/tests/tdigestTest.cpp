@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "taos.h"
+#include "tsdb.h"
+
+#include "qTDigest.h"
+
+namespace {
+double relativeError(double v, double expect) { return fabs(v - expect) / expect; }
+}  // namespace
+
+TEST(testCase, tdigest_quantile) {
+  STDigest* pDigest = tDigestCreate(TDIGEST_DEFAULT_COMPRESSION);
+
+  const int32_t num = 1000000;
+  for (int32_t i = 1; i <= num; ++i) {
+    tDigestAdd(pDigest, i, 1);
+  }
+
+  ASSERT_EQ(pDigest->total, num);
+  ASSERT_LE(pDigest->numOfCentroids, TDIGEST_MAX_CENTROIDS(TDIGEST_DEFAULT_COMPRESSION));
+
+  EXPECT_EQ(tDigestQuantile(pDigest, 0), 1);
+  EXPECT_EQ(tDigestQuantile(pDigest, 1), num);
+
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest, 0.5), num * 0.5), 0.01);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest, 0.99), num * 0.99), 0.001);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest, 0.999), num * 0.999), 0.0001);
+
+  free(pDigest);
+}
+
+TEST(testCase, tdigest_batch_merge) {
+  STDigest* pDigest1 = tDigestCreate(TDIGEST_DEFAULT_COMPRESSION);
+  STDigest* pDigest2 = tDigestCreate(TDIGEST_DEFAULT_COMPRESSION);
+
+  double buf[3000] = {0};
+  for (int32_t i = 0; i < 3000; ++i) {
+    buf[i] = i;
+  }
+
+  for (int32_t i = 0; i < 100; ++i) {
+    tDigestAddBatch(pDigest1, buf, 3000);
+  }
+
+  for (int32_t i = 0; i < 3000; ++i) {
+    buf[i] = 3000 + i;
+  }
+
+  for (int32_t i = 0; i < 100; ++i) {
+    tDigestAddBatch(pDigest2, buf, 3000);
+  }
+
+  // transfer the digest by copying the continuous buffer, the buffered values are compressed before
+  tDigestCompress(pDigest2);
+  ASSERT_EQ(pDigest2->numOfBuffered, 0);
+  char* pBuf = (char*)malloc(TDIGEST_SIZE(TDIGEST_DEFAULT_COMPRESSION));
+  memcpy(pBuf, pDigest2, TDIGEST_SIZE(TDIGEST_DEFAULT_COMPRESSION));
+  free(pDigest2);
+
+  STDigest* pCopy = (STDigest*)pBuf;
+  tDigestAutoFill(pCopy);
+
+  tDigestMerge(pDigest1, pCopy);
+  ASSERT_EQ(pDigest1->total, 600000);
+
+  EXPECT_EQ(tDigestQuantile(pDigest1, 0), 0);
+  EXPECT_EQ(tDigestQuantile(pDigest1, 1), 5999);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest1, 0.5), 3000), 0.01);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest1, 0.99), 5940), 0.001);
+
+  free(pDigest1);
+  free(pBuf);
+}
+
+// the digest created in a buffer has no buffer of its own, the values are added with a buffer set by the caller
+TEST(testCase, tdigest_outer_buffer) {
+  char*     pBuf = (char*)malloc(TDIGEST_SIZE(TDIGEST_DEFAULT_COMPRESSION));
+  STDigest* pDigest = tDigestCreateFrom(pBuf, TDIGEST_DEFAULT_COMPRESSION);
+  ASSERT_TRUE(pDigest->buffer == NULL);
+
+  const int32_t num = 10000;
+  for (int32_t i = 1; i <= num; ++i) {
+    SCentroid buffer[TDIGEST_BUFFER_LEN(TDIGEST_DEFAULT_COMPRESSION)];
+    tDigestSetBuffer(pDigest, buffer);
+    tDigestAdd(pDigest, num + 1 - i, 1);
+    tDigestCompress(pDigest);
+    tDigestAutoFill(pDigest);
+    ASSERT_EQ(pDigest->numOfBuffered, 0);
+  }
+
+  ASSERT_EQ(pDigest->total, num);
+  ASSERT_LE(pDigest->numOfCentroids, TDIGEST_MAX_CENTROIDS(TDIGEST_DEFAULT_COMPRESSION));
+  for (int32_t i = 1; i < pDigest->numOfCentroids; ++i) {
+    ASSERT_LE(pDigest->centroids[i - 1].mean, pDigest->centroids[i].mean);
+  }
+
+  EXPECT_EQ(tDigestQuantile(pDigest, 0), 1);
+  EXPECT_EQ(tDigestQuantile(pDigest, 1), num);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest, 0.5), num * 0.5), 0.01);
+  EXPECT_LT(relativeError(tDigestQuantile(pDigest, 0.99), num * 0.99), 0.002);
+
+  free(pBuf);
+}
@@ -17,6 +17,7 @@
 #include "tidpool.h"
 #include "tmd5.h"
 #include "tmempool.h"
+#include "tslab.h"
 #include "ttimer.h"
 #include "tutil.h"
 #include "lz4.h"
@@ -260,7 +261,7 @@ void *rpcOpen(const SRpcInit *pInit) {
   }
 
   if (pRpc->connType == TAOS_CONN_SERVER) {
-    pRpc->hash = taosHashInit(pRpc->sessions, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true);
+    pRpc->hash = taosHashInitConcurrent(pRpc->sessions, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY));
     if (pRpc->hash == NULL) {
       tError("%s failed to init string hash", pRpc->label);
       rpcClose(pRpc);
@@ -318,7 +319,7 @@ void rpcClose(void *param) {
 void *rpcMallocCont(int contLen) {
   int size = contLen + RPC_MSG_OVERHEAD;
 
-  char *start = (char *)calloc(1, (size_t)size);
+  char *start = (char *)taosSlabMalloc(TAOS_SLAB_RPC, size);
   if (start == NULL) {
     tError("failed to malloc msg, size:%d", size);
     return NULL;
@@ -330,7 +331,7 @@ void *rpcMallocCont(int contLen) {
 void rpcFreeCont(void *cont) {
   if ( cont ) {
     char *temp = ((char *)cont) - sizeof(SRpcHead) - sizeof(SRpcReqContext);
-    free(temp);
+    taosSlabFree(temp);
     // tTrace("free mem: %p", temp);
   }
 }
@@ -340,12 +341,12 @@ void *rpcReallocCont(void *ptr, int contLen) {
 
   char *start = ((char *)ptr) - sizeof(SRpcReqContext) - sizeof(SRpcHead);
   if (contLen == 0 ) {
-    free(start); 
+    taosSlabFree(start); 
     return NULL;
   }
 
   int size = contLen + RPC_MSG_OVERHEAD;
-  start = realloc(start, size);
+  start = taosSlabRealloc(TAOS_SLAB_RPC, start, size);
   if (start == NULL) {
     tError("failed to realloc cont, size:%d", size);
     return NULL;
@@ -550,7 +551,7 @@ void rpcCancelRequest(void *handle) {
 static void rpcFreeMsg(void *msg) {
   if ( msg ) {
     char *temp = (char *)msg - sizeof(SRpcReqContext);
-    free(temp);
+    taosSlabFree(temp);
     // tTrace("free mem: %p", temp);
   }
 }
@@ -1421,10 +1422,10 @@ static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead) {
     int contLen = htonl(pComp->contLen);
   
     // prepare the temporary buffer to decompress message
-    char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
-    pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
+    char *temp = (char *)taosSlabMalloc(TAOS_SLAB_RPC, contLen + RPC_MSG_OVERHEAD);
   
-    if (pNewHead) {
+    if (temp) {
+      pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
       int compLen = rpcContLenFromMsg(pHead->msgLen) - overhead;
       int origLen = LZ4_decompress_safe((char*)(pCont + overhead), (char *)pNewHead->content, compLen, contLen);
       assert(origLen == contLen);
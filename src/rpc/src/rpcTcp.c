@@ -18,6 +18,8 @@
 #include "tutil.h"
 #include "taosdef.h"
 #include "taoserror.h" 
+#include "tslab.h"
+#include "tplacement.h"
 #include "rpcLog.h"
 #include "rpcHead.h"
 #include "rpcTcp.h"
@@ -228,6 +230,7 @@ static void *taosAcceptTcpConnection(void *arg) {
   SServerObj        *pServerObj;
 
   pServerObj = (SServerObj *)arg;
+  taosPlaceThread(TAOS_THREAD_POOL_RPC);
   tDebug("%s TCP server is ready, ip:0x%x:%hu", pServerObj->label, pServerObj->ip, pServerObj->port);
 
   while (1) {
@@ -417,7 +420,7 @@ static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
   }
 
   msgLen = (int32_t)htonl((uint32_t)rpcHead.msgLen);
-  buffer = malloc(msgLen + tsRpcOverhead);
+  buffer = taosSlabMalloc(TAOS_SLAB_RPC, msgLen + tsRpcOverhead);
   if ( NULL == buffer) {
     tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
     return -1;
@@ -432,7 +435,7 @@ static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
   if (leftLen != retLen) {
     tError("%s %p read error, leftLen:%d retLen:%d FD:%p", 
             pThreadObj->label, pFdObj->thandle, leftLen, retLen, pFdObj);
-    free(buffer);
+    taosSlabFree(buffer);
     return -1;
   }
 
@@ -448,7 +451,7 @@ static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
   pInfo->connType = RPC_CONN_TCP;
 
   if (pFdObj->closedByApp) {
-    free(buffer); 
+    taosSlabFree(buffer); 
     return -1;
   }
 
@@ -462,7 +465,8 @@ static void *taosProcessTcpData(void *param) {
   SFdObj            *pFdObj;
   struct epoll_event events[maxEvents];
   SRecvInfo          recvInfo;
- 
+  taosPlaceThread(TAOS_THREAD_POOL_RPC);
+
   while (1) {
     int fdNum = epoll_wait(pThreadObj->pollFd, events, maxEvents, -1);
     if (pThreadObj->stop) {
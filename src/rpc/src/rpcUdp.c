@@ -20,6 +20,8 @@
 #include "tutil.h"
 #include "taosdef.h"
 #include "taoserror.h"
+#include "tslab.h"
+#include "tplacement.h"
 #include "rpcLog.h"
 #include "rpcUdp.h"
 #include "rpcHead.h"
@@ -192,6 +194,7 @@ static void *taosRecvUdpData(void *param) {
 
   memset(&sourceAdd, 0, sizeof(sourceAdd));
   addLen = sizeof(sourceAdd);
+  taosPlaceThread(TAOS_THREAD_POOL_RPC);
   tDebug("%s UDP thread is created, index:%d", pConn->label, pConn->index);
   char *msg = pConn->buffer;
 
@@ -209,7 +212,7 @@ static void *taosRecvUdpData(void *param) {
       continue;
     }
 
-    char *tmsg = malloc(dataLen + tsRpcOverhead);
+    char *tmsg = taosSlabMalloc(TAOS_SLAB_RPC, dataLen + tsRpcOverhead);
     if (NULL == tmsg) {
       tError("%s failed to allocate memory, size:%ld", pConn->label, dataLen);
       continue;
@@ -21,6 +21,7 @@
 #include "tqueue.h"
 #include "twal.h"
 #include "tsync.h"
+#include "tplacement.h"
 #include "syncInt.h"
 
 static void syncRemoveExtraFile(SSyncPeer *pPeer, uint32_t sindex, uint32_t eindex) {
@@ -298,6 +299,7 @@ void *syncRestoreData(void *param)
   SSyncNode  *pNode = pPeer->pSyncNode;
 
   taosBlockSIGPIPE();
+  taosPlaceThread(TAOS_THREAD_POOL_SYNC);
   __sync_fetch_and_add(&tsSyncNum, 1);
 
   (*pNode->notifyRole)(pNode->ahandle, TAOS_SYNC_ROLE_SYNCING);
@@ -25,6 +25,7 @@
 #include "tsocket.h"
 #include "twal.h"
 #include "tsync.h"
+#include "tplacement.h"
 #include "syncInt.h"
 
 static int syncAddIntoWatchList(SSyncPeer *pPeer, char *name) 
@@ -458,6 +459,7 @@ void *syncRetrieveData(void *param)
   SSyncPeer  *pPeer = (SSyncPeer *)param;
   SSyncNode  *pNode = pPeer->pSyncNode;
   taosBlockSIGPIPE();
+  taosPlaceThread(TAOS_THREAD_POOL_SYNC);
 
   pPeer->fileChanged = 0;
   pPeer->syncFd = taosOpenTcpClientSocket(pPeer->ip, pPeer->port, 0);
@@ -18,6 +18,7 @@
 #include "tutil.h"
 #include "tsocket.h"
 #include "taoserror.h"
+#include "tplacement.h"
 #include "taosTcpPool.h"
 
 typedef struct SThreadObj {
@@ -181,6 +182,7 @@ static void *taosProcessTcpData(void *param) {
 
   void *buffer = malloc(pInfo->bufferSize);
   taosBlockSIGPIPE();
+  taosPlaceThread(TAOS_THREAD_POOL_SYNC);
 
   while (1) {
     if (pThread->stop) break; 
@@ -235,6 +237,7 @@ static void *taosAcceptPeerTcpConnection(void *argv) {
   SPoolInfo  *pInfo = &pPool->info;
 
   taosBlockSIGPIPE();
+  taosPlaceThread(TAOS_THREAD_POOL_SYNC);
 
   while (1) {
     struct sockaddr_in clientAddr;
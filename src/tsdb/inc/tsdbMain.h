@@ -65,6 +65,7 @@ typedef struct STable {
   void*          eventHandler;   // TODO
   void*          streamHandler;  // TODO
   TSKEY          lastKey;        // lastkey inserted in this table, initialized as 0, TODO: make a structure
+  bool           restored;       // lastKey is restored from data files, see tsdbRestoreTableInfo
   char*          sql;
   void*          cqhandle;
   SRWLatch       latch;  // TODO: implementa latch functions
@@ -99,6 +100,18 @@ typedef struct {
   int            nBufBlocks;
   int64_t        index;
   SList*         bufBlockList;
+  int8_t         registered;       // the pool is accounted in the dnode buffer budget
+  int            nBorrowed;        // blocks borrowed from the dnode buffer budget, protected by the repo lock
+  int            memBorrowed;      // blocks borrowed by the memtable being written
+  int64_t        memStartTime;     // time when the memtable being written is created
+  int8_t         commitRequested;  // the dnode buffer budget runs low and asks the repo to commit
+  char*          region;           // the configured blocks are carved out of the region if it is mapped
+  size_t         regionSize;
+  int8_t         hugePage;         // huge page mode taken by the region
+  int8_t         numaBind;         // the region follows the NUMA node of the write thread
+  int32_t        numaNode;         // NUMA node the region is bound to, -1 if not bound
+  int32_t        numaMisses;       // blocks taken in a row by the write threads on other nodes
+  int32_t        numaMoveTo;       // node the pages of the region are to be moved to out of the repo lock, -1 if none
 } STsdbBufPool;
 
 // ------------------ tsdbMemTable.c
@@ -112,6 +125,7 @@ typedef struct {
   TSKEY      keyFirst;
   TSKEY      keyLast;
   int64_t    numOfRows;
+  TSKEY      commitKey;  // the rows not later than it are out of order, it is the last key when the data is created
   SSkipList* pData;
 } STableData;
 
@@ -125,9 +139,39 @@ typedef struct {
   STableData** tData;
   SList*       actList;
   SList*       extraBuffList;
+  int64_t      extraBytes;
   SList*       bufBlockList;
+  void*        pOMem;  // the late rows folded in refer to the rows of it, it is unreferenced when the memtable is freed
 } SMemTable;
 
+// A columnar submit block kept in the memtable as it is, the columns are of the schema of the block version
+typedef struct {
+  int32_t  numOfRows;
+  int32_t  numOfCols;
+  SDataCol cols[];
+} SMemColBlock;
+
+// A row of a columnar block in the skip list. Its length is 0 to tell it from a SDataRow, and the version and the
+// key are at the offsets of those of a SDataRow, so dataRowVersion and dataRowKey apply to both.
+#ifdef WINDOWS
+#pragma pack(push ,1) 
+typedef struct {
+#else
+typedef struct __attribute__((packed)){
+#endif
+  uint16_t      len;
+  int16_t       sversion;
+  TSKEY         key;
+  int32_t       index;  // index of the row in the block
+  SMemColBlock* pBlock;
+} SMemColRow;
+#ifdef WINDOWS
+#pragma pack(pop) 
+#endif
+
+#define tsdbIsMemColRow(r) (dataRowLen(r) == 0)
+#define tsdbMemRowLen(r) (tsdbIsMemColRow(r) ? (int)sizeof(SMemColRow) : (int)dataRowLen(r))
+
 enum { TSDB_UPDATE_META, TSDB_DROP_META };
 
 #ifdef WINDOWS
@@ -205,6 +249,28 @@ typedef struct {
 } SFileGroupIter;
 
 // ------------------ tsdbMain.c
+// The lastKey of tables is restored from the data files after the repository is opened, by a background thread
+// with bounded I/O, or by the query which needs it before the background thread finishes.
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_t       thread;
+  bool            running;
+  bool            stop;
+  bool            done;  // all file groups are restored
+  SFileGroupIter  iter;  // file groups are restored from the newest one
+} STsdbRestoreH;
+
+// The rows older than the committed data of their tables are kept in a separate memtable and appended to the .ooo
+// file, instead of being merged into the existing file blocks by every commit. When the memtable grows large, they are
+// folded into the memtable being committed, so the file groups are rewritten once for both. The .ooo file is shipped
+// by sync like the data files, its magic is the checksum of its content.
+typedef struct {
+  SMemTable* mem;
+  int8_t     folding;  // the memtable is being folded by the commit thread, late rows go to the memtable meanwhile
+  int        fd;       // the .ooo file, -1 if the file can not be written
+  uint32_t   magic;
+} STsdbOooH;
+
 typedef struct {
   int8_t state;
 
@@ -218,9 +284,14 @@ typedef struct {
   SMemTable*      imem;
   STsdbFileH*     tsdbFileH;
   int             commit;
+  int8_t          commitOver;       // the commit thread is over and can be joined without waiting
+  int64_t         commitStartTime;  // in milliseconds
+  int64_t         commitDuration;   // duration of the last commit in milliseconds
   pthread_t       commitThread;
   pthread_mutex_t mutex;
   bool            repoLocked;
+  STsdbRestoreH   restoreH;
+  STsdbOooH       oooH;
 } STsdbRepo;
 
 // ------------------ tsdbRWHelper.c
@@ -404,23 +475,51 @@ static FORCE_INLINE STSchema *tsdbGetTableTagSchema(STable *pTable) {
 
 // ------------------ tsdbBuffer.c
 #define TSDB_BUFFER_RESERVE 1024  // Reseve 1K as commit threshold
+#define TSDB_MIN_WRITE_DELAY 10    // min and max delay of writes suggested under buffer pressure, in milliseconds
+#define TSDB_MAX_WRITE_DELAY 1000
+#define TSDB_MAX_MEM_SCALE 4  // the memtable grows to 4 times its configured size with the borrowed blocks
 
 STsdbBufPool* tsdbNewBufPool();
 void          tsdbFreeBufPool(STsdbBufPool* pBufPool);
 int           tsdbOpenBufPool(STsdbRepo* pRepo);
 void          tsdbCloseBufPool(STsdbRepo* pRepo);
 SListNode*    tsdbAllocBufBlockFromPool(STsdbRepo* pRepo);
+void          tsdbMoveBufRegion(STsdbRepo* pRepo);
+SListNode*    tsdbBorrowBufBlock(STsdbRepo* pRepo);
+bool          tsdbCanBorrowBufBlock(STsdbRepo* pRepo);
+void          tsdbReturnBufBlocks(STsdbRepo* pRepo);
 
 // ------------------ tsdbMemTable.c
-int   tsdbInsertRowToMem(STsdbRepo* pRepo, SDataRow row, STable* pTable);
+#define TSDB_MAX_INSERT_BATCH 256  // max rows inserted to the memtable by one run
+#define TSDB_OOO_FOLD_RATIO 4      // the late rows are folded when they take 1/4 of the buffer pool size
+
+int   tsdbInsertRowsToMem(STsdbRepo* pRepo, SDataRow* rows, int nRows, STable* pTable);
 int   tsdbRefMemTable(STsdbRepo* pRepo, SMemTable* pMemTable);
 int   tsdbUnRefMemTable(STsdbRepo* pRepo, SMemTable* pMemTable);
-int   tsdbTakeMemSnapshot(STsdbRepo* pRepo, SMemTable** pMem, SMemTable** pIMem);
-void  tsdbUnTakeMemSnapShot(STsdbRepo* pRepo, SMemTable* pMem, SMemTable* pIMem);
+int   tsdbTakeMemSnapshot(STsdbRepo* pRepo, SMemTable** pMem, SMemTable** pIMem, SMemTable** pOMem);
+void  tsdbUnTakeMemSnapShot(STsdbRepo* pRepo, SMemTable* pMem, SMemTable* pIMem, SMemTable* pOMem);
 void* tsdbAllocBytes(STsdbRepo* pRepo, int bytes);
 int   tsdbAsyncCommit(STsdbRepo* pRepo);
+int   tsdbOpenOooStore(STsdbRepo* pRepo);
+void  tsdbCloseOooStore(STsdbRepo* pRepo);
+bool  tsdbIsOooRow(STsdbRepo* pRepo, STable* pTable, TSKEY key);
+bool  tsdbOooShouldFold(STsdbRepo* pRepo);
+int   tsdbInsertRowsToOoo(STsdbRepo* pRepo, SDataRow* rows, int nRows, STable* pTable);
 int   tsdbLoadDataFromCache(STable* pTable, SSkipListIterator* pIter, TSKEY maxKey, int maxRowsToRead, SDataCols* pCols,
                             TSKEY* filterKeys, int nFilterKeys);
+void  tsdbAppendMemRowToDataCol(SDataRow row, STSchema* pSchema, SDataCols* pCols);
+void  tsdbMemRowToDataRow(SDataRow row, STSchema* pSchema, SDataRow pRow);
+
+// the value of the column of index idx of pSchema, pSchema is the schema of the row version
+static FORCE_INLINE void* tsdbGetMemRowDataOfCol(SDataRow row, STSchema* pSchema, int idx) {
+  if (tsdbIsMemColRow(row)) {
+    SMemColRow* pRow = (SMemColRow*)row;
+    return tdGetColDataOfRow(pRow->pBlock->cols + idx, pRow->index);
+  }
+
+  STColumn* pCol = schemaColAt(pSchema, idx);
+  return tdGetRowDataOfCol(row, pCol->type, TD_DATA_ROW_HEAD_SIZE + pCol->offset);
+}
 
 static FORCE_INLINE SDataRow tsdbNextIterRow(SSkipListIterator* pIter) {
   if (pIter == NULL) return NULL;
@@ -451,6 +550,18 @@ static FORCE_INLINE STsdbBufBlock* tsdbGetCurrBufBlock(STsdbRepo* pRepo) {
   return pBufBlock;
 }
 
+// the memtable being written reaches the commit threshold
+static FORCE_INLINE bool tsdbIsMemTableFull(STsdbRepo* pRepo) {
+  if (pRepo->mem == NULL) return false;
+  if (pRepo->mem->extraBuffList != NULL) return true;
+
+  STsdbBufBlock* pBufBlock = tsdbGetCurrBufBlock(pRepo);
+  if (listNEles(pRepo->mem->bufBlockList) < pRepo->config.totalBlocks / 3) return false;
+  if (pBufBlock != NULL && pBufBlock->remain >= TSDB_BUFFER_RESERVE) return false;
+
+  return !tsdbCanBorrowBufBlock(pRepo);
+}
+
 // ------------------ tsdbFile.c
 #define TSDB_KEY_FILEID(key, daysPerFile, precision) ((key) / tsMsPerDay[(precision)] / (daysPerFile))
 #define TSDB_MAX_FILE(keep, daysPerFile) ((keep) / (daysPerFile) + 3)
@@ -542,6 +653,7 @@ static FORCE_INLINE int compTSKEY(const void* key1, const void* key2) {
 #define TSDB_SUBMIT_MSG_HEAD_SIZE sizeof(SSubmitMsg)
 
 char*       tsdbGetMetaFileName(char* rootDir);
+char*       tsdbGetOooFileName(char* rootDir);
 void        tsdbGetDataFileName(STsdbRepo* pRepo, int fid, int type, char* fname);
 int         tsdbLockRepo(STsdbRepo* pRepo);
 int         tsdbUnlockRepo(STsdbRepo* pRepo);
@@ -550,6 +662,17 @@ int         tsdbGetNextMaxTables(int tid);
 STsdbMeta*  tsdbGetMeta(TSDB_REPO_T* pRepo);
 STsdbFileH* tsdbGetFile(TSDB_REPO_T* pRepo);
 int         tsdbCheckCommit(STsdbRepo* pRepo);
+void        tsdbRestoreTableInfo(STsdbRepo* pRepo, STable* pTable);
+
+// lastKey is updated by both the write thread and the restore, so it only increases
+static FORCE_INLINE void tsdbUpdateTableLastKey(STable* pTable, TSKEY key) {
+  TSKEY lastKey = atomic_load_64(&TABLE_LASTKEY(pTable));
+  while (lastKey < key) {
+    TSKEY old = atomic_val_compare_exchange_64(&TABLE_LASTKEY(pTable), lastKey, key);
+    if (old == lastKey) break;
+    lastKey = old;
+  }
+}
 
 #ifdef __cplusplus
 }
@@ -18,8 +18,97 @@
 
 #define POOL_IS_EMPTY(b) (listNEles((b)->bufBlockList) == 0)
 
+// the memtables are asked to commit when less than 1/8 of the dnode buffer budget is left
+#define TSDB_BUF_BUDGET_LOW(m) ((m)->used > (m)->budget - (m)->budget / 8)
+
+// the blocks in the region are cache line aligned
+#define TSDB_BUF_BLOCK_STRIDE(s) ((sizeof(STsdbBufBlock) + (size_t)(s) + 63) & ~((size_t)63))
+#define TSDB_BUF_BLOCK_IN_REGION(p, b) \
+  ((p)->region != NULL && (char *)(b) >= (p)->region && (char *)(b) < (p)->region + (p)->regionSize)
+
+// the write threads of a repo may run on different nodes, the region is moved after so many blocks in a row are
+// taken on another node
+#define TSDB_NUMA_REBIND_MISSES 4
+
+typedef struct {
+  pthread_mutex_t mutex;
+  int64_t         budget;    // bytes shared by all the buffer pools, 0 if not shared
+  int64_t         used;      // bytes of the blocks held by all the buffer pools
+  SList *         repoList;  // repos whose buffer pools are accounted
+} STsdbBufMgr;
+
+static STsdbBufMgr        tsdbBufMgr = {0};
+static STsdbBufPoolStatis tsdbBufPoolStatis = {0};
+
 static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize);
-static void           tsdbFreeBufBlock(STsdbBufBlock *pBufBlock);
+static void           tsdbFreeBufBlock(STsdbBufPool *pBufPool, STsdbBufBlock *pBufBlock);
+static void           tsdbMapBufRegion(STsdbRepo *pRepo);
+static void           tsdbUnmapBufRegion(STsdbRepo *pRepo);
+static void           tsdbBindBufRegion(STsdbRepo *pRepo);
+static void           tsdbBindNewBufRegion(STsdbRepo *pRepo);
+static void           tsdbRegisterBufPool(STsdbRepo *pRepo);
+static void           tsdbUnregisterBufPool(STsdbRepo *pRepo);
+static void           tsdbRequestCommitForBudget();
+
+// ---------------- PUBLIC FUNCTIONS ----------------
+int tsdbInitBufMgr(int64_t budget) {
+  STsdbBufMgr *pMgr = &tsdbBufMgr;
+
+  if (budget <= 0) return 0;
+
+  int code = pthread_mutex_init(&pMgr->mutex, NULL);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    return -1;
+  }
+
+  pMgr->repoList = tdListNew(sizeof(STsdbRepo *));
+  if (pMgr->repoList == NULL) {
+    pthread_mutex_destroy(&pMgr->mutex);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pMgr->used = 0;
+  pMgr->budget = budget;
+
+  tsdbInfo("buffer budget is initialized, budget:%" PRId64 " bytes", budget);
+  return 0;
+}
+
+void tsdbCleanupBufMgr() {
+  STsdbBufMgr *pMgr = &tsdbBufMgr;
+
+  if (pMgr->budget <= 0) return;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  int nRepos = listNEles(pMgr->repoList);
+  pthread_mutex_unlock(&pMgr->mutex);
+
+  // the repos not closed yet still account their buffer pools in the budget
+  if (nRepos > 0) {
+    tsdbWarn("buffer budget is not cleaned up since %d buffer pools are still open", nRepos);
+    return;
+  }
+
+  tdListFree(pMgr->repoList);
+  pMgr->repoList = NULL;
+  pthread_mutex_destroy(&pMgr->mutex);
+  pMgr->budget = 0;
+  pMgr->used = 0;
+}
+
+void tsdbGetBufPoolStatis(STsdbBufPoolStatis *pStatis) {
+  STsdbBufPoolStatis *pPoolStatis = &tsdbBufPoolStatis;
+
+  pStatis->regionBytes = atomic_load_64(&pPoolStatis->regionBytes);
+  pStatis->hugePageBytes = atomic_load_64(&pPoolStatis->hugePageBytes);
+  pStatis->numaBoundBytes = atomic_load_64(&pPoolStatis->numaBoundBytes);
+  pStatis->prefaultMs = atomic_load_64(&pPoolStatis->prefaultMs);
+  pStatis->numaRebinds = atomic_load_64(&pPoolStatis->numaRebinds);
+  pStatis->localBlocks = atomic_load_64(&pPoolStatis->localBlocks);
+  pStatis->remoteBlocks = atomic_load_64(&pPoolStatis->remoteBlocks);
+}
 
 // ---------------- INTERNAL FUNCTIONS ----------------
 STsdbBufPool *tsdbNewBufPool() {
@@ -72,12 +161,22 @@ int tsdbOpenBufPool(STsdbRepo *pRepo) {
   pPool->nBufBlocks = 0;
   pPool->index = 0;
 
+  tsdbMapBufRegion(pRepo);
+
   for (int i = 0; i < pCfg->totalBlocks; i++) {
-    STsdbBufBlock *pBufBlock = tsdbNewBufBlock(pPool->bufBlockSize);
-    if (pBufBlock == NULL) goto _err;
+    STsdbBufBlock *pBufBlock = NULL;
+    if (pPool->region != NULL) {
+      pBufBlock = (STsdbBufBlock *)(pPool->region + TSDB_BUF_BLOCK_STRIDE(pPool->bufBlockSize) * i);
+      pBufBlock->blockId = 0;
+      pBufBlock->offset = 0;
+      pBufBlock->remain = pPool->bufBlockSize;
+    } else {
+      pBufBlock = tsdbNewBufBlock(pPool->bufBlockSize);
+      if (pBufBlock == NULL) goto _err;
+    }
 
     if (tdListAppend(pPool->bufBlockList, (void *)(&pBufBlock)) < 0) {
-      tsdbFreeBufBlock(pBufBlock);
+      tsdbFreeBufBlock(pPool, pBufBlock);
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       goto _err;
     }
@@ -85,8 +184,10 @@ int tsdbOpenBufPool(STsdbRepo *pRepo) {
     pPool->nBufBlocks++;
   }
 
-  tsdbDebug("vgId:%d buffer pool is opened! bufBlockSize:%d tBufBlocks:%d nBufBlocks:%d", REPO_ID(pRepo),
-            pPool->bufBlockSize, pPool->tBufBlocks, pPool->nBufBlocks);
+  tsdbRegisterBufPool(pRepo);
+
+  tsdbDebug("vgId:%d buffer pool is opened! bufBlockSize:%d tBufBlocks:%d nBufBlocks:%d hugePage:%d", REPO_ID(pRepo),
+            pPool->bufBlockSize, pPool->tBufBlocks, pPool->nBufBlocks, pPool->hugePage);
 
   return 0;
 
@@ -102,12 +203,16 @@ void tsdbCloseBufPool(STsdbRepo *pRepo) {
   STsdbBufBlock *pBufBlock = NULL;
 
   if (pBufPool) {
+    tsdbUnregisterBufPool(pRepo);
+
     SListNode *pNode = NULL;
     while ((pNode = tdListPopHead(pBufPool->bufBlockList)) != NULL) {
       tdListNodeGetData(pBufPool->bufBlockList, pNode, (void *)(&pBufBlock));
-      tsdbFreeBufBlock(pBufBlock);
+      tsdbFreeBufBlock(pBufPool, pBufBlock);
       free(pNode);
     }
+
+    tsdbUnmapBufRegion(pRepo);
   }
 
   tsdbDebug("vgId:%d buffer pool is closed", REPO_ID(pRepo));
@@ -130,6 +235,8 @@ SListNode *tsdbAllocBufBlockFromPool(STsdbRepo *pRepo) {
   STsdbBufBlock *pBufBlock = NULL;
   tdListNodeGetData(pBufPool->bufBlockList, pNode, (void *)(&pBufBlock));
 
+  if (pBufPool->numaBind) tsdbBindBufRegion(pRepo);
+
   pBufBlock->blockId = pBufPool->index++;
   pBufBlock->offset = 0;
   pBufBlock->remain = pBufPool->bufBlockSize;
@@ -138,12 +245,228 @@ SListNode *tsdbAllocBufBlockFromPool(STsdbRepo *pRepo) {
   return pNode;
 }
 
+bool tsdbCanBorrowBufBlock(STsdbRepo *pRepo) {
+  STsdbBufMgr * pMgr = &tsdbBufMgr;
+  STsdbBufPool *pBufPool = pRepo->pPool;
+  bool          can = false;
+
+  if (!pBufPool->registered) return false;
+  if (pBufPool->memBorrowed >= (pRepo->config.totalBlocks / 3) * (TSDB_MAX_MEM_SCALE - 1)) return false;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  can = (pMgr->used + pBufPool->bufBlockSize <= pMgr->budget);
+  pthread_mutex_unlock(&pMgr->mutex);
+
+  return can;
+}
+
+// the memtable being written has used up the blocks configured for it, borrow one more from the dnode budget
+SListNode *tsdbBorrowBufBlock(STsdbRepo *pRepo) {
+  ASSERT(pRepo != NULL && pRepo->pPool != NULL);
+  ASSERT(IS_REPO_LOCKED(pRepo));
+
+  STsdbBufMgr * pMgr = &tsdbBufMgr;
+  STsdbBufPool *pBufPool = pRepo->pPool;
+  bool          granted = false;
+
+  if (!pBufPool->registered) return NULL;
+  if (pBufPool->memBorrowed >= (pRepo->config.totalBlocks / 3) * (TSDB_MAX_MEM_SCALE - 1)) return NULL;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  if (pMgr->used + pBufPool->bufBlockSize <= pMgr->budget) {
+    pMgr->used += pBufPool->bufBlockSize;
+    granted = true;
+  }
+  if (TSDB_BUF_BUDGET_LOW(pMgr)) tsdbRequestCommitForBudget();
+  pthread_mutex_unlock(&pMgr->mutex);
+
+  if (!granted) return NULL;
+
+  STsdbBufBlock *pBufBlock = tsdbNewBufBlock(pBufPool->bufBlockSize);
+  SListNode *    pNode = (pBufBlock == NULL) ? NULL : (SListNode *)malloc(sizeof(SListNode) + sizeof(STsdbBufBlock *));
+  if (pNode == NULL) {
+    tsdbFreeBufBlock(pBufPool, pBufBlock);
+    pthread_mutex_lock(&pMgr->mutex);
+    pMgr->used -= pBufPool->bufBlockSize;
+    pthread_mutex_unlock(&pMgr->mutex);
+    return NULL;
+  }
+
+  pNode->next = pNode->prev = NULL;
+  memcpy(pNode->data, (void *)(&pBufBlock), sizeof(STsdbBufBlock *));
+
+  pBufBlock->blockId = pBufPool->index++;
+  pBufPool->tBufBlocks++;
+  pBufPool->nBufBlocks++;
+  pBufPool->nBorrowed++;
+  pBufPool->memBorrowed++;
+
+  tsdbDebug("vgId:%d buffer block is borrowed, blockId:%" PRId64 " nBorrowed:%d memBorrowed:%d", REPO_ID(pRepo),
+            pBufBlock->blockId, pBufPool->nBorrowed, pBufPool->memBorrowed);
+  return pNode;
+}
+
+// free the borrowed blocks back to the dnode budget once they are released by the memtables
+void tsdbReturnBufBlocks(STsdbRepo *pRepo) {
+  ASSERT(IS_REPO_LOCKED(pRepo));
+
+  STsdbBufMgr *  pMgr = &tsdbBufMgr;
+  STsdbBufPool * pBufPool = pRepo->pPool;
+  STsdbBufBlock *pBufBlock = NULL;
+  int            nReturned = 0;
+
+  // the blocks in the region are kept and the blocks allocated from heap are freed instead
+  SListNode *pNode = listHead(pBufPool->bufBlockList);
+  while (pBufPool->nBorrowed > 0 && pNode != NULL) {
+    SListNode *pNext = pNode->next;
+    tdListNodeGetData(pBufPool->bufBlockList, pNode, (void *)(&pBufBlock));
+    if (!TSDB_BUF_BLOCK_IN_REGION(pBufPool, pBufBlock)) {
+      tdListPopNode(pBufPool->bufBlockList, pNode);
+      tsdbFreeBufBlock(pBufPool, pBufBlock);
+      free(pNode);
+
+      pBufPool->tBufBlocks--;
+      pBufPool->nBufBlocks--;
+      pBufPool->nBorrowed--;
+      nReturned++;
+    }
+    pNode = pNext;
+  }
+
+  if (nReturned == 0) return;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  pMgr->used -= (int64_t)nReturned * pBufPool->bufBlockSize;
+  pthread_mutex_unlock(&pMgr->mutex);
+
+  tsdbDebug("vgId:%d %d buffer blocks are returned, nBorrowed:%d", REPO_ID(pRepo), nReturned, pBufPool->nBorrowed);
+}
+
+void tsdbGetBufPressure(TSDB_REPO_T *repo, STsdbBufPressure *pPressure) {
+  STsdbRepo *   pRepo = (STsdbRepo *)repo;
+  STsdbBufPool *pBufPool = pRepo->pPool;
+
+  memset(pPressure, 0, sizeof(*pPressure));
+
+  // the memtable being written is only changed by the write thread, which is the caller
+  pPressure->totalBlocks = pBufPool->tBufBlocks;
+  pPressure->committing = (pRepo->commit && !atomic_load_8(&pRepo->commitOver));
+  if (pRepo->mem != NULL) {
+    pPressure->memBlocks = listNEles(pRepo->mem->bufBlockList);
+    pPressure->extraBytes = pRepo->mem->extraBytes;
+  }
+
+  if (tsdbLockRepo(pRepo) < 0) return;
+  pPressure->freeBlocks = listNEles(pBufPool->bufBlockList);
+  tsdbUnlockRepo(pRepo);
+
+  STsdbBufBlock *pBufBlock = tsdbGetCurrBufBlock(pRepo);
+  bool needBlock = (pBufBlock == NULL || pBufBlock->remain < TSDB_BUFFER_RESERVE);
+
+  if (pPressure->committing && tsdbIsMemTableFull(pRepo)) {
+    // the writes can not go on until the commit is over, the delay is estimated by the duration of the last commit
+    int64_t elapsed = taosGetTimestampMs() - pRepo->commitStartTime;
+    pPressure->level = TSDB_BUF_PRESSURE_HIGH;
+    pPressure->delay = (int32_t)MIN(MAX(pRepo->commitDuration - elapsed, TSDB_MIN_WRITE_DELAY), TSDB_MAX_WRITE_DELAY);
+  } else if (pPressure->freeBlocks == 0 && needBlock && !tsdbIsMemTableFull(pRepo)) {
+    // the blocks are held by the memtables being committed or queried
+    pPressure->level = TSDB_BUF_PRESSURE_HIGH;
+    pPressure->delay = TSDB_MIN_WRITE_DELAY * 10;
+  }
+}
+
 // ---------------- LOCAL FUNCTIONS ----------------
+static void tsdbRegisterBufPool(STsdbRepo *pRepo) {
+  STsdbBufMgr * pMgr = &tsdbBufMgr;
+  STsdbBufPool *pBufPool = pRepo->pPool;
+
+  if (pMgr->budget <= 0) return;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  if (tdListAppend(pMgr->repoList, (void *)(&pRepo)) < 0) {
+    pthread_mutex_unlock(&pMgr->mutex);
+    tsdbWarn("vgId:%d failed to add buffer pool to the budget, blocks are not borrowed", REPO_ID(pRepo));
+    return;
+  }
+
+  // the blocks configured for the repo are always kept even if the budget is exceeded
+  pMgr->used += (int64_t)pBufPool->tBufBlocks * pBufPool->bufBlockSize;
+  pBufPool->registered = 1;
+  if (pMgr->used > pMgr->budget) {
+    tsdbWarn("vgId:%d buffer budget is exceeded by the configured blocks, used:%" PRId64 " budget:%" PRId64,
+             REPO_ID(pRepo), pMgr->used, pMgr->budget);
+  }
+  pthread_mutex_unlock(&pMgr->mutex);
+}
+
+static void tsdbUnregisterBufPool(STsdbRepo *pRepo) {
+  STsdbBufMgr * pMgr = &tsdbBufMgr;
+  STsdbBufPool *pBufPool = pRepo->pPool;
+  SListIter     iter = {0};
+  SListNode *   pNode = NULL;
+  STsdbRepo *   pTRepo = NULL;
+
+  if (!pBufPool->registered) return;
+
+  pthread_mutex_lock(&pMgr->mutex);
+  tdListInitIter(pMgr->repoList, &iter, TD_LIST_FORWARD);
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    tdListNodeGetData(pMgr->repoList, pNode, (void *)(&pTRepo));
+    if (pTRepo == pRepo) {
+      tdListPopNode(pMgr->repoList, pNode);
+      free(pNode);
+      break;
+    }
+  }
+  pMgr->used -= (int64_t)pBufPool->tBufBlocks * pBufPool->bufBlockSize;
+  pBufPool->registered = 0;
+  pthread_mutex_unlock(&pMgr->mutex);
+}
+
+/*
+ * The budget runs low, ask the memtable holding most borrowed blocks to commit, the older one if there is a tie.
+ * The commit is taken by the write thread of the repo the next time it checks commit. Must be called with the mutex
+ * of the buffer budget locked.
+ */
+static void tsdbRequestCommitForBudget() {
+  STsdbBufMgr *pMgr = &tsdbBufMgr;
+  SListIter    iter = {0};
+  SListNode *  pNode = NULL;
+  STsdbRepo *  pRepo = NULL;
+  STsdbRepo *  pVictim = NULL;
+  int          maxBorrowed = 0;
+  int64_t      startTime = 0;
+
+  tdListInitIter(pMgr->repoList, &iter, TD_LIST_FORWARD);
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    tdListNodeGetData(pMgr->repoList, pNode, (void *)(&pRepo));
+
+    STsdbBufPool *pBufPool = pRepo->pPool;
+    if (atomic_load_8(&pBufPool->commitRequested)) continue;
+
+    int     memBorrowed = atomic_load_32(&pBufPool->memBorrowed);
+    int64_t memStartTime = atomic_load_64(&pBufPool->memStartTime);
+    if (memBorrowed == 0) continue;
+
+    if (memBorrowed > maxBorrowed || (memBorrowed == maxBorrowed && memStartTime < startTime)) {
+      pVictim = pRepo;
+      maxBorrowed = memBorrowed;
+      startTime = memStartTime;
+    }
+  }
+
+  if (pVictim == NULL) return;
+
+  atomic_store_8(&pVictim->pPool->commitRequested, 1);
+  tsdbDebug("vgId:%d is asked to commit for the buffer budget, memBorrowed:%d used:%" PRId64 " budget:%" PRId64,
+            REPO_ID(pVictim), maxBorrowed, pMgr->used, pMgr->budget);
+}
+
 static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize) {
   STsdbBufBlock *pBufBlock = (STsdbBufBlock *)malloc(sizeof(*pBufBlock) + bufBlockSize);
   if (pBufBlock == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    goto _err;
+    return NULL;
   }
 
   pBufBlock->blockId = 0;
@@ -151,10 +474,146 @@ static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize) {
   pBufBlock->remain = bufBlockSize;
 
   return pBufBlock;
+}
 
-_err:
-  tsdbFreeBufBlock(pBufBlock);
-  return NULL;
+// the blocks in the region are released with the region
+static void tsdbFreeBufBlock(STsdbBufPool *pBufPool, STsdbBufBlock *pBufBlock) {
+  if (TSDB_BUF_BLOCK_IN_REGION(pBufPool, pBufBlock)) return;
+  taosTFree(pBufBlock);
+}
+
+/*
+ * Map the configured blocks in one region, so that they are backed by huge pages and bound to a NUMA node as a
+ * whole. The region is bound before it is pre-faulted, so the pages are taken from the node at once instead of being
+ * moved later, and the page faults are taken at open instead of in the writes. The blocks are allocated from heap if
+ * the region is not asked for or can not be mapped.
+ */
+static void tsdbMapBufRegion(STsdbRepo *pRepo) {
+  STsdbBufPoolStatis *pStatis = &tsdbBufPoolStatis;
+  STsdbBufPool *      pBufPool = pRepo->pPool;
+
+  pBufPool->region = NULL;
+  pBufPool->regionSize = 0;
+  pBufPool->hugePage = TAOS_HUGE_PAGE_NONE;
+  pBufPool->numaBind = 0;
+  pBufPool->numaNode = -1;
+  pBufPool->numaMisses = 0;
+  pBufPool->numaMoveTo = -1;
+
+  if (tsMemtableHugePage == TAOS_HUGE_PAGE_NONE && !tsMemtableNumaBind) return;
+
+  size_t  size = TSDB_BUF_BLOCK_STRIDE(pBufPool->bufBlockSize) * pBufPool->tBufBlocks;
+  int32_t hugePage = TAOS_HUGE_PAGE_NONE;
+  size = (size + TAOS_HUGE_PAGE_SIZE - 1) / TAOS_HUGE_PAGE_SIZE * TAOS_HUGE_PAGE_SIZE;
+
+  char *region = taosMapRegion(size, tsMemtableHugePage, &hugePage);
+  if (region == NULL) {
+    tsdbWarn("vgId:%d failed to map buffer pool region, size:%zu, blocks are allocated from heap", REPO_ID(pRepo),
+             size);
+    return;
+  }
+
+  pBufPool->region = region;
+  pBufPool->regionSize = size;
+  pBufPool->hugePage = (int8_t)hugePage;
+  pBufPool->numaBind = (int8_t)tsMemtableNumaBind;
+  if (pBufPool->numaBind) tsdbBindNewBufRegion(pRepo);
+
+  int64_t startTime = taosGetTimestampMs();
+  taosPrefaultRegion(region, size);
+  int64_t elapsed = taosGetTimestampMs() - startTime;
+
+  atomic_add_fetch_64(&pStatis->regionBytes, size);
+  if (hugePage != TAOS_HUGE_PAGE_NONE) atomic_add_fetch_64(&pStatis->hugePageBytes, size);
+  atomic_add_fetch_64(&pStatis->prefaultMs, elapsed);
+
+  tsdbDebug("vgId:%d buffer pool region is mapped, size:%zu hugePage:%d node:%d prefault:%" PRId64 "ms", REPO_ID(pRepo),
+            size, hugePage, pBufPool->numaNode, elapsed);
+}
+
+// the region is not faulted in yet, so only the policy is set and no pages are moved
+static void tsdbBindNewBufRegion(STsdbRepo *pRepo) {
+  STsdbBufPool *pBufPool = pRepo->pPool;
+
+  int32_t node = taosGetNumaNode();
+  if (node < 0) return;
+
+  if (taosBindRegionToNode(pBufPool->region, pBufPool->regionSize, node, false) < 0) {
+    tsdbWarn("vgId:%d failed to bind buffer pool region to NUMA node %d since %s, the region is not bound",
+             REPO_ID(pRepo), node, strerror(errno));
+    pBufPool->numaBind = 0;
+    return;
+  }
+
+  atomic_add_fetch_64(&tsdbBufPoolStatis.numaBoundBytes, pBufPool->regionSize);
+  pBufPool->numaNode = node;
+}
+
+static void tsdbUnmapBufRegion(STsdbRepo *pRepo) {
+  STsdbBufPoolStatis *pStatis = &tsdbBufPoolStatis;
+  STsdbBufPool *      pBufPool = pRepo->pPool;
+
+  if (pBufPool->region == NULL) return;
+
+  atomic_sub_fetch_64(&pStatis->regionBytes, pBufPool->regionSize);
+  if (pBufPool->hugePage != TAOS_HUGE_PAGE_NONE) atomic_sub_fetch_64(&pStatis->hugePageBytes, pBufPool->regionSize);
+  if (pBufPool->numaNode >= 0) atomic_sub_fetch_64(&pStatis->numaBoundBytes, pBufPool->regionSize);
+
+  taosUnmapRegion(pBufPool->region, pBufPool->regionSize);
+  pBufPool->region = NULL;
+  pBufPool->regionSize = 0;
+  pBufPool->numaNode = -1;
+}
+
+/*
+ * Follow the NUMA node of the write thread taking a block. Since the vnode queues are shared by the write workers, the
+ * region is only moved when the blocks are taken on another node for a while. Must be called with the repo locked,
+ * and the pages are moved by tsdbMoveBufRegion after the repo is unlocked.
+ */
+static void tsdbBindBufRegion(STsdbRepo *pRepo) {
+  STsdbBufPoolStatis *pStatis = &tsdbBufPoolStatis;
+  STsdbBufPool *      pBufPool = pRepo->pPool;
+
+  int32_t node = taosGetNumaNode();
+  if (node < 0) return;
+
+  if (node != pBufPool->numaNode) {
+    pBufPool->numaMisses++;
+    if (pBufPool->numaMisses >= TSDB_NUMA_REBIND_MISSES) {
+      tsdbDebug("vgId:%d buffer pool region is to be moved to NUMA node %d, previous node:%d", REPO_ID(pRepo), node,
+                pBufPool->numaNode);
+      pBufPool->numaMoveTo = node;
+      pBufPool->numaNode = node;
+    }
+  }
+
+  if (node == pBufPool->numaNode) {
+    pBufPool->numaMisses = 0;
+    atomic_add_fetch_64(&pStatis->localBlocks, 1);
+  } else {
+    atomic_add_fetch_64(&pStatis->remoteBlocks, 1);
+  }
 }
 
-static void tsdbFreeBufBlock(STsdbBufBlock *pBufBlock) { taosTFree(pBufBlock); }
\ No newline at end of file
+/*
+ * Move the pages of the region to the node decided by tsdbBindBufRegion. The move may take long for a large region,
+ * so it is done by the write thread without the repo lock, the pages being moved are still accessible.
+ */
+void tsdbMoveBufRegion(STsdbRepo *pRepo) {
+  STsdbBufPoolStatis *pStatis = &tsdbBufPoolStatis;
+  STsdbBufPool *      pBufPool = pRepo->pPool;
+
+  if (!pBufPool->numaBind || pBufPool->numaMoveTo < 0) return;
+
+  int32_t node = atomic_exchange_32(&pBufPool->numaMoveTo, -1);
+  if (node < 0) return;
+
+  if (taosBindRegionToNode(pBufPool->region, pBufPool->regionSize, node, true) < 0) {
+    tsdbWarn("vgId:%d failed to move buffer pool region to NUMA node %d since %s", REPO_ID(pRepo), node,
+             strerror(errno));
+    return;
+  }
+
+  atomic_add_fetch_64(&pStatis->numaRebinds, 1);
+  tsdbDebug("vgId:%d buffer pool region is moved to NUMA node %d", REPO_ID(pRepo), node);
+}
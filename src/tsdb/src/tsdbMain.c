@@ -26,11 +26,14 @@
 #define TSDB_CFG_FILE_NAME "config"
 #define TSDB_DATA_DIR_NAME "data"
 #define TSDB_META_FILE_NAME "meta"
+#define TSDB_OOO_FILE_NAME "ooo"
 #define TSDB_META_FILE_INDEX 10000000
+#define TSDB_OOO_FILE_INDEX (TSDB_META_FILE_INDEX + 1)
 #define IS_VALID_PRECISION(precision) \
   (((precision) >= TSDB_TIME_PRECISION_MILLI) && ((precision) <= TSDB_TIME_PRECISION_NANO))
 #define TSDB_DEFAULT_COMPRESSION TWO_STAGE_COMP
 #define IS_VALID_COMPRESSION(compression) (((compression) >= NO_COMPRESSION) && ((compression) <= TWO_STAGE_COMP))
+#define TSDB_RESTORE_BYTES_PER_SEC (32 * 1024 * 1024)  // max rate to read index by background restore
 
 typedef struct {
   int32_t  totalLen;
@@ -38,6 +41,14 @@ typedef struct {
   SDataRow row;
 } SSubmitBlkIter;
 
+typedef struct {
+  char *  bitmap;
+  char *  pVal;   // the values of the column in the block
+  int8_t  comp;
+  int32_t len;
+  int32_t rawLen;
+} SSubmitColInfo;
+
 typedef struct {
   int32_t totalLen;
   int32_t len;
@@ -53,11 +64,17 @@ static char *      tsdbGetCfgFname(char *rootDir);
 static STsdbRepo * tsdbNewRepo(char *rootDir, STsdbAppH *pAppH, STsdbCfg *pCfg);
 static void        tsdbFreeRepo(STsdbRepo *pRepo);
 static int         tsdbInitSubmitMsgIter(SSubmitMsg *pMsg, SSubmitMsgIter *pIter);
+static int         tsdbInsertRun(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable, bool ooo);
 static int32_t     tsdbInsertDataToTable(STsdbRepo *pRepo, SSubmitBlk *pBlock, TSKEY now, int32_t *affectedrows);
 static int         tsdbGetSubmitMsgNext(SSubmitMsgIter *pIter, SSubmitBlk **pPBlock);
 static SDataRow    tsdbGetSubmitBlkNext(SSubmitBlkIter *pIter);
-static int         tsdbRestoreInfo(STsdbRepo *pRepo);
-static int         tsdbInitSubmitBlkIter(SSubmitBlk *pBlock, SSubmitBlkIter *pIter);
+static int         tsdbStartRestore(STsdbRepo *pRepo);
+static void        tsdbStopRestore(STsdbRepo *pRepo);
+static int64_t     tsdbRestoreNextFGroup(STsdbRepo *pRepo);
+static void *      tsdbRestoreInBackground(void *param);
+static int         tsdbInitSubmitBlkIter(void *rows, int32_t len, SSubmitBlkIter *pIter);
+static int         tsdbDecodeColSubmitBlk(STsdbRepo *pRepo, STable *pTable, SSubmitBlk *pBlock, char **ppRows,
+                                          int32_t *rowsLen);
 static void        tsdbAlterCompression(STsdbRepo *pRepo, int8_t compression);
 static int         tsdbAlterKeep(STsdbRepo *pRepo, int32_t keep);
 static int         tsdbAlterCacheTotalBlocks(STsdbRepo *pRepo, int totalBlocks);
@@ -121,7 +138,12 @@ TSDB_REPO_T *tsdbOpenRepo(char *rootDir, STsdbAppH *pAppH) {
     goto _err;
   }
 
-  if (tsdbRestoreInfo(pRepo) < 0) {
+  if (tsdbOpenOooStore(pRepo) < 0) {
+    tsdbError("vgId:%d failed to open out-of-order store since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _err;
+  }
+
+  if (tsdbStartRestore(pRepo) < 0) {
     tsdbError("vgId:%d failed to restore info from file since %s", REPO_ID(pRepo), tstrerror(terrno));
     goto _err;
   }
@@ -146,6 +168,7 @@ void tsdbCloseRepo(TSDB_REPO_T *repo, int toCommit) {
   int        vgId = REPO_ID(pRepo);
 
   tsdbStopStream(pRepo);
+  tsdbStopRestore(pRepo);
 
   if (toCommit) {
     tsdbAsyncCommit(pRepo);
@@ -155,6 +178,7 @@ void tsdbCloseRepo(TSDB_REPO_T *repo, int toCommit) {
   tsdbUnRefMemTable(pRepo, pRepo->imem);
   pRepo->mem = NULL;
   pRepo->imem = NULL;
+  tsdbCloseOooStore(pRepo);
 
   tsdbCloseFileH(pRepo);
   tsdbCloseBufPool(pRepo);
@@ -222,6 +246,11 @@ uint32_t tsdbGetFileInfo(TSDB_REPO_T *repo, char *name, uint32_t *index, uint32_
         fname = tsdbGetMetaFileName(pRepo->rootDir);
         *index = TSDB_META_FILE_INDEX;
         magic = TSDB_META_FILE_MAGIC(pRepo->tsdbMeta);
+      } else if (*index <= TSDB_OOO_FILE_INDEX && TSDB_OOO_FILE_INDEX <= eindex) {
+        // the late rows not folded yet are only in the .ooo file and the WAL, the file is restored by the receiver
+        fname = tsdbGetOooFileName(pRepo->rootDir);
+        *index = TSDB_OOO_FILE_INDEX;
+        magic = atomic_load_32(&pRepo->oooH.magic);
       } else {
         return 0;
       }
@@ -246,6 +275,9 @@ uint32_t tsdbGetFileInfo(TSDB_REPO_T *repo, char *name, uint32_t *index, uint32_
     if (*index == TSDB_META_FILE_INDEX) {  // get meta file
       fname = tsdbGetMetaFileName(pRepo->rootDir);
       magic = TSDB_META_FILE_MAGIC(pRepo->tsdbMeta);
+    } else if (*index == TSDB_OOO_FILE_INDEX) {
+      fname = tsdbGetOooFileName(pRepo->rootDir);
+      magic = atomic_load_32(&pRepo->oooH.magic);
     } else {
       int         fid = (*index) / TSDB_FILE_TYPE_MAX;
       SFileGroup *pFGroup = tsdbSearchFGroup(pFileH, fid, TD_EQ);
@@ -338,6 +370,18 @@ char *tsdbGetMetaFileName(char *rootDir) {
   return fname;
 }
 
+char *tsdbGetOooFileName(char *rootDir) {
+  int   tlen = strlen(rootDir) + strlen(TSDB_OOO_FILE_NAME) + 2;
+  char *fname = calloc(1, tlen);
+  if (fname == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  snprintf(fname, tlen, "%s/%s", rootDir, TSDB_OOO_FILE_NAME);
+  return fname;
+}
+
 void tsdbGetDataFileName(STsdbRepo *pRepo, int fid, int type, char *fname) {
   snprintf(fname, TSDB_FILENAME_LEN, "%s/%s/v%df%d%s", pRepo->rootDir, TSDB_DATA_DIR_NAME, REPO_ID(pRepo), fid, tsdbFileSuffix[type]);
 }
@@ -390,17 +434,27 @@ int tsdbGetNextMaxTables(int tid) {
 }
 
 int tsdbCheckCommit(STsdbRepo *pRepo) {
-  ASSERT(pRepo->mem != NULL);
   STsdbCfg *pCfg = &(pRepo->config);
 
-  STsdbBufBlock *pBufBlock = tsdbGetCurrBufBlock(pRepo);
-  ASSERT(pBufBlock != NULL);
-  if ((pRepo->mem->extraBuffList != NULL) ||
-      ((listNEles(pRepo->mem->bufBlockList) >= pCfg->totalBlocks / 3) && (pBufBlock->remain < TSDB_BUFFER_RESERVE))) {
-    // trigger commit
-    if (tsdbAsyncCommit(pRepo) < 0) return -1;
+  // the memtable is empty if only late rows are written
+  bool full = (pRepo->mem != NULL) && tsdbIsMemTableFull(pRepo);
+  bool fold = tsdbOooShouldFold(pRepo);
+
+  // the memtable is also committed when the dnode buffer budget runs low and asks for its borrowed blocks
+  if (!full && !fold && !atomic_load_8(&pRepo->pPool->commitRequested)) return 0;
+
+  // Joining the last commit which is still running would block the write worker. The memtable keeps growing out of
+  // the buffer pool until the commit is over, while the new writes from clients are throttled by the buffer pressure.
+  int64_t maxExtraBytes = (int64_t)pRepo->pPool->bufBlockSize * (pCfg->totalBlocks / 3);
+  if (pRepo->commit && !atomic_load_8(&pRepo->commitOver) && (!full || pRepo->mem->extraBytes < maxExtraBytes)) {
+    tsdbTrace("vgId:%d commit is delayed since last commit is not over, extraBytes:%" PRId64, REPO_ID(pRepo),
+              (pRepo->mem == NULL) ? 0 : pRepo->mem->extraBytes);
+    return 0;
   }
 
+  // trigger commit
+  if (tsdbAsyncCommit(pRepo) < 0) return -1;
+
   return 0;
 }
 
@@ -651,7 +705,14 @@ static STsdbRepo *tsdbNewRepo(char *rootDir, STsdbAppH *pAppH, STsdbCfg *pCfg) {
     goto _err;
   }
 
+  code = pthread_mutex_init(&pRepo->restoreH.mutex, NULL);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    goto _err;
+  }
+
   pRepo->repoLocked = false;
+  pRepo->oooH.fd = -1;
 
   pRepo->rootDir = strdup(rootDir);
   if (pRepo->rootDir == NULL) {
@@ -695,6 +756,7 @@ static void tsdbFreeRepo(STsdbRepo *pRepo) {
     // tsdbFreeMemTable(pRepo->mem);
     // tsdbFreeMemTable(pRepo->imem);
     taosTFree(pRepo->rootDir);
+    pthread_mutex_destroy(&pRepo->restoreH.mutex);
     pthread_mutex_destroy(&pRepo->mutex);
     free(pRepo);
   }
@@ -717,6 +779,30 @@ static int tsdbInitSubmitMsgIter(SSubmitMsg *pMsg, SSubmitMsgIter *pIter) {
   return 0;
 }
 
+static int tsdbInsertRun(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable, bool ooo) {
+  if (!ooo) return tsdbInsertRowsToMem(pRepo, rows, nRows, pTable);
+  if (!tsdbIsMemColRow(rows[0])) return tsdbInsertRowsToOoo(pRepo, rows, nRows, pTable);
+
+  // the late store keeps SDataRows, the late rows of a columnar block are built as rows
+  STSchema *pSchema = tsdbGetTableSchemaByVersion(pTable, dataRowVersion(rows[0]));
+  int       maxLen = dataRowMaxBytesFromSchema(pSchema);
+  SDataRow  oRows[TSDB_MAX_INSERT_BATCH] = {0};
+  char *    buf = (char *)malloc((size_t)maxLen * nRows);
+  if (buf == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  for (int i = 0; i < nRows; i++) {
+    oRows[i] = (SDataRow)(buf + maxLen * i);
+    tsdbMemRowToDataRow(rows[i], pSchema, oRows[i]);
+  }
+
+  int code = tsdbInsertRowsToOoo(pRepo, oRows, nRows, pTable);
+  free(buf);
+  return code;
+}
+
 static int32_t tsdbInsertDataToTable(STsdbRepo *pRepo, SSubmitBlk *pBlock, TSKEY now, int32_t *affectedrows) {
   STsdbMeta *pMeta = pRepo->tsdbMeta;
   int64_t    points = 0;
@@ -727,26 +813,54 @@ static int32_t tsdbInsertDataToTable(STsdbRepo *pRepo, SSubmitBlk *pBlock, TSKEY
 
   SSubmitBlkIter blkIter = {0};
   SDataRow       row = NULL;
+  SDataRow       rows[TSDB_MAX_INSERT_BATCH] = {0};
+  int            nRows = 0;
+  bool           ooo = false;  // the run is of the rows older than the committed data
+  char *         pRows = NULL;  // rows of a columnar block, they refer to the block decoded to the memtable
+  int32_t        rowsLen = 0;
 
   TSKEY minKey = now - tsMsPerDay[pRepo->config.precision] * pRepo->config.keep;
   TSKEY maxKey = now + tsMsPerDay[pRepo->config.precision] * pRepo->config.daysPerFile;
 
-  tsdbInitSubmitBlkIter(pBlock, &blkIter);
+  if (pBlock->format == TSDB_SUBMIT_BLK_COL) {
+    if (tsdbDecodeColSubmitBlk(pRepo, pTable, pBlock, &pRows, &rowsLen) < 0) return -1;
+    tsdbInitSubmitBlkIter(pRows, rowsLen, &blkIter);
+  } else {
+    tsdbInitSubmitBlkIter(pBlock->data + pBlock->schemaLen, pBlock->dataLen, &blkIter);
+  }
+
+  // the rows of a block are sorted by the client, they are inserted to the memtable run by run
   while ((row = tsdbGetSubmitBlkNext(&blkIter)) != NULL) {
     if (dataRowKey(row) < minKey || dataRowKey(row) > maxKey) {
       tsdbError("vgId:%d table %s tid %d uid %" PRIu64 " timestamp is out of range! now %" PRId64 " minKey %" PRId64
                 " maxKey %" PRId64,
                 REPO_ID(pRepo), TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), TABLE_UID(pTable), now, minKey, maxKey);
+      if (nRows > 0) tsdbInsertRun(pRepo, rows, nRows, pTable, ooo);
+      taosTFree(pRows);
       terrno = TSDB_CODE_TDB_TIMESTAMP_OUT_OF_RANGE;
       return -1;
     }
 
-    if (tsdbInsertRowToMem(pRepo, row, pTable) < 0) return -1;
+    bool late = tsdbIsOooRow(pRepo, pTable, dataRowKey(row));
+    if (nRows == TSDB_MAX_INSERT_BATCH || (nRows > 0 && (dataRowKey(row) <= dataRowKey(rows[nRows - 1]) || late != ooo))) {
+      if (tsdbInsertRun(pRepo, rows, nRows, pTable, ooo) < 0) {
+        taosTFree(pRows);
+        return -1;
+      }
+      nRows = 0;
+    }
 
+    if (nRows == 0) ooo = late;
+    rows[nRows++] = row;
     (*affectedrows)++;
     points++;
   }
 
+  // the rows are copied to the memtable
+  int code = (nRows > 0) ? tsdbInsertRun(pRepo, rows, nRows, pTable, ooo) : 0;
+  taosTFree(pRows);
+  if (code < 0) return -1;
+
   STSchema *pSchema = tsdbGetTableSchemaByVersion(pTable, pBlock->sversion);
   pRepo->stat.pointsWritten += points * schemaNCols(pSchema);
   pRepo->stat.totalStorage += points * schemaVLen(pSchema);
@@ -777,56 +891,331 @@ static SDataRow tsdbGetSubmitBlkNext(SSubmitBlkIter *pIter) {
   SDataRow row = pIter->row;
   if (row == NULL) return NULL;
 
-  pIter->len += dataRowLen(row);
+  pIter->len += tsdbMemRowLen(row);
   if (pIter->len >= pIter->totalLen) {
     pIter->row = NULL;
   } else {
-    pIter->row = (char *)row + dataRowLen(row);
+    pIter->row = (char *)row + tsdbMemRowLen(row);
   }
 
   return row;
 }
 
-static int tsdbRestoreInfo(STsdbRepo *pRepo) {
-  STsdbMeta * pMeta = pRepo->tsdbMeta;
-  STsdbFileH *pFileH = pRepo->tsdbFileH;
-  SFileGroup *pFGroup = NULL;
+static int tsdbStartRestore(STsdbRepo *pRepo) {
+  STsdbRestoreH *pRestore = &pRepo->restoreH;
+
+  tsdbInitFileGroupIter(pRepo->tsdbFileH, &(pRestore->iter), TSDB_ORDER_DESC);
+  if (pRepo->tsdbFileH->nFGroups == 0) {
+    pRestore->done = true;
+    return 0;
+  }
+
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+
+  int code = pthread_create(&(pRestore->thread), &thattr, tsdbRestoreInBackground, (void *)pRepo);
+  pthread_attr_destroy(&thattr);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    return -1;
+  }
+
+  pRestore->running = true;
+  return 0;
+}
+
+static void tsdbStopRestore(STsdbRepo *pRepo) {
+  STsdbRestoreH *pRestore = &pRepo->restoreH;
+  if (!pRestore->running) return;
 
-  SFileGroupIter iter;
+  pthread_mutex_lock(&pRestore->mutex);
+  pRestore->stop = true;
+  pthread_mutex_unlock(&pRestore->mutex);
+
+  pthread_join(pRestore->thread, NULL);
+  pRestore->running = false;
+}
+
+/*
+ * Restore the lastKey of tables from the SCompIdx of the next file group, it shall be called with the restore mutex
+ * locked. Since the file groups are restored from the newest one, and the key ranges of file groups do not overlap,
+ * the maxKey in the first file group having data of a table is the lastKey of it in files.
+ *
+ * @return the bytes read from file, or -1 if failed, the file group is skipped then
+ */
+static int64_t tsdbRestoreNextFGroup(STsdbRepo *pRepo) {
+  STsdbRestoreH *pRestore = &pRepo->restoreH;
+  STsdbMeta *    pMeta = pRepo->tsdbMeta;
+  STsdbFileH *   pFileH = pRepo->tsdbFileH;
   SRWHelper      rhelper = {0};
 
-  if (tsdbInitReadHelper(&rhelper, pRepo) < 0) goto _err;
+  if (pRestore->done) return 0;
 
-  tsdbInitFileGroupIter(pFileH, &iter, TSDB_ORDER_DESC);
-  while ((pFGroup = tsdbGetFileGroupNext(&iter)) != NULL) {
-    if (tsdbSetAndOpenHelperFile(&rhelper, pFGroup) < 0) goto _err;
-    if (tsdbLoadCompIdx(&rhelper, NULL) < 0) goto _err;
-    for (int i = 1; i < pMeta->maxTables; i++) {
-      STable *pTable = pMeta->tables[i];
-      if (pTable == NULL) continue;
-      if (tsdbSetHelperTable(&rhelper, pTable, pRepo) < 0) goto _err;
-      SCompIdx *pIdx = &(rhelper.curCompIdx);
+  if (tsdbInitReadHelper(&rhelper, pRepo) < 0) return -1;
 
-      if (pIdx->offset > 0 && pTable->lastKey < pIdx->maxKey) pTable->lastKey = pIdx->maxKey;
-    }
+  pthread_rwlock_rdlock(&(pFileH->fhlock));
+
+  SFileGroup *pFGroup = tsdbGetFileGroupNext(&(pRestore->iter));
+  if (pFGroup == NULL) {
+    pthread_rwlock_unlock(&(pFileH->fhlock));
+    tsdbDestroyHelper(&rhelper);
+    pRestore->done = true;
+    tsdbDebug("vgId:%d info of all tables are restored from files", REPO_ID(pRepo));
+    return 0;
+  }
+
+  if (tsdbSetAndOpenHelperFile(&rhelper, pFGroup) < 0) {
+    pthread_rwlock_unlock(&(pFileH->fhlock));
+    goto _err;
   }
 
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+
+  if (tsdbLoadCompIdx(&rhelper, NULL) < 0) goto _err;
+
+  tsdbRLockRepoMeta(pRepo);
+  for (int i = 0; i < rhelper.idxH.numOfIdx; i++) {
+    SCompIdx *pIdx = rhelper.idxH.pIdxArray + i;
+    if (pIdx->tid <= 0 || pIdx->tid >= pMeta->maxTables || pIdx->offset <= 0) continue;
+
+    STable *pTable = pMeta->tables[pIdx->tid];
+    if (pTable == NULL || TABLE_UID(pTable) != pIdx->uid) continue;
+
+    tsdbUpdateTableLastKey(pTable, pIdx->maxKey);
+    pTable->restored = true;
+  }
+  tsdbUnlockRepoMeta(pRepo);
+
+  int64_t bytes = rhelper.idxH.numOfIdx * sizeof(SCompIdx);
+  tsdbDebug("vgId:%d info of %d tables are restored from file group %d", REPO_ID(pRepo), rhelper.idxH.numOfIdx,
+            pRestore->iter.fileId);
+
   tsdbDestroyHelper(&rhelper);
-  return 0;
+  return bytes;
 
 _err:
+  tsdbError("vgId:%d failed to restore info from file group since %s, skip it", REPO_ID(pRepo), tstrerror(terrno));
   tsdbDestroyHelper(&rhelper);
   return -1;
 }
 
-static int tsdbInitSubmitBlkIter(SSubmitBlk *pBlock, SSubmitBlkIter *pIter) {
-  if (pBlock->dataLen <= 0) return -1;
-  pIter->totalLen = pBlock->dataLen;
+static void *tsdbRestoreInBackground(void *param) {
+  STsdbRepo *    pRepo = (STsdbRepo *)param;
+  STsdbRestoreH *pRestore = &pRepo->restoreH;
+  int64_t        st = taosGetTimestampMs();
+
+  while (true) {
+    pthread_mutex_lock(&pRestore->mutex);
+    if (pRestore->stop || pRestore->done) {
+      pthread_mutex_unlock(&pRestore->mutex);
+      break;
+    }
+
+    int64_t bytes = tsdbRestoreNextFGroup(pRepo);
+    pthread_mutex_unlock(&pRestore->mutex);
+
+    // bound the I/O of restore, so it does not compete with the writes and queries
+    int64_t delay = MIN(bytes * 1000 / TSDB_RESTORE_BYTES_PER_SEC, 1000);
+    if (delay > 0) taosMsleep((int32_t)delay);
+  }
+
+  tsdbDebug("vgId:%d background restore is over, %" PRId64 " ms elapsed", REPO_ID(pRepo), taosGetTimestampMs() - st);
+  return NULL;
+}
+
+// make sure the lastKey of the table is restored from files before it is used
+void tsdbRestoreTableInfo(STsdbRepo *pRepo, STable *pTable) {
+  STsdbRestoreH *pRestore = &pRepo->restoreH;
+  if (pRestore->done || pTable->restored) return;
+
+  pthread_mutex_lock(&pRestore->mutex);
+  while (!pRestore->done && !pTable->restored) {
+    tsdbRestoreNextFGroup(pRepo);
+  }
+  pthread_mutex_unlock(&pRestore->mutex);
+}
+
+static int tsdbInitSubmitBlkIter(void *rows, int32_t len, SSubmitBlkIter *pIter) {
+  if (len <= 0) return -1;
+  pIter->totalLen = len;
   pIter->len = 0;
-  pIter->row = (SDataRow)(pBlock->data+pBlock->schemaLen);
+  pIter->row = (SDataRow)rows;
   return 0;
 }
 
+static int tsdbCheckSubmitCols(SSubmitBlk *pBlock, STSchema *pSchema, SSubmitColInfo *pInfo) {
+  int   numOfRows = pBlock->numOfRows;
+  int   bitmapLen = (numOfRows + 7) / 8;
+  char *pData = pBlock->data + pBlock->schemaLen;
+  char *pEnd = pData + pBlock->dataLen;
+
+  if (numOfRows <= 0) return -1;
+
+  for (int i = 0; i < schemaNCols(pSchema); i++) {
+    STColumn *     pCol = schemaColAt(pSchema, i);
+    SSubmitColHead head = {0};
+
+    if (pData + sizeof(SSubmitColHead) + bitmapLen > pEnd) return -1;
+    memcpy(&head, pData, sizeof(SSubmitColHead));
+    head.colId = htons(head.colId);
+    head.rawLen = htonl(head.rawLen);
+    head.len = htonl(head.len);
+    if (head.colId != pCol->colId || head.type != pCol->type || head.len < 0 || head.rawLen < 0) return -1;
+    if (head.comp != ONE_STAGE_COMP && (head.comp != NO_COMPRESSION || head.len != head.rawLen)) return -1;
+    if (!IS_VAR_DATA_TYPE(pCol->type) && head.rawLen != numOfRows * TYPE_BYTES[pCol->type]) return -1;
+
+    pInfo[i].bitmap = pData + sizeof(SSubmitColHead);
+    pInfo[i].pVal = pInfo[i].bitmap + bitmapLen;
+    pInfo[i].comp = head.comp;
+    pInfo[i].len = head.len;
+    pInfo[i].rawLen = head.rawLen;
+    if (pInfo[i].pVal + head.len > pEnd) return -1;
+
+    pData += (sizeof(SSubmitColHead) + bitmapLen + head.len);
+  }
+
+  return (pData == pEnd) ? 0 : -1;
+}
+
+// Decode a column of a columnar block to pDataCol, whose buffer is allocated from the memtable. The null values of a
+// binary or nchar column all refer to one null value after the values.
+static int tsdbDecodeSubmitCol(STsdbRepo *pRepo, STColumn *pCol, SSubmitColInfo *pInfo, int numOfRows,
+                               SDataCol *pDataCol) {
+  bool    isVar = IS_VAR_DATA_TYPE(pCol->type);
+  int32_t spaceSize = pInfo->rawLen + ((pInfo->comp == ONE_STAGE_COMP) ? COMP_OVERFLOW_BYTES : 0);
+  int     nelements = numOfRows;
+
+  if (isVar) {
+    for (int row = 0; row < numOfRows; row++) {
+      if (pInfo->bitmap[row >> 3] & (1 << (row & 7))) nelements--;
+    }
+    spaceSize += (VARSTR_HEADER_SIZE + TSDB_NCHAR_SIZE);
+  }
+
+  pDataCol->type = pCol->type;
+  pDataCol->colId = pCol->colId;
+  pDataCol->bytes = pCol->bytes;
+  pDataCol->offset = pCol->offset;
+  pDataCol->spaceSize = spaceSize;
+  pDataCol->len = pInfo->rawLen;
+  pDataCol->dataOff = NULL;
+  pDataCol->pData = NULL;
+
+  char *buf = (char *)tsdbAllocBytes(pRepo, spaceSize + (isVar ? sizeof(VarDataOffsetT) * numOfRows : 0));
+  if (buf == NULL) return -1;
+
+  if (isVar) {
+    pDataCol->dataOff = (VarDataOffsetT *)buf;
+    buf += sizeof(VarDataOffsetT) * numOfRows;
+  }
+  pDataCol->pData = buf;
+
+  terrno = TSDB_CODE_TDB_SUBMIT_MSG_MSSED_UP;
+  if (pInfo->comp == ONE_STAGE_COMP) {
+    if ((*(tDataTypeDesc[pCol->type].decompFunc))(pInfo->pVal, pInfo->len, nelements, pDataCol->pData,
+                                                    pInfo->rawLen + COMP_OVERFLOW_BYTES, ONE_STAGE_COMP, NULL,
+                                                    0) != pInfo->rawLen) {
+      return -1;
+    }
+  } else {
+    memcpy(pDataCol->pData, pInfo->pVal, pInfo->rawLen);
+  }
+
+  if (!isVar) {
+    for (int row = 0; row < numOfRows; row++) {
+      if (pInfo->bitmap[row >> 3] & (1 << (row & 7))) {
+        setNull(POINTER_SHIFT(pDataCol->pData, TYPE_BYTES[pCol->type] * row), pCol->type, pCol->bytes);
+      }
+    }
+  } else {
+    int32_t offset = 0;
+    char *  pNull = POINTER_SHIFT(pDataCol->pData, pInfo->rawLen);
+
+    setVardataNull(pNull, pCol->type);
+    for (int row = 0; row < numOfRows; row++) {
+      if (pInfo->bitmap[row >> 3] & (1 << (row & 7))) {
+        pDataCol->dataOff[row] = pInfo->rawLen;
+        continue;
+      }
+
+      void *value = POINTER_SHIFT(pDataCol->pData, offset);
+      if (offset + (int32_t)sizeof(VarDataLenT) > pInfo->rawLen ||
+          offset + (int32_t)varDataTLen(value) > pInfo->rawLen || varDataTLen(value) > pCol->bytes) {
+        return -1;
+      }
+      pDataCol->dataOff[row] = offset;
+      offset += varDataTLen(value);
+    }
+
+    if (offset != pInfo->rawLen) return -1;
+    pDataCol->len += varDataTLen(pNull);
+  }
+  terrno = TSDB_CODE_SUCCESS;
+
+  return 0;
+}
+
+// Decode a columnar block to the memtable as columns, the rows of the block returned refer to the columns. The bytes
+// taken from the memtable are not returned if the block is invalid, they are freed with the memtable.
+static int tsdbDecodeColSubmitBlk(STsdbRepo *pRepo, STable *pTable, SSubmitBlk *pBlock, char **ppRows,
+                                  int32_t *rowsLen) {
+  STSchema *      pSchema = tsdbGetTableSchemaByVersion(pTable, pBlock->sversion);
+  int             numOfCols = schemaNCols(pSchema);
+  SSubmitColInfo *pInfo = NULL;
+  SMemColBlock *  pColBlock = NULL;
+  SMemColRow *    pRows = NULL;
+
+  pInfo = (SSubmitColInfo *)calloc(numOfCols, sizeof(SSubmitColInfo));
+  if (pInfo == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  if (tsdbCheckSubmitCols(pBlock, pSchema, pInfo) < 0) {
+    terrno = TSDB_CODE_TDB_SUBMIT_MSG_MSSED_UP;
+    goto _err;
+  }
+
+  pRows = (SMemColRow *)calloc(pBlock->numOfRows, sizeof(SMemColRow));
+  if (pRows == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  pColBlock = (SMemColBlock *)tsdbAllocBytes(pRepo, sizeof(SMemColBlock) + sizeof(SDataCol) * numOfCols);
+  if (pColBlock == NULL) goto _err;
+  pColBlock->numOfRows = pBlock->numOfRows;
+  pColBlock->numOfCols = numOfCols;
+
+  for (int i = 0; i < numOfCols; i++) {
+    if (tsdbDecodeSubmitCol(pRepo, schemaColAt(pSchema, i), pInfo + i, pBlock->numOfRows, pColBlock->cols + i) < 0) {
+      goto _err;
+    }
+  }
+
+  for (int row = 0; row < pBlock->numOfRows; row++) {
+    pRows[row].len = 0;
+    pRows[row].sversion = (int16_t)schemaVersion(pSchema);
+    pRows[row].key = *(TSKEY *)tdGetColDataOfRow(pColBlock->cols, row);
+    pRows[row].index = row;
+    pRows[row].pBlock = pColBlock;
+  }
+
+  taosTFree(pInfo);
+
+  *ppRows = (char *)pRows;
+  *rowsLen = (int32_t)sizeof(SMemColRow) * pBlock->numOfRows;
+  return 0;
+
+_err:
+  tsdbError("vgId:%d failed to decode columnar submit block of table %s tid %d since %s", REPO_ID(pRepo),
+            TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), tstrerror(terrno));
+  taosTFree(pInfo);
+  taosTFree(pRows);
+  return -1;
+}
+
 static void tsdbAlterCompression(STsdbRepo *pRepo, int8_t compression) {
   int8_t ocompression = pRepo->config.compression;
   pRepo->config.compression = compression;
@@ -1013,6 +1402,14 @@ static int tsdbScanAndConvertSubmitMsg(STsdbRepo *pRepo, SSubmitMsg *pMsg) {
     pBlock->dataLen = htonl(pBlock->dataLen);
     pBlock->schemaLen = htonl(pBlock->schemaLen);
     pBlock->numOfRows = htons(pBlock->numOfRows);
+    pBlock->format = htons(pBlock->format);
+
+    if (pBlock->format != TSDB_SUBMIT_BLK_ROW && pBlock->format != TSDB_SUBMIT_BLK_COL) {
+      tsdbError("vgId:%d invalid submit block format %d, uid %" PRIu64 " tid %d", REPO_ID(pRepo), pBlock->format,
+                pBlock->uid, pBlock->tid);
+      terrno = TSDB_CODE_TDB_SUBMIT_MSG_MSSED_UP;
+      return -1;
+    }
 
     if (pBlock->tid <= 0 || pBlock->tid >= pMeta->maxTables) {
       tsdbError("vgId:%d failed to get table to insert data, uid %" PRIu64 " tid %d", REPO_ID(pRepo), pBlock->uid,
@@ -13,12 +13,18 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "tchecksum.h"
+#include "tcoding.h"
+#include "tplacement.h"
 #include "tsdb.h"
 #include "tsdbMain.h"
 
 #define TSDB_DATA_SKIPLIST_LEVEL 5
+#define TSDB_OOO_RECORD_HEAD_SIZE (sizeof(int32_t) + sizeof(uint64_t) + sizeof(int32_t))  // length, uid and tid
 
+static bool        tsdbIsLastBytes(STsdbRepo *pRepo, void *ptr, int bytes);
 static void        tsdbFreeBytes(STsdbRepo *pRepo, void *ptr, int bytes);
+static void        tsdbFreeInsertNodes(STsdbRepo *pRepo, SSkipListNode **nodes, int nNodes);
 static SMemTable * tsdbNewMemTable(STsdbRepo *pRepo);
 static void        tsdbFreeMemTable(SMemTable *pMemTable);
 static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable);
@@ -28,21 +34,32 @@ static void *      tsdbCommitData(void *arg);
 static int         tsdbCommitMeta(STsdbRepo *pRepo);
 static void        tsdbEndCommit(STsdbRepo *pRepo);
 static int         tsdbHasDataToCommit(SCommitIter *iters, int nIters, TSKEY minKey, TSKEY maxKey);
-static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols);
-static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo);
+static int tsdbCommitToFile(STsdbRepo *pRepo, SMemTable *pMem, int fid, SCommitIter *iters, SRWHelper *pHelper,
+                            SDataCols *pDataCols);
+static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo, SMemTable *pMem);
 static void         tsdbDestroyCommitIters(SCommitIter *iters, int maxTables);
 static int          tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables);
+static int          tsdbCommitTSData(STsdbRepo *pRepo, SMemTable *pMem);
+static int          tsdbPutOooRows(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable, SSkipListNode **nodes);
+static void         tsdbAppendOooRows(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable);
+static int          tsdbRestoreOooRows(STsdbRepo *pRepo, char *buf, int64_t size, int64_t *validSize);
+static int          tsdbFoldOooRows(STsdbRepo *pRepo, SMemTable *pMem);
+static void         tsdbResetOooStore(STsdbRepo *pRepo);
+static void         tsdbSyncOooStore(STsdbRepo *pRepo);
 
 // ---------------- INTERNAL FUNCTIONS ----------------
-int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
-  STsdbCfg *  pCfg = &pRepo->config;
-  STsdbMeta * pMeta = pRepo->tsdbMeta;
-  int32_t     level = 0;
-  int32_t     headSize = 0;
-  TSKEY       key = dataRowKey(row);
-  SMemTable * pMemTable = pRepo->mem;
-  STableData *pTableData = NULL;
-  SSkipList * pSList = NULL;
+int tsdbInsertRowsToMem(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable) {
+  STsdbCfg *     pCfg = &pRepo->config;
+  STsdbMeta *    pMeta = pRepo->tsdbMeta;
+  int32_t        level = 0;
+  int32_t        headSize = 0;
+  SMemTable *    pMemTable = pRepo->mem;
+  STableData *   pTableData = NULL;
+  SSkipList *    pSList = NULL;
+  SSkipListNode *nodes[TSDB_MAX_INSERT_BATCH] = {0};
+  int            nNodes = 0;
+
+  ASSERT(nRows > 0 && nRows <= TSDB_MAX_INSERT_BATCH);
 
   if (pMemTable != NULL && TABLE_TID(pTable) < pMemTable->maxTables && pMemTable->tData[TABLE_TID(pTable)] != NULL &&
       pMemTable->tData[TABLE_TID(pTable)]->uid == TABLE_UID(pTable)) {
@@ -50,36 +67,37 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
     pSList = pTableData->pData;
   }
 
-  tSkipListNewNodeInfo(pSList, &level, &headSize);
+  for (nNodes = 0; nNodes < nRows; nNodes++) {
+    SDataRow row = rows[nNodes];
 
-  SSkipListNode *pNode = (SSkipListNode *)malloc(headSize + sizeof(SDataRow *));
-  if (pNode == NULL) {
-    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    return -1;
-  }
+    tSkipListNewNodeInfo(pSList, &level, &headSize);
 
-  void *pRow = tsdbAllocBytes(pRepo, dataRowLen(row));
-  if (pRow == NULL) {
-    tsdbError("vgId:%d failed to insert row with key %" PRId64 " to table %s while allocate %d bytes since %s",
-              REPO_ID(pRepo), key, TABLE_CHAR_NAME(pTable), dataRowLen(row), tstrerror(terrno));
-    free(pNode);
-    return -1;
-  }
+    SSkipListNode *pNode = (SSkipListNode *)malloc(headSize + sizeof(SDataRow *));
+    if (pNode == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _err;
+    }
+
+    void *pRow = tsdbAllocBytes(pRepo, tsdbMemRowLen(row));
+    if (pRow == NULL) {
+      tsdbError("vgId:%d failed to insert row with key %" PRId64 " to table %s while allocate %d bytes since %s",
+                REPO_ID(pRepo), dataRowKey(row), TABLE_CHAR_NAME(pTable), tsdbMemRowLen(row), tstrerror(terrno));
+      free(pNode);
+      goto _err;
+    }
 
-  pNode->level = level;
-  dataRowCpy(pRow, row);
-  *(SDataRow *)SL_GET_NODE_DATA(pNode) = pRow;
+    pNode->level = level;
+    memcpy(pRow, row, tsdbMemRowLen(row));
+    *(SDataRow *)SL_GET_NODE_DATA(pNode) = pRow;
+    nodes[nNodes] = pNode;
+  }
 
   // Operations above may change pRepo->mem, retake those values
   ASSERT(pRepo->mem != NULL);
   pMemTable = pRepo->mem;
 
   if (TABLE_TID(pTable) >= pMemTable->maxTables) {
-    if (tsdbAdjustMemMaxTables(pMemTable, pMeta->maxTables) < 0) {
-      tsdbFreeBytes(pRepo, pRow, dataRowLen(row));
-      free(pNode);
-      return -1;
-    }
+    if (tsdbAdjustMemMaxTables(pMemTable, pMeta->maxTables) < 0) goto _err;
   }
   pTableData = pMemTable->tData[TABLE_TID(pTable)];
 
@@ -95,10 +113,8 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
     if (pTableData == NULL) {
       tsdbError("vgId:%d failed to insert row with key %" PRId64
                 " to table %s while create new table data object since %s",
-                REPO_ID(pRepo), key, TABLE_CHAR_NAME(pTable), tstrerror(terrno));
-      tsdbFreeBytes(pRepo, (void *)pRow, dataRowLen(row));
-      free(pNode);
-      return -1;
+                REPO_ID(pRepo), dataRowKey(rows[0]), TABLE_CHAR_NAME(pTable), tstrerror(terrno));
+      goto _err;
     }
 
     pRepo->mem->tData[TABLE_TID(pTable)] = pTableData;
@@ -106,26 +122,40 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
 
   ASSERT((pTableData != NULL) && pTableData->uid == TABLE_UID(pTable));
 
-  if (tSkipListPut(pTableData->pData, pNode) == NULL) {
-    tsdbFreeBytes(pRepo, (void *)pRow, dataRowLen(row));
-    free(pNode);
-  } else {
-    if (TABLE_LASTKEY(pTable) < key) TABLE_LASTKEY(pTable) = key;
-    if (pMemTable->keyFirst > key) pMemTable->keyFirst = key;
-    if (pMemTable->keyLast < key) pMemTable->keyLast = key;
-    pMemTable->numOfRows++;
+  // the rows are linked into the skip list in one pass, and the statistics are updated once for the run
+  int nInserted = tSkipListPutBatch(pTableData->pData, nodes, nRows);
+  if (nInserted > 0) {
+    TSKEY keyFirst = INT64_MAX, keyLast = INT64_MIN;
+    for (int i = 0; i < nRows; i++) {
+      if (nodes[i] != NULL) continue;
+      keyFirst = MIN(keyFirst, dataRowKey(rows[i]));
+      keyLast = MAX(keyLast, dataRowKey(rows[i]));
+    }
 
-    if (pTableData->keyFirst > key) pTableData->keyFirst = key;
-    if (pTableData->keyLast < key) pTableData->keyLast = key;
-    pTableData->numOfRows++;
+    tsdbUpdateTableLastKey(pTable, keyLast);
+    if (pMemTable->keyFirst > keyFirst) pMemTable->keyFirst = keyFirst;
+    if (pMemTable->keyLast < keyLast) pMemTable->keyLast = keyLast;
+    pMemTable->numOfRows += nInserted;
+
+    if (pTableData->keyFirst > keyFirst) pTableData->keyFirst = keyFirst;
+    if (pTableData->keyLast < keyLast) pTableData->keyLast = keyLast;
+    pTableData->numOfRows += nInserted;
 
     ASSERT(pTableData->numOfRows == tSkipListGetSize(pTableData->pData));
   }
 
-  tsdbTrace("vgId:%d a row is inserted to table %s tid %d uid %" PRIu64 " key %" PRIu64, REPO_ID(pRepo),
-            TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), TABLE_UID(pTable), key);
+  // the rows discarded for the duplicated keys
+  tsdbFreeInsertNodes(pRepo, nodes, nRows);
+
+  tsdbTrace("vgId:%d %d rows are inserted to table %s tid %d uid %" PRIu64 " key %" PRId64 " to %" PRId64 ", %d discarded",
+            REPO_ID(pRepo), nInserted, TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), TABLE_UID(pTable),
+            dataRowKey(rows[0]), dataRowKey(rows[nRows - 1]), nRows - nInserted);
 
   return 0;
+
+_err:
+  tsdbFreeInsertNodes(pRepo, nodes, nNodes);
+  return -1;
 }
 
 int tsdbRefMemTable(STsdbRepo *pRepo, SMemTable *pMemTable) {
@@ -149,6 +179,7 @@ int tsdbUnRefMemTable(STsdbRepo *pRepo, SMemTable *pMemTable) {
     while ((pNode = tdListPopHead(pMemTable->bufBlockList)) != NULL) {
       tdListAppendNode(pBufPool->bufBlockList, pNode);
     }
+    tsdbReturnBufBlocks(pRepo);
     int code = pthread_cond_signal(&pBufPool->poolNotEmpty);
     if (code != 0) {
       tsdbUnlockRepo(pRepo);
@@ -163,6 +194,7 @@ int tsdbUnRefMemTable(STsdbRepo *pRepo, SMemTable *pMemTable) {
         tsdbFreeTableData(pMemTable->tData[i]);
       }
     }
+    tsdbUnRefMemTable(pRepo, (SMemTable *)pMemTable->pOMem);
 
     tdListDiscard(pMemTable->actList);
     tdListDiscard(pMemTable->bufBlockList);
@@ -171,23 +203,26 @@ int tsdbUnRefMemTable(STsdbRepo *pRepo, SMemTable *pMemTable) {
   return 0;
 }
 
-int tsdbTakeMemSnapshot(STsdbRepo *pRepo, SMemTable **pMem, SMemTable **pIMem) {
+int tsdbTakeMemSnapshot(STsdbRepo *pRepo, SMemTable **pMem, SMemTable **pIMem, SMemTable **pOMem) {
   if (tsdbLockRepo(pRepo) < 0) return -1;
 
   *pMem = pRepo->mem;
   *pIMem = pRepo->imem;
+  *pOMem = pRepo->oooH.mem;
   tsdbRefMemTable(pRepo, *pMem);
   tsdbRefMemTable(pRepo, *pIMem);
+  tsdbRefMemTable(pRepo, *pOMem);
 
   if (tsdbUnlockRepo(pRepo) < 0) return -1;
 
   if (*pMem != NULL) taosRLockLatch(&((*pMem)->latch));
+  if (*pOMem != NULL) taosRLockLatch(&((*pOMem)->latch));
 
-  tsdbDebug("vgId:%d take memory snapshot, pMem %p pIMem %p", REPO_ID(pRepo), *pMem, *pIMem);
+  tsdbDebug("vgId:%d take memory snapshot, pMem %p pIMem %p pOMem %p", REPO_ID(pRepo), *pMem, *pIMem, *pOMem);
   return 0;
 }
 
-void tsdbUnTakeMemSnapShot(STsdbRepo *pRepo, SMemTable *pMem, SMemTable *pIMem) {
+void tsdbUnTakeMemSnapShot(STsdbRepo *pRepo, SMemTable *pMem, SMemTable *pIMem, SMemTable *pOMem) {
   if (pMem != NULL) {
     taosRUnLockLatch(&(pMem->latch));
     tsdbUnRefMemTable(pRepo, pMem);
@@ -196,6 +231,11 @@ void tsdbUnTakeMemSnapShot(STsdbRepo *pRepo, SMemTable *pMem, SMemTable *pIMem)
   if (pIMem != NULL) {
     tsdbUnRefMemTable(pRepo, pIMem);
   }
+
+  if (pOMem != NULL) {
+    taosRUnLockLatch(&(pOMem->latch));
+    tsdbUnRefMemTable(pRepo, pOMem);
+  }
 }
 
 void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
@@ -208,13 +248,28 @@ void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
     SMemTable *pMemTable = tsdbNewMemTable(pRepo);
     if (pMemTable == NULL) return NULL;
     pRepo->mem = pMemTable;
+    atomic_store_64(&pRepo->pPool->memStartTime, taosGetTimestampMs());
   }
 
   ASSERT(pRepo->mem != NULL);
 
   pBufBlock = tsdbGetCurrBufBlock(pRepo);
-  if ((pRepo->mem->extraBuffList != NULL) ||
-      ((listNEles(pRepo->mem->bufBlockList) >= pCfg->totalBlocks / 3) && (pBufBlock->remain < bytes))) {
+  if (pRepo->mem->extraBuffList == NULL && (pBufBlock == NULL || pBufBlock->remain < bytes)) {
+    // take a block from the pool, or borrow one from the dnode budget if the memtable has used up its share
+    SListNode *pNode = NULL;
+    if (tsdbLockRepo(pRepo) < 0) return NULL;
+    if (listNEles(pRepo->mem->bufBlockList) < pCfg->totalBlocks / 3) {
+      pNode = tsdbAllocBufBlockFromPool(pRepo);
+    } else {
+      pNode = tsdbBorrowBufBlock(pRepo);
+    }
+    if (pNode != NULL) tdListAppendNode(pRepo->mem->bufBlockList, pNode);
+    if (tsdbUnlockRepo(pRepo) < 0) return NULL;
+    tsdbMoveBufRegion(pRepo);
+    pBufBlock = tsdbGetCurrBufBlock(pRepo);
+  }
+
+  if ((pRepo->mem->extraBuffList != NULL) || (pBufBlock == NULL) || (pBufBlock->remain < bytes)) {
     // allocate from SYSTEM buffer pool
     if (pRepo->mem->extraBuffList == NULL) {
       pRepo->mem->extraBuffList = tdListNew(0);
@@ -233,19 +288,10 @@ void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
 
     pNode->next = pNode->prev = NULL;
     tdListAppend(pRepo->mem->extraBuffList, pNode);
+    pRepo->mem->extraBytes += bytes;
     ptr = (void *)(pNode->data);
     tsdbTrace("vgId:%d allocate %d bytes from SYSTEM buffer block", REPO_ID(pRepo), bytes);
   } else {  // allocate from TSDB buffer pool
-    if (pBufBlock == NULL || pBufBlock->remain < bytes) {
-      ASSERT(listNEles(pRepo->mem->bufBlockList) < pCfg->totalBlocks / 3);
-      if (tsdbLockRepo(pRepo) < 0) return NULL;
-      SListNode *pNode = tsdbAllocBufBlockFromPool(pRepo);
-      tdListAppendNode(pRepo->mem->bufBlockList, pNode);
-      if (tsdbUnlockRepo(pRepo) < 0) return NULL;
-      pBufBlock = tsdbGetCurrBufBlock(pRepo);
-    }
-
-    ASSERT(pBufBlock->remain >= bytes);
     ptr = POINTER_SHIFT(pBufBlock->data, pBufBlock->offset);
     pBufBlock->offset += bytes;
     pBufBlock->remain -= bytes;
@@ -272,12 +318,24 @@ int tsdbAsyncCommit(STsdbRepo *pRepo) {
   }
 
   ASSERT(pRepo->commit == 0);
+  bool fold = tsdbOooShouldFold(pRepo);
+  if (pRepo->mem == NULL && fold) {
+    // only late rows are written, an empty memtable is committed to fold them
+    pRepo->mem = tsdbNewMemTable(pRepo);
+    if (pRepo->mem == NULL) return -1;
+  }
+
   if (pRepo->mem != NULL) {
     if (pRepo->appH.notifyStatus) pRepo->appH.notifyStatus(pRepo->appH.appH, TSDB_STATUS_COMMIT_START);
     if (tsdbLockRepo(pRepo) < 0) return -1;
     pRepo->imem = pRepo->mem;
     pRepo->mem = NULL;
+    if (fold) atomic_store_8(&pRepo->oooH.folding, 1);
     pRepo->commit = 1;
+    pRepo->commitOver = 0;
+    pRepo->commitStartTime = taosGetTimestampMs();
+    pRepo->pPool->memBorrowed = 0;
+    atomic_store_8(&pRepo->pPool->commitRequested, 0);
     code = pthread_create(&pRepo->commitThread, NULL, tsdbCommitData, (void *)pRepo);
     if (code != 0) {
       tsdbError("vgId:%d failed to create commit thread since %s", REPO_ID(pRepo), strerror(errno));
@@ -343,7 +401,7 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
           }
         }
 
-        tdAppendDataRowToDataCol(row, pSchema, pCols);
+        tsdbAppendMemRowToDataCol(row, pSchema, pCols);
       }
       numOfRows++;
     }
@@ -352,7 +410,191 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
   return numOfRows;
 }
 
+// tdAppendDataRowToDataCol for a row of the memtable, which may be a row of a columnar block
+void tsdbAppendMemRowToDataCol(SDataRow row, STSchema *pSchema, SDataCols *pCols) {
+  ASSERT(dataColsKeyLast(pCols) < dataRowKey(row));
+
+  int rcol = 0;
+  int dcol = 0;
+
+  while (dcol < pCols->numOfCols) {
+    SDataCol *pDataCol = &(pCols->cols[dcol]);
+    if (rcol >= schemaNCols(pSchema)) {
+      dataColSetNullAt(pDataCol, pCols->numOfRows);
+      dcol++;
+      continue;
+    }
+
+    STColumn *pRowCol = schemaColAt(pSchema, rcol);
+    if (pRowCol->colId == pDataCol->colId) {
+      dataColAppendVal(pDataCol, tsdbGetMemRowDataOfCol(row, pSchema, rcol), pCols->numOfRows, pCols->maxPoints);
+      dcol++;
+      rcol++;
+    } else if (pRowCol->colId < pDataCol->colId) {
+      rcol++;
+    } else {
+      dataColSetNullAt(pDataCol, pCols->numOfRows);
+      dcol++;
+    }
+  }
+  pCols->numOfRows++;
+}
+
+// Build the SDataRow of a row of the memtable, pRow has the space of dataRowMaxBytesFromSchema(pSchema)
+void tsdbMemRowToDataRow(SDataRow row, STSchema *pSchema, SDataRow pRow) {
+  tdInitDataRow(pRow, pSchema);
+  for (int i = 0; i < schemaNCols(pSchema); i++) {
+    STColumn *pCol = schemaColAt(pSchema, i);
+    tdAppendColVal(pRow, tsdbGetMemRowDataOfCol(row, pSchema, i), pCol->type, pCol->bytes, pCol->offset);
+  }
+}
+
+int tsdbOpenOooStore(STsdbRepo *pRepo) {
+  STsdbOooH *pOoo = &pRepo->oooH;
+  char *     fname = NULL;
+  char *     buf = NULL;
+  struct stat fState;
+
+  pOoo->magic = TSDB_FILE_INIT_MAGIC;
+  fname = tsdbGetOooFileName(pRepo->rootDir);
+  if (fname == NULL) goto _err;
+
+  pOoo->fd = open(fname, O_RDWR | O_CREAT | O_APPEND, 0755);
+  if (pOoo->fd < 0) {
+    tsdbError("vgId:%d failed to open file %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  if (fstat(pOoo->fd, &fState) < 0) {
+    tsdbError("vgId:%d failed to fstat file %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  // the late rows which are not folded yet are restored to the memtable
+  if (fState.st_size > 0) {
+    int64_t validSize = 0;
+
+    buf = (char *)malloc(fState.st_size);
+    if (buf == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _err;
+    }
+
+    if (pread(pOoo->fd, buf, fState.st_size, 0) != fState.st_size) {
+      tsdbError("vgId:%d failed to read file %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+
+    if (tsdbRestoreOooRows(pRepo, buf, fState.st_size, &validSize) < 0) goto _err;
+
+    if (validSize < fState.st_size) {
+      tsdbWarn("vgId:%d file %s is truncated from %" PRId64 " to %" PRId64 " bytes since the tail is broken",
+               REPO_ID(pRepo), fname, (int64_t)fState.st_size, validSize);
+      if (ftruncate(pOoo->fd, validSize) < 0) {
+        tsdbError("vgId:%d failed to truncate file %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        goto _err;
+      }
+    }
+
+    pOoo->magic = taosCalcChecksum(TSDB_FILE_INIT_MAGIC, (uint8_t *)buf, (uint32_t)validSize);
+    tsdbInfo("vgId:%d %" PRId64 " late rows are restored from file %s", REPO_ID(pRepo),
+             (pOoo->mem == NULL) ? 0 : pOoo->mem->numOfRows, fname);
+  }
+
+  taosTFree(buf);
+  taosTFree(fname);
+  return 0;
+
+_err:
+  taosTFree(buf);
+  taosTFree(fname);
+  return -1;
+}
+
+void tsdbCloseOooStore(STsdbRepo *pRepo) {
+  STsdbOooH *pOoo = &pRepo->oooH;
+
+  tsdbUnRefMemTable(pRepo, pOoo->mem);
+  pOoo->mem = NULL;
+
+  if (pOoo->fd >= 0) {
+    close(pOoo->fd);
+    pOoo->fd = -1;
+  }
+}
+
+// A row is late if its table has committed data with a later key, such rows are kept aside and folded in batch.
+bool tsdbIsOooRow(STsdbRepo *pRepo, STable *pTable, TSKEY key) {
+  SMemTable *pMem = pRepo->mem;
+  TSKEY      commitKey = TABLE_LASTKEY(pTable);
+
+  if (pRepo->oooH.fd < 0 || atomic_load_8(&pRepo->oooH.folding)) return false;
+
+  // the lastKey is not known before the table is restored from files, the rows go to the memtable as before
+  if (!pTable->restored) return false;
+
+  if (pMem != NULL && TABLE_TID(pTable) < pMem->maxTables && pMem->tData[TABLE_TID(pTable)] != NULL &&
+      pMem->tData[TABLE_TID(pTable)]->uid == TABLE_UID(pTable)) {
+    commitKey = pMem->tData[TABLE_TID(pTable)]->commitKey;
+  }
+
+  return key <= commitKey;
+}
+
+bool tsdbOooShouldFold(STsdbRepo *pRepo) {
+  STsdbOooH *pOoo = &pRepo->oooH;
+
+  if (pOoo->mem == NULL || atomic_load_8(&pOoo->folding)) return false;
+
+  // the rows which can not be appended to the file are folded by the next commit
+  if (pOoo->fd < 0) return true;
+
+  return pOoo->mem->extraBytes >=
+         (int64_t)pRepo->pPool->bufBlockSize * pRepo->config.totalBlocks / TSDB_OOO_FOLD_RATIO;
+}
+
+int tsdbInsertRowsToOoo(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable) {
+  SSkipListNode *nodes[TSDB_MAX_INSERT_BATCH] = {0};
+  TSKEY          keyFirst = dataRowKey(rows[0]);
+  TSKEY          keyLast = dataRowKey(rows[nRows - 1]);
+
+  ASSERT(nRows > 0 && nRows <= TSDB_MAX_INSERT_BATCH);
+
+  int nInserted = tsdbPutOooRows(pRepo, rows, nRows, pTable, nodes);
+  if (nInserted < 0) {
+    tsdbError("vgId:%d failed to insert late rows to table %s since %s", REPO_ID(pRepo), TABLE_CHAR_NAME(pTable),
+              tstrerror(terrno));
+    return -1;
+  }
+
+  if (nInserted > 0) tsdbAppendOooRows(pRepo, rows, nRows, pTable);
+
+  tsdbTrace("vgId:%d %d late rows are inserted to table %s tid %d uid %" PRIu64 " key %" PRId64 " to %" PRId64
+            ", %d discarded",
+            REPO_ID(pRepo), nInserted, TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), TABLE_UID(pTable), keyFirst,
+            keyLast, nRows - nInserted);
+
+  return 0;
+}
+
 // ---------------- LOCAL FUNCTIONS ----------------
+static bool tsdbIsLastBytes(STsdbRepo *pRepo, void *ptr, int bytes) {
+  if (pRepo->mem == NULL) return false;
+
+  if (pRepo->mem->extraBuffList == NULL) {
+    STsdbBufBlock *pBufBlock = tsdbGetCurrBufBlock(pRepo);
+    return (pBufBlock != NULL) && (pBufBlock->offset >= bytes) &&
+           (ptr == POINTER_SHIFT(pBufBlock->data, pBufBlock->offset - bytes));
+  } else {
+    SListNode *pNode = listTail(pRepo->mem->extraBuffList);
+    return (pNode != NULL) && (ptr == (void *)(pNode->data));
+  }
+}
+
 static void tsdbFreeBytes(STsdbRepo *pRepo, void *ptr, int bytes) {
   ASSERT(pRepo->mem != NULL);
   if (pRepo->mem->extraBuffList == NULL) {
@@ -372,6 +614,27 @@ static void tsdbFreeBytes(STsdbRepo *pRepo, void *ptr, int bytes) {
   }
 }
 
+// free the nodes not in the skip list, the bytes of their rows are returned only if they are the last allocated ones
+static void tsdbFreeInsertNodes(STsdbRepo *pRepo, SSkipListNode **nodes, int nNodes) {
+  bool tail = true;
+
+  for (int i = nNodes - 1; i >= 0; i--) {
+    if (nodes[i] == NULL) {
+      tail = false;
+      continue;
+    }
+
+    SDataRow row = *(SDataRow *)SL_GET_NODE_DATA(nodes[i]);
+    if (tail && tsdbIsLastBytes(pRepo, row, tsdbMemRowLen(row))) {
+      tsdbFreeBytes(pRepo, row, tsdbMemRowLen(row));
+    } else {
+      tail = false;
+    }
+
+    free(nodes[i]);
+  }
+}
+
 static SMemTable* tsdbNewMemTable(STsdbRepo *pRepo) {
   STsdbMeta *pMeta = pRepo->tsdbMeta;
 
@@ -437,6 +700,7 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
   pTableData->keyFirst = INT64_MAX;
   pTableData->keyLast = 0;
   pTableData->numOfRows = 0;
+  pTableData->commitKey = TABLE_LASTKEY(pTable);
 
   pTableData->pData = tSkipListCreate(TSDB_DATA_SKIPLIST_LEVEL, TSDB_DATA_TYPE_TIMESTAMP,
                                       TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 1, tsdbGetTsTupleKey);
@@ -462,69 +726,92 @@ static void tsdbFreeTableData(STableData *pTableData) {
 static char *tsdbGetTsTupleKey(const void *data) { return dataRowTuple(*(SDataRow *)data); }
 
 static void *tsdbCommitData(void *arg) {
-  STsdbRepo *  pRepo = (STsdbRepo *)arg;
-  SMemTable *  pMem = pRepo->imem;
-  STsdbCfg *   pCfg = &pRepo->config;
-  SDataCols *  pDataCols = NULL;
-  STsdbMeta *  pMeta = pRepo->tsdbMeta;
-  SCommitIter *iters = NULL;
-  SRWHelper    whelper = {0};
+  STsdbRepo *pRepo = (STsdbRepo *)arg;
+  SMemTable *pMem = pRepo->imem;
   ASSERT(pRepo->commit == 1);
   ASSERT(pMem != NULL);
 
+  taosPlaceThread(TAOS_THREAD_POOL_COMMIT);
+
   tsdbInfo("vgId:%d start to commit! keyFirst %" PRId64 " keyLast %" PRId64 " numOfRows %" PRId64, REPO_ID(pRepo),
             pMem->keyFirst, pMem->keyLast, pMem->numOfRows);
 
-  // Create the iterator to read from cache
-  if (pMem->numOfRows > 0) {
-    iters = tsdbCreateCommitIters(pRepo);
-    if (iters == NULL) {
-      tsdbError("vgId:%d failed to create commit iterator since %s", REPO_ID(pRepo), tstrerror(terrno));
-      goto _exit;
-    }
-
-    if (tsdbInitWriteHelper(&whelper, pRepo) < 0) {
-      tsdbError("vgId:%d failed to init write helper since %s", REPO_ID(pRepo), tstrerror(terrno));
-      goto _exit;
-    }
-
-    if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) {
-      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-      tsdbError("vgId:%d failed to init data cols with maxRowBytes %d maxCols %d maxRowsPerFileBlock %d since %s",
-                REPO_ID(pRepo), pMeta->maxCols, pMeta->maxRowBytes, pCfg->maxRowsPerFileBlock, tstrerror(terrno));
-      goto _exit;
-    }
-
-    int sfid = TSDB_KEY_FILEID(pMem->keyFirst, pCfg->daysPerFile, pCfg->precision);
-    int efid = TSDB_KEY_FILEID(pMem->keyLast, pCfg->daysPerFile, pCfg->precision);
-
-    // Loop to commit to each file
-    for (int fid = sfid; fid <= efid; fid++) {
-      if (tsdbCommitToFile(pRepo, fid, iters, &whelper, pDataCols) < 0) {
-        tsdbError("vgId:%d failed to commit to file %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
-        goto _exit;
-      }
-    }
+  if (atomic_load_8(&pRepo->oooH.folding) && tsdbFoldOooRows(pRepo, pMem) < 0) {
+    tsdbError("vgId:%d failed to fold late rows since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _exit;
   }
 
+  if (tsdbCommitTSData(pRepo, pMem) < 0) goto _exit;
+
   // Commit to update meta file
   if (tsdbCommitMeta(pRepo) < 0) {
     tsdbError("vgId:%d failed to commit data while committing meta data since %s", REPO_ID(pRepo), tstrerror(terrno));
     goto _exit;
   }
 
+  if (pMem->pOMem != NULL) tsdbResetOooStore(pRepo);
+
   tsdbFitRetention(pRepo);
 
 _exit:
-  tdFreeDataCols(pDataCols);
-  tsdbDestroyCommitIters(iters, pMem->maxTables);
-  tsdbDestroyHelper(&whelper);
+  // the late rows which failed to be folded are kept and folded by the next commit
+  atomic_store_8(&pRepo->oooH.folding, 0);
+  tsdbSyncOooStore(pRepo);
   tsdbEndCommit(pRepo);
   tsdbInfo("vgId:%d commit over", pRepo->config.tsdbId);
 
   return NULL;
 }
 
+static int tsdbCommitTSData(STsdbRepo *pRepo, SMemTable *pMem) {
+  STsdbCfg *   pCfg = &pRepo->config;
+  SDataCols *  pDataCols = NULL;
+  STsdbMeta *  pMeta = pRepo->tsdbMeta;
+  SCommitIter *iters = NULL;
+  SRWHelper    whelper = {0};
+  int          code = -1;
+
+  if (pMem->numOfRows <= 0) return 0;
+
+  // Create the iterator to read from cache
+  iters = tsdbCreateCommitIters(pRepo, pMem);
+  if (iters == NULL) {
+    tsdbError("vgId:%d failed to create commit iterator since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _exit;
+  }
+
+  if (tsdbInitWriteHelper(&whelper, pRepo) < 0) {
+    tsdbError("vgId:%d failed to init write helper since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _exit;
+  }
+
+  if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbError("vgId:%d failed to init data cols with maxRowBytes %d maxCols %d maxRowsPerFileBlock %d since %s",
+              REPO_ID(pRepo), pMeta->maxCols, pMeta->maxRowBytes, pCfg->maxRowsPerFileBlock, tstrerror(terrno));
+    goto _exit;
+  }
+
+  int sfid = TSDB_KEY_FILEID(pMem->keyFirst, pCfg->daysPerFile, pCfg->precision);
+  int efid = TSDB_KEY_FILEID(pMem->keyLast, pCfg->daysPerFile, pCfg->precision);
+
+  // Loop to commit to each file
+  for (int fid = sfid; fid <= efid; fid++) {
+    if (tsdbCommitToFile(pRepo, pMem, fid, iters, &whelper, pDataCols) < 0) {
+      tsdbError("vgId:%d failed to commit to file %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
+      goto _exit;
+    }
+  }
+
+  code = 0;
+
+_exit:
+  tdFreeDataCols(pDataCols);
+  tsdbDestroyCommitIters(iters, pMem->maxTables);
+  tsdbDestroyHelper(&whelper);
+  return code;
+}
+
 static int tsdbCommitMeta(STsdbRepo *pRepo) {
   SMemTable *pMem = pRepo->imem;
   STsdbMeta *pMeta = pRepo->tsdbMeta;
@@ -575,7 +862,9 @@ _err:
 
 static void tsdbEndCommit(STsdbRepo *pRepo) {
   ASSERT(pRepo->commit == 1);
+  pRepo->commitDuration = taosGetTimestampMs() - pRepo->commitStartTime;
   if (pRepo->appH.notifyStatus) pRepo->appH.notifyStatus(pRepo->appH.appH, TSDB_STATUS_COMMIT_OVER);
+  atomic_store_8(&pRepo->commitOver, 1);
 }
 
 static int tsdbHasDataToCommit(SCommitIter *iters, int nIters, TSKEY minKey, TSKEY maxKey) {
@@ -591,12 +880,12 @@ void tsdbGetFidKeyRange(int daysPerFile, int8_t precision, int fileId, TSKEY *mi
   *maxKey = *minKey + daysPerFile * tsMsPerDay[precision] - 1;
 }
 
-static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols) {
+static int tsdbCommitToFile(STsdbRepo *pRepo, SMemTable *pMem, int fid, SCommitIter *iters, SRWHelper *pHelper,
+                            SDataCols *pDataCols) {
   char *      dataDir = NULL;
   STsdbCfg *  pCfg = &pRepo->config;
   STsdbFileH *pFileH = pRepo->tsdbFileH;
   SFileGroup *pGroup = NULL;
-  SMemTable * pMem = pRepo->imem;
   bool        newLast = false;
 
   TSKEY minKey = 0, maxKey = 0;
@@ -710,8 +999,7 @@ _err:
   return -1;
 }
 
-static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo) {
-  SMemTable *pMem = pRepo->imem;
+static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo, SMemTable *pMem) {
   STsdbMeta *pMeta = pRepo->tsdbMeta;
 
   SCommitIter *iters = (SCommitIter *)calloc(pMem->maxTables, sizeof(SCommitIter));
@@ -783,4 +1071,308 @@ static int tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables) {
   taosTFree(tData);
 
   return 0;
-}
\ No newline at end of file
+}
+
+static int tsdbPutOooRows(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable, SSkipListNode **nodes) {
+  STsdbOooH * pOoo = &pRepo->oooH;
+  SMemTable * pMemTable = pOoo->mem;
+  STableData *pTableData = NULL;
+  int32_t     level = 0;
+  int32_t     headSize = 0;
+  int64_t     bytes = 0;
+
+  if (pMemTable == NULL) {
+    pMemTable = tsdbNewMemTable(pRepo);
+    if (pMemTable == NULL) return -1;
+
+    if (tsdbLockRepo(pRepo) < 0) {
+      T_REF_DEC(pMemTable);
+      tsdbFreeMemTable(pMemTable);
+      return -1;
+    }
+    pOoo->mem = pMemTable;
+    if (tsdbUnlockRepo(pRepo) < 0) return -1;
+  }
+
+  if (TABLE_TID(pTable) >= pMemTable->maxTables) {
+    if (tsdbAdjustMemMaxTables(pMemTable, pRepo->tsdbMeta->maxTables) < 0) return -1;
+  }
+
+  pTableData = pMemTable->tData[TABLE_TID(pTable)];
+  if (pTableData == NULL || pTableData->uid != TABLE_UID(pTable)) {
+    if (pTableData != NULL) {
+      taosWLockLatch(&(pMemTable->latch));
+      pMemTable->tData[TABLE_TID(pTable)] = NULL;
+      tsdbFreeTableData(pTableData);
+      taosWUnLockLatch(&(pMemTable->latch));
+    }
+
+    pTableData = tsdbNewTableData(&pRepo->config, pTable);
+    if (pTableData == NULL) return -1;
+    pMemTable->tData[TABLE_TID(pTable)] = pTableData;
+  }
+
+  // the row is kept right after its node and freed with the node, the memtable lives across commits
+  for (int i = 0; i < nRows; i++) {
+    tSkipListNewNodeInfo(pTableData->pData, &level, &headSize);
+
+    SSkipListNode *pNode = (SSkipListNode *)malloc(headSize + sizeof(SDataRow *) + dataRowLen(rows[i]));
+    if (pNode == NULL) {
+      for (int j = 0; j < i; j++) free(nodes[j]);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    SDataRow pRow = (SDataRow)POINTER_SHIFT(pNode, headSize + sizeof(SDataRow *));
+    pNode->level = level;
+    dataRowCpy(pRow, rows[i]);
+    *(SDataRow *)SL_GET_NODE_DATA(pNode) = pRow;
+    nodes[i] = pNode;
+    bytes += headSize + sizeof(SDataRow *) + dataRowLen(rows[i]);
+  }
+
+  int nInserted = tSkipListPutBatch(pTableData->pData, nodes, nRows);
+
+  for (int i = 0; i < nRows; i++) {
+    if (nodes[i] != NULL) {  // discarded for the duplicated key
+      bytes -= SL_NODE_HEADER_SIZE(nodes[i]->level) + sizeof(SDataRow *) + dataRowLen(rows[i]);
+      free(nodes[i]);
+      rows[i] = NULL;
+      continue;
+    }
+
+    TSKEY key = dataRowKey(rows[i]);
+    if (pMemTable->keyFirst > key) pMemTable->keyFirst = key;
+    if (pMemTable->keyLast < key) pMemTable->keyLast = key;
+    if (pTableData->keyFirst > key) pTableData->keyFirst = key;
+    if (pTableData->keyLast < key) pTableData->keyLast = key;
+  }
+
+  pMemTable->numOfRows += nInserted;
+  pMemTable->extraBytes += bytes;
+  pTableData->numOfRows += nInserted;
+
+  return nInserted;
+}
+
+// the rows are appended as records of length, uid, tid, row and checksum. The rows discarded are NULL.
+static void tsdbAppendOooRows(STsdbRepo *pRepo, SDataRow *rows, int nRows, STable *pTable) {
+  STsdbOooH *pOoo = &pRepo->oooH;
+  int        tlen = 0;
+
+  if (pOoo->fd < 0) return;
+
+  for (int i = 0; i < nRows; i++) {
+    if (rows[i] != NULL) tlen += TSDB_OOO_RECORD_HEAD_SIZE + dataRowLen(rows[i]) + sizeof(TSCKSUM);
+  }
+
+  char *buf = (char *)malloc(tlen);
+  if (buf == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  char *pBuf = buf;
+  for (int i = 0; i < nRows; i++) {
+    if (rows[i] == NULL) continue;
+
+    int   len = TSDB_OOO_RECORD_HEAD_SIZE + dataRowLen(rows[i]) + sizeof(TSCKSUM);
+    void *ptr = pBuf;
+
+    taosEncodeFixedI32(&ptr, len);
+    taosEncodeFixedU64(&ptr, TABLE_UID(pTable));
+    taosEncodeFixedI32(&ptr, TABLE_TID(pTable));
+    dataRowCpy(ptr, rows[i]);
+    taosCalcChecksumAppend(0, (uint8_t *)pBuf, len);
+    pBuf += len;
+  }
+
+  if (taosTWrite(pOoo->fd, buf, tlen) != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  // the magic is read by the sync thread to tell if the file is changed
+  atomic_store_32(&pOoo->magic, taosCalcChecksum(pOoo->magic, (uint8_t *)buf, tlen));
+  free(buf);
+  return;
+
+_err:
+  // the rows are kept in the WAL, they are folded by the next commit
+  tsdbError("vgId:%d failed to append %d bytes of late rows since %s, the late rows are not kept aside any more",
+            REPO_ID(pRepo), tlen, tstrerror(terrno));
+  taosTFree(buf);
+  close(pOoo->fd);
+  pOoo->fd = -1;
+}
+
+static int tsdbRestoreOooRows(STsdbRepo *pRepo, char *buf, int64_t size, int64_t *validSize) {
+  STsdbMeta *pMeta = pRepo->tsdbMeta;
+  int64_t    offset = 0;
+  int64_t    nRestored = 0;
+
+  while (offset + TSDB_OOO_RECORD_HEAD_SIZE + sizeof(TSCKSUM) <= size) {
+    int32_t        len = 0;
+    uint64_t       uid = 0;
+    int32_t        tid = 0;
+    void *         ptr = buf + offset;
+    SSkipListNode *node = NULL;
+
+    ptr = taosDecodeFixedI32(ptr, &len);
+    if (len < TSDB_OOO_RECORD_HEAD_SIZE + TD_DATA_ROW_HEAD_SIZE + sizeof(TSCKSUM) || offset + len > size) break;
+    if (!taosCheckChecksumWhole((uint8_t *)(buf + offset), len)) break;
+
+    ptr = taosDecodeFixedU64(ptr, &uid);
+    ptr = taosDecodeFixedI32(ptr, &tid);
+
+    SDataRow row = (SDataRow)ptr;
+    if (dataRowLen(row) != len - TSDB_OOO_RECORD_HEAD_SIZE - sizeof(TSCKSUM)) break;
+
+    // the rows of the dropped tables are skipped
+    STable *pTable = (tid > 0 && tid < pMeta->maxTables) ? pMeta->tables[tid] : NULL;
+    if (pTable != NULL && TABLE_UID(pTable) == uid) {
+      if (tsdbPutOooRows(pRepo, &row, 1, pTable, &node) < 0) return -1;
+      nRestored++;
+    }
+
+    offset += len;
+  }
+
+  *validSize = offset;
+  tsdbDebug("vgId:%d %" PRId64 " late rows are read from %" PRId64 " bytes", REPO_ID(pRepo), nRestored, offset);
+  return 0;
+}
+
+// The late rows are put into the memtable to commit, so the existing file blocks are merged once for both. The nodes
+// refer to the rows of the late memtable, it is kept referenced by the memtable. The late rows with the keys in the
+// memtable are discarded, the same as the readers do.
+static int tsdbFoldOooRows(STsdbRepo *pRepo, SMemTable *pMem) {
+  STsdbMeta *    pMeta = pRepo->tsdbMeta;
+  SMemTable *    pOMem = pRepo->oooH.mem;
+  SSkipListNode *nodes[TSDB_MAX_INSERT_BATCH] = {0};
+  int32_t        level = 0;
+  int32_t        headSize = 0;
+  int64_t        nFolded = 0;
+
+  ASSERT(pOMem != NULL && pMem->pOMem == NULL);
+  tsdbInfo("vgId:%d start to fold late rows! keyFirst %" PRId64 " keyLast %" PRId64 " numOfRows %" PRId64,
+           REPO_ID(pRepo), pOMem->keyFirst, pOMem->keyLast, pOMem->numOfRows);
+
+  if (pMem->maxTables < pOMem->maxTables && tsdbAdjustMemMaxTables(pMem, pOMem->maxTables) < 0) return -1;
+
+  tsdbRefMemTable(pRepo, pOMem);
+  pMem->pOMem = pOMem;
+
+  for (int tid = 0; tid < pOMem->maxTables; tid++) {
+    STableData *pOData = pOMem->tData[tid];
+    STable *    pTable = NULL;
+    if (pOData == NULL || pOData->numOfRows == 0) continue;
+
+    if (tsdbRLockRepoMeta(pRepo) < 0) return -1;
+    if (pMeta->tables[tid] != NULL && TABLE_UID(pMeta->tables[tid]) == pOData->uid) {
+      pTable = pMeta->tables[tid];
+      tsdbRefTable(pTable);
+    }
+    if (tsdbUnlockRepoMeta(pRepo) < 0) {
+      if (pTable != NULL) tsdbUnRefTable(pTable);
+      return -1;
+    }
+
+    // the rows of the dropped tables are skipped
+    if (pTable == NULL) continue;
+
+    STableData *pTableData = pMem->tData[tid];
+    if (pTableData == NULL || pTableData->uid != pOData->uid) {
+      if (pTableData != NULL) {
+        taosWLockLatch(&(pMem->latch));
+        pMem->tData[tid] = NULL;
+        tsdbFreeTableData(pTableData);
+        taosWUnLockLatch(&(pMem->latch));
+      }
+
+      pTableData = tsdbNewTableData(&pRepo->config, pTable);
+      if (pTableData == NULL) {
+        tsdbUnRefTable(pTable);
+        return -1;
+      }
+      pMem->tData[tid] = pTableData;
+    }
+    tsdbUnRefTable(pTable);
+
+    SSkipListIterator *pIter = tSkipListCreateIter(pOData->pData);
+    if (pIter == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    // the rows are put in runs of ascending keys
+    bool hasNext = tSkipListIterNext(pIter);
+    while (hasNext) {
+      int nNodes = 0;
+      for (; nNodes < TSDB_MAX_INSERT_BATCH && hasNext; nNodes++, hasNext = tSkipListIterNext(pIter)) {
+        tSkipListNewNodeInfo(pTableData->pData, &level, &headSize);
+
+        nodes[nNodes] = (SSkipListNode *)malloc(headSize + sizeof(SDataRow *));
+        if (nodes[nNodes] == NULL) {
+          for (int i = 0; i < nNodes; i++) free(nodes[i]);
+          tSkipListDestroyIter(pIter);
+          terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+          return -1;
+        }
+
+        nodes[nNodes]->level = level;
+        *(SDataRow *)SL_GET_NODE_DATA(nodes[nNodes]) = *(SDataRow *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      }
+
+      int nInserted = tSkipListPutBatch(pTableData->pData, nodes, nNodes);
+
+      for (int i = 0; i < nNodes; i++) {
+        if (nodes[i] != NULL) {  // discarded for the duplicated key
+          free(nodes[i]);
+          nodes[i] = NULL;
+        }
+      }
+
+      pTableData->numOfRows += nInserted;
+      pMem->numOfRows += nInserted;
+      nFolded += nInserted;
+    }
+
+    tSkipListDestroyIter(pIter);
+
+    if (pTableData->keyFirst > pOData->keyFirst) pTableData->keyFirst = pOData->keyFirst;
+    if (pTableData->keyLast < pOData->keyLast) pTableData->keyLast = pOData->keyLast;
+    if (pMem->keyFirst > pOData->keyFirst) pMem->keyFirst = pOData->keyFirst;
+    if (pMem->keyLast < pOData->keyLast) pMem->keyLast = pOData->keyLast;
+  }
+
+  tsdbInfo("vgId:%d %" PRId64 " late rows are folded to the memtable to commit", REPO_ID(pRepo), nFolded);
+  return 0;
+}
+
+// the late rows are committed, the file is emptied and the late memtable is released with the committed memtable
+static void tsdbResetOooStore(STsdbRepo *pRepo) {
+  STsdbOooH *pOoo = &pRepo->oooH;
+  SMemTable *pOMem = pOoo->mem;
+
+  // the rows in the file are restored again after crash if it fails to be truncated, they are discarded by the merge
+  if (pOoo->fd >= 0 && ftruncate(pOoo->fd, 0) < 0) {
+    tsdbError("vgId:%d failed to truncate out-of-order file since %s", REPO_ID(pRepo), strerror(errno));
+    close(pOoo->fd);
+    pOoo->fd = -1;
+  }
+  atomic_store_32(&pOoo->magic, TSDB_FILE_INIT_MAGIC);
+
+  if (tsdbLockRepo(pRepo) < 0) return;
+  pOoo->mem = NULL;
+  tsdbUnlockRepo(pRepo);
+
+  tsdbUnRefMemTable(pRepo, pOMem);
+  tsdbInfo("vgId:%d late rows are folded", REPO_ID(pRepo));
+}
+
+static void tsdbSyncOooStore(STsdbRepo *pRepo) {
+  if (pRepo->oooH.fd >= 0 && fsync(pRepo->oooH.fd) < 0) {
+    tsdbError("vgId:%d failed to sync out-of-order file since %s", REPO_ID(pRepo), strerror(errno));
+  }
+}
@@ -23,15 +23,23 @@
 #define TSDB_SUPER_TABLE_SL_LEVEL 5
 #define DEFAULT_TAG_INDEX_COLUMN 0
 
+typedef struct {
+  STable *pSTable;
+  STable *pTable;
+  char *  key;  // tag index key of pTable
+} STableIndexElem;
+
 static int     tsdbCompareSchemaVersion(const void *key1, const void *key2);
 static int     tsdbRestoreTable(void *pHandle, void *cont, int contLen);
 static void    tsdbOrgMeta(void *pHandle);
+static int     tsdbCompareTableIndexElem(const void *a, const void *b);
 static char *  getTagIndexKey(const void *pData);
 static STable *tsdbNewTable(STableCfg *pCfg, bool isSuper);
 static void    tsdbFreeTable(STable *pTable);
 static int     tsdbAddTableToMeta(STsdbRepo *pRepo, STable *pTable, bool addIdx, bool lock);
 static void    tsdbRemoveTableFromMeta(STsdbRepo *pRepo, STable *pTable, bool rmFromIdx, bool lock);
 static int     tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper);
+static SSkipListNode *tsdbNewTableIndexNode(STable *pSTable, STable *pTable);
 static int     tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable);
 static int     tsdbInitTableCfg(STableCfg *config, ETableType type, uint64_t uid, int32_t tid);
 static int     tsdbTableSetSchema(STableCfg *config, STSchema *pSchema, bool dup);
@@ -104,6 +112,7 @@ int tsdbCreateTable(TSDB_REPO_T *repo, STableCfg *pCfg) {
 
   table = tsdbNewTable(pCfg, false);
   if (table == NULL) goto _err;
+  table->restored = true;  // a new table has no data in files
 
   // Register to meta
   tsdbWLockRepoMeta(pRepo);
@@ -633,12 +642,74 @@ static void tsdbOrgMeta(void *pHandle) {
   STsdbRepo *pRepo = (STsdbRepo *)pHandle;
   STsdbMeta *pMeta = pRepo->tsdbMeta;
 
+  // Sort the child tables by super table and tag index key, so that the tables of each super table are put into its
+  // index skip list as sorted runs, each table is linked right after the previous one instead of searched from the top.
+  SArray *pTables = taosArrayInit(pMeta->nTables + 1, sizeof(STableIndexElem));
+  if (pTables == NULL) {
+    for (int i = 1; i < pMeta->maxTables; i++) {
+      STable *pTable = pMeta->tables[i];
+      if (pTable != NULL && pTable->type == TSDB_CHILD_TABLE) {
+        tsdbAddTableIntoIndex(pMeta, pTable, true);
+      }
+    }
+    return;
+  }
+
   for (int i = 1; i < pMeta->maxTables; i++) {
     STable *pTable = pMeta->tables[i];
     if (pTable != NULL && pTable->type == TSDB_CHILD_TABLE) {
-      tsdbAddTableIntoIndex(pMeta, pTable, true);
+      STableIndexElem elem = {.pSTable = tsdbGetTableByUid(pMeta, TABLE_SUID(pTable)), .pTable = pTable};
+      ASSERT(elem.pSTable != NULL);
+      // the tag schema of the child table is taken from its super table
+      pTable->pSuper = elem.pSTable;
+      elem.key = getTagIndexKey(&pTable);
+      taosArrayPush(pTables, &elem);
+    }
+  }
+
+  taosArraySort(pTables, tsdbCompareTableIndexElem);
+
+  SSkipListNode *nodes[TSDB_MAX_INSERT_BATCH] = {0};
+  STable *       pSTable = NULL;
+  int            nNodes = 0;
+
+  for (size_t i = 0; i < taosArrayGetSize(pTables); i++) {
+    STableIndexElem *pElem = taosArrayGet(pTables, i);
+
+    if (pElem->pSTable != pSTable || nNodes >= TSDB_MAX_INSERT_BATCH) {
+      if (nNodes > 0) tSkipListPutBatch(pSTable->pIndex, nodes, nNodes);
+      pSTable = pElem->pSTable;
+      nNodes = 0;
+    }
+
+    SSkipListNode *pNode = tsdbNewTableIndexNode(pSTable, pElem->pTable);
+    if (pNode == NULL) {
+      tsdbError("vgId:%d failed to add table %s into the tag index since %s", REPO_ID(pRepo),
+                TABLE_CHAR_NAME(pElem->pTable), tstrerror(terrno));
+      continue;
     }
+
+    nodes[nNodes++] = pNode;
+    T_REF_INC(pSTable);
   }
+
+  if (nNodes > 0) tSkipListPutBatch(pSTable->pIndex, nodes, nNodes);
+
+  taosArrayDestroy(pTables);
+}
+
+static int tsdbCompareTableIndexElem(const void *a, const void *b) {
+  const STableIndexElem *pElem1 = (const STableIndexElem *)a;
+  const STableIndexElem *pElem2 = (const STableIndexElem *)b;
+
+  if (pElem1->pSTable != pElem2->pSTable) {
+    return (TABLE_UID(pElem1->pSTable) < TABLE_UID(pElem2->pSTable)) ? -1 : 1;
+  }
+
+  int ret = pElem1->pSTable->pIndex->comparFn(pElem1->key, pElem2->key);
+  if (ret != 0) return ret;
+
+  return TABLE_TID(pElem1->pTable) - TABLE_TID(pElem2->pTable);
 }
 
 static char *getTagIndexKey(const void *pData) {
@@ -892,6 +963,15 @@ static int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper
 
   pTable->pSuper = pSTable;
 
+  SSkipListNode *pNode = tsdbNewTableIndexNode(pSTable, pTable);
+  if (pNode == NULL) return -1;
+
+  tSkipListPut(pSTable->pIndex, pNode);
+  if (refSuper) T_REF_INC(pSTable);
+  return 0;
+}
+
+static SSkipListNode *tsdbNewTableIndexNode(STable *pSTable, STable *pTable) {
   int32_t level = 0;
   int32_t headSize = 0;
 
@@ -902,15 +982,12 @@ static int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper
   SSkipListNode *pNode = calloc(1, headSize + sizeof(STable *));
   if (pNode == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    return -1;
+    return NULL;
   }
   pNode->level = level;
 
   memcpy(SL_GET_NODE_DATA(pNode), &pTable, sizeof(STable *));
-
-  tSkipListPut(pSTable->pIndex, pNode);
-  if (refSuper) T_REF_INC(pSTable);
-  return 0;
+  return pNode;
 }
 
 static int tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable) {
@@ -1656,7 +1656,7 @@ static int tsdbLoadAndMergeFromCache(SDataCols *pDataCols, int *iter, SCommitIte
         ASSERT(pSchema != NULL);
       }
 
-      tdAppendDataRowToDataCol(row, pSchema, pTarget);
+      tsdbAppendMemRowToDataCol(row, pSchema, pTarget);
       tSkipListIterNext(pCommitIter->pIter);
     }
 
@@ -66,10 +66,11 @@ typedef struct STableCheckInfo {
   int32_t       compSize;
   int32_t       numOfBlocks;    // number of qualified data blocks not the original blocks
   SDataCols*    pDataCols;
-  int32_t       chosen;         // indicate which iterator should move forward
+  int32_t       chosen;         // indicate which iterator should move forward, 0: iter, 1: iiter, 2: oiter
   bool          initBuf;        // whether to initialize the in-memory skip list iterator or not
   SSkipListIterator* iter;      // mem buffer skip list iterator
   SSkipListIterator* iiter;     // imem buffer skip list iterator
+  SSkipListIterator* oiter;     // out-of-order buffer skip list iterator
 } STableCheckInfo;
 
 typedef struct STableBlockInfo {
@@ -113,6 +114,7 @@ typedef struct STsdbQueryHandle {
   int32_t        allocSize;        // allocated data block size
   SMemTable*     mem;              // mem-table
   SMemTable*     imem;             // imem-table, acquired from snapshot
+  SMemTable*     omem;             // out-of-order mem-table, acquired from snapshot
   SArray*        defaultLoadColumn;// default load column
   SDataBlockLoadInfo dataBlockLoadInfo; /* record current block load information */
   SLoadCompBlockInfo compBlockLoadInfo; /* record current compblock information in SQuery */
@@ -188,7 +190,7 @@ TsdbQueryHandleT* tsdbQueryTables(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STab
     goto out_of_memory;
   }
 
-  tsdbTakeMemSnapshot(pQueryHandle->pTsdb, &pQueryHandle->mem, &pQueryHandle->imem);
+  tsdbTakeMemSnapshot(pQueryHandle->pTsdb, &pQueryHandle->mem, &pQueryHandle->imem, &pQueryHandle->omem);
 
   size_t sizeOfGroup = taosArrayGetSize(groupList->pGroupList);
   assert(sizeOfGroup >= 1 && pCond != NULL && pCond->numOfCols > 0);
@@ -309,11 +311,11 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
   int32_t order = pHandle->order;
 
   // no data in buffer, abort
-  if (pHandle->mem == NULL && pHandle->imem == NULL) {
+  if (pHandle->mem == NULL && pHandle->imem == NULL && pHandle->omem == NULL) {
     return false;
   }
 
-  assert(pCheckInfo->iter == NULL && pCheckInfo->iiter == NULL);
+  assert(pCheckInfo->iter == NULL && pCheckInfo->iiter == NULL && pCheckInfo->oiter == NULL);
 
   // TODO: add uid check
   if (pHandle->mem && pCheckInfo->tableId.tid < pHandle->mem->maxTables &&
@@ -328,14 +330,21 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
                                                    (const char*)&pCheckInfo->lastKey, TSDB_DATA_TYPE_TIMESTAMP, order);
   }
 
-  // both iterators are NULL, no data in buffer right now
-  if (pCheckInfo->iter == NULL && pCheckInfo->iiter == NULL) {
+  if (pHandle->omem && pCheckInfo->tableId.tid < pHandle->omem->maxTables &&
+      pHandle->omem->tData[pCheckInfo->tableId.tid] != NULL) {
+    pCheckInfo->oiter = tSkipListCreateIterFromVal(pHandle->omem->tData[pCheckInfo->tableId.tid]->pData,
+                                                   (const char*)&pCheckInfo->lastKey, TSDB_DATA_TYPE_TIMESTAMP, order);
+  }
+
+  // all iterators are NULL, no data in buffer right now
+  if (pCheckInfo->iter == NULL && pCheckInfo->iiter == NULL && pCheckInfo->oiter == NULL) {
     return false;
   }
 
   bool memEmpty  = (pCheckInfo->iter == NULL) || (pCheckInfo->iter != NULL && !tSkipListIterNext(pCheckInfo->iter));
   bool imemEmpty = (pCheckInfo->iiter == NULL) || (pCheckInfo->iiter != NULL && !tSkipListIterNext(pCheckInfo->iiter));
-  if (memEmpty && imemEmpty) { // buffer is empty
+  bool omemEmpty = (pCheckInfo->oiter == NULL) || (pCheckInfo->oiter != NULL && !tSkipListIterNext(pCheckInfo->oiter));
+  if (memEmpty && imemEmpty && omemEmpty) { // buffer is empty
     return false;
   }
 
@@ -365,102 +374,89 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
         pHandle->qinfo);
   }
 
+  if (!omemEmpty) {
+    SSkipListNode* node = tSkipListIterGet(pCheckInfo->oiter);
+    assert(node != NULL);
+
+    SDataRow row = *(SDataRow *)SL_GET_NODE_DATA(node);
+    TSKEY key = dataRowKey(row);  // first timestamp in buffer
+    tsdbDebug("%p uid:%" PRId64", tid:%d check late data in omem from skey:%" PRId64 ", order:%d, %p", pHandle,
+           pCheckInfo->tableId.uid, pCheckInfo->tableId.tid, key, order, pHandle->qinfo);
+  }
+
   return true;
 }
 
 static void destroyTableMemIterator(STableCheckInfo* pCheckInfo) {
   tSkipListDestroyIter(pCheckInfo->iter);
   tSkipListDestroyIter(pCheckInfo->iiter);
+  tSkipListDestroyIter(pCheckInfo->oiter);
+}
+
+static SDataRow getCurrentRowInIter(SSkipListIterator* pIter) {
+  if (pIter == NULL) {
+    return NULL;
+  }
+
+  SSkipListNode* node = tSkipListIterGet(pIter);
+  return (node == NULL) ? NULL : *(SDataRow *)SL_GET_NODE_DATA(node);
 }
 
 SDataRow getSDataRowInTableMem(STableCheckInfo* pCheckInfo, int32_t order) {
-  SDataRow rmem = NULL, rimem = NULL;
-  if (pCheckInfo->iter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    if (node != NULL) {
-      rmem = *(SDataRow *)SL_GET_NODE_DATA(node);
+  // the iterators are listed by precedence: the rows in imem are written before the late rows kept in omem, and the
+  // late rows are written before the rows in mem with the same timestamp
+  SSkipListIterator* iters[] = {pCheckInfo->iiter, pCheckInfo->oiter, pCheckInfo->iter};
+  int32_t            chosen[] = {1, 2, 0};
+
+  SDataRow row = NULL;
+  int32_t  index = -1;
+
+  for (int32_t i = 0; i < tListLen(iters); ++i) {
+    SDataRow r = getCurrentRowInIter(iters[i]);
+    if (r == NULL) {
+      continue;
     }
-  }
 
-  if (pCheckInfo->iiter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    if (node != NULL) {
-      rimem = *(SDataRow *)SL_GET_NODE_DATA(node);
+    if (row == NULL) {
+      row = r;
+      index = i;
+      continue;
     }
-  }
 
-  if (rmem != NULL && rimem != NULL) {
-    TSKEY r1 = dataRowKey(rmem);
-    TSKEY r2 = dataRowKey(rimem);
+    TSKEY r1 = dataRowKey(row);
+    TSKEY r2 = dataRowKey(r);
 
-    if (r1 == r2) { // data ts are duplicated, ignore the data in mem
-      tSkipListIterNext(pCheckInfo->iter);
-      pCheckInfo->chosen = 1;
-      return rimem;
-    } else {
-      if (ASCENDING_TRAVERSE(order)) {
-        if (r1 < r2) {
-          pCheckInfo->chosen = 0;
-          return rmem;
-        } else {
-          pCheckInfo->chosen = 1;
-          return rimem;
-        }
-      } else {
-        if (r1 < r2) {
-          pCheckInfo->chosen = 1;
-          return rimem;
-        } else {
-          pCheckInfo->chosen = 0;
-          return rmem;
-        }
-      }
+    if (r1 == r2) {  // data ts are duplicated, ignore the data in the iterator with lower precedence
+      tSkipListIterNext(iters[i]);
+    } else if ((ASCENDING_TRAVERSE(order) && r2 < r1) || (!ASCENDING_TRAVERSE(order) && r2 > r1)) {
+      row = r;
+      index = i;
     }
   }
 
-  // at least one (rmem or rimem) is absent here
-  if (rmem != NULL) {
-    pCheckInfo->chosen = 0;
-    return rmem;
-  }
-
-  if (rimem != NULL) {
-    pCheckInfo->chosen = 1;
-    return rimem;
+  if (row != NULL) {
+    pCheckInfo->chosen = chosen[index];
   }
 
-  return NULL;
+  return row;
 }
 
 static bool moveToNextRowInMem(STableCheckInfo* pCheckInfo) {
-  bool hasNext = false;
+  SSkipListIterator* pIter = NULL;
   if (pCheckInfo->chosen == 0) {
-    if (pCheckInfo->iter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iter);
-    }
-
-    if (hasNext) {
-      return hasNext;
-    }
-
-    if (pCheckInfo->iiter != NULL) {
-      return tSkipListIterGet(pCheckInfo->iiter) != NULL;
-    }
-  } else { //pCheckInfo->chosen == 1
-    if (pCheckInfo->iiter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iiter);
-    }
-
-    if (hasNext) {
-      return hasNext;
-    }
+    pIter = pCheckInfo->iter;
+  } else if (pCheckInfo->chosen == 1) {
+    pIter = pCheckInfo->iiter;
+  } else {
+    pIter = pCheckInfo->oiter;
+  }
 
-    if (pCheckInfo->iter != NULL) {
-      return tSkipListIterGet(pCheckInfo->iter) != NULL;
-    }
+  if (pIter != NULL && tSkipListIterNext(pIter)) {
+    return true;
   }
 
-  return hasNext;
+  return getCurrentRowInIter(pCheckInfo->iter) != NULL || getCurrentRowInIter(pCheckInfo->iiter) != NULL ||
+         getCurrentRowInIter(pCheckInfo->oiter) != NULL;
 }
 
 static bool hasMoreDataInCache(STsdbQueryHandle* pHandle) {
@@ -950,7 +946,7 @@ static void copyOneRowFromMem(STsdbQueryHandle* pQueryHandle, int32_t capacity,
     }
 
     if (pSchema->columns[j].colId == pColInfo->info.colId) {
-      void* value = tdGetRowDataOfCol(row, pColInfo->info.type, TD_DATA_ROW_HEAD_SIZE + pSchema->columns[j].offset);
+      void* value = tsdbGetMemRowDataOfCol(row, pSchema, j);
       if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
         memcpy(pData, value, varDataTLen(value));
       } else {
@@ -1098,7 +1094,7 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
   cur->win = TSWINDOW_INITIALIZER;
 
   // no data in buffer, load data from file directly
-  if (pCheckInfo->iiter == NULL && pCheckInfo->iter == NULL) {
+  if (pCheckInfo->iiter == NULL && pCheckInfo->iter == NULL && pCheckInfo->oiter == NULL) {
     int32_t start = cur->pos;
     int32_t end = endPos;
 
@@ -1122,7 +1118,7 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
     updateInfoAfterMerge(pQueryHandle, pCheckInfo, numOfRows, pos);
     doCheckGeneratedBlockRange(pQueryHandle);
     return;
-  } else if (pCheckInfo->iter != NULL || pCheckInfo->iiter != NULL) {
+  } else if (pCheckInfo->iter != NULL || pCheckInfo->iiter != NULL || pCheckInfo->oiter != NULL) {
     SSkipListNode* node = NULL;
     do {
       SDataRow row = getSDataRowInTableMem(pCheckInfo, pQueryHandle->order);
@@ -1643,7 +1639,8 @@ bool tsdbNextDataBlock(TsdbQueryHandleT* pHandle) {
         return false;
       }
 
-      tsdbTakeMemSnapshot(pSecQueryHandle->pTsdb, &pSecQueryHandle->mem, &pSecQueryHandle->imem);
+      tsdbTakeMemSnapshot(pSecQueryHandle->pTsdb, &pSecQueryHandle->mem, &pSecQueryHandle->imem,
+                          &pSecQueryHandle->omem);
 
       // allocate buffer in order to load data blocks from file
       int32_t numOfCols = QH_GET_NUM_OF_COLS(pQueryHandle);
@@ -1760,6 +1757,7 @@ void changeQueryHandleForLastrowQuery(TsdbQueryHandleT pqHandle) {
 
   for(int32_t i = 0; i < numOfTables; ++i) {
     STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    tsdbRestoreTableInfo(pQueryHandle->pTsdb, pCheckInfo->pTableObj);
     if (pCheckInfo->pTableObj->lastKey > key) {
       key = pCheckInfo->pTableObj->lastKey;
       index = i;
@@ -1780,6 +1778,7 @@ void changeQueryHandleForLastrowQuery(TsdbQueryHandleT pqHandle) {
 
     STableCheckInfo* pTableCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
     tSkipListDestroyIter(pTableCheckInfo->iter);
+    tSkipListDestroyIter(pTableCheckInfo->oiter);
 
     if (pTableCheckInfo->pDataCols != NULL) {
       taosTFree(pTableCheckInfo->pDataCols->buf);
@@ -1813,6 +1812,7 @@ static void changeQueryHandleForInterpQuery(TsdbQueryHandleT pHandle) {
   int32_t i = 0;
   while(i < numOfTables) {
     STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    tsdbRestoreTableInfo(pQueryHandle->pTsdb, pCheckInfo->pTableObj);
     if (pQueryHandle->window.skey <= pCheckInfo->pTableObj->lastKey &&
         pCheckInfo->pTableObj->lastKey != TSKEY_INITIAL_VAL) {
       break;
@@ -2466,7 +2466,7 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   taosTFree(pQueryHandle->statis);
 
   // todo check error
-  tsdbUnTakeMemSnapShot(pQueryHandle->pTsdb, pQueryHandle->mem, pQueryHandle->imem);
+  tsdbUnTakeMemSnapShot(pQueryHandle->pTsdb, pQueryHandle->mem, pQueryHandle->imem, pQueryHandle->omem);
 
   tsdbDestroyHelper(&pQueryHandle->rhelper);
 
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <sys/time.h>
 
+#include "tscompression.h"
 #include "tsdb.h"
 #include "tsdbMain.h"
 
@@ -24,7 +25,10 @@ typedef struct {
   STSchema * pSchema;
 } SInsertInfo;
 
+// the rows are inserted in submit messages of rowsPerSubmit rows, the number of rows inserted is returned
 static int insertData(SInsertInfo *pInfo) {
+  SShellSubmitRspMsg rsp = {0};
+  int                affectedRows = 0;
   SSubmitMsg *pMsg =
       (SSubmitMsg *)malloc(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pInfo->pSchema) * pInfo->rowsPerSubmit);
   if (pMsg == NULL) return -1;
@@ -74,22 +78,23 @@ static int insertData(SInsertInfo *pInfo) {
     pBlock->tid = htonl(pBlock->tid);
 
     pBlock->sversion = htonl(pBlock->sversion);
-    pBlock->padding = htonl(pBlock->padding);
+    pBlock->format = htons(TSDB_SUBMIT_BLK_ROW);
 
     pMsg->length = htonl(pMsg->length);
     pMsg->numOfBlocks = htonl(pMsg->numOfBlocks);
 
-    if (tsdbInsertData(pInfo->pRepo, pMsg, NULL) < 0) {
+    if (tsdbInsertData(pInfo->pRepo, pMsg, &rsp) < 0) {
       taosTFree(pMsg);
       return -1;
     }
+    affectedRows += htonl(rsp.affectedRows);
   }
 
   double etime = getCurTime();
 
   printf("Spent %f seconds to write %d records\n", etime - stime, pInfo->totalRows);
   taosTFree(pMsg);
-  return 0;
+  return affectedRows;
 }
 
 static void tsdbSetCfg(STsdbCfg *pCfg, int32_t tsdbId, int32_t cacheBlockSize, int32_t totalBlocks, int32_t maxTables,
@@ -128,34 +133,356 @@ static void tsdbSetTableCfg(STableCfg *pCfg) {
   tdDestroyTSchemaBuilder(&schemaBuilder);
 }
 
-TEST(TsdbTest, testInsertSpeed) {
-  int         vnode = 1;
-  int         ret = 0;
-  STsdbCfg    tsdbCfg;
-  STableCfg   tableCfg;
-  std::string testDir = "./test";
-  char *      rootDir = strdup((testDir + "/vnode" + std::to_string(vnode)).c_str());
 
-  tsdbDebugFlag = 131; //NOTE: you must set the flag
+#define TEST_DIR "./test"
+#define TEST_START_TIME 1590000000000L
+
+// Each test works on a repository of its own under ./test with the table t1 created. The repository is closed without
+// commit and removed after the test.
+class TsdbTest : public ::testing::Test {
+ protected:
+  TSDB_REPO_T *repo = NULL;
+  STableCfg *  pTableCfg = NULL;
+  std::string  rootDir;
+
+  void SetUp() override {
+    rootDir = std::string(TEST_DIR) + "/" + ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    ASSERT_EQ(taosMkDir(TEST_DIR, 0755), 0);
+    taosRemoveDir((char *)rootDir.c_str());
+
+    pTableCfg = (STableCfg *)calloc(1, sizeof(STableCfg));
+    ASSERT_NE(pTableCfg, nullptr);
+    tsdbSetTableCfg(pTableCfg);
+  }
+
+  void TearDown() override {
+    if (repo != NULL) tsdbCloseRepo(repo, 0);
+    repo = NULL;
+    tsdbClearTableCfg(pTableCfg);
+    taosRemoveDir((char *)rootDir.c_str());
+  }
+
+  STsdbRepo *getRepo() { return (STsdbRepo *)repo; }
+
+  STable *getTable() { return tsdbGetTableByUid(tsdbGetMeta(repo), pTableCfg->tableId.uid); }
+
+  void openRepo(int32_t cacheBlockSize, int32_t totalBlocks) {
+    STsdbCfg tsdbCfg = {0};
 
-  taosRemoveDir(rootDir);
+    tsdbSetCfg(&tsdbCfg, 1, cacheBlockSize, totalBlocks, -1, -1, -1, -1, -1, -1, -1);
+    ASSERT_EQ(tsdbCreateRepo((char *)rootDir.c_str(), &tsdbCfg), 0);
+    repo = tsdbOpenRepo((char *)rootDir.c_str(), NULL);
+    ASSERT_NE(repo, nullptr);
+    ASSERT_EQ(tsdbCreateTable(repo, pTableCfg), 0);
+  }
+
+  void reopenRepo(int toCommit) {
+    tsdbCloseRepo(repo, toCommit);
+    repo = tsdbOpenRepo((char *)rootDir.c_str(), NULL);
+    ASSERT_NE(repo, nullptr);
+  }
 
-  // Create and open repository
-  tsdbSetCfg(&tsdbCfg, 1, 16, 4, -1, -1, -1, -1, -1, -1, -1);
-  tsdbCreateRepo(rootDir, &tsdbCfg);
-  TSDB_REPO_T *repo = tsdbOpenRepo(rootDir, NULL);
-  ASSERT_NE(repo, nullptr);
+  // commit the memtable and wait for it, the committed memtable is released as tsdbEndCommit does
+  void commitRepo() {
+    STsdbRepo *pRepo = getRepo();
+
+    ASSERT_EQ(tsdbAsyncCommit(pRepo), 0);
+    ASSERT_EQ(pthread_join(pRepo->commitThread, NULL), 0);
+    pRepo->commit = 0;
+    tsdbUnRefMemTable(pRepo, pRepo->imem);
+    pRepo->imem = NULL;
+  }
 
-  // Create table
-  tsdbSetTableCfg(&tableCfg);
-  tsdbCreateTable(repo, &tableCfg);
+  // the rows are 10ms apart from the one after startTime
+  int insertRows(TSKEY startTime, int totalRows) {
+    SInsertInfo iInfo = {repo,      true, pTableCfg->tableId.tid, pTableCfg->tableId.uid, 0, startTime, 10, totalRows,
+                         100, pTableCfg->schema};
+    return insertData(&iInfo);
+  }
+};
 
-  // Insert data
-  SInsertInfo iInfo = {repo, true, 1, 5849583783847394, 0, 1590000000000, 10, 10000000, 100, tableCfg.schema};
+TEST_F(TsdbTest, testInsertSpeed) {
+  tsdbDebugFlag = 131; //NOTE: you must set the flag
 
-  insertData(&iInfo);
+  ASSERT_NO_FATAL_FAILURE(openRepo(16, 4));
+  ASSERT_EQ(insertRows(TEST_START_TIME, 10000000), 10000000);
+  EXPECT_EQ(TABLE_LASTKEY(getTable()), TEST_START_TIME + 10000000L * 10);
 
   tsdbCloseRepo(repo, 1);
+  repo = NULL;
+}
+
+TEST_F(TsdbTest, testRestoreLastKey) {
+  ASSERT_NO_FATAL_FAILURE(openRepo(16, 4));
+  ASSERT_EQ(insertRows(TEST_START_TIME, 100000), 100000);
+  TSKEY lastKey = TABLE_LASTKEY(getTable());
+  EXPECT_EQ(lastKey, TEST_START_TIME + 100000L * 10);
+
+  // the lastKey is restored from the data file when it is needed
+  ASSERT_NO_FATAL_FAILURE(reopenRepo(1));
+  STable *pTable = getTable();
+  ASSERT_NE(pTable, nullptr);
+  EXPECT_FALSE(pTable->restored);
+  tsdbRestoreTableInfo(getRepo(), pTable);
+  ASSERT_TRUE(pTable->restored);
+  ASSERT_EQ(TABLE_LASTKEY(pTable), lastKey);
+}
+
+// the memtable grows beyond its configured blocks with the blocks borrowed from the dnode budget
+TEST_F(TsdbTest, testBufBudget) {
+  ASSERT_EQ(tsdbInitBufMgr(10 * 1024 * 1024), 0);
+
+  // the memtable is committed when it reaches 2 blocks without the budget
+  ASSERT_NO_FATAL_FAILURE(openRepo(1, 6));
+  ASSERT_EQ(insertRows(TEST_START_TIME, 100000), 100000);
+
+  STsdbRepo *pRepo = getRepo();
+  EXPECT_EQ(pRepo->imem, nullptr);
+  EXPECT_EQ(pRepo->mem->numOfRows, 100000);
+  EXPECT_GT(pRepo->pPool->nBorrowed, 0);
+  EXPECT_LE(pRepo->pPool->tBufBlocks, 10);
+
+  // the borrowed blocks are returned after commit
+  ASSERT_NO_FATAL_FAILURE(commitRepo());
+  EXPECT_EQ(pRepo->pPool->nBorrowed, 0);
+  EXPECT_EQ(pRepo->pPool->tBufBlocks, 6);
+
+  tsdbCloseRepo(repo, 0);
+  repo = NULL;
+  tsdbCleanupBufMgr();
+}
+
+// the configured blocks are carved out of one region, the borrowed blocks are returned without the region blocks
+TEST_F(TsdbTest, testBufPoolRegion) {
+  STsdbBufPoolStatis statis = {0};
+
+  ASSERT_EQ(tsdbInitBufMgr(10 * 1024 * 1024), 0);
+  tsMemtableHugePage = TAOS_HUGE_PAGE_TRANSPARENT;
+  tsMemtableNumaBind = 1;
+
+  ASSERT_NO_FATAL_FAILURE(openRepo(1, 6));
+
+  STsdbRepo *pRepo = getRepo();
+  ASSERT_NE(pRepo->pPool->region, nullptr);
+  EXPECT_EQ(pRepo->pPool->regionSize % TAOS_HUGE_PAGE_SIZE, 0);
+  tsdbGetBufPoolStatis(&statis);
+  EXPECT_EQ(statis.regionBytes, (int64_t)pRepo->pPool->regionSize);
+
+  ASSERT_EQ(insertRows(TEST_START_TIME, 100000), 100000);
+  EXPECT_GT(pRepo->pPool->nBorrowed, 0);
+
+  tsdbGetBufPoolStatis(&statis);
+  if (taosGetNumaNode() >= 0 && pRepo->pPool->numaBind) {
+    EXPECT_EQ(pRepo->pPool->numaNode, taosGetNumaNode());
+    EXPECT_GT(statis.localBlocks, 0);
+  }
+
+  ASSERT_NO_FATAL_FAILURE(commitRepo());
+  EXPECT_EQ(pRepo->pPool->nBorrowed, 0);
+  EXPECT_EQ(pRepo->pPool->tBufBlocks, 6);
+
+  SListIter      iter = {0};
+  SListNode *    pNode = NULL;
+  STsdbBufBlock *pBufBlock = NULL;
+  tdListInitIter(pRepo->pPool->bufBlockList, &iter, TD_LIST_FORWARD);
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    tdListNodeGetData(pRepo->pPool->bufBlockList, pNode, (void *)(&pBufBlock));
+    EXPECT_GE((char *)pBufBlock, pRepo->pPool->region);
+    EXPECT_LT((char *)pBufBlock, pRepo->pPool->region + pRepo->pPool->regionSize);
+  }
+
+  tsdbCloseRepo(repo, 0);
+  repo = NULL;
+  tsdbGetBufPoolStatis(&statis);
+  EXPECT_EQ(statis.regionBytes, 0);
+  EXPECT_EQ(statis.numaBoundBytes, 0);
+
+  tsMemtableHugePage = TAOS_HUGE_PAGE_NONE;
+  tsMemtableNumaBind = 0;
+  tsdbCleanupBufMgr();
+}
+
+// the byte order of a submit message of one block is restored after tsdbInsertData converts it
+static void restoreSubmitMsg(SSubmitMsg *pMsg) {
+  SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+
+  pMsg->length = htonl(pMsg->length);
+  pMsg->numOfBlocks = htonl(pMsg->numOfBlocks);
+  pBlock->uid = htobe64(pBlock->uid);
+  pBlock->tid = htonl(pBlock->tid);
+  pBlock->format = htons(pBlock->format);
+  pBlock->sversion = htonl(pBlock->sversion);
+  pBlock->dataLen = htonl(pBlock->dataLen);
+  pBlock->numOfRows = htons(pBlock->numOfRows);
+}
+
+// a columnar block is kept as columns in the memtable, the null values are restored from the bitmap, and its late
+// rows are built as rows for the late store
+TEST_F(TsdbTest, testColumnarSubmit) {
+  const int   numOfRows = 100;
+  const TSKEY startTime = taosGetTimestampMs();
+
+  ASSERT_NO_FATAL_FAILURE(openRepo(16, 4));
+
+  STSchema *pSchema = pTableCfg->schema;
+  int       bitmapLen = (numOfRows + 7) / 8;
+  int       size = sizeof(SSubmitMsg) + sizeof(SSubmitBlk) +
+             schemaNCols(pSchema) * (sizeof(SSubmitColHead) + bitmapLen + sizeof(int64_t) * numOfRows + COMP_OVERFLOW_BYTES);
+  SSubmitMsg *pMsg = (SSubmitMsg *)calloc(1, size);
+  ASSERT_NE(pMsg, nullptr);
+  SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+  char *      pData = pBlock->data;
+
+  // column 2 has a null value every 3 rows, odd columns are compressed
+  for (int j = 0; j < schemaNCols(pSchema); j++) {
+    STColumn *      pCol = schemaColAt(pSchema, j);
+    SSubmitColHead *pHead = (SSubmitColHead *)pData;
+    char *          bitmap = pData + sizeof(SSubmitColHead);
+    char            values[sizeof(int64_t) * numOfRows];
+
+    for (int i = 0; i < numOfRows; i++) {
+      if (j == 0) {
+        *(TSKEY *)(values + sizeof(TSKEY) * i) = startTime + i;
+      } else if (j == 2 && i % 3 == 0) {
+        bitmap[i >> 3] |= (1 << (i & 7));
+        *(int32_t *)(values + sizeof(int32_t) * i) = *(int32_t *)getNullValue(pCol->type);
+      } else {
+        *(int32_t *)(values + sizeof(int32_t) * i) = i * j;
+      }
+    }
+
+    int rawLen = TYPE_BYTES[pCol->type] * numOfRows;
+    int len = rawLen;
+    pHead->comp = NO_COMPRESSION;
+    if (j % 2 == 1) {
+      len = (*(tDataTypeDesc[pCol->type].compFunc))(values, rawLen, numOfRows, bitmap + bitmapLen,
+                                                    rawLen + COMP_OVERFLOW_BYTES, ONE_STAGE_COMP, NULL, 0);
+      pHead->comp = ONE_STAGE_COMP;
+    } else {
+      memcpy(bitmap + bitmapLen, values, rawLen);
+    }
+
+    pHead->colId = htons(pCol->colId);
+    pHead->type = pCol->type;
+    pHead->rawLen = htonl(rawLen);
+    pHead->len = htonl(len);
+    pData += sizeof(SSubmitColHead) + bitmapLen + len;
+  }
+
+  int dataLen = (int)(pData - pBlock->data);
+  pBlock->uid = htobe64(pTableCfg->tableId.uid);
+  pBlock->tid = htonl(pTableCfg->tableId.tid);
+  pBlock->format = htons(TSDB_SUBMIT_BLK_COL);
+  pBlock->sversion = htonl(schemaVersion(pSchema));
+  pBlock->dataLen = htonl(dataLen);
+  pBlock->numOfRows = htons(numOfRows);
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataLen);
+  pMsg->numOfBlocks = htonl(1);
+
+  SShellSubmitRspMsg rsp = {0};
+  ASSERT_EQ(tsdbInsertData(repo, pMsg, &rsp), 0);
+  EXPECT_EQ(htonl(rsp.affectedRows), numOfRows);
+
+  STsdbRepo *        pRepo = getRepo();
+  SSkipListIterator *pIter = tSkipListCreateIter(pRepo->mem->tData[pTableCfg->tableId.tid]->pData);
+  int                i = 0;
+  while (tSkipListIterNext(pIter)) {
+    SDataRow row = *(SDataRow *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    EXPECT_TRUE(tsdbIsMemColRow(row));
+    EXPECT_EQ(dataRowKey(row), startTime + i);
+    EXPECT_EQ(dataRowVersion(row), schemaVersion(pSchema));
+    for (int j = 1; j < schemaNCols(pSchema); j++) {
+      int32_t val = *(int32_t *)tsdbGetMemRowDataOfCol(row, pSchema, j);
+      if (j == 2 && i % 3 == 0) {
+        EXPECT_TRUE(isNull((char *)&val, schemaColAt(pSchema, j)->type));
+      } else {
+        EXPECT_EQ(val, i * j);
+      }
+    }
+    i++;
+  }
+  EXPECT_EQ(i, numOfRows);
+  tSkipListDestroyIter(pIter);
+
+  // the rows of the block are committed, the same block is late then
+  ASSERT_NO_FATAL_FAILURE(commitRepo());
+  restoreSubmitMsg(pMsg);
+  ASSERT_EQ(tsdbInsertData(repo, pMsg, &rsp), 0);
+  EXPECT_EQ(htonl(rsp.affectedRows), numOfRows);
+  ASSERT_NE(pRepo->oooH.mem, nullptr);
+  EXPECT_TRUE(pRepo->mem == NULL || pRepo->mem->numOfRows == 0);
+
+  pIter = tSkipListCreateIter(pRepo->oooH.mem->tData[pTableCfg->tableId.tid]->pData);
+  i = 0;
+  while (tSkipListIterNext(pIter)) {
+    SDataRow row = *(SDataRow *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    EXPECT_FALSE(tsdbIsMemColRow(row));
+    EXPECT_EQ(dataRowKey(row), startTime + i);
+    for (int j = 1; j < schemaNCols(pSchema); j++) {
+      STColumn *pCol = schemaColAt(pSchema, j);
+      int32_t   val = *(int32_t *)tdGetRowDataOfCol(row, pCol->type, TD_DATA_ROW_HEAD_SIZE + pCol->offset);
+      if (j == 2 && i % 3 == 0) {
+        EXPECT_TRUE(isNull((char *)&val, pCol->type));
+      } else {
+        EXPECT_EQ(val, i * j);
+      }
+    }
+    i++;
+  }
+  EXPECT_EQ(i, numOfRows);
+  tSkipListDestroyIter(pIter);
+
+  // a column which does not match the schema is rejected
+  restoreSubmitMsg(pMsg);
+  ((SSubmitColHead *)pBlock->data)->colId = htons(100);
+  EXPECT_LT(tsdbInsertData(repo, pMsg, &rsp), 0);
+  EXPECT_EQ(terrno, TSDB_CODE_TDB_SUBMIT_MSG_MSSED_UP);
+
+  free(pMsg);
+}
+
+// the late rows are kept aside and replayed after reopen, they are folded to the data files in one batch
+TEST_F(TsdbTest, testOooStore) {
+  ASSERT_NO_FATAL_FAILURE(openRepo(1, 4));
+  ASSERT_EQ(insertRows(TEST_START_TIME, 10000), 10000);
+  ASSERT_NO_FATAL_FAILURE(commitRepo());
+
+  // the rows older than the committed ones do not go to the memtable
+  STsdbRepo *pRepo = getRepo();
+  ASSERT_EQ(insertRows(TEST_START_TIME + 5, 1000), 1000);
+  ASSERT_NE(pRepo->oooH.mem, nullptr);
+  EXPECT_EQ(pRepo->oooH.mem->numOfRows, 1000);
+  EXPECT_TRUE(pRepo->mem == NULL || pRepo->mem->numOfRows == 0);
+
+  ASSERT_NO_FATAL_FAILURE(reopenRepo(0));
+  pRepo = getRepo();
+  ASSERT_NE(pRepo->oooH.mem, nullptr);
+  EXPECT_EQ(pRepo->oooH.mem->numOfRows, 1000);
+
+  // the late rows are folded when they take a quarter of the buffer, the duplicated ones are discarded
+  int nInserted = 1000;
+  tsdbRestoreTableInfo(pRepo, getTable());
+  for (int offset = 1; offset < 10 && !pRepo->commit; offset++) {
+    int nRows = insertRows(TEST_START_TIME + offset, 9000);
+    ASSERT_EQ(nRows, (offset == 5) ? 8000 : 9000);
+    nInserted += nRows;
+  }
+  ASSERT_TRUE(pRepo->commit);
+  ASSERT_EQ(pthread_join(pRepo->commitThread, NULL), 0);
+  EXPECT_EQ(pRepo->oooH.mem, nullptr);
+  EXPECT_EQ(pRepo->oooH.folding, 0);
+
+  // the late rows are committed with the memtable, the imem refers to the rows of the late memtable till it is freed
+  ASSERT_NE(pRepo->imem, nullptr);
+  EXPECT_EQ(pRepo->imem->numOfRows + ((pRepo->mem == NULL) ? 0 : pRepo->mem->numOfRows), nInserted);
+  EXPECT_NE(pRepo->imem->pOMem, nullptr);
+
+  struct stat fState;
+  char *      fname = tsdbGetOooFileName(pRepo->rootDir);
+  ASSERT_EQ(stat(fname, &fState), 0);
+  EXPECT_EQ(fState.st_size, 0);
+  EXPECT_EQ(pRepo->oooH.magic, TSDB_FILE_INIT_MAGIC);
+  free(fname);
 }
 
 static char *getTKey(const void *data) {
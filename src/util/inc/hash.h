@@ -26,6 +26,9 @@ extern "C" {
 #define HASH_DEFAULT_LOAD_FACTOR (0.75)
 #define HASH_INDEX(v, c) ((v) & ((c)-1))
 
+#define HASH_CONCURRENT_SHARDS 16   // number of independently locked shards of a concurrent hash table
+#define HASH_INLINE_KEY_BYTES  8    // leading bytes of the key kept in the slot of a concurrent hash table
+
 typedef void (*_hash_free_fn_t)(void *param);
 
 typedef struct SHashNode {
@@ -53,6 +56,9 @@ typedef struct SHashObj {
 #else
   pthread_mutex_t *lock;
 #endif
+
+  struct SHashShard *shards;       // shards of a concurrent hash table, NULL for a normal one
+  int32_t            numOfShards;
 } SHashObj;
 
 typedef struct SHashMutableIterator {
@@ -61,6 +67,12 @@ typedef struct SHashMutableIterator {
   SHashNode *pCur;
   SHashNode *pNext;  // current node can be deleted for mutable iterator, so keep the next one before return current
   int32_t    num;    // already check number of elements in hash table
+
+  // the nodes of a shard of a concurrent hash table are copied under the shard lock, and returned one by one
+  int32_t     shardIndex;
+  SHashNode **pNodes;
+  int32_t     numOfNodes;
+  int32_t     nodeIndex;
 } SHashMutableIterator;
 
 /**
@@ -73,6 +85,20 @@ typedef struct SHashMutableIterator {
  */
 SHashObj *taosHashInit(size_t capacity, _hash_fn_t fn, bool threadsafe);
 
+/**
+ * init a thread safe hash table for the maps shared by many threads. The keys are spread over shards which are locked
+ * separately, each shard is an open addressing table which is resized incrementally by the writers, so a resize never
+ * blocks the readers of other shards for a full rehash.
+ *
+ * The iterator copies the nodes of one shard at a time, the entries must not be removed by other threads during the
+ * iteration, as for a normal hash table.
+ *
+ * @param capacity    initial capacity of the hash table
+ * @param fn          hash function to generate the hash value
+ * @return
+ */
+SHashObj *taosHashInitConcurrent(size_t capacity, _hash_fn_t fn);
+
 /**
  * return the size of hash table
  * @param pHashObj
@@ -41,4 +41,21 @@ uint32_t taosIntHash_64(const char *key, uint32_t len);
 
 _hash_fn_t taosGetDefaultHashFunction(int32_t type);
 
+/**
+ * select the shard of a key by the high bits of its mixed hash value. The hash value of an integer key is the key
+ * itself, or almost, so it is mixed by the finalizer of murmur hash before the shard is selected.
+ * @hashVal     hash value of the key
+ * @numOfShards number of shards
+ * @return      index of the shard
+ */
+static FORCE_INLINE int32_t taosHashShardIndex(uint32_t hashVal, int32_t numOfShards) {
+  hashVal ^= hashVal >> 16;
+  hashVal *= 0x85ebca6b;
+  hashVal ^= hashVal >> 13;
+  hashVal *= 0xc2b2ae35;
+  hashVal ^= hashVal >> 16;
+
+  return (int32_t)(((uint64_t)hashVal * (uint32_t)numOfShards) >> 32u);
+}
+
 #endif //TDENGINE_HASHUTIL_H
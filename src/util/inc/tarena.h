@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TARENA_H
+#define TDENGINE_TARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+#define TAOS_ARENA_DEFAULT_CHUNK_SIZE 4096
+
+typedef struct SArenaChunk {
+  struct SArenaChunk *next;
+  size_t              size;  // bytes of the data
+  size_t              used;
+  char                data[];
+} SArenaChunk;
+
+/*
+ * the objects of the same lifetime, e.g. the ones of a query or the nodes of a parsed statement, are allocated from
+ * an arena by bumping a pointer, and they are released together when the arena is destroyed. The objects are never
+ * freed one by one, and an arena is not thread safe.
+ */
+typedef struct SArena {
+  SArenaChunk *pChunk;      // chunk of the allocation, the first chunk is allocated with the arena
+  size_t       chunkSize;
+  size_t       allocBytes;  // bytes allocated from the arena
+  size_t       totalBytes;  // bytes of the chunks
+} SArena;
+
+/**
+ * @param chunkSize  size of the chunks, the first one is allocated with the arena
+ * @return           the arena, or NULL if there is no memory
+ */
+SArena *taosArenaInit(size_t chunkSize);
+
+/**
+ * allocate a buffer aligned to 8 bytes, the buffer larger than half a chunk is allocated in a chunk of its own
+ * @return  the buffer, or NULL if there is no memory
+ */
+void *taosArenaMalloc(SArena *pArena, size_t size);
+
+void *taosArenaCalloc(SArena *pArena, size_t num, size_t size);
+
+// the memory of all the buffers is released, except the first chunk
+void taosArenaReset(SArena *pArena);
+
+void taosArenaDestroy(SArena *pArena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TARENA_H
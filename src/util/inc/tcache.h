@@ -31,9 +31,11 @@ typedef struct SCacheStatis {
   int64_t hitCount;
   int64_t totalAccess;
   int64_t refreshCount;
+  int64_t evictCount;    // number of elements evicted by the size limit of a sharded cache
 } SCacheStatis;
 
 struct STrashElem;
+struct SCacheShard;
 
 typedef struct SCacheDataNode {
   uint64_t           addedTime;    // the added time when this element is added or updated into cache
@@ -43,7 +45,11 @@ typedef struct SCacheDataNode {
   struct STrashElem *pTNodeHeader; // point to trash node head
   uint16_t           keySize: 15;  // max key size: 32kb
   bool               inTrashCan: 1;// denote if it is in trash or not
+  uint8_t            visited;      // second chance bit of CLOCK eviction, set when the element is acquired
+  uint8_t            shardIndex;   // the shard of a sharded cache which the element belongs to
   uint32_t           size;         // allocated size for current SCacheDataNode
+  struct SCacheDataNode *prev;     // the CLOCK ring of the shard, only used by the sharded cache
+  struct SCacheDataNode *next;
   T_REF_DECLARE()
   char              *key;
   char               data[];
@@ -75,8 +81,12 @@ typedef struct {
   uint8_t         deleting;           // set the deleting flag to stop refreshing ASAP.
   pthread_t       refreshWorker;
   bool            extendLifespan;     // auto extend life span when one item is accessed.
+  _hash_fn_t      hashFp;
+  struct SCacheShard *pShards;        // the shards of a sharded cache, pHashTable is not used if it is not NULL
+  int32_t         numOfShards;
+  int64_t         maxSize;            // the size limit of a sharded cache, 0 means no limit
 #if defined(LINUX)
-  pthread_rwlock_t lock;
+  pthread_rwlock_t lock;              // guards the trash of a sharded cache
 #else
   pthread_mutex_t  lock;
 #endif
@@ -93,6 +103,21 @@ typedef struct {
  */
 SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan, __cache_free_fn_t fn, const char *cacheName);
 
+/**
+ * initialize a sharded cache object. Each shard has its own lock, and the acquisitions only take the read lock of
+ * the shard. When the total size of the elements exceeds maxSize, the elements which are not referenced are
+ * evicted by CLOCK, the element acquired since the last visit of the clock hand gets a second chance.
+ *
+ * @param keyType              key type
+ * @param refreshTimeInSeconds refresh operation interval time
+ * @param extendLifespan       auto extend lifespan, if accessed
+ * @param fn                   free resource callback function
+ * @param maxSize              size limit in bytes of all elements, 0 means no limit
+ * @return
+ */
+SCacheObj *taosCacheInitSharded(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan,
+                                __cache_free_fn_t fn, const char *cacheName, int64_t maxSize);
+
 /**
  * add data into cache
  *
@@ -171,6 +196,20 @@ void taosCacheEmpty(SCacheObj *pCacheObj);
  */
 void taosCacheCleanup(SCacheObj *pCacheObj);
 
+/**
+ * get the number of elements in cache, the elements in trash are not included
+ * @param pCacheObj
+ * @return
+ */
+size_t taosCacheGetNumOfElems(SCacheObj *pCacheObj);
+
+/**
+ * get the hit/miss/eviction statistics of cache
+ * @param pCacheObj
+ * @param pStatis
+ */
+void taosCacheGetStatis(SCacheObj *pCacheObj, SCacheStatis *pStatis);
+
 /**
  *
  * @param pCacheObj
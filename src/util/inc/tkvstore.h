@@ -41,6 +41,8 @@ typedef struct {
   int        sfd;
   char *     fnew;
   int        nfd;
+  char *     fckpt;
+  int64_t    ckptSize;  // size of the store file covered by the checkpoint file
   SHashObj * map;
   iterFunc   iFunc;
   afterFunc  aFunc;
@@ -35,6 +35,11 @@ int32_t taosInitLog(char *logName, int32_t numOfLogLines, int32_t maxFiles);
 void    taosCloseLog();
 void    taosResetLog();
 
+/*
+ * If tsBinaryLog is set and the log is written asynchronously, the line is not formatted by the calling thread.
+ * The raw arguments are copied into a ring buffer of the thread and rendered by the log thread later, so the flags
+ * and the format must be string literals in this mode.
+ */
 void    taosPrintLog(const char *flags, int32_t dflag, const char *format, ...)
 #ifdef __GNUC__
  __attribute__((format(printf, 3, 4)))
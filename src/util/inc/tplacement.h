@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TPLACEMENT_H
+#define TDENGINE_TPLACEMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+#include "taosdef.h"
+
+// the thread pools of the dnode which are placed on the cores configured for them
+typedef enum {
+  TAOS_THREAD_POOL_RPC,
+  TAOS_THREAD_POOL_WRITE,
+  TAOS_THREAD_POOL_READ,
+  TAOS_THREAD_POOL_COMMIT,
+  TAOS_THREAD_POOL_SYNC,
+  TAOS_THREAD_POOL_MAX
+} ETaosThreadPool;
+
+typedef struct {
+  const char *cores[TAOS_THREAD_POOL_MAX];  // core list of each pool like "0-3,8", the threads float if it is empty
+  int32_t     numOfCores;                   // online cores of the system
+  int8_t      pinWrite;                     // each write thread takes one core of its pool
+  int8_t      isolateRpc;                   // the read threads do not run on the cores of the rpc threads
+} SThreadPlacementCfg;
+
+/**
+ * init the placement of the thread pools, the threads are not placed if it is not initialized
+ * @return 0 if success, -1 if a core list is invalid and terrno is set
+ */
+int32_t taosInitThreadPlacement(const SThreadPlacementCfg *pCfg);
+void    taosCleanupThreadPlacement();
+
+/**
+ * bind the calling thread to the cores of its pool. The threads of a pinned pool take the cores one by one, the
+ * cores are ordered by NUMA node so that the threads started together are on the same node.
+ */
+void taosPlaceThread(int8_t pool);
+
+/*
+ * the effective placement like "rpc:0-1 write:2-5/pin read:6-15/fail:2 commit:* sync:*". The cores are those the
+ * placed threads are actually allowed to run on, * if no thread is placed, and fail:n is the number of threads which
+ * failed to be placed and float.
+ */
+void taosGetThreadPlacement(char *buf, int32_t len);
+
+// parse the core list into cores, the number of cores is returned, or -1 if the list is invalid
+int32_t taosParseCoreList(const char *str, int32_t numOfCores, int32_t *cores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TPLACEMENT_H
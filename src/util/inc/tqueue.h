@@ -38,7 +38,7 @@ int        taosGetQitem(taos_qall, int *type, void **pitem);
 void       taosResetQitems(taos_qall);
 
 taos_qset  taosOpenQset();
-void       taosCloseQset();
+void       taosCloseQset(taos_qset);
 void       taosQsetThreadResume(taos_qset param);
 int        taosAddIntoQset(taos_qset, taos_queue, void *ahandle);
 void       taosRemoveFromQset(taos_qset, taos_queue);
@@ -46,6 +46,8 @@ int        taosGetQueueNumber(taos_qset);
 
 int        taosReadQitemFromQset(taos_qset, int *type, void **pitem, void **handle);
 int        taosReadAllQitemsFromQset(taos_qset, taos_qall, void **handle);
+int        taosAcquireAllQitemsFromQset(taos_qset, taos_qall, void **handle, taos_queue *queue);
+void       taosReleaseQueue(taos_queue);
 
 int        taosGetQueueItemsNumber(taos_queue param);
 int        taosGetQsetItemsNumber(taos_qset param);
@@ -28,9 +28,24 @@ typedef struct SSchedMsg {
   void *thandle;
 } SSchedMsg;
 
+typedef struct SSchedStatus {
+  int32_t numOfThreads;
+  int32_t numOfPending;    // tasks waiting to be executed
+  int32_t maxPending;      // high watermark of the pending tasks
+  int64_t numOfTasks;      // tasks executed
+  int64_t numOfSteals;     // tasks executed by other threads than the one they were scheduled to
+  int64_t numOfOverflows;  // tasks scheduled while the pending tasks exceed the queue size
+} SSchedStatus;
+
+/*
+ * Each thread of the scheduler has its own task queues, and an idle thread steals the tasks of the busy ones, so a
+ * slow task only delays the tasks which no idle thread can take. The queueSize is a soft limit: the tasks are never
+ * blocked or dropped when it is exceeded, which is counted in numOfOverflows.
+ */
 void *taosInitScheduler(int queueSize, int numOfThreads, const char *label);
 void *taosInitSchedulerWithInfo(int queueSize, int numOfThreads, const char *label, void *tmrCtrl);
 int  taosScheduleTask(void *qhandle, SSchedMsg *pMsg);
+void taosGetSchedulerStatus(void *qhandle, SSchedStatus *pStatus);
 void taosCleanUpScheduler(void *param);
 
 #ifdef __cplusplus
@@ -173,6 +173,20 @@ void tSkipListNewNodeInfo(SSkipList *pSkipList, int32_t *level, int32_t *headSiz
  */
 SSkipListNode *tSkipListPut(SSkipList *pSkipList, SSkipListNode *pNode);
 
+/**
+ * put a run of nodes sorted by key in ascending order into the skip list. The position of each node is searched from
+ * the position of the previous one, so a run appended after the maximum key is linked at the tail directly.
+ *
+ * The entries of the inserted nodes are set to NULL in pNodes, the nodes left are discarded since their keys exist
+ * in the skip list, and they are still owned by the caller.
+ *
+ * @param pSkipList
+ * @param pNodes
+ * @param num
+ * @return          the number of inserted nodes
+ */
+int32_t tSkipListPutBatch(SSkipList *pSkipList, SSkipListNode **pNodes, int32_t num);
+
 /**
  * get *all* nodes which key are equivalent to pKey
  *
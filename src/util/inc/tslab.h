@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSLAB_H
+#define TDENGINE_TSLAB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+// the modules which allocate from the slab, the live bytes are accounted for each of them
+typedef enum {
+  TAOS_SLAB_RPC,
+  TAOS_SLAB_QUEUE,
+  TAOS_SLAB_MAX_MODULES
+} ETaosSlabModule;
+
+typedef struct {
+  int64_t liveBytes[TAOS_SLAB_MAX_MODULES];  // bytes allocated and not freed yet
+  int64_t pooledBytes;                       // bytes of the free blocks kept in the global pool
+} SSlabStatis;
+
+/**
+ * allocate a zeroed buffer. The buffers up to 64KB are allocated from size classes, a freed buffer is kept in the
+ * cache of the freeing thread, and the caches exchange buffers with a global pool in batch, so a buffer allocated by
+ * one thread and freed by another one is reused without taking a lock in most cases.
+ *
+ * @param module  module which owns the buffer, see ETaosSlabModule
+ * @param size    size of the buffer
+ * @return        buffer, or NULL if there is no memory
+ */
+void *taosSlabMalloc(int8_t module, int32_t size);
+
+/**
+ * resize the buffer, the content is kept, the additional bytes are not initialized
+ * @param module  module which owns the buffer if it is allocated by this call
+ * @param ptr     buffer from taosSlabMalloc, or NULL
+ * @param size    new size of the buffer, the buffer is freed if it is 0
+ * @return        the new buffer, or NULL if there is no memory and the old buffer is not changed
+ */
+void *taosSlabRealloc(int8_t module, void *ptr, int32_t size);
+
+void  taosSlabFree(void *ptr);
+
+void        taosSlabGetStatis(SSlabStatis *pStatis);
+const char *taosSlabModuleName(int8_t module);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSLAB_H
@@ -164,6 +164,41 @@ static void doAddToHashTable(SHashObj *pHashObj, SHashNode *pNode);
  */
 static SHashNode *getNextHashNode(SHashMutableIterator *pIter);
 
+#define HASH_ENTRY_DELETED ((SHashNode *)1)  // the slot of a removed entry, probing goes on through it
+#define HASH_MIGRATE_SLOTS 32                // slots of the old table moved by each write during the resize of a shard
+
+typedef struct SHashEntry {
+  uint32_t   hashVal;
+  uint32_t   keyLen;
+  SHashNode *pNode;  // NULL if the slot is empty, HASH_ENTRY_DELETED if the entry is removed
+  char       key[HASH_INLINE_KEY_BYTES];
+} SHashEntry;
+
+typedef struct SHashTable {
+  SHashEntry *entries;
+  uint32_t    capacity;
+  uint32_t    used;  // number of the slots which are not empty, including the removed ones
+} SHashTable;
+
+typedef struct SHashShard {
+#if defined(LINUX)
+  pthread_rwlock_t lock;
+#else
+  pthread_mutex_t  lock;
+#endif
+  SHashTable table;
+  SHashTable old;       // the table being moved to table during a resize, its entries are NULL if there is no resize
+  uint32_t   migrated;  // the slots of old before it are moved
+  int32_t    size;
+} SHashShard;
+
+static int32_t    taosHashPutConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen, void *data, size_t size);
+static void *     taosHashGetConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen);
+static void       taosHashRemoveConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen);
+static void       taosHashCleanupConcurrent(SHashObj *pHashObj);
+static bool       taosHashIterNextConcurrent(SHashMutableIterator *pIter);
+static int32_t    taosHashGetMaxProbeLength(const SHashObj *pHashObj);
+
 SHashObj *taosHashInit(size_t capacity, _hash_fn_t fn, bool threadsafe) {
   if (capacity == 0 || fn == NULL) {
     return NULL;
@@ -212,10 +247,14 @@ size_t taosHashGetSize(const SHashObj *pHashObj) {
     return 0;
   }
 
-  return pHashObj->size;
+  return (pHashObj->shards != NULL) ? atomic_load_64(&pHashObj->size) : pHashObj->size;
 }
 
 int32_t taosHashPut(SHashObj *pHashObj, const void *key, size_t keyLen, void *data, size_t size) {
+  if (pHashObj->shards != NULL) {
+    return taosHashPutConcurrent(pHashObj, key, keyLen, data, size);
+  }
+
   __wr_lock(pHashObj->lock);
 
   uint32_t   hashVal = 0;
@@ -258,6 +297,10 @@ int32_t taosHashPut(SHashObj *pHashObj, const void *key, size_t keyLen, void *da
 }
 
 void *taosHashGet(SHashObj *pHashObj, const void *key, size_t keyLen) {
+  if (pHashObj->shards != NULL) {
+    return taosHashGetConcurrent(pHashObj, key, keyLen);
+  }
+
   __rd_lock(pHashObj->lock);
 
   uint32_t   hashVal = 0;
@@ -275,6 +318,11 @@ void *taosHashGet(SHashObj *pHashObj, const void *key, size_t keyLen) {
 }
 
 void taosHashRemove(SHashObj *pHashObj, const void *key, size_t keyLen) {
+  if (pHashObj->shards != NULL) {
+    taosHashRemoveConcurrent(pHashObj, key, keyLen);
+    return;
+  }
+
   __wr_lock(pHashObj->lock);
 
   uint32_t   val = 0;
@@ -310,6 +358,11 @@ void taosHashRemove(SHashObj *pHashObj, const void *key, size_t keyLen) {
 void taosHashCleanup(SHashObj *pHashObj) {
   if (pHashObj == NULL) return;
 
+  if (pHashObj->shards != NULL) {
+    taosHashCleanupConcurrent(pHashObj);
+    return;
+  }
+
   SHashNode *pNode, *pNext;
 
   __wr_lock(pHashObj->lock);
@@ -363,6 +416,10 @@ bool taosHashIterNext(SHashMutableIterator *pIter) {
     return false;
   }
 
+  if (pIter->pHashObj->shards != NULL) {
+    return taosHashIterNextConcurrent(pIter);
+  }
+
   size_t size = taosHashGetSize(pIter->pHashObj);
   if (size == 0) {
     return false;
@@ -419,6 +476,7 @@ void *taosHashDestroyIter(SHashMutableIterator *iter) {
     return NULL;
   }
 
+  taosTFree(iter->pNodes);
   free(iter);
   return NULL;
 }
@@ -429,6 +487,10 @@ int32_t taosHashGetMaxOverflowLinkLength(const SHashObj *pHashObj) {
     return 0;
   }
 
+  if (pHashObj->shards != NULL) {
+    return taosHashGetMaxProbeLength(pHashObj);
+  }
+
   int32_t num = 0;
 
   for (int32_t i = 0; i < pHashObj->size; ++i) {
@@ -595,3 +657,305 @@ SHashNode *getNextHashNode(SHashMutableIterator *pIter) {
   
   return NULL;
 }
+
+// ---------------- concurrent hash table ----------------
+static FORCE_INLINE SHashShard *taosHashGetShard(SHashObj *pHashObj, uint32_t hashVal) {
+  // the mixed hash value selects the shard, the low bits of the raw one select the slot
+  return pHashObj->shards + taosHashShardIndex(hashVal, pHashObj->numOfShards);
+}
+
+static int32_t taosHashInitTable(SHashTable *pTable, uint32_t capacity) {
+  pTable->entries = (SHashEntry *)calloc(capacity, sizeof(SHashEntry));
+  if (pTable->entries == NULL) {
+    uError("failed to allocate memory, reason:%s", strerror(errno));
+    return -1;
+  }
+
+  pTable->capacity = capacity;
+  pTable->used = 0;
+  return 0;
+}
+
+static SHashEntry *taosHashFindEntry(SHashTable *pTable, const void *key, uint32_t keyLen, uint32_t hashVal) {
+  if (pTable->entries == NULL) return NULL;
+
+  uint32_t prefixLen = MIN(keyLen, HASH_INLINE_KEY_BYTES);
+  uint32_t slot = HASH_INDEX(hashVal, pTable->capacity);
+
+  for (uint32_t i = 0; i < pTable->capacity; ++i) {
+    SHashEntry *pEntry = pTable->entries + slot;
+    if (pEntry->pNode == NULL) break;
+
+    // the node is touched only if the hash value and the leading bytes of the key are matched
+    if (pEntry->pNode != HASH_ENTRY_DELETED && pEntry->hashVal == hashVal && pEntry->keyLen == keyLen &&
+        memcmp(pEntry->key, key, prefixLen) == 0 &&
+        (keyLen <= HASH_INLINE_KEY_BYTES || memcmp(pEntry->pNode->key, key, keyLen) == 0)) {
+      return pEntry;
+    }
+
+    slot = HASH_INDEX(slot + 1, pTable->capacity);
+  }
+
+  return NULL;
+}
+
+static void taosHashInsertEntry(SHashTable *pTable, SHashNode *pNode) {
+  uint32_t slot = HASH_INDEX(pNode->hashVal, pTable->capacity);
+
+  while (pTable->entries[slot].pNode != NULL && pTable->entries[slot].pNode != HASH_ENTRY_DELETED) {
+    slot = HASH_INDEX(slot + 1, pTable->capacity);
+  }
+
+  SHashEntry *pEntry = pTable->entries + slot;
+  if (pEntry->pNode == NULL) pTable->used++;
+
+  pEntry->hashVal = pNode->hashVal;
+  pEntry->keyLen = pNode->keyLen;
+  pEntry->pNode = pNode;
+  memcpy(pEntry->key, pNode->key, MIN(pNode->keyLen, HASH_INLINE_KEY_BYTES));
+}
+
+// move some slots of the old table to the new one, the resize is spread over the writes of the shard
+static void taosHashMigrateShard(SHashShard *pShard) {
+  if (pShard->old.entries == NULL) return;
+
+  for (int32_t i = 0; i < HASH_MIGRATE_SLOTS && pShard->migrated < pShard->old.capacity; ++i) {
+    SHashEntry *pEntry = pShard->old.entries + pShard->migrated++;
+    if (pEntry->pNode != NULL && pEntry->pNode != HASH_ENTRY_DELETED) {
+      taosHashInsertEntry(&pShard->table, pEntry->pNode);
+      pEntry->pNode = HASH_ENTRY_DELETED;
+    }
+  }
+
+  if (pShard->migrated == pShard->old.capacity) {
+    taosTFree(pShard->old.entries);
+    memset(&pShard->old, 0, sizeof(SHashTable));
+    pShard->migrated = 0;
+  }
+}
+
+static void taosHashResizeShard(SHashShard *pShard) {
+  SHashTable *pTable = &pShard->table;
+  if (pShard->old.entries != NULL || pTable->used + 1 <= pTable->capacity * HASH_DEFAULT_LOAD_FACTOR) return;
+
+  // the table is rebuilt in the same capacity if most of the used slots are removed ones
+  uint32_t capacity = pTable->capacity;
+  if (pShard->size >= capacity * HASH_DEFAULT_LOAD_FACTOR / 2 && capacity < HASH_MAX_CAPACITY) capacity <<= 1u;
+
+  SHashTable table = {0};
+  if (taosHashInitTable(&table, capacity) != 0) return;
+
+  pShard->old = *pTable;
+  pShard->migrated = 0;
+  *pTable = table;
+}
+
+SHashObj *taosHashInitConcurrent(size_t capacity, _hash_fn_t fn) {
+  if (capacity == 0 || fn == NULL) {
+    return NULL;
+  }
+
+  SHashObj *pHashObj = (SHashObj *)calloc(1, sizeof(SHashObj));
+  if (pHashObj == NULL) {
+    uError("failed to allocate memory, reason:%s", strerror(errno));
+    return NULL;
+  }
+
+  pHashObj->hashFp = fn;
+  pHashObj->numOfShards = HASH_CONCURRENT_SHARDS;
+  pHashObj->capacity = taosHashCapacity((int32_t)(capacity / HASH_CONCURRENT_SHARDS / HASH_DEFAULT_LOAD_FACTOR) + 1);
+
+  pHashObj->shards = (SHashShard *)calloc(pHashObj->numOfShards, sizeof(SHashShard));
+  if (pHashObj->shards == NULL) {
+    free(pHashObj);
+    uError("failed to allocate memory, reason:%s", strerror(errno));
+    return NULL;
+  }
+
+  for (int32_t i = 0; i < pHashObj->numOfShards; ++i) {
+    SHashShard *pShard = pHashObj->shards + i;
+    if (__lock_init(&pShard->lock) != 0 || taosHashInitTable(&pShard->table, (uint32_t)pHashObj->capacity) != 0) {
+      uError("failed to init hash shard, reason:%s", strerror(errno));
+      taosHashCleanupConcurrent(pHashObj);
+      return NULL;
+    }
+  }
+
+  return pHashObj;
+}
+
+static int32_t taosHashPutConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen, void *data, size_t size) {
+  uint32_t    hashVal = (*pHashObj->hashFp)(key, (uint32_t)keyLen);
+  SHashShard *pShard = taosHashGetShard(pHashObj, hashVal);
+
+  __wr_lock(&pShard->lock);
+
+  taosHashMigrateShard(pShard);
+
+  SHashEntry *pEntry = taosHashFindEntry(&pShard->table, key, (uint32_t)keyLen, hashVal);
+  if (pEntry == NULL) pEntry = taosHashFindEntry(&pShard->old, key, (uint32_t)keyLen, hashVal);
+
+  if (pEntry != NULL) {
+    SHashNode *pNewNode = doUpdateHashNode(pEntry->pNode, key, keyLen, data, size);
+    if (pNewNode == NULL) {
+      __unlock(&pShard->lock);
+      return -1;
+    }
+
+    pEntry->pNode = pNewNode;
+  } else {
+    SHashNode *pNewNode = doCreateHashNode(key, keyLen, data, size, hashVal);
+    if (pNewNode == NULL) {
+      __unlock(&pShard->lock);
+      return -1;
+    }
+
+    taosHashResizeShard(pShard);
+    taosHashInsertEntry(&pShard->table, pNewNode);
+    pShard->size++;
+    atomic_add_fetch_64(&pHashObj->size, 1);
+  }
+
+  __unlock(&pShard->lock);
+  return 0;
+}
+
+static void *taosHashGetConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen) {
+  uint32_t    hashVal = (*pHashObj->hashFp)(key, (uint32_t)keyLen);
+  SHashShard *pShard = taosHashGetShard(pHashObj, hashVal);
+  void *      data = NULL;
+
+  __rd_lock(&pShard->lock);
+
+  SHashEntry *pEntry = taosHashFindEntry(&pShard->table, key, (uint32_t)keyLen, hashVal);
+  if (pEntry == NULL) pEntry = taosHashFindEntry(&pShard->old, key, (uint32_t)keyLen, hashVal);
+  if (pEntry != NULL) data = pEntry->pNode->data;
+
+  __unlock(&pShard->lock);
+  return data;
+}
+
+static void taosHashRemoveConcurrent(SHashObj *pHashObj, const void *key, size_t keyLen) {
+  uint32_t    hashVal = (*pHashObj->hashFp)(key, (uint32_t)keyLen);
+  SHashShard *pShard = taosHashGetShard(pHashObj, hashVal);
+
+  __wr_lock(&pShard->lock);
+
+  taosHashMigrateShard(pShard);
+
+  SHashEntry *pEntry = taosHashFindEntry(&pShard->table, key, (uint32_t)keyLen, hashVal);
+  if (pEntry == NULL) pEntry = taosHashFindEntry(&pShard->old, key, (uint32_t)keyLen, hashVal);
+
+  if (pEntry != NULL) {
+    taosTFree(pEntry->pNode);
+    pEntry->pNode = HASH_ENTRY_DELETED;
+    pShard->size--;
+    atomic_sub_fetch_64(&pHashObj->size, 1);
+  }
+
+  __unlock(&pShard->lock);
+}
+
+static void taosHashFreeTable(SHashObj *pHashObj, SHashTable *pTable) {
+  if (pTable->entries == NULL) return;
+
+  for (uint32_t i = 0; i < pTable->capacity; ++i) {
+    SHashNode *pNode = pTable->entries[i].pNode;
+    if (pNode == NULL || pNode == HASH_ENTRY_DELETED) continue;
+
+    if (pHashObj->freeFp) {
+      pHashObj->freeFp(pNode->data);
+    }
+
+    free(pNode);
+  }
+
+  taosTFree(pTable->entries);
+}
+
+static void taosHashCleanupConcurrent(SHashObj *pHashObj) {
+  for (int32_t i = 0; i < pHashObj->numOfShards; ++i) {
+    SHashShard *pShard = pHashObj->shards + i;
+
+    __wr_lock(&pShard->lock);
+    taosHashFreeTable(pHashObj, &pShard->table);
+    taosHashFreeTable(pHashObj, &pShard->old);
+    __unlock(&pShard->lock);
+    __lock_destroy(&pShard->lock);
+  }
+
+  taosTFree(pHashObj->shards);
+  free(pHashObj);
+}
+
+static int32_t taosHashCopyNodes(SHashTable *pTable, SHashMutableIterator *pIter, int32_t capacity) {
+  if (pTable->entries == NULL) return 0;
+
+  for (uint32_t i = 0; i < pTable->capacity; ++i) {
+    SHashNode *pNode = pTable->entries[i].pNode;
+    if (pNode == NULL || pNode == HASH_ENTRY_DELETED) continue;
+
+    if (pIter->numOfNodes >= capacity) {
+      capacity = MAX(capacity * 2, 16);
+      SHashNode **pNodes = (SHashNode **)realloc(pIter->pNodes, capacity * POINTER_BYTES);
+      if (pNodes == NULL) return -1;
+      pIter->pNodes = pNodes;
+    }
+
+    pIter->pNodes[pIter->numOfNodes++] = pNode;
+  }
+
+  return capacity;
+}
+
+static bool taosHashIterNextConcurrent(SHashMutableIterator *pIter) {
+  SHashObj *pHashObj = pIter->pHashObj;
+  int32_t   capacity = pIter->numOfNodes;
+
+  while (pIter->nodeIndex >= pIter->numOfNodes) {
+    if (pIter->shardIndex >= pHashObj->numOfShards) {
+      pIter->pCur = NULL;
+      return false;
+    }
+
+    SHashShard *pShard = pHashObj->shards + pIter->shardIndex++;
+    pIter->numOfNodes = 0;
+    pIter->nodeIndex = 0;
+
+    __rd_lock(&pShard->lock);
+    capacity = taosHashCopyNodes(&pShard->table, pIter, capacity);
+    if (capacity >= 0) capacity = taosHashCopyNodes(&pShard->old, pIter, capacity);
+    __unlock(&pShard->lock);
+
+    if (capacity < 0) {
+      uError("failed to allocate memory for hash iterator, reason:%s", strerror(errno));
+      pIter->pCur = NULL;
+      return false;
+    }
+  }
+
+  pIter->pCur = pIter->pNodes[pIter->nodeIndex++];
+  pIter->num++;
+  return true;
+}
+
+// for profile only, the longest distance from the home slot of an entry of a concurrent hash table
+static int32_t taosHashGetMaxProbeLength(const SHashObj *pHashObj) {
+  int32_t num = 0;
+
+  for (int32_t i = 0; i < pHashObj->numOfShards; ++i) {
+    SHashShard *pShard = pHashObj->shards + i;
+
+    __rd_lock(&pShard->lock);
+    for (uint32_t j = 0; j < pShard->table.capacity; ++j) {
+      SHashEntry *pEntry = pShard->table.entries + j;
+      if (pEntry->pNode == NULL || pEntry->pNode == HASH_ENTRY_DELETED) continue;
+
+      int32_t len = (int32_t)HASH_INDEX(j - pEntry->hashVal, pShard->table.capacity) + 1;
+      if (num < len) num = len;
+    }
+    __unlock(&pShard->lock);
+  }
+
+  return num;
+}
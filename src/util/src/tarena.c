@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tarena.h"
+
+#define ARENA_ALIGN(s) (((s) + 7) & ~((size_t)7))
+
+SArena *taosArenaInit(size_t chunkSize) {
+  chunkSize = ARENA_ALIGN(MAX(chunkSize, 64));
+
+  // the arena and its first chunk are allocated together, so a small arena takes one allocation only
+  size_t  headSize = ARENA_ALIGN(sizeof(SArena));
+  SArena *pArena = (SArena *)malloc(headSize + sizeof(SArenaChunk) + chunkSize);
+  if (pArena == NULL) return NULL;
+
+  SArenaChunk *pChunk = (SArenaChunk *)((char *)pArena + headSize);
+  pChunk->next = NULL;
+  pChunk->size = chunkSize;
+  pChunk->used = 0;
+
+  pArena->pChunk = pChunk;
+  pArena->chunkSize = chunkSize;
+  pArena->allocBytes = 0;
+  pArena->totalBytes = chunkSize;
+
+  return pArena;
+}
+
+static FORCE_INLINE bool taosIsFirstArenaChunk(SArena *pArena, SArenaChunk *pChunk) {
+  return (char *)pChunk == (char *)pArena + ARENA_ALIGN(sizeof(SArena));
+}
+
+void *taosArenaMalloc(SArena *pArena, size_t size) {
+  SArenaChunk *pChunk = pArena->pChunk;
+
+  size = ARENA_ALIGN(size);
+  if (pChunk->used + size <= pChunk->size) {
+    void *p = pChunk->data + pChunk->used;
+    pChunk->used += size;
+    pArena->allocBytes += size;
+    return p;
+  }
+
+  size_t       chunkSize = (size > pArena->chunkSize / 2) ? size : pArena->chunkSize;
+  SArenaChunk *pNew = (SArenaChunk *)malloc(sizeof(SArenaChunk) + chunkSize);
+  if (pNew == NULL) return NULL;
+
+  pNew->size = chunkSize;
+  pNew->used = size;
+
+  // a large buffer takes a chunk of its own, the space left in the current chunk is still used by the small ones
+  if (chunkSize == size) {
+    pNew->next = pChunk->next;
+    pChunk->next = pNew;
+  } else {
+    pNew->next = pChunk;
+    pArena->pChunk = pNew;
+  }
+
+  pArena->allocBytes += size;
+  pArena->totalBytes += chunkSize;
+  return pNew->data;
+}
+
+void *taosArenaCalloc(SArena *pArena, size_t num, size_t size) {
+  void *p = taosArenaMalloc(pArena, num * size);
+  if (p != NULL) memset(p, 0, num * size);
+  return p;
+}
+
+void taosArenaReset(SArena *pArena) {
+  SArenaChunk *pChunk = pArena->pChunk;
+  SArenaChunk *pFirst = NULL;
+
+  while (pChunk != NULL) {
+    SArenaChunk *pNext = pChunk->next;
+    if (taosIsFirstArenaChunk(pArena, pChunk)) {
+      pFirst = pChunk;
+    } else {
+      free(pChunk);
+    }
+    pChunk = pNext;
+  }
+
+  pFirst->next = NULL;
+  pFirst->used = 0;
+
+  pArena->pChunk = pFirst;
+  pArena->allocBytes = 0;
+  pArena->totalBytes = pFirst->size;
+}
+
+void taosArenaDestroy(SArena *pArena) {
+  if (pArena == NULL) return;
+
+  taosArenaReset(pArena);
+  free(pArena);
+}
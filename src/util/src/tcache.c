@@ -62,6 +62,60 @@ static FORCE_INLINE void __cache_lock_destroy(SCacheObj *pCacheObj) {
 #endif
 }
 
+#define CACHE_NUM_OF_SHARDS 16
+
+typedef struct SCacheShard {
+  SHashObj       *pHashTable;
+  SCacheDataNode *pHand;      // the clock hand, the elements of the shard are linked in a ring by prev/next
+  int64_t         totalSize;
+  int64_t         maxSize;
+#if defined(LINUX)
+  pthread_rwlock_t lock;
+#else
+  pthread_mutex_t  lock;
+#endif
+} SCacheShard;
+
+static FORCE_INLINE void __shard_wr_lock(SCacheShard *pShard) {
+#if defined(LINUX)
+  pthread_rwlock_wrlock(&pShard->lock);
+#else
+  pthread_mutex_lock(&pShard->lock);
+#endif
+}
+
+static FORCE_INLINE void __shard_rd_lock(SCacheShard *pShard) {
+#if defined(LINUX)
+  pthread_rwlock_rdlock(&pShard->lock);
+#else
+  pthread_mutex_lock(&pShard->lock);
+#endif
+}
+
+static FORCE_INLINE void __shard_unlock(SCacheShard *pShard) {
+#if defined(LINUX)
+  pthread_rwlock_unlock(&pShard->lock);
+#else
+  pthread_mutex_unlock(&pShard->lock);
+#endif
+}
+
+static FORCE_INLINE int32_t __shard_lock_init(SCacheShard *pShard) {
+#if defined(LINUX)
+  return pthread_rwlock_init(&pShard->lock, NULL);
+#else
+  return pthread_mutex_init(&pShard->lock, NULL);
+#endif
+}
+
+static FORCE_INLINE void __shard_lock_destroy(SCacheShard *pShard) {
+#if defined(LINUX)
+  pthread_rwlock_destroy(&pShard->lock);
+#else
+  pthread_mutex_destroy(&pShard->lock);
+#endif
+}
+
 #if 0
 static FORCE_INLINE void taosFreeNode(void *data) {
   SCacheDataNode *pNode = *(SCacheDataNode **)data;
@@ -226,7 +280,292 @@ static void doCleanupDataCache(SCacheObj *pCacheObj);
  */
 static void* taosCacheTimedRefresh(void *handle);
 
-SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan, __cache_free_fn_t fn, const char* cacheName) {
+// ---------------- sharded cache ----------------
+static FORCE_INLINE SCacheShard *taosCacheGetShard(SCacheObj *pCacheObj, const void *key, size_t keyLen) {
+  // the mixed hash value selects the shard, the hash table of the shard hashes the key by itself
+  uint32_t hashVal = (*pCacheObj->hashFp)(key, (uint32_t)keyLen);
+  return pCacheObj->pShards + taosHashShardIndex(hashVal, pCacheObj->numOfShards);
+}
+
+static void taosCacheFreeNode(SCacheObj *pCacheObj, SCacheDataNode *pNode) {
+  pNode->signature = 0;
+  if (pCacheObj->freeFp) pCacheObj->freeFp(pNode->data);
+  free(pNode);
+}
+
+static void taosCacheFreeNodeList(SCacheObj *pCacheObj, SCacheDataNode *pList) {
+  while (pList != NULL) {
+    SCacheDataNode *pNext = pList->next;
+    taosCacheFreeNode(pCacheObj, pList);
+    pList = pNext;
+  }
+}
+
+/**
+ * the new element is put right behind the clock hand, so it is the last one to be visited
+ */
+static void taosShardLinkNode(SCacheShard *pShard, SCacheDataNode *pNode) {
+  if (pShard->pHand == NULL) {
+    pNode->prev = pNode;
+    pNode->next = pNode;
+    pShard->pHand = pNode;
+  } else {
+    pNode->next = pShard->pHand;
+    pNode->prev = pShard->pHand->prev;
+    pNode->prev->next = pNode;
+    pShard->pHand->prev = pNode;
+  }
+
+  pShard->totalSize += pNode->size;
+}
+
+static void taosShardUnlinkNode(SCacheShard *pShard, SCacheDataNode *pNode) {
+  if (pNode->next == pNode) {
+    pShard->pHand = NULL;
+  } else {
+    pNode->prev->next = pNode->next;
+    pNode->next->prev = pNode->prev;
+    if (pShard->pHand == pNode) {
+      pShard->pHand = pNode->next;
+    }
+  }
+
+  pNode->prev = NULL;
+  pNode->next = NULL;
+  pShard->totalSize -= pNode->size;
+  taosHashRemove(pShard->pHashTable, pNode->key, pNode->keySize);
+}
+
+/**
+ * unlink the element from the shard, it is moved into trash if it is still referenced, otherwise it is put into
+ * the list to free after the shard is unlocked
+ */
+static void taosShardRemoveNode(SCacheObj *pCacheObj, SCacheShard *pShard, SCacheDataNode *pNode,
+                                SCacheDataNode **pList) {
+  taosShardUnlinkNode(pShard, pNode);
+
+  if (T_REF_VAL_GET(pNode) > 0) {
+    __cache_wr_lock(pCacheObj);
+    taosAddToTrash(pCacheObj, pNode);
+    __cache_unlock(pCacheObj);
+  } else {
+    pNode->next = *pList;
+    *pList = pNode;
+  }
+}
+
+/**
+ * evict elements by CLOCK until the size of the shard is under its limit. The referenced elements are skipped, the
+ * element acquired since the last visit of the hand loses its second chance. Each element is visited at most twice,
+ * so the loop ends even if all elements are referenced.
+ */
+static SCacheDataNode *taosShardEvict(SCacheObj *pCacheObj, SCacheShard *pShard) {
+  SCacheDataNode *pList = NULL;
+  if (pShard->maxSize <= 0) {
+    return NULL;
+  }
+
+  size_t steps = taosHashGetSize(pShard->pHashTable) * 2;
+  while (pShard->totalSize > pShard->maxSize && pShard->pHand != NULL && steps-- > 0) {
+    SCacheDataNode *pNode = pShard->pHand;
+
+    if (T_REF_VAL_GET(pNode) > 0) {
+      pShard->pHand = pNode->next;
+      continue;
+    }
+
+    if (atomic_load_8(&pNode->visited) != 0) {
+      atomic_store_8(&pNode->visited, 0);
+      pShard->pHand = pNode->next;
+      continue;
+    }
+
+    taosShardUnlinkNode(pShard, pNode);
+    pNode->next = pList;
+    pList = pNode;
+
+    atomic_add_fetch_64(&pCacheObj->statistics.evictCount, 1);
+  }
+
+  return pList;
+}
+
+static void *taosShardedCachePut(SCacheObj *pCacheObj, const void *key, size_t keyLen, const void *pData,
+                                 size_t dataSize, int duration) {
+  SCacheDataNode *pNode = taosCreateCacheNode(key, keyLen, pData, dataSize, duration * 1000L);
+  if (pNode == NULL) {
+    uError("cache:%s, key:%p, failed to added into cache, out of memory", pCacheObj->name, key);
+    return NULL;
+  }
+
+  SCacheShard *pShard = taosCacheGetShard(pCacheObj, key, keyLen);
+  pNode->shardIndex = (uint8_t)(pShard - pCacheObj->pShards);
+  T_REF_INC(pNode);
+
+  SCacheDataNode *pList = NULL;
+
+  __shard_wr_lock(pShard);
+
+  SCacheDataNode **pt = (SCacheDataNode **)taosHashGet(pShard->pHashTable, key, keyLen);
+  if (pt != NULL) {
+    taosShardRemoveNode(pCacheObj, pShard, *pt, &pList);
+  }
+
+  taosHashPut(pShard->pHashTable, key, keyLen, &pNode, sizeof(void *));
+  taosShardLinkNode(pShard, pNode);
+
+  SCacheDataNode *pEvicted = taosShardEvict(pCacheObj, pShard);
+
+  __shard_unlock(pShard);
+
+  uDebug("cache:%s, key:%p, %p added into shard:%d, replaced:%d evicted:%d size:%" PRId64 "bytes", pCacheObj->name, key,
+         pNode->data, pNode->shardIndex, pt != NULL, pEvicted != NULL, (int64_t)dataSize);
+
+  taosCacheFreeNodeList(pCacheObj, pList);
+  taosCacheFreeNodeList(pCacheObj, pEvicted);
+
+  return pNode->data;
+}
+
+/**
+ * a hit only takes the read lock of the shard, increases the reference count and sets the second chance bit,
+ * so the hits of different threads do not block each other
+ */
+static SCacheDataNode *taosShardedCacheAcquire(SCacheObj *pCacheObj, const void *key, size_t keyLen) {
+  SCacheShard *   pShard = taosCacheGetShard(pCacheObj, key, keyLen);
+  SCacheDataNode *pNode = NULL;
+
+  __shard_rd_lock(pShard);
+
+  SCacheDataNode **pt = (SCacheDataNode **)taosHashGet(pShard->pHashTable, key, keyLen);
+  if (pt != NULL) {
+    pNode = *pt;
+    T_REF_INC(pNode);
+    if (atomic_load_8(&pNode->visited) == 0) {
+      atomic_store_8(&pNode->visited, 1);
+    }
+  }
+
+  __shard_unlock(pShard);
+
+  atomic_add_fetch_64((pNode != NULL) ? &pCacheObj->statistics.hitCount : &pCacheObj->statistics.missCount, 1);
+  atomic_add_fetch_64(&pCacheObj->statistics.totalAccess, 1);
+
+  return pNode;
+}
+
+static void taosShardedCacheRelease(SCacheObj *pCacheObj, SCacheDataNode *pNode) {
+  SCacheShard *   pShard = pCacheObj->pShards + pNode->shardIndex;
+  SCacheDataNode *pList = NULL;
+  int32_t         ref = 0;
+
+  // an element is moved into trash with the lock of its shard held, and the trash is emptied with the cache lock held
+  __shard_wr_lock(pShard);
+
+  if (pNode->inTrashCan) {
+    __cache_wr_lock(pCacheObj);
+
+    // NOTE: once refcount is decrease, pNode may be freed by other thread immediately.
+    ref = T_REF_DEC(pNode);
+    uDebug("cache:%s, key:%p, %p is released, refcnt:%d", pCacheObj->name, pNode->key, pNode->data, ref);
+    if (ref == 0) {
+      taosRemoveFromTrashCan(pCacheObj, pNode->pTNodeHeader);
+    }
+
+    __cache_unlock(pCacheObj);
+  } else {
+    ref = T_REF_DEC(pNode);
+    uDebug("cache:%s, key:%p, %p is released, refcnt:%d", pCacheObj->name, pNode->key, pNode->data, ref);
+    taosShardRemoveNode(pCacheObj, pShard, pNode, &pList);
+  }
+
+  __shard_unlock(pShard);
+
+  taosCacheFreeNodeList(pCacheObj, pList);
+}
+
+static void doShardedCacheRefresh(SCacheObj *pCacheObj, int64_t time, __cache_free_fn_t fp, bool all) {
+  for (int32_t i = 0; i < pCacheObj->numOfShards; ++i) {
+    SCacheShard *   pShard = pCacheObj->pShards + i;
+    SCacheDataNode *pList = NULL;
+
+    __shard_wr_lock(pShard);
+
+    size_t          num = taosHashGetSize(pShard->pHashTable);
+    SCacheDataNode *pNode = pShard->pHand;
+    for (size_t j = 0; j < num; ++j) {
+      SCacheDataNode *pNext = pNode->next;
+
+      if (all || (pNode->expireTime < (uint64_t)time && T_REF_VAL_GET(pNode) <= 0)) {
+        taosShardRemoveNode(pCacheObj, pShard, pNode, &pList);
+      } else if (fp) {
+        fp(pNode->data);
+      }
+
+      pNode = pNext;
+    }
+
+    __shard_unlock(pShard);
+
+    taosCacheFreeNodeList(pCacheObj, pList);
+  }
+}
+
+static int32_t taosCacheInitShards(SCacheObj *pCacheObj, int64_t maxSize) {
+  pCacheObj->pShards = (SCacheShard *)calloc(CACHE_NUM_OF_SHARDS, sizeof(SCacheShard));
+  if (pCacheObj->pShards == NULL) {
+    return -1;
+  }
+
+  pCacheObj->numOfShards = CACHE_NUM_OF_SHARDS;
+  pCacheObj->maxSize = maxSize;
+
+  for (int32_t i = 0; i < pCacheObj->numOfShards; ++i) {
+    SCacheShard *pShard = pCacheObj->pShards + i;
+
+    pShard->maxSize = maxSize / pCacheObj->numOfShards;
+    pShard->pHashTable = taosHashInit(128, pCacheObj->hashFp, false);
+    if (pShard->pHashTable == NULL || __shard_lock_init(pShard) != 0) {
+      for (int32_t j = 0; j <= i; ++j) {
+        taosHashCleanup(pCacheObj->pShards[j].pHashTable);
+        if (j < i) __shard_lock_destroy(pCacheObj->pShards + j);
+      }
+
+      taosTFree(pCacheObj->pShards);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void taosCacheCleanupShards(SCacheObj *pCacheObj) {
+  for (int32_t i = 0; i < pCacheObj->numOfShards; ++i) {
+    SCacheShard *   pShard = pCacheObj->pShards + i;
+    SCacheDataNode *pNode = pShard->pHand;
+
+    // the elements still referenced are not freed, the same as the elements in the hash table of a plain cache
+    size_t num = taosHashGetSize(pShard->pHashTable);
+    for (size_t j = 0; j < num; ++j) {
+      SCacheDataNode *pNext = pNode->next;
+      if (T_REF_VAL_GET(pNode) <= 0) {
+        taosCacheFreeNode(pCacheObj, pNode);
+      } else {
+        uDebug("cache:%s key:%p, %p will not remove from cache, refcnt:%d", pCacheObj->name, pNode->key,
+               pNode->data, T_REF_VAL_GET(pNode));
+      }
+      pNode = pNext;
+    }
+
+    taosHashCleanup(pShard->pHashTable);
+    __shard_lock_destroy(pShard);
+  }
+
+  taosTFree(pCacheObj->pShards);
+}
+
+static SCacheObj *taosCacheInitImpl(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan,
+                                     __cache_free_fn_t fn, const char *cacheName, bool sharded, int64_t maxSize) {
   if (refreshTimeInSeconds <= 0) {
     return NULL;
   }
@@ -237,13 +576,23 @@ SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool ext
     return NULL;
   }
   
-  pCacheObj->pHashTable = taosHashInit(128, taosGetDefaultHashFunction(keyType), false);
-  pCacheObj->name = strdup(cacheName);
-  if (pCacheObj->pHashTable == NULL) {
-    free(pCacheObj);
-    uError("failed to allocate memory, reason:%s", strerror(errno));
-    return NULL;
+  pCacheObj->hashFp = taosGetDefaultHashFunction(keyType);
+  if (sharded) {
+    if (taosCacheInitShards(pCacheObj, maxSize) != 0) {
+      free(pCacheObj);
+      uError("failed to allocate memory, reason:%s", strerror(errno));
+      return NULL;
+    }
+  } else {
+    pCacheObj->pHashTable = taosHashInit(128, pCacheObj->hashFp, false);
+    if (pCacheObj->pHashTable == NULL) {
+      free(pCacheObj);
+      uError("failed to allocate memory, reason:%s", strerror(errno));
+      return NULL;
+    }
   }
+
+  pCacheObj->name = strdup(cacheName);
   
   // set free cache node callback function for hash table
   pCacheObj->freeFp = fn;
@@ -251,7 +600,12 @@ SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool ext
   pCacheObj->extendLifespan = extendLifespan;
 
   if (__cache_lock_init(pCacheObj) != 0) {
-    taosHashCleanup(pCacheObj->pHashTable);
+    if (sharded) {
+      taosCacheCleanupShards(pCacheObj);
+    } else {
+      taosHashCleanup(pCacheObj->pHashTable);
+    }
+    taosTFree(pCacheObj->name);
     free(pCacheObj);
     
     uError("failed to init lock, reason:%s", strerror(errno));
@@ -268,10 +622,27 @@ SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool ext
   return pCacheObj;
 }
 
+SCacheObj *taosCacheInit(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan, __cache_free_fn_t fn, const char* cacheName) {
+  return taosCacheInitImpl(keyType, refreshTimeInSeconds, extendLifespan, fn, cacheName, false, 0);
+}
+
+SCacheObj *taosCacheInitSharded(int32_t keyType, int64_t refreshTimeInSeconds, bool extendLifespan,
+                                __cache_free_fn_t fn, const char *cacheName, int64_t maxSize) {
+  return taosCacheInitImpl(keyType, refreshTimeInSeconds, extendLifespan, fn, cacheName, true, MAX(maxSize, 0));
+}
+
 void *taosCachePut(SCacheObj *pCacheObj, const void *key, size_t keyLen, const void *pData, size_t dataSize, int duration) {
   SCacheDataNode *pNode;
   
-  if (pCacheObj == NULL || pCacheObj->pHashTable == NULL) {
+  if (pCacheObj == NULL) {
+    return NULL;
+  }
+
+  if (pCacheObj->pShards != NULL) {
+    return taosShardedCachePut(pCacheObj, key, keyLen, pData, dataSize, duration);
+  }
+
+  if (pCacheObj->pHashTable == NULL) {
     return NULL;
   }
 
@@ -302,6 +673,11 @@ void *taosCachePut(SCacheObj *pCacheObj, const void *key, size_t keyLen, const v
 }
 
 void *taosCacheAcquireByKey(SCacheObj *pCacheObj, const void *key, size_t keyLen) {
+  if (pCacheObj != NULL && pCacheObj->pShards != NULL) {
+    SCacheDataNode *pNode = taosShardedCacheAcquire(pCacheObj, key, keyLen);
+    return (pNode != NULL) ? pNode->data : NULL;
+  }
+
   if (pCacheObj == NULL || taosHashGetSize(pCacheObj->pHashTable) == 0) {
     return NULL;
   }
@@ -333,6 +709,14 @@ void *taosCacheAcquireByKey(SCacheObj *pCacheObj, const void *key, size_t keyLen
 }
 
 void* taosCacheUpdateExpireTimeByName(SCacheObj *pCacheObj, void *key, size_t keyLen, uint64_t expireTime) {
+  if (pCacheObj != NULL && pCacheObj->pShards != NULL) {
+    SCacheDataNode *pNode = taosShardedCacheAcquire(pCacheObj, key, keyLen);
+    if (pNode != NULL) {
+      atomic_store_64(&pNode->expireTime, expireTime);
+    }
+    return (pNode != NULL) ? pNode->data : NULL;
+  }
+
   if (pCacheObj == NULL || taosHashGetSize(pCacheObj->pHashTable) == 0) {
     return NULL;
   }
@@ -401,7 +785,7 @@ void *taosCacheTransfer(SCacheObj *pCacheObj, void **data) {
 }
 
 void taosCacheRelease(SCacheObj *pCacheObj, void **data, bool _remove) {
-  if (pCacheObj == NULL || (*data) == NULL || (taosHashGetSize(pCacheObj->pHashTable) + pCacheObj->numOfElemsInTrash == 0)) {
+  if (pCacheObj == NULL || (*data) == NULL || (taosCacheGetNumOfElems(pCacheObj) + pCacheObj->numOfElemsInTrash == 0)) {
     return;
   }
   
@@ -423,7 +807,9 @@ void taosCacheRelease(SCacheObj *pCacheObj, void **data, bool _remove) {
     uDebug("cache:%s data:%p extend life time to %"PRId64 "  before release", pCacheObj->name, pNode->data, pNode->expireTime);
   }
 
-  if (_remove) {
+  if (_remove && pCacheObj->pShards != NULL) {
+    taosShardedCacheRelease(pCacheObj, pNode);
+  } else if (_remove) {
     __cache_wr_lock(pCacheObj);
 
     // NOTE: once refcount is decrease, pNode may be freed by other thread immediately.
@@ -463,6 +849,12 @@ void taosCacheRelease(SCacheObj *pCacheObj, void **data, bool _remove) {
 }
 
 void taosCacheEmpty(SCacheObj *pCacheObj) {
+  if (pCacheObj->pShards != NULL) {
+    doShardedCacheRefresh(pCacheObj, 0, NULL, true);
+    taosTrashCanEmpty(pCacheObj, false);
+    return;
+  }
+
   SHashMutableIterator *pIter = taosHashCreateIter(pCacheObj->pHashTable);
   
   __cache_wr_lock(pCacheObj);
@@ -610,25 +1002,29 @@ void taosTrashCanEmpty(SCacheObj *pCacheObj, bool force) {
 }
 
 void doCleanupDataCache(SCacheObj *pCacheObj) {
-  __cache_wr_lock(pCacheObj);
+  if (pCacheObj->pShards != NULL) {
+    taosCacheCleanupShards(pCacheObj);
+  } else {
+    __cache_wr_lock(pCacheObj);
 
-  SHashMutableIterator *pIter = taosHashCreateIter(pCacheObj->pHashTable);
-  while (taosHashIterNext(pIter)) {
-    SCacheDataNode *pNode = *(SCacheDataNode **)taosHashIterGet(pIter);
+    SHashMutableIterator *pIter = taosHashCreateIter(pCacheObj->pHashTable);
+    while (taosHashIterNext(pIter)) {
+      SCacheDataNode *pNode = *(SCacheDataNode **)taosHashIterGet(pIter);
 
-    int32_t c = T_REF_VAL_GET(pNode);
-    if (c <= 0) {
-      taosCacheReleaseNode(pCacheObj, pNode);
-    } else {
-      uDebug("cache:%s key:%p, %p will not remove from cache, refcnt:%d", pCacheObj->name, pNode->key,
-          pNode->data, T_REF_VAL_GET(pNode));
+      int32_t c = T_REF_VAL_GET(pNode);
+      if (c <= 0) {
+        taosCacheReleaseNode(pCacheObj, pNode);
+      } else {
+        uDebug("cache:%s key:%p, %p will not remove from cache, refcnt:%d", pCacheObj->name, pNode->key,
+            pNode->data, T_REF_VAL_GET(pNode));
+      }
     }
-  }
-  taosHashDestroyIter(pIter);
+    taosHashDestroyIter(pIter);
 
-  // todo memory leak if there are object with refcount greater than 0 in hash table?
-  taosHashCleanup(pCacheObj->pHashTable);
-  __cache_unlock(pCacheObj);
+    // todo memory leak if there are object with refcount greater than 0 in hash table?
+    taosHashCleanup(pCacheObj->pHashTable);
+    __cache_unlock(pCacheObj);
+  }
 
   taosTrashCanEmpty(pCacheObj, true);
   __cache_lock_destroy(pCacheObj);
@@ -639,6 +1035,11 @@ void doCleanupDataCache(SCacheObj *pCacheObj) {
 }
 
 static void doCacheRefresh(SCacheObj* pCacheObj, int64_t time, __cache_free_fn_t fp) {
+  if (pCacheObj->pShards != NULL) {
+    doShardedCacheRefresh(pCacheObj, time, fp, false);
+    return;
+  }
+
   SHashMutableIterator *pIter = taosHashCreateIter(pCacheObj->pHashTable);
 
   __cache_wr_lock(pCacheObj);
@@ -686,7 +1087,7 @@ void* taosCacheTimedRefresh(void *handle) {
 
     // reset the count value
     count = 0;
-    size_t elemInHash = taosHashGetSize(pCacheObj->pHashTable);
+    size_t elemInHash = taosCacheGetNumOfElems(pCacheObj);
     if (elemInHash + pCacheObj->numOfElemsInTrash == 0) {
       continue;
     }
@@ -705,6 +1106,27 @@ void* taosCacheTimedRefresh(void *handle) {
   return NULL;
 }
 
+size_t taosCacheGetNumOfElems(SCacheObj *pCacheObj) {
+  if (pCacheObj->pShards == NULL) {
+    return taosHashGetSize(pCacheObj->pHashTable);
+  }
+
+  size_t num = 0;
+  for (int32_t i = 0; i < pCacheObj->numOfShards; ++i) {
+    num += taosHashGetSize(pCacheObj->pShards[i].pHashTable);
+  }
+
+  return num;
+}
+
+void taosCacheGetStatis(SCacheObj *pCacheObj, SCacheStatis *pStatis) {
+  pStatis->missCount = atomic_load_64(&pCacheObj->statistics.missCount);
+  pStatis->hitCount = atomic_load_64(&pCacheObj->statistics.hitCount);
+  pStatis->totalAccess = atomic_load_64(&pCacheObj->statistics.totalAccess);
+  pStatis->refreshCount = atomic_load_64(&pCacheObj->statistics.refreshCount);
+  pStatis->evictCount = atomic_load_64(&pCacheObj->statistics.evictCount);
+}
+
 void taosCacheRefresh(SCacheObj *pCacheObj, __cache_free_fn_t fp) {
   if (pCacheObj == NULL) {
     return;
@@ -17,6 +17,7 @@
 #include "os.h"
 #include "hash.h"
 #include "taoserror.h"
+#include "tarray.h"
 #include "tchecksum.h"
 #include "tcoding.h"
 #include "tkvstore.h"
@@ -28,7 +29,12 @@
 #define TD_KVSTORE_MAINOR_VERSION 0
 #define TD_KVSTORE_SNAP_SUFFIX ".snap"
 #define TD_KVSTORE_NEW_SUFFIX ".new"
+#define TD_KVSTORE_CKPT_SUFFIX ".ckpt"
+#define TD_KVSTORE_CKPT_TMP_SUFFIX ".t"
 #define TD_KVSTORE_INIT_MAGIC 0xFFFFFFFF
+#define TD_KVSTORE_CKPT_MIN_SIZE (1024 * 1024)  // bytes appended to the store since the last checkpoint
+#define TD_KVSTORE_CKPT_BUF_SIZE (1024 * 1024)
+#define TD_KVSTORE_CKSUM_STEP (1024 * 1024 * 1024)
 
 typedef struct {
   uint64_t uid;
@@ -42,12 +48,22 @@ static void *    tdDecodeStoreInfo(void *buf, SStoreInfo *pInfo);
 static SKVStore *tdNewKVStore(char *fname, iterFunc iFunc, afterFunc aFunc, void *appH);
 static char *    tdGetKVStoreSnapshotFname(char *fdata);
 static char *    tdGetKVStoreNewFname(char *fdata);
+static char *    tdGetKVStoreCkptFname(char *fdata);
 static void      tdFreeKVStore(SKVStore *pStore);
 static int       tdUpdateKVStoreHeader(int fd, char *fname, SStoreInfo *pInfo);
 static int       tdLoadKVStoreHeader(int fd, char *fname, SStoreInfo *pInfo, uint32_t *version);
 static int       tdEncodeKVRecord(void **buf, SKVRecord *pRecord);
 static void *    tdDecodeKVRecord(void *buf, SKVRecord *pRecord);
-static int       tdRestoreKVStore(SKVStore *pStore);
+static int       tdRestoreKVStore(SKVStore *pStore, int64_t storeSize);
+static int       tdScanKVStore(SKVStore *pStore, TSCKSUM *magic, SArray *pRecords);
+static char *    tdLoadKVStoreCkpt(SKVStore *pStore, int64_t storeSize, SStoreInfo *pInfo, int64_t *fsize);
+static int       tdWriteKVStoreCkpt(SKVStore *pStore);
+static int       tdEncodeCkptHeader(void **buf, SStoreInfo *pInfo, int64_t contSize, TSCKSUM cksum);
+static void *    tdDecodeCkptHeader(void *buf, SStoreInfo *pInfo, int64_t *contSize, TSCKSUM *cksum, uint32_t *version);
+static char *    tdMapKVStoreFile(int fd, char *fname, int64_t size);
+static void      tdUnmapKVStoreFile(char *ptr, int64_t size);
+static TSCKSUM   tdCalcKVStoreChecksum(TSCKSUM csi, char *data, int64_t size);
+static int       tdKVRecordOffsetCompar(const void *a, const void *b);
 
 int tdCreateKVStore(char *fname) {
   int fd = open(fname, O_RDWR | O_CREAT, 0755);
@@ -86,6 +102,12 @@ int tdDestroyKVStore(char *fname) {
     return -1;
   }
 
+  char *fckpt = tdGetKVStoreCkptFname(fname);
+  if (fckpt != NULL) {
+    (void)remove(fckpt);
+    free(fckpt);
+  }
+
   return 0;
 }
 
@@ -147,7 +169,7 @@ SKVStore *tdOpenKVStore(char *fname, iterFunc iFunc, afterFunc aFunc, void *appH
   pStore->info.size = TD_KVSTORE_HEADER_SIZE;
   pStore->info.magic = info.magic;
 
-  if (tdRestoreKVStore(pStore) < 0) goto _err;
+  if (tdRestoreKVStore(pStore, info.size) < 0) goto _err;
 
   close(pStore->fd);
   pStore->fd = -1;
@@ -319,6 +341,11 @@ int tdKVStoreEndCommit(SKVStore *pStore) {
     return -1;
   }
 
+  // the checkpoint only speeds up opening, the store is still fine if it fails to be written
+  if (pStore->info.size - pStore->ckptSize >= MAX(TD_KVSTORE_CKPT_MIN_SIZE, pStore->ckptSize / 4)) {
+    (void)tdWriteKVStoreCkpt(pStore);
+  }
+
   if (close(pStore->fd) < 0) {
     uError("failed to close file %s since %s", pStore->fname, strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -427,6 +454,10 @@ static SKVStore *tdNewKVStore(char *fname, iterFunc iFunc, afterFunc aFunc, void
   pStore->fnew = tdGetKVStoreNewFname(fname);
   if (pStore->fnew == NULL) goto _err;
 
+  pStore->fckpt = tdGetKVStoreCkptFname(fname);
+  if (pStore->fckpt == NULL) goto _err;
+  pStore->ckptSize = TD_KVSTORE_HEADER_SIZE;
+
   pStore->fd = -1;
   pStore->sfd = -1;
   pStore->nfd = -1;
@@ -451,6 +482,7 @@ static void tdFreeKVStore(SKVStore *pStore) {
     taosTFree(pStore->fname);
     taosTFree(pStore->fsnap);
     taosTFree(pStore->fnew);
+    taosTFree(pStore->fckpt);
     taosHashCleanup(pStore->map);
     free(pStore);
   }
@@ -478,6 +510,17 @@ static char *tdGetKVStoreNewFname(char *fdata) {
   return fname;
 }
 
+static char *tdGetKVStoreCkptFname(char *fdata) {
+  size_t size = strlen(fdata) + strlen(TD_KVSTORE_CKPT_SUFFIX) + 1;
+  char * fname = malloc(size);
+  if (fname == NULL) {
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return NULL;
+  }
+  sprintf(fname, "%s%s", fdata, TD_KVSTORE_CKPT_SUFFIX);
+  return fname;
+}
+
 static int tdEncodeKVRecord(void **buf, SKVRecord *pRecord) {
   int tlen = 0;
   tlen += taosEncodeFixedU64(buf, pRecord->uid);
@@ -495,16 +538,147 @@ static void *tdDecodeKVRecord(void *buf, SKVRecord *pRecord) {
   return buf;
 }
 
-static int tdRestoreKVStore(SKVStore *pStore) {
-  char                  tbuf[128] = "\0";
-  void *                buf = NULL;
-  int64_t               maxBufSize = 0;
-  SKVRecord             rInfo = {0};
-  SHashMutableIterator *pIter = NULL;
+static int tdRestoreKVStore(SKVStore *pStore, int64_t storeSize) {
+  SStoreInfo info = pStore->info;
+  SArray *   pRecords = NULL;
+  char *     pCkpt = NULL;
+  int64_t    ckptFSize = 0;
+  void *     buf = NULL;
+  int64_t    maxBufSize = 0;
 
   ASSERT(TD_KVSTORE_HEADER_SIZE == lseek(pStore->fd, 0, SEEK_CUR));
   ASSERT(pStore->info.size == TD_KVSTORE_HEADER_SIZE);
 
+  pRecords = taosArrayInit(1024, sizeof(SKVRecord));
+  if (pRecords == NULL) {
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  // The checkpoint holds the live records of the store file up to a size in a compact form. Only the records appended
+  // after that size are read from the store file. The running magic of the appended records must lead to the magic of
+  // the store file, otherwise the checkpoint does not belong to the store file and the whole file is scanned.
+  pCkpt = tdLoadKVStoreCkpt(pStore, storeSize, &pStore->info, &ckptFSize);
+  if (pCkpt != NULL) {
+    TSCKSUM magic = pStore->info.magic;
+    if (tdScanKVStore(pStore, &magic, pRecords) < 0 || magic != info.magic) {
+      uWarn("checkpoint %s does not match file %s, scan the whole file", pStore->fckpt, pStore->fname);
+      tdUnmapKVStoreFile(pCkpt, ckptFSize);
+      pCkpt = NULL;
+      (void)remove(pStore->fckpt);
+
+      taosHashCleanup(pStore->map);
+      pStore->map = taosHashInit(4096, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+      if (pStore->map == NULL) {
+        terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+        goto _err;
+      }
+      taosArrayClear(pRecords);
+      pStore->info = info;
+      if (lseek(pStore->fd, TD_KVSTORE_HEADER_SIZE, SEEK_SET) < 0) {
+        uError("failed to lseek file %s since %s", pStore->fname, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        goto _err;
+      }
+    }
+  }
+
+  if (pCkpt == NULL) {
+    pStore->ckptSize = TD_KVSTORE_HEADER_SIZE;
+    if (tdScanKVStore(pStore, NULL, pRecords) < 0) goto _err;
+  }
+  pStore->info.magic = info.magic;
+
+  // restore the records in the checkpoint, which are mapped and need no copy
+  if (pCkpt != NULL) {
+    char *pBuf = pCkpt + TD_KVSTORE_HEADER_SIZE;
+    while (pBuf < pCkpt + ckptFSize) {
+      SKVRecord rInfo = {0};
+      pBuf = tdDecodeKVRecord(pBuf, &rInfo);
+
+      SKVRecord *pRecord = taosHashGet(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid));
+      if (pRecord != NULL && pRecord->offset == rInfo.offset && pStore->iFunc) {
+        if ((*pStore->iFunc)(pStore->appH, pBuf, (int)rInfo.size) < 0) {
+          uError("failed to restore record uid %" PRIu64 " in kv store %s checkpoint since %s", rInfo.uid,
+                 pStore->fckpt, tstrerror(terrno));
+          goto _err;
+        }
+      }
+      pBuf = POINTER_SHIFT(pBuf, rInfo.size);
+    }
+
+    tdUnmapKVStoreFile(pCkpt, ckptFSize);
+    pCkpt = NULL;
+  }
+
+  // restore the records in the store file in the order of offset
+  for (size_t i = 0; i < taosArrayGetSize(pRecords); i++) {
+    maxBufSize = MAX(maxBufSize, ((SKVRecord *)taosArrayGet(pRecords, i))->size);
+  }
+
+  if (maxBufSize > 0) {
+    buf = malloc(maxBufSize);
+    if (buf == NULL) {
+      uError("failed to allocate %" PRId64 " bytes in KV store %s", maxBufSize, pStore->fname);
+      terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+      goto _err;
+    }
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pRecords); i++) {
+    SKVRecord *pRecord = taosArrayGet(pRecords, i);
+
+    // the record is updated or dropped later
+    SKVRecord *pLatest = taosHashGet(pStore->map, (void *)(&pRecord->uid), sizeof(pRecord->uid));
+    if (pLatest == NULL || pLatest->offset != pRecord->offset) continue;
+
+    if (lseek(pStore->fd, (off_t)(pRecord->offset + sizeof(SKVRecord)), SEEK_SET) < 0) {
+      uError("failed to lseek file %s since %s, offset %" PRId64, pStore->fname, strerror(errno), pRecord->offset);
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+
+    if (taosTRead(pStore->fd, buf, pRecord->size) < pRecord->size) {
+      uError("failed to read %" PRId64 " bytes from file %s since %s, offset %" PRId64, pRecord->size, pStore->fname,
+             strerror(errno), pRecord->offset);
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+
+    if (pStore->iFunc) {
+      if ((*pStore->iFunc)(pStore->appH, buf, (int)pRecord->size) < 0) {
+        uError("failed to restore record uid %" PRIu64 " in kv store %s at offset %" PRId64 " size %" PRId64
+               " since %s",
+               pRecord->uid, pStore->fname, pRecord->offset, pRecord->size, tstrerror(terrno));
+        goto _err;
+      }
+    }
+  }
+
+  uDebug("KV store %s is restored, %" PRId64 " records, %" PRId64 " bytes from checkpoint and %" PRId64
+         " bytes from file",
+         pStore->fname, pStore->info.nRecords, pStore->ckptSize, pStore->info.size - pStore->ckptSize);
+
+  if (pStore->aFunc) (*pStore->aFunc)(pStore->appH);
+
+  taosArrayDestroy(pRecords);
+  taosTFree(buf);
+  return 0;
+
+_err:
+  if (pCkpt != NULL) tdUnmapKVStoreFile(pCkpt, ckptFSize);
+  taosArrayDestroy(pRecords);
+  taosTFree(buf);
+  return -1;
+}
+
+// Scan the records of the store file from the current offset to the end. If magic is not NULL, the running magic is
+// calculated and a record which does not fit the file is reported as corruption.
+static int tdScanKVStore(SKVStore *pStore, TSCKSUM *magic, SArray *pRecords) {
+  char      tbuf[128] = "\0";
+  SKVRecord rInfo = {0};
+  TSCKSUM   cksum = 0;
+
   while (true) {
     ssize_t tsize = taosTRead(pStore->fd, tbuf, sizeof(SKVRecord));
     if (tsize == 0) break;
@@ -512,14 +686,21 @@ static int tdRestoreKVStore(SKVStore *pStore) {
       uError("failed to read %zu bytes from file %s at offset %" PRId64 "since %s", sizeof(SKVRecord), pStore->fname,
              pStore->info.size, strerror(errno));
       terrno = TAOS_SYSTEM_ERROR(errno);
-      goto _err;
+      return -1;
     }
 
     char *pBuf = tdDecodeKVRecord(tbuf, &rInfo);
     ASSERT(POINTER_DISTANCE(pBuf, tbuf) == sizeof(SKVRecord));
+    if (magic != NULL &&
+        ((rInfo.offset > 0 && pStore->info.size != rInfo.offset) || rInfo.size < (int64_t)sizeof(TSCKSUM))) {
+      terrno = TSDB_CODE_COM_FILE_CORRUPTED;
+      return -1;
+    }
     ASSERT((rInfo.offset > 0) ? (pStore->info.size == rInfo.offset) : true);
 
     if (rInfo.offset < 0) {
+      if (magic != NULL) *magic = taosCalcChecksum(*magic, (uint8_t *)tbuf, sizeof(SKVRecord));
+
       taosHashRemove(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid));
       pStore->info.size += sizeof(SKVRecord);
       pStore->info.nRecords--;
@@ -527,73 +708,307 @@ static int tdRestoreKVStore(SKVStore *pStore) {
       pStore->info.tombSize += (rInfo.size + sizeof(SKVRecord) * 2);
     } else {
       ASSERT(rInfo.offset > 0 && rInfo.size > 0);
-      if (taosHashPut(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid), &rInfo, sizeof(rInfo)) < 0) {
-        uError("failed to put record in KV store %s", pStore->fname);
-        terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
-        goto _err;
+      if (magic != NULL) {
+        if (lseek(pStore->fd, (off_t)(rInfo.size - sizeof(TSCKSUM)), SEEK_CUR) < 0 ||
+            taosTRead(pStore->fd, &cksum, sizeof(TSCKSUM)) < sizeof(TSCKSUM)) {
+          terrno = TSDB_CODE_COM_FILE_CORRUPTED;
+          return -1;
+        }
+        *magic = taosCalcChecksum(*magic, (uint8_t *)(&cksum), sizeof(TSCKSUM));
+      } else if (lseek(pStore->fd, (off_t)rInfo.size, SEEK_CUR) < 0) {
+        uError("failed to lseek file %s since %s", pStore->fname, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        return -1;
       }
 
-      maxBufSize = MAX(maxBufSize, rInfo.size);
+      SKVRecord *pRecord = taosHashGet(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid));
+      if (pRecord != NULL) {
+        pStore->info.tombSize += pRecord->size;
+      } else {
+        pStore->info.nRecords++;
+      }
 
-      if (lseek(pStore->fd, (off_t)rInfo.size, SEEK_CUR) < 0) {
-        uError("failed to lseek file %s since %s", pStore->fname, strerror(errno));
-        terrno = TAOS_SYSTEM_ERROR(errno);
-        goto _err;
+      if (taosHashPut(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid), &rInfo, sizeof(rInfo)) < 0 ||
+          taosArrayPush(pRecords, &rInfo) == NULL) {
+        uError("failed to put record in KV store %s", pStore->fname);
+        terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+        return -1;
       }
 
       pStore->info.size += (sizeof(SKVRecord) + rInfo.size);
-      pStore->info.nRecords++;
     }
   }
 
-  buf = malloc(maxBufSize);
-  if (buf == NULL) {
-    uError("failed to allocate %" PRId64 " bytes in KV store %s", maxBufSize, pStore->fname);
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    goto _err;
+  return 0;
+}
+
+// Load and verify the checkpoint file, and put the records in it into the map. The whole file is returned mapped, or
+// NULL if there is no valid checkpoint.
+static char *tdLoadKVStoreCkpt(SKVStore *pStore, int64_t storeSize, SStoreInfo *pInfo, int64_t *fsize) {
+  SStoreInfo  info = {0};
+  int64_t     contSize = 0;
+  TSCKSUM     cksum = 0;
+  uint32_t    version = 0;
+  char *      pCkpt = NULL;
+  struct stat fstatInfo;
+
+  int fd = open(pStore->fckpt, O_RDONLY);
+  if (fd < 0) {
+    if (errno != ENOENT) uWarn("failed to open file %s since %s", pStore->fckpt, strerror(errno));
+    return NULL;
   }
 
+  if (fstat(fd, &fstatInfo) < 0 || fstatInfo.st_size < TD_KVSTORE_HEADER_SIZE) {
+    uWarn("checkpoint %s is broken", pStore->fckpt);
+    close(fd);
+    (void)remove(pStore->fckpt);
+    return NULL;
+  }
+
+  *fsize = fstatInfo.st_size;
+  pCkpt = tdMapKVStoreFile(fd, pStore->fckpt, *fsize);
+  close(fd);
+  if (pCkpt == NULL) return NULL;
+
+  if (!taosCheckChecksumWhole((uint8_t *)pCkpt, TD_KVSTORE_HEADER_SIZE)) goto _broken;
+  tdDecodeCkptHeader(pCkpt, &info, &contSize, &cksum, &version);
+  if (version != KVSTORE_FILE_VERSION || contSize != *fsize - TD_KVSTORE_HEADER_SIZE || info.size > storeSize ||
+      tdCalcKVStoreChecksum(0, pCkpt + TD_KVSTORE_HEADER_SIZE, contSize) != cksum) {
+    goto _broken;
+  }
+
+  char *pBuf = pCkpt + TD_KVSTORE_HEADER_SIZE;
+  while (pBuf < pCkpt + *fsize) {
+    SKVRecord rInfo = {0};
+    if (POINTER_DISTANCE(pCkpt + *fsize, pBuf) < sizeof(SKVRecord)) goto _broken;
+    pBuf = tdDecodeKVRecord(pBuf, &rInfo);
+    if (rInfo.offset <= 0 || rInfo.size <= 0 || rInfo.size > POINTER_DISTANCE(pCkpt + *fsize, pBuf)) goto _broken;
+
+    if (taosHashPut(pStore->map, (void *)(&rInfo.uid), sizeof(rInfo.uid), &rInfo, sizeof(rInfo)) < 0) {
+      uError("failed to put record in KV store %s", pStore->fname);
+      goto _broken;
+    }
+    pBuf = POINTER_SHIFT(pBuf, rInfo.size);
+  }
+
+  *pInfo = info;
+  pStore->ckptSize = info.size;
+  if (lseek(pStore->fd, (off_t)info.size, SEEK_SET) < 0) {
+    uError("failed to lseek file %s since %s", pStore->fname, strerror(errno));
+    goto _broken;
+  }
+
+  uDebug("checkpoint %s of %" PRId64 " records is loaded", pStore->fckpt, info.nRecords);
+  return pCkpt;
+
+_broken:
+  uWarn("checkpoint %s is broken or does not match file %s", pStore->fckpt, pStore->fname);
+  tdUnmapKVStoreFile(pCkpt, *fsize);
+  (void)remove(pStore->fckpt);
+  taosHashCleanup(pStore->map);
+  pStore->map = taosHashInit(4096, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false);
+  if (pStore->map == NULL) {
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+  }
+  return NULL;
+}
+
+// Write the live records of the store file into the checkpoint file in the order of offset. It is called at the end
+// of a commit, when the store file is synced.
+static int tdWriteKVStoreCkpt(SKVStore *pStore) {
+  SArray *              pRecords = NULL;
+  SHashMutableIterator *pIter = NULL;
+  char *                pFile = NULL;
+  char *                buf = NULL;
+  char *                ftmp = NULL;
+  int                   tfd = -1;
+  int64_t               contSize = 0;
+  TSCKSUM               cksum = 0;
+  int32_t               bufSize = 0;
+  char                  header[TD_KVSTORE_HEADER_SIZE] = "\0";
+
+  ftmp = malloc(strlen(pStore->fckpt) + strlen(TD_KVSTORE_CKPT_TMP_SUFFIX) + 1);
+  pRecords = taosArrayInit(pStore->info.nRecords + 1, sizeof(SKVRecord));
   pIter = taosHashCreateIter(pStore->map);
-  if (pIter == NULL) {
-    uError("failed to create hash iter while opening KV store %s", pStore->fname);
+  buf = malloc(TD_KVSTORE_CKPT_BUF_SIZE);
+  if (ftmp == NULL || pRecords == NULL || pIter == NULL || buf == NULL) {
     terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
     goto _err;
   }
+  sprintf(ftmp, "%s%s", pStore->fckpt, TD_KVSTORE_CKPT_TMP_SUFFIX);
 
   while (taosHashIterNext(pIter)) {
-    SKVRecord *pRecord = taosHashIterGet(pIter);
+    taosArrayPush(pRecords, taosHashIterGet(pIter));
+  }
+  taosArraySort(pRecords, tdKVRecordOffsetCompar);
 
-    if (lseek(pStore->fd, (off_t)(pRecord->offset + sizeof(SKVRecord)), SEEK_SET) < 0) {
-      uError("failed to lseek file %s since %s, offset %" PRId64, pStore->fname, strerror(errno), pRecord->offset);
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      goto _err;
-    }
+  pFile = tdMapKVStoreFile(pStore->fd, pStore->fname, pStore->info.size);
+  if (pFile == NULL) goto _err;
 
-    if (taosTRead(pStore->fd, buf, pRecord->size) < pRecord->size) {
-      uError("failed to read %" PRId64 " bytes from file %s since %s, offset %" PRId64, pRecord->size, pStore->fname,
-             strerror(errno), pRecord->offset);
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      goto _err;
+  tfd = open(ftmp, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+  if (tfd < 0) {
+    uError("failed to open file %s since %s", ftmp, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  if (lseek(tfd, TD_KVSTORE_HEADER_SIZE, SEEK_SET) < 0) {
+    uError("failed to lseek file %s since %s", ftmp, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  for (size_t i = 0; i <= taosArrayGetSize(pRecords); i++) {
+    SKVRecord *pRecord = (i < taosArrayGetSize(pRecords)) ? taosArrayGet(pRecords, i) : NULL;
+    int64_t    tlen = (pRecord == NULL) ? 0 : (int64_t)sizeof(SKVRecord) + pRecord->size;
+
+    if (bufSize > 0 && (pRecord == NULL || bufSize + tlen > TD_KVSTORE_CKPT_BUF_SIZE)) {
+      if (taosTWrite(tfd, buf, bufSize) < bufSize) {
+        uError("failed to write %d bytes to file %s since %s", bufSize, ftmp, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        goto _err;
+      }
+      cksum = taosCalcChecksum(cksum, (uint8_t *)buf, bufSize);
+      contSize += bufSize;
+      bufSize = 0;
     }
+    if (pRecord == NULL) break;
 
-    if (pStore->iFunc) {
-      if ((*pStore->iFunc)(pStore->appH, buf, (int)pRecord->size) < 0) {
-        uError("failed to restore record uid %" PRIu64 " in kv store %s at offset %" PRId64 " size %" PRId64
-               " since %s",
-               pRecord->uid, pStore->fname, pRecord->offset, pRecord->size, tstrerror(terrno));
+    ASSERT(pRecord->offset + tlen <= pStore->info.size);
+    if (tlen > TD_KVSTORE_CKPT_BUF_SIZE) {
+      char *tbuf = realloc(buf, tlen);
+      if (tbuf == NULL) {
+        terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
         goto _err;
       }
+      buf = tbuf;
     }
+
+    void *pBuf = buf + bufSize;
+    tdEncodeKVRecord(&pBuf, pRecord);
+    memcpy(pBuf, pFile + pRecord->offset + sizeof(SKVRecord), pRecord->size);
+    bufSize += (int32_t)tlen;
   }
 
-  if (pStore->aFunc) (*pStore->aFunc)(pStore->appH);
+  void *pBuf = header;
+  tdEncodeCkptHeader(&pBuf, &(pStore->info), contSize, cksum);
+  ASSERT(POINTER_DISTANCE(pBuf, header) + sizeof(TSCKSUM) <= TD_KVSTORE_HEADER_SIZE);
+  taosCalcChecksumAppend(0, (uint8_t *)header, TD_KVSTORE_HEADER_SIZE);
+
+  if (lseek(tfd, 0, SEEK_SET) < 0 || taosTWrite(tfd, header, TD_KVSTORE_HEADER_SIZE) < TD_KVSTORE_HEADER_SIZE) {
+    uError("failed to write %d bytes to file %s since %s", TD_KVSTORE_HEADER_SIZE, ftmp, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
 
+  if (fsync(tfd) < 0) {
+    uError("failed to fsync file %s since %s", ftmp, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  close(tfd);
+  tfd = -1;
+
+  if (rename(ftmp, pStore->fckpt) < 0) {
+    uError("failed to rename file %s to %s since %s", ftmp, pStore->fckpt, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  pStore->ckptSize = pStore->info.size;
+  uDebug("checkpoint %s of %" PRId64 " records is written, %" PRId64 " bytes", pStore->fckpt, pStore->info.nRecords,
+         contSize + TD_KVSTORE_HEADER_SIZE);
+
+  tdUnmapKVStoreFile(pFile, pStore->info.size);
   taosHashDestroyIter(pIter);
+  taosArrayDestroy(pRecords);
   taosTFree(buf);
+  taosTFree(ftmp);
   return 0;
 
 _err:
+  uError("failed to write checkpoint of KV store %s since %s", pStore->fname, tstrerror(terrno));
+  if (tfd >= 0) {
+    close(tfd);
+    (void)remove(ftmp);
+  }
+  if (pFile != NULL) tdUnmapKVStoreFile(pFile, pStore->info.size);
   taosHashDestroyIter(pIter);
+  taosArrayDestroy(pRecords);
   taosTFree(buf);
+  taosTFree(ftmp);
   return -1;
 }
+
+static int tdEncodeCkptHeader(void **buf, SStoreInfo *pInfo, int64_t contSize, TSCKSUM cksum) {
+  int tlen = 0;
+  tlen += tdEncodeStoreInfo(buf, pInfo);
+  tlen += taosEncodeFixedU32(buf, KVSTORE_FILE_VERSION);
+  tlen += taosEncodeVariantI64(buf, contSize);
+  tlen += taosEncodeFixedU32(buf, cksum);
+
+  return tlen;
+}
+
+static void *tdDecodeCkptHeader(void *buf, SStoreInfo *pInfo, int64_t *contSize, TSCKSUM *cksum, uint32_t *version) {
+  buf = tdDecodeStoreInfo(buf, pInfo);
+  buf = taosDecodeFixedU32(buf, version);
+  buf = taosDecodeVariantI64(buf, contSize);
+  buf = taosDecodeFixedU32(buf, cksum);
+
+  return buf;
+}
+
+static char *tdMapKVStoreFile(int fd, char *fname, int64_t size) {
+#ifdef WINDOWS
+  char *ptr = malloc(size);
+  if (ptr == NULL) {
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  if (lseek(fd, 0, SEEK_SET) < 0 || taosTRead(fd, ptr, size) < size) {
+    uError("failed to read %" PRId64 " bytes from file %s since %s", size, fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    free(ptr);
+    return NULL;
+  }
+
+  return ptr;
+#else
+  char *ptr = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    uError("failed to mmap %" PRId64 " bytes of file %s since %s", size, fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return NULL;
+  }
+
+  (void)madvise(ptr, (size_t)size, MADV_SEQUENTIAL);
+  return ptr;
+#endif
+}
+
+static void tdUnmapKVStoreFile(char *ptr, int64_t size) {
+#ifdef WINDOWS
+  free(ptr);
+#else
+  munmap(ptr, (size_t)size);
+#endif
+}
+
+static TSCKSUM tdCalcKVStoreChecksum(TSCKSUM csi, char *data, int64_t size) {
+  for (int64_t offset = 0; offset < size; offset += TD_KVSTORE_CKSUM_STEP) {
+    csi = taosCalcChecksum(csi, (uint8_t *)(data + offset), (uint32_t)MIN(size - offset, TD_KVSTORE_CKSUM_STEP));
+  }
+
+  return csi;
+}
+
+static int tdKVRecordOffsetCompar(const void *a, const void *b) {
+  const SKVRecord *pRecord1 = (const SKVRecord *)a;
+  const SKVRecord *pRecord2 = (const SKVRecord *)b;
+
+  if (pRecord1->offset == pRecord2->offset) return 0;
+  return (pRecord1->offset < pRecord2->offset) ? -1 : 1;
+}
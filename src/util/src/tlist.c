@@ -101,6 +101,7 @@ SListNode *tdListPopHead(SList *list) {
     list->tail = NULL;
   } else {
     list->head = node->next;
+    list->head->prev = NULL;
   }
   list->numOfEles--;
   node->next = NULL;
@@ -116,6 +117,7 @@ SListNode *tdListPopTail(SList *list) {
     list->tail = NULL;
   } else {
     list->tail = node->prev;
+    list->tail->next = NULL;
   }
   list->numOfEles--;
   node->next = node->prev = NULL;
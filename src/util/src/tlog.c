@@ -45,6 +45,7 @@ typedef struct {
   int32_t         buffSize;
   int32_t         fd;
   int32_t         stop;
+  int32_t         recordPending;  // set by the binary log records pushed since the last flush of the log rings
   pthread_t       asyncThread;
   pthread_mutex_t buffMutex;
   tsem_t          buffNotEmpty;
@@ -310,6 +311,472 @@ static int32_t taosOpenLogFile(char *fn, int32_t maxLines, int32_t maxFileNum) {
   return 0;
 }
 
+// ---------------- binary log ----------------
+/*
+ * In binary mode, taosPrintLog does not format the log line. It copies the timestamp, the format and the raw
+ * arguments into a ring buffer owned by the calling thread, and the log thread renders the records into text.
+ * A record is dropped if the ring of the thread is full, the number of dropped records is written into the log.
+ */
+#define LOG_RING_SIZE         (64 * 1024)  // must be power of 2
+#define LOG_MAX_RECORD_SIZE   (MAX_LOGLINE_SIZE + 64)
+#define LOG_OUTPUT_BUF_SIZE   (64 * 1024)
+#define LOG_MAX_SPEC_LEN      32
+#define LOG_RECORD_PADDING    0
+#define LOG_RECORD_LINE       1
+#define LOG_ALIGN(x)          (((x) + 7) & ~7)
+
+typedef enum {
+  LOG_ARG_NONE,
+  LOG_ARG_INT,
+  LOG_ARG_LONG,
+  LOG_ARG_LLONG,
+  LOG_ARG_SIZE,
+  LOG_ARG_PTRDIFF,
+  LOG_ARG_INTMAX,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_LDOUBLE,
+  LOG_ARG_STR,
+  LOG_ARG_PTR,
+  LOG_ARG_INVALID,
+} ELogArgType;
+
+typedef struct {
+  const char *end;            // the char behind the conversion spec
+  int8_t      type;
+  int8_t      numOfStars;     // number of the int arguments for width and precision
+  bool        starPrecision;  // the precision is given by the last int argument
+  int32_t     precision;      // -1 if the precision is not given in the spec
+} SLogSpec;
+
+typedef struct {
+  uint32_t    len;         // length of the record including the header, aligned to 8 bytes
+  uint32_t    type;
+  int64_t     ts;          // in microseconds
+  const char *flags;
+  const char *format;      // identifies the record, it is not copied, so it shall be a string literal
+  char        args[];
+} SLogRecord;
+
+typedef struct SLogRing {
+  struct SLogRing *next;
+  int64_t          head;      // advanced by the log thread
+  int64_t          tail;      // advanced by the owner thread
+  int64_t          dropped;
+  int32_t          closed;    // the owner thread exits, the ring is freed by the log thread once it is drained
+  char             id[24];
+  char             buffer[];
+} SLogRing;
+
+typedef struct {
+  int64_t sec;
+  int32_t len;
+  char    prefix[24];
+} SLogTimeCache;
+
+int32_t tsBinaryLog = 0;
+
+static threadlocal SLogTimeCache tsLogTimeCache = {.sec = -1};
+static threadlocal SLogRing *    tsLogRing = NULL;
+static SLogRing *                tsLogRings = NULL;
+static pthread_mutex_t           tsLogRingMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t            tsLogRingOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t             tsLogRingKey;
+
+// the date and time are formatted only once per second by each thread
+static int32_t taosFormatLogTime(char *buffer, int64_t us) {
+  SLogTimeCache *pCache = &tsLogTimeCache;
+  int64_t        sec = us / 1000000;
+
+  if (pCache->sec != sec) {
+    struct tm Tm;
+    time_t    curTime = (time_t)sec;
+    localtime_r(&curTime, &Tm);
+
+    pCache->len = sprintf(pCache->prefix, "%02d/%02d %02d:%02d:%02d", Tm.tm_mon + 1, Tm.tm_mday, Tm.tm_hour,
+                          Tm.tm_min, Tm.tm_sec);
+    pCache->sec = sec;
+  }
+
+  memcpy(buffer, pCache->prefix, pCache->len);
+  return pCache->len + sprintf(buffer + pCache->len, ".%06d ", (int32_t)(us % 1000000));
+}
+
+static void taosParseLogSpec(const char *p, SLogSpec *pSpec) {
+  pSpec->type = LOG_ARG_INVALID;
+  pSpec->numOfStars = 0;
+  pSpec->starPrecision = false;
+  pSpec->precision = -1;
+
+  p++;  // skip the '%'
+  if (*p == '%') {
+    pSpec->type = LOG_ARG_NONE;
+    pSpec->end = p + 1;
+    return;
+  }
+
+  while (*p != 0 && strchr("-+ #0", *p) != NULL) p++;
+
+  if (*p == '*') {
+    pSpec->numOfStars++;
+    p++;
+  } else {
+    while (isdigit(*p)) p++;
+  }
+
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      pSpec->numOfStars++;
+      pSpec->starPrecision = true;
+      p++;
+    } else {
+      pSpec->precision = 0;
+      while (isdigit(*p)) pSpec->precision = pSpec->precision * 10 + (*p++ - '0');
+    }
+  }
+
+  int8_t intType = LOG_ARG_INT;
+  bool   longDouble = false;
+  if (p[0] == 'h') {
+    p += (p[1] == 'h') ? 2 : 1;
+  } else if (p[0] == 'l' && p[1] == 'l') {
+    intType = LOG_ARG_LLONG;
+    p += 2;
+  } else if (p[0] == 'l') {
+    intType = LOG_ARG_LONG;
+    p++;
+  } else if (p[0] == 'q') {
+    intType = LOG_ARG_LLONG;
+    p++;
+  } else if (p[0] == 'j') {
+    intType = LOG_ARG_INTMAX;
+    p++;
+  } else if (p[0] == 'z') {
+    intType = LOG_ARG_SIZE;
+    p++;
+  } else if (p[0] == 't') {
+    intType = LOG_ARG_PTRDIFF;
+    p++;
+  } else if (p[0] == 'L') {
+    longDouble = true;
+    p++;
+  }
+
+  // the positional arguments, %n, the wide chars and the other extensions are not supported
+  switch (*p) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+      pSpec->type = intType;
+      break;
+    case 'c':
+      if (intType == LOG_ARG_INT) pSpec->type = LOG_ARG_INT;
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      pSpec->type = longDouble ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+      break;
+    case 's':
+      if (intType == LOG_ARG_INT) pSpec->type = LOG_ARG_STR;
+      break;
+    case 'p':
+      pSpec->type = LOG_ARG_PTR;
+      break;
+    default:
+      break;
+  }
+
+  pSpec->end = (*p != 0) ? p + 1 : p;
+}
+
+/*
+ * the arguments are copied in order: an int argument is 8 bytes, a long double is 16 bytes, a string is its length
+ * in 4 bytes followed by the null terminated chars, and each argument is aligned to 8 bytes
+ */
+static int32_t taosEncodeLogArgs(char *buffer, int32_t size, const char *format, va_list ap) {
+  SLogSpec spec;
+  int32_t  len = 0;
+
+  for (const char *p = strchr(format, '%'); p != NULL; p = strchr(spec.end, '%')) {
+    taosParseLogSpec(p, &spec);
+    if (spec.type == LOG_ARG_INVALID) return -1;
+    if (spec.type == LOG_ARG_NONE) continue;
+
+    int32_t precision = spec.precision;
+    for (int32_t i = 0; i < spec.numOfStars; ++i) {
+      if (len + 8 > size) return -1;
+      int64_t v = va_arg(ap, int);
+      memcpy(buffer + len, &v, 8);
+      len += 8;
+      if (spec.starPrecision) precision = (int32_t)v;
+    }
+
+    if (spec.type == LOG_ARG_LDOUBLE) {
+      if (len + 16 > size) return -1;
+      long double v = va_arg(ap, long double);
+      memcpy(buffer + len, &v, sizeof(v));
+      len += 16;
+    } else if (spec.type == LOG_ARG_STR) {
+      const char *s = va_arg(ap, const char *);
+      if (s == NULL) s = "(null)";
+
+      // a string longer than the record is truncated, the same as a long line of text
+      int32_t maxLen = size - len - 5;
+      if (maxLen < 0) return -1;
+      if (precision >= 0 && precision < maxLen) maxLen = precision;
+
+      uint32_t slen = (uint32_t)strnlen(s, maxLen);
+      memcpy(buffer + len, &slen, 4);
+      memcpy(buffer + len + 4, s, slen);
+      buffer[len + 4 + slen] = 0;
+      len += LOG_ALIGN(4 + slen + 1);
+    } else {
+      if (len + 8 > size) return -1;
+
+      int64_t v = 0;
+      switch (spec.type) {
+        case LOG_ARG_INT:     v = va_arg(ap, int); break;
+        case LOG_ARG_LONG:    v = va_arg(ap, long); break;
+        case LOG_ARG_LLONG:   v = va_arg(ap, long long); break;
+        case LOG_ARG_SIZE:    v = (int64_t)va_arg(ap, size_t); break;
+        case LOG_ARG_PTRDIFF: v = va_arg(ap, ptrdiff_t); break;
+        case LOG_ARG_INTMAX:  v = va_arg(ap, intmax_t); break;
+        case LOG_ARG_PTR:     v = (int64_t)(uintptr_t)va_arg(ap, void *); break;
+        case LOG_ARG_DOUBLE: {
+          double d = va_arg(ap, double);
+          memcpy(&v, &d, 8);
+          break;
+        }
+        default: return -1;
+      }
+
+      memcpy(buffer + len, &v, 8);
+      len += 8;
+    }
+  }
+
+  return len;
+}
+
+#define LOG_RENDER_ARG(fmt, stars, n, value)                                                     \
+  ((n) == 0 ? snprintf(buffer, size, fmt, value)                                                \
+            : ((n) == 1 ? snprintf(buffer, size, fmt, stars[0], value)                          \
+                        : snprintf(buffer, size, fmt, stars[0], stars[1], value)))
+
+static int32_t taosRenderLogArg(char *buffer, int32_t size, const char *fmt, SLogSpec *pSpec, const char *args,
+                                int32_t *pos) {
+  int32_t stars[2] = {0};
+  for (int32_t i = 0; i < pSpec->numOfStars; ++i) {
+    int64_t v = 0;
+    memcpy(&v, args + *pos, 8);
+    stars[i] = (int32_t)v;
+    *pos += 8;
+  }
+
+  int32_t n = pSpec->numOfStars;
+  int64_t v = 0;
+
+  if (pSpec->type == LOG_ARG_LDOUBLE) {
+    long double d;
+    memcpy(&d, args + *pos, sizeof(d));
+    *pos += 16;
+    return LOG_RENDER_ARG(fmt, stars, n, d);
+  }
+
+  if (pSpec->type == LOG_ARG_STR) {
+    uint32_t slen = 0;
+    memcpy(&slen, args + *pos, 4);
+
+    const char *s = args + *pos + 4;
+    *pos += LOG_ALIGN(4 + slen + 1);
+    return LOG_RENDER_ARG(fmt, stars, n, s);
+  }
+
+  memcpy(&v, args + *pos, 8);
+  *pos += 8;
+
+  switch (pSpec->type) {
+    case LOG_ARG_INT:     return LOG_RENDER_ARG(fmt, stars, n, (int)v);
+    case LOG_ARG_LONG:    return LOG_RENDER_ARG(fmt, stars, n, (long)v);
+    case LOG_ARG_LLONG:   return LOG_RENDER_ARG(fmt, stars, n, (long long)v);
+    case LOG_ARG_SIZE:    return LOG_RENDER_ARG(fmt, stars, n, (size_t)v);
+    case LOG_ARG_PTRDIFF: return LOG_RENDER_ARG(fmt, stars, n, (ptrdiff_t)v);
+    case LOG_ARG_INTMAX:  return LOG_RENDER_ARG(fmt, stars, n, (intmax_t)v);
+    case LOG_ARG_PTR:     return LOG_RENDER_ARG(fmt, stars, n, (void *)(uintptr_t)v);
+    case LOG_ARG_DOUBLE: {
+      double d;
+      memcpy(&d, &v, 8);
+      return LOG_RENDER_ARG(fmt, stars, n, d);
+    }
+    default: return 0;
+  }
+}
+
+static int32_t taosRenderLogRecord(char *buffer, SLogRing *pRing, SLogRecord *pRecord) {
+  int32_t  len = taosFormatLogTime(buffer, pRecord->ts);
+  int32_t  pos = 0;
+  SLogSpec spec;
+
+  len += sprintf(buffer + len, "%s", pRing->id);
+  len += snprintf(buffer + len, MAX_LOGLINE_SIZE - len, "%s", pRecord->flags);
+  len = MIN(len, MAX_LOGLINE_SIZE);
+
+  int32_t     limit = MIN(len + MAX_LOGLINE_CONTENT_SIZE, MAX_LOGLINE_SIZE);
+  const char *p = pRecord->format;
+  while (*p != 0 && len < limit) {
+    const char *q = strchr(p, '%');
+    if (q == NULL) q = p + strlen(p);
+
+    int32_t n = MIN((int32_t)(q - p), limit - len);
+    memcpy(buffer + len, p, n);
+    len += n;
+    if (*q == 0 || len >= limit) break;
+
+    taosParseLogSpec(q, &spec);
+    if (spec.type == LOG_ARG_NONE) {
+      buffer[len++] = '%';
+    } else {
+      char fmt[LOG_MAX_SPEC_LEN] = {0};
+      memcpy(fmt, q, MIN(spec.end - q, LOG_MAX_SPEC_LEN - 1));
+
+      n = taosRenderLogArg(buffer + len, limit - len + 1, fmt, &spec, pRecord->args, &pos);
+      len += MIN(MAX(n, 0), limit - len);
+    }
+
+    p = spec.end;
+  }
+
+  buffer[len++] = '\n';
+  return len;
+}
+
+static void taosCloseLogRing(void *param) {
+  SLogRing *pRing = param;
+  atomic_store_32(&pRing->closed, 1);
+}
+
+static void taosInitLogRingKey() { pthread_key_create(&tsLogRingKey, taosCloseLogRing); }
+
+static SLogRing *taosGetLogRing() {
+  if (tsLogRing != NULL) return tsLogRing;
+
+  SLogRing *pRing = calloc(1, sizeof(SLogRing) + LOG_RING_SIZE);
+  if (pRing == NULL) return NULL;
+
+  pthread_once(&tsLogRingOnce, taosInitLogRingKey);
+  pthread_setspecific(tsLogRingKey, pRing);
+  sprintf(pRing->id, "0x%08" PRIx64 " ", taosGetPthreadId());
+
+  pthread_mutex_lock(&tsLogRingMutex);
+  pRing->next = tsLogRings;
+  tsLogRings = pRing;
+  pthread_mutex_unlock(&tsLogRingMutex);
+
+  tsLogRing = pRing;
+  return pRing;
+}
+
+// return -1 if the line shall be printed as text
+static int32_t taosPushLogRecord(SLogBuff *tLogBuff, const char *flags, const char *format, va_list ap) {
+  if (tLogBuff == NULL || tLogBuff->stop) return -1;
+
+  SLogRing *pRing = taosGetLogRing();
+  if (pRing == NULL) return -1;
+
+  int64_t     buffer[LOG_MAX_RECORD_SIZE / sizeof(int64_t)];
+  SLogRecord *pRecord = (SLogRecord *)buffer;
+
+  int32_t argLen = taosEncodeLogArgs(pRecord->args, sizeof(buffer) - sizeof(SLogRecord), format, ap);
+  if (argLen < 0) return -1;
+
+  pRecord->len = LOG_ALIGN((uint32_t)sizeof(SLogRecord) + argLen);
+  pRecord->type = LOG_RECORD_LINE;
+  pRecord->ts = taosGetTimestampUs();
+  pRecord->flags = flags;
+  pRecord->format = format;
+
+  // only the owner thread advances the tail, so it is read without atomic operation
+  int64_t tail = pRing->tail;
+  int64_t head = atomic_load_64(&pRing->head);
+  int32_t offset = (int32_t)(tail & (LOG_RING_SIZE - 1));
+  int32_t padding = (offset + pRecord->len > LOG_RING_SIZE) ? LOG_RING_SIZE - offset : 0;
+
+  if (tail + padding + pRecord->len - head > LOG_RING_SIZE) {
+    atomic_add_fetch_64(&pRing->dropped, 1);
+    return 0;
+  }
+
+  // a record is not split at the end of the ring
+  if (padding > 0) {
+    SLogRecord *pPadding = (SLogRecord *)(pRing->buffer + offset);
+    pPadding->len = padding;
+    pPadding->type = LOG_RECORD_PADDING;
+    offset = 0;
+  }
+
+  memcpy(pRing->buffer + offset, pRecord, pRecord->len);
+  atomic_store_64(&pRing->tail, tail + padding + pRecord->len);
+
+  // the log thread is woken up only once for all the records pushed before it clears the flag
+  if (atomic_val_compare_exchange_32(&tLogBuff->recordPending, 0, 1) == 0) {
+    tsem_post(&(tLogBuff->buffNotEmpty));
+  }
+
+  return 0;
+}
+
+static void taosFlushLogRings(SLogBuff *tLogBuff) {
+  char    buffer[LOG_OUTPUT_BUF_SIZE];
+  int32_t len = 0;
+
+  atomic_store_32(&tLogBuff->recordPending, 0);
+
+  pthread_mutex_lock(&tsLogRingMutex);
+
+  SLogRing **ppRing = &tsLogRings;
+  while (*ppRing != NULL) {
+    SLogRing *pRing = *ppRing;
+    int32_t   closed = atomic_load_32(&pRing->closed);
+    int64_t   tail = atomic_load_64(&pRing->tail);
+    int64_t   head = pRing->head;
+
+    while (head < tail) {
+      SLogRecord *pRecord = (SLogRecord *)(pRing->buffer + (head & (LOG_RING_SIZE - 1)));
+      if (pRecord->type == LOG_RECORD_LINE) {
+        if (len + MAX_LOGLINE_BUFFER_SIZE > LOG_OUTPUT_BUF_SIZE) {
+          taosTWrite(tLogBuff->fd, buffer, len);
+          len = 0;
+        }
+        len += taosRenderLogRecord(buffer + len, pRing, pRecord);
+      }
+      head += pRecord->len;
+    }
+
+    atomic_store_64(&pRing->head, head);
+
+    int64_t dropped = atomic_exchange_64(&pRing->dropped, 0);
+    if (dropped > 0) {
+      if (len + MAX_LOGLINE_BUFFER_SIZE > LOG_OUTPUT_BUF_SIZE) {
+        taosTWrite(tLogBuff->fd, buffer, len);
+        len = 0;
+      }
+      len += taosFormatLogTime(buffer + len, taosGetTimestampUs());
+      len += sprintf(buffer + len, "%sUTL %" PRId64 " log records are dropped since the log ring is full\n", pRing->id,
+                     dropped);
+    }
+
+    if (closed) {
+      *ppRing = pRing->next;
+      free(pRing);
+    } else {
+      ppRing = &pRing->next;
+    }
+  }
+
+  pthread_mutex_unlock(&tsLogRingMutex);
+
+  if (len > 0) {
+    taosTWrite(tLogBuff->fd, buffer, len);
+  }
+}
+
 void taosPrintLog(const char *flags, int32_t dflag, const char *format, ...) {
   if (tsTotalLogDirGB != 0 && tsAvailLogDirGB < tsMinimalLogDirGB) {
     printf("server disk:%s space remain %.3f GB, total %.1f GB, stop print log.\n", tsLogDir, tsAvailLogDirGB, tsTotalLogDirGB);
@@ -320,16 +787,25 @@ void taosPrintLog(const char *flags, int32_t dflag, const char *format, ...) {
   va_list        argpointer;
   char           buffer[MAX_LOGLINE_BUFFER_SIZE] = { 0 };
   int32_t        len;
-  struct tm      Tm, *ptm;
-  struct timeval timeSecs;
-  time_t         curTime;
 
-  gettimeofday(&timeSecs, NULL);
-  curTime = timeSecs.tv_sec;
-  ptm = localtime_r(&curTime, &Tm);
+  if (tsBinaryLog && tsAsyncLog && (dflag & DEBUG_FILE) && !(dflag & DEBUG_SCREEN) && tsLogObj.logHandle &&
+      tsLogObj.logHandle->fd >= 0) {
+    va_start(argpointer, format);
+    int32_t code = taosPushLogRecord(tsLogObj.logHandle, flags, format, argpointer);
+    va_end(argpointer);
 
-  len = sprintf(buffer, "%02d/%02d %02d:%02d:%02d.%06d 0x%08" PRIx64 " ", ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_hour,
-                ptm->tm_min, ptm->tm_sec, (int32_t)timeSecs.tv_usec, taosGetPthreadId());
+    if (code == 0) {
+      if (tsLogObj.maxLines > 0) {
+        atomic_add_fetch_32(&tsLogObj.lines, 1);
+
+        if ((tsLogObj.lines > tsLogObj.maxLines) && (tsLogObj.openInProgress == 0)) taosOpenNewLogFile();
+      }
+      return;
+    }
+  }
+
+  len = taosFormatLogTime(buffer, taosGetTimestampUs());
+  len += sprintf(buffer + len, "0x%08" PRIx64 " ", taosGetPthreadId());
   len += sprintf(buffer + len, "%s", flags);
 
   va_start(argpointer, format);
@@ -567,6 +1043,9 @@ static void *taosAsyncOutputLog(void *param) {
   while (1) {
     tsem_wait(&(tLogBuff->buffNotEmpty));
 
+    // read the flag before the buffer is polled, so the last polling starts after all logs are pushed
+    int32_t stop = tLogBuff->stop;
+
     // Polling the buffer
     while (1) {
       log_size = taosPollLogBuffer(tLogBuff, tempBuffer, TSDB_DEFAULT_LOG_BUF_UNIT);
@@ -578,7 +1057,9 @@ static void *taosAsyncOutputLog(void *param) {
       }
     }
 
-    if (tLogBuff->stop) break;
+    taosFlushLogRings(tLogBuff);
+
+    if (stop) break;
   }
 
   return NULL;
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taoserror.h"
+#include "tulog.h"
+#include "tplacement.h"
+
+typedef struct {
+  int32_t  numOfCores;
+  int32_t *cores;
+  int8_t   pinned;
+  int32_t  nextCore;      // the core taken by the next thread of a pinned pool
+  int32_t  numOfThreads;  // threads placed on the cores
+  int32_t  numOfFailed;   // threads which failed to be placed, they float
+  int8_t   bound[TAOS_MAX_CPU_CORES];  // the cores that the placed threads are actually allowed to run on
+} SPlacementPool;
+
+static SPlacementPool tsPlacementPools[TAOS_THREAD_POOL_MAX];
+static int8_t         tsPlacementInited = 0;
+static const char *   tsPlacementPoolNames[] = {"rpc", "write", "read", "commit", "sync"};
+
+static int32_t taosInitPlacementPool(SPlacementPool *pPool, int32_t *cores, int32_t numOfCores);
+static void    taosSortCoresByNode(int32_t *cores, int32_t numOfCores);
+static void    taosPrintCoreList(char *buf, int32_t len, const int32_t *cores, int32_t numOfCores);
+static void    taosPrintPlacement(char *buf, int32_t len, bool effective);
+
+int32_t taosInitThreadPlacement(const SThreadPlacementCfg *pCfg) {
+  int32_t numOfCores = MIN(MAX(pCfg->numOfCores, 1), TAOS_MAX_CPU_CORES);
+  int32_t cores[TAOS_THREAD_POOL_MAX][TAOS_MAX_CPU_CORES];
+  int32_t num[TAOS_THREAD_POOL_MAX] = {0};
+
+  for (int8_t pool = 0; pool < TAOS_THREAD_POOL_MAX; ++pool) {
+    num[pool] = taosParseCoreList(pCfg->cores[pool], numOfCores, cores[pool]);
+    if (num[pool] < 0) {
+      uError("invalid cores of %s threads:%s, online cores:%d", tsPlacementPoolNames[pool], pCfg->cores[pool],
+             numOfCores);
+      terrno = TSDB_CODE_COM_INVALID_CFG_MSG;
+      return -1;
+    }
+  }
+
+  // the write threads are pinned to all the cores if no cores are configured for them
+  if (pCfg->pinWrite && num[TAOS_THREAD_POOL_WRITE] == 0) {
+    for (int32_t i = 0; i < numOfCores; ++i) cores[TAOS_THREAD_POOL_WRITE][i] = i;
+    num[TAOS_THREAD_POOL_WRITE] = numOfCores;
+  }
+
+  // the read threads run on the cores left by the rpc threads
+  if (pCfg->isolateRpc && num[TAOS_THREAD_POOL_RPC] > 0) {
+    int32_t *pRead = cores[TAOS_THREAD_POOL_READ];
+    int32_t  nRead = 0;
+    bool     all = (num[TAOS_THREAD_POOL_READ] == 0);
+    int32_t  total = all ? numOfCores : num[TAOS_THREAD_POOL_READ];
+
+    for (int32_t i = 0; i < total; ++i) {
+      int32_t core = all ? i : pRead[i];
+      bool    isRpc = false;
+      for (int32_t j = 0; j < num[TAOS_THREAD_POOL_RPC]; ++j) {
+        if (cores[TAOS_THREAD_POOL_RPC][j] == core) isRpc = true;
+      }
+      if (!isRpc) pRead[nRead++] = core;
+    }
+
+    if (nRead == 0) {
+      uWarn("no cores are left for read threads by rpc threads, read threads are not isolated");
+    }
+    num[TAOS_THREAD_POOL_READ] = nRead;
+  }
+
+  for (int8_t pool = 0; pool < TAOS_THREAD_POOL_MAX; ++pool) {
+    SPlacementPool *pPool = tsPlacementPools + pool;
+    if (taosInitPlacementPool(pPool, cores[pool], num[pool]) < 0) {
+      taosCleanupThreadPlacement();
+      return -1;
+    }
+  }
+
+  if (tsPlacementPools[TAOS_THREAD_POOL_WRITE].numOfCores > 0 && pCfg->pinWrite) {
+    SPlacementPool *pPool = tsPlacementPools + TAOS_THREAD_POOL_WRITE;
+    taosSortCoresByNode(pPool->cores, pPool->numOfCores);
+    pPool->pinned = 1;
+  }
+
+  tsPlacementInited = 1;
+
+  char placement[TSDB_PLACEMENT_LEN] = {0};
+  taosPrintPlacement(placement, sizeof(placement), false);
+  uInfo("thread placement is initialized, %s", placement);
+  return 0;
+}
+
+void taosCleanupThreadPlacement() {
+  tsPlacementInited = 0;
+
+  for (int8_t pool = 0; pool < TAOS_THREAD_POOL_MAX; ++pool) {
+    SPlacementPool *pPool = tsPlacementPools + pool;
+    if (pPool->numOfCores > 0) {
+      uDebug("%d %s threads are placed, %d failed", pPool->numOfThreads, tsPlacementPoolNames[pool],
+             pPool->numOfFailed);
+    }
+    taosTFree(pPool->cores);
+    memset(pPool, 0, sizeof(SPlacementPool));
+  }
+}
+
+void taosPlaceThread(int8_t pool) {
+  if (!tsPlacementInited || pool < 0 || pool >= TAOS_THREAD_POOL_MAX) return;
+
+  SPlacementPool *pPool = tsPlacementPools + pool;
+  if (pPool->numOfCores == 0) return;
+
+  int32_t *cores = pPool->cores;
+  int32_t  numOfCores = pPool->numOfCores;
+  if (pPool->pinned) {
+    cores += atomic_fetch_add_32(&pPool->nextCore, 1) % pPool->numOfCores;
+    numOfCores = 1;
+  }
+
+  if (taosSetThreadAffinity(cores, numOfCores) != 0) {
+    uWarn("failed to place %s thread since %s", tsPlacementPoolNames[pool], strerror(errno));
+    atomic_add_fetch_32(&pPool->numOfFailed, 1);
+    return;
+  }
+
+  // the cores which are not online are left out by the system, so the affinity is read back
+  int32_t actual[TAOS_MAX_CPU_CORES];
+  int32_t numOfActual = taosGetThreadAffinity(actual, TAOS_MAX_CPU_CORES);
+  if (numOfActual < 0) {
+    memcpy(actual, cores, numOfCores * sizeof(int32_t));
+    numOfActual = numOfCores;
+  }
+
+  for (int32_t i = 0; i < numOfActual; ++i) {
+    pPool->bound[actual[i]] = 1;
+  }
+
+  atomic_add_fetch_32(&pPool->numOfThreads, 1);
+}
+
+void taosGetThreadPlacement(char *buf, int32_t len) { taosPrintPlacement(buf, len, true); }
+
+int32_t taosParseCoreList(const char *str, int32_t numOfCores, int32_t *cores) {
+  int8_t  used[TAOS_MAX_CPU_CORES] = {0};
+  int32_t num = 0;
+
+  if (str == NULL) return 0;
+
+  const char *p = str;
+  while (*p != 0) {
+    while (*p == ' ' || *p == ',') p++;
+    if (*p == 0) break;
+
+    char *  end = NULL;
+    int64_t first = strtoll(p, &end, 10);
+    if (end == p) return -1;
+    int64_t last = first;
+
+    p = end;
+    while (*p == ' ') p++;
+    if (*p == '-') {
+      p++;
+      last = strtoll(p, &end, 10);
+      if (end == p) return -1;
+      p = end;
+    }
+
+    while (*p == ' ') p++;
+    if (*p != 0 && *p != ',') return -1;
+    if (first < 0 || first > last || last >= numOfCores) return -1;
+
+    for (int64_t core = first; core <= last; ++core) {
+      if (used[core]) continue;
+      used[core] = 1;
+      cores[num++] = (int32_t)core;
+    }
+  }
+
+  return num;
+}
+
+static int32_t taosInitPlacementPool(SPlacementPool *pPool, int32_t *cores, int32_t numOfCores) {
+  memset(pPool, 0, sizeof(SPlacementPool));
+  if (numOfCores == 0) return 0;
+
+  pPool->cores = (int32_t *)calloc(numOfCores, sizeof(int32_t));
+  if (pPool->cores == NULL) {
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  memcpy(pPool->cores, cores, numOfCores * sizeof(int32_t));
+  pPool->numOfCores = numOfCores;
+  return 0;
+}
+
+static void taosSortCoresByNode(int32_t *cores, int32_t numOfCores) {
+  int32_t nodes[TAOS_MAX_CPU_CORES];
+  for (int32_t i = 0; i < numOfCores; ++i) {
+    nodes[i] = taosGetNumaNodeOfCore(cores[i]);
+    if (nodes[i] < 0) nodes[i] = INT32_MAX;  // the cores of unknown node are taken last
+  }
+
+  // the cores are few, and the order of the cores on the same node is kept
+  for (int32_t i = 1; i < numOfCores; ++i) {
+    int32_t core = cores[i], node = nodes[i];
+    int32_t j = i - 1;
+    while (j >= 0 && nodes[j] > node) {
+      cores[j + 1] = cores[j];
+      nodes[j + 1] = nodes[j];
+      j--;
+    }
+    cores[j + 1] = core;
+    nodes[j + 1] = node;
+  }
+}
+
+// the configured cores of each pool, or the cores its placed threads run on and the number of threads failed to be placed
+static void taosPrintPlacement(char *buf, int32_t len, bool effective) {
+  int32_t pos = 0;
+  buf[0] = 0;
+
+  for (int8_t pool = 0; pool < TAOS_THREAD_POOL_MAX && pos < len; ++pool) {
+    SPlacementPool *pPool = tsPlacementPools + pool;
+    char            cores[TSDB_PLACEMENT_LEN] = "*";
+    char            failed[32] = {0};
+
+    if (tsPlacementInited && pPool->numOfCores > 0) {
+      if (!effective) {
+        taosPrintCoreList(cores, sizeof(cores), pPool->cores, pPool->numOfCores);
+      } else if (atomic_load_32(&pPool->numOfThreads) > 0) {
+        int32_t bound[TAOS_MAX_CPU_CORES];
+        int32_t num = 0;
+        for (int32_t core = 0; core < TAOS_MAX_CPU_CORES; ++core) {
+          if (pPool->bound[core]) bound[num++] = core;
+        }
+        taosPrintCoreList(cores, sizeof(cores), bound, num);
+      }
+
+      int32_t numOfFailed = atomic_load_32(&pPool->numOfFailed);
+      if (effective && numOfFailed > 0) snprintf(failed, sizeof(failed), "/fail:%d", numOfFailed);
+    }
+
+    pos += snprintf(buf + pos, len - pos, "%s%s:%s%s%s", (pool == 0) ? "" : " ", tsPlacementPoolNames[pool], cores,
+                    (tsPlacementInited && pPool->pinned) ? "/pin" : "", failed);
+  }
+}
+
+static void taosPrintCoreList(char *buf, int32_t len, const int32_t *cores, int32_t numOfCores) {
+  int32_t pos = 0;
+  buf[0] = 0;
+
+  for (int32_t i = 0; i < numOfCores && pos < len; ++i) {
+    int32_t j = i;
+    while (j + 1 < numOfCores && cores[j + 1] == cores[j] + 1) j++;
+
+    if (j == i) {
+      pos += snprintf(buf + pos, len - pos, "%s%d", (i == 0) ? "" : ",", cores[i]);
+    } else {
+      pos += snprintf(buf + pos, len - pos, "%s%d-%d", (i == 0) ? "" : ",", cores[i], cores[j]);
+    }
+    i = j;
+  }
+}
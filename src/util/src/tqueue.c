@@ -17,6 +17,7 @@
 #include "tulog.h"
 #include "taoserror.h"
 #include "tqueue.h"
+#include "tslab.h"
 
 typedef struct STaosQnode {
   int                 type;
@@ -26,13 +27,16 @@ typedef struct STaosQnode {
 
 typedef struct STaosQueue {
   int32_t             itemSize;
-  int32_t             numOfItems;
-  struct STaosQnode  *head;
+  int32_t             numOfItems;  // items in the queue, including the ones still in the inbox
+  struct STaosQnode  *inbox;   // items pushed by the writers without lock, in reverse order
+  struct STaosQnode  *head;    // items collected from the inbox in order, only accessed by the reader with mutex
   struct STaosQnode  *tail;
+  int32_t             numOfReady;  // number of items from head to tail
   struct STaosQueue  *next;    // for queue set
   struct STaosQset   *qset;    // for queue set
   void               *ahandle; // for queue set
-  pthread_mutex_t     mutex;  
+  int8_t              busy;    // items are being processed by a worker, see taosAcquireAllQitemsFromQset
+  pthread_mutex_t     mutex;   // serializes the readers of the queue, writers never take it
 } STaosQueue;
 
 typedef struct STaosQset {
@@ -41,6 +45,9 @@ typedef struct STaosQset {
   pthread_mutex_t    mutex;
   int32_t            numOfQueues;
   int32_t            numOfItems;
+  int32_t            seq;           // bumped when items may be readable, readers sleep only if it does not change
+  int32_t            numOfWaiters;  // readers sleeping on sem, the writers post sem only if there is one
+  int32_t            numOfResumes;  // wake ups from taosQsetThreadResume not consumed yet
   tsem_t             sem;
 } STaosQset;
 
@@ -50,7 +57,14 @@ typedef struct STaosQall {
   int32_t       itemSize;
   int32_t       numOfItems;
 } STaosQall; 
-  
+
+static void taosCollectQitems(STaosQueue *queue);
+static bool taosQueueIsEmpty(STaosQueue *queue);
+static void taosNotifyQset(STaosQset *qset);
+static void taosWaitQset(STaosQset *qset, int32_t seq);
+static bool taosConsumeQsetResume(STaosQset *qset);
+static void taosFreeQnode(STaosQnode *pNode);
+
 taos_queue taosOpenQueue() {
   
   STaosQueue *queue = (STaosQueue *) calloc(sizeof(STaosQueue), 1);
@@ -72,68 +86,68 @@ void taosCloseQueue(taos_queue param) {
   STaosQset  *qset;
 
   pthread_mutex_lock(&queue->mutex);
+  taosCollectQitems(queue);
   STaosQnode *pNode = queue->head;  
   queue->head = NULL;
+  queue->tail = NULL;
+  queue->numOfReady = 0;
   qset = queue->qset;
   pthread_mutex_unlock(&queue->mutex);
 
   if (queue->qset) taosRemoveFromQset(qset, queue); 
 
-  pthread_mutex_lock(&queue->mutex);
-
   while (pNode) {
     pTemp = pNode;
     pNode = pNode->next;
-    free (pTemp);
+    taosFreeQnode(pTemp);
   }
 
-  pthread_mutex_unlock(&queue->mutex);
   pthread_mutex_destroy(&queue->mutex);
   free(queue);
 
   uTrace("queue:%p is closed", queue);
 }
 
+// the nodes are allocated from the slab, the items are usually allocated by the RPC threads and freed by the workers
 void *taosAllocateQitem(int size) {
-  STaosQnode *pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
-  
+  STaosQnode *pNode = (STaosQnode *)taosSlabMalloc(TAOS_SLAB_QUEUE, sizeof(STaosQnode) + size);
   if (pNode == NULL) return NULL;
+
   uTrace("item:%p, node:%p is allocated", pNode->item, pNode);
   return (void *)pNode->item;
 }
 
+static void taosFreeQnode(STaosQnode *pNode) { taosSlabFree(pNode); }
+
 void taosFreeQitem(void *param) {
   if (param == NULL) return;
 
   char *temp = (char *)param;
   temp -= sizeof(STaosQnode);
   uTrace("item:%p, node:%p is freed", param, temp);
-  free(temp);
+  taosFreeQnode((STaosQnode *)temp);
 }
 
 int taosWriteQitem(taos_queue param, int type, void *item) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQnode *pNode = (STaosQnode *)(((char *)item) - sizeof(STaosQnode));
+  STaosQnode *pHead = NULL;
   pNode->type = type;
-  pNode->next = NULL;
-
-  pthread_mutex_lock(&queue->mutex);
 
-  if (queue->tail) {
-    queue->tail->next = pNode;
-    queue->tail = pNode;
-  } else {
-    queue->head = pNode;
-    queue->tail = pNode; 
-  }
+  // the writers push the item to the inbox without lock, the reader collects all of them at once
+  do {
+    pHead = atomic_load_ptr(&queue->inbox);
+    pNode->next = pHead;
+  } while (atomic_val_compare_exchange_ptr(&queue->inbox, pHead, pNode) != pHead);
 
-  queue->numOfItems++;
-  if (queue->qset) atomic_add_fetch_32(&queue->qset->numOfItems, 1);
-  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, queue->numOfItems);
+  int32_t    numOfItems = atomic_add_fetch_32(&queue->numOfItems, 1);
+  STaosQset *qset = atomic_load_ptr(&queue->qset);
+  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, numOfItems);
 
-  pthread_mutex_unlock(&queue->mutex);
-
-  if (queue->qset) tsem_post(&queue->qset->sem);
+  if (qset) {
+    atomic_add_fetch_32(&qset->numOfItems, 1);
+    taosNotifyQset(qset);
+  }
 
   return 0;
 }
@@ -145,6 +159,8 @@ int taosReadQitem(taos_queue param, int *type, void **pitem) {
 
   pthread_mutex_lock(&queue->mutex);
 
+  if (queue->head == NULL) taosCollectQitems(queue);
+
   if (queue->head) {
       pNode = queue->head;
       *pitem = pNode->item;
@@ -152,10 +168,12 @@ int taosReadQitem(taos_queue param, int *type, void **pitem) {
       queue->head = pNode->next;
       if (queue->head == NULL) 
         queue->tail = NULL;
-      queue->numOfItems--;
-      if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, 1);
+      queue->numOfReady--;
+      int32_t numOfItems = atomic_sub_fetch_32(&queue->numOfItems, 1);
+      STaosQset *qset = atomic_load_ptr(&queue->qset);
+      if (qset) atomic_sub_fetch_32(&qset->numOfItems, 1);
       code = 1;
-      uDebug("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
+      uDebug("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, numOfItems);
   } 
 
   pthread_mutex_unlock(&queue->mutex);
@@ -172,27 +190,35 @@ void taosFreeQall(void *param) {
   free(param);
 }
 
+// move all the items of the queue to qall, the mutex of the queue must be held
+static int taosTakeAllQitems(STaosQueue *queue, STaosQall *qall) {
+  taosCollectQitems(queue);
+  if (queue->head == NULL) return 0;
+
+  memset(qall, 0, sizeof(STaosQall));
+  qall->current = queue->head;
+  qall->start = queue->head;
+  qall->numOfItems = queue->numOfReady;
+  qall->itemSize = queue->itemSize;
+
+  queue->head = NULL;
+  queue->tail = NULL;
+  queue->numOfReady = 0;
+  atomic_sub_fetch_32(&queue->numOfItems, qall->numOfItems);
+
+  STaosQset *qset = atomic_load_ptr(&queue->qset);
+  if (qset) atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
+
+  return qall->numOfItems;
+}
+
 int taosReadAllQitems(taos_queue param, taos_qall p2) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQall  *qall = (STaosQall *)p2;
   int         code = 0;
 
   pthread_mutex_lock(&queue->mutex);
-
-  if (queue->head) {
-    memset(qall, 0, sizeof(STaosQall));
-    qall->current = queue->head;
-    qall->start = queue->head;
-    qall->numOfItems = queue->numOfItems;
-    qall->itemSize = queue->itemSize;
-    code = qall->numOfItems;
-
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->numOfItems = 0;
-    if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, qall->numOfItems);
-  } 
-
+  code = taosTakeAllQitems(queue, qall);
   pthread_mutex_unlock(&queue->mutex);
   
   return code; 
@@ -263,7 +289,8 @@ void taosCloseQset(taos_qset param) {
 // thread to exit.
 void taosQsetThreadResume(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
-  tsem_post(&qset->sem);
+  atomic_add_fetch_32(&qset->numOfResumes, 1);
+  taosNotifyQset(qset);
 }
 
 int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
@@ -280,8 +307,8 @@ int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
   qset->numOfQueues++;
 
   pthread_mutex_lock(&queue->mutex);
-  atomic_add_fetch_32(&qset->numOfItems, queue->numOfItems);
-  queue->qset = qset;
+  atomic_add_fetch_32(&qset->numOfItems, atomic_load_32(&queue->numOfItems));
+  atomic_store_ptr(&queue->qset, qset);
   pthread_mutex_unlock(&queue->mutex);
 
   pthread_mutex_unlock(&qset->mutex);
@@ -322,8 +349,8 @@ void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
       qset->numOfQueues--;
 
       pthread_mutex_lock(&queue->mutex);
-      atomic_sub_fetch_32(&qset->numOfItems, queue->numOfItems);
-      queue->qset = NULL;
+      atomic_store_ptr(&queue->qset, NULL);
+      atomic_sub_fetch_32(&qset->numOfItems, atomic_load_32(&queue->numOfItems));
       queue->next = NULL;
       pthread_mutex_unlock(&queue->mutex);
     }
@@ -338,44 +365,56 @@ int taosGetQueueNumber(taos_qset param) {
   return ((STaosQset *)param)->numOfQueues;
 }
 
+/*
+ * The readers block only when no item is readable, and they return 0 only for taosQsetThreadResume. A reader takes
+ * the seq before it looks for items, and sleeps only if no item is written or released after that.
+ */
 int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phandle) {
   STaosQset  *qset = (STaosQset *)param;
   STaosQnode *pNode = NULL;
   int         code = 0;
-   
-  tsem_wait(&qset->sem);
 
-  pthread_mutex_lock(&qset->mutex);
+  while (1) {
+    int32_t seq = atomic_load_32(&qset->seq);
 
-  for(int i=0; i<qset->numOfQueues; ++i) {
-    if (qset->current == NULL) 
-      qset->current = qset->head;   
-    STaosQueue *queue = qset->current;
-    if (queue) qset->current = queue->next;
-    if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    pthread_mutex_lock(&qset->mutex);
 
-    pthread_mutex_lock(&queue->mutex);
+    for(int i=0; i<qset->numOfQueues; ++i) {
+      if (qset->current == NULL) 
+        qset->current = qset->head;   
+      STaosQueue *queue = qset->current;
+      if (queue) qset->current = queue->next;
+      if (queue == NULL) break;
+      if (taosQueueIsEmpty(queue)) continue;
 
-    if (queue->head) {
-        pNode = queue->head;
-        *pitem = pNode->item;
-        *type = pNode->type;
-        *phandle = queue->ahandle;
-        queue->head = pNode->next;
-        if (queue->head == NULL) 
-          queue->tail = NULL;
-        queue->numOfItems--;
-        atomic_sub_fetch_32(&qset->numOfItems, 1);
-        code = 1;
-        uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
-    } 
-
-    pthread_mutex_unlock(&queue->mutex);
-    if (pNode) break;
-  }
+      pthread_mutex_lock(&queue->mutex);
 
-  pthread_mutex_unlock(&qset->mutex);
+      if (queue->head == NULL) taosCollectQitems(queue);
+
+      if (queue->head) {
+          pNode = queue->head;
+          *pitem = pNode->item;
+          *type = pNode->type;
+          *phandle = queue->ahandle;
+          queue->head = pNode->next;
+          if (queue->head == NULL) 
+            queue->tail = NULL;
+          queue->numOfReady--;
+          int32_t numOfItems = atomic_sub_fetch_32(&queue->numOfItems, 1);
+          atomic_sub_fetch_32(&qset->numOfItems, 1);
+          code = 1;
+          uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, numOfItems);
+      } 
+
+      pthread_mutex_unlock(&queue->mutex);
+      if (pNode) break;
+    }
+
+    pthread_mutex_unlock(&qset->mutex);
+
+    if (code != 0 || taosConsumeQsetResume(qset)) break;
+    taosWaitQset(qset, seq);
+  }
 
   return code; 
 }
@@ -386,49 +425,162 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
   STaosQall  *qall = (STaosQall *)p2;
   int         code = 0;
 
-  tsem_wait(&qset->sem);
-  pthread_mutex_lock(&qset->mutex);
+  while (1) {
+    int32_t seq = atomic_load_32(&qset->seq);
+
+    pthread_mutex_lock(&qset->mutex);
+
+    for(int i=0; i<qset->numOfQueues; ++i) {
+      if (qset->current == NULL) 
+        qset->current = qset->head;   
+      queue = qset->current;
+      if (queue) qset->current = queue->next;
+      if (queue == NULL) break;
+      if (taosQueueIsEmpty(queue)) continue;
+
+      pthread_mutex_lock(&queue->mutex);
+      code = taosTakeAllQitems(queue, qall);
+      if (code != 0) *phandle = queue->ahandle;
+      pthread_mutex_unlock(&queue->mutex);
 
-  for(int i=0; i<qset->numOfQueues; ++i) {
-    if (qset->current == NULL) 
-      qset->current = qset->head;   
-    queue = qset->current;
-    if (queue) qset->current = queue->next;
-    if (queue == NULL) break;
-    if (queue->head == NULL) continue;
-
-    pthread_mutex_lock(&queue->mutex);
-
-    if (queue->head) {
-      qall->current = queue->head;
-      qall->start = queue->head;
-      qall->numOfItems = queue->numOfItems;
-      qall->itemSize = queue->itemSize;
-      code = qall->numOfItems;
-      *phandle = queue->ahandle;
-          
-      queue->head = NULL;
-      queue->tail = NULL;
-      queue->numOfItems = 0;
-      atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
-      for (int j=1; j<qall->numOfItems; ++j) tsem_wait(&qset->sem);
-    } 
-
-    pthread_mutex_unlock(&queue->mutex);
-
-    if (code != 0) break;  
+      if (code != 0) break;  
+    }
+
+    pthread_mutex_unlock(&qset->mutex);
+
+    if (code != 0 || taosConsumeQsetResume(qset)) break;
+    taosWaitQset(qset, seq);
   }
 
-  pthread_mutex_unlock(&qset->mutex);
   return code;
 }
 
+/*
+ * Read all items from the next queue that is not being processed by other workers, and mark the queue busy, so a
+ * queue shared by multiple workers of a qset is still processed by one thread at a time, and the order of items is
+ * kept. The queue must be released by taosReleaseQueue after the items are processed.
+ *
+ * The items of a busy queue are skipped, the reader sleeps until the queue is released or new items are written.
+ * 0 is returned only by taosQsetThreadResume.
+ */
+int taosAcquireAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle, taos_queue *pqueue) {
+  STaosQset  *qset = (STaosQset *)param;
+  STaosQueue *queue;
+  STaosQall  *qall = (STaosQall *)p2;
+  int         code = 0;
+
+  while (1) {
+    int32_t seq = atomic_load_32(&qset->seq);
+
+    pthread_mutex_lock(&qset->mutex);
+
+    for(int i=0; i<qset->numOfQueues; ++i) {
+      if (qset->current == NULL) 
+        qset->current = qset->head;   
+      queue = qset->current;
+      if (queue) qset->current = queue->next;
+      if (queue == NULL) break;
+      if (queue->busy || taosQueueIsEmpty(queue)) continue;
+
+      pthread_mutex_lock(&queue->mutex);
+      code = taosTakeAllQitems(queue, qall);
+      if (code != 0) {
+        *phandle = queue->ahandle;
+        *pqueue = queue;
+        queue->busy = 1;
+      }
+      pthread_mutex_unlock(&queue->mutex);
+
+      if (code != 0) break;  
+    }
+
+    pthread_mutex_unlock(&qset->mutex);
+
+    if (code != 0 || taosConsumeQsetResume(qset)) break;
+    taosWaitQset(qset, seq);
+  }
+
+  return code;
+}
+
+void taosReleaseQueue(taos_queue param) {
+  STaosQueue *queue = (STaosQueue *)param;
+  STaosQset  *qset = queue->qset;
+  int         pending = 0;
+
+  if (qset) pthread_mutex_lock(&qset->mutex);
+
+  pthread_mutex_lock(&queue->mutex);
+  queue->busy = 0;
+  pending = !taosQueueIsEmpty(queue);
+  pthread_mutex_unlock(&queue->mutex);
+
+  if (qset) pthread_mutex_unlock(&qset->mutex);
+
+  // the items written during processing may have been skipped by other workers, wake up one of them
+  if (qset && pending) taosNotifyQset(qset);
+}
+
 int taosGetQueueItemsNumber(taos_queue param) {
   STaosQueue *queue = (STaosQueue *)param;
-  return queue->numOfItems;
+  return atomic_load_32(&queue->numOfItems);
 }
 
 int taosGetQsetItemsNumber(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
-  return qset->numOfItems;
+  return atomic_load_32(&qset->numOfItems);
+}
+
+// move the items in the inbox to the end of the ordered list, the mutex of the queue must be held
+static void taosCollectQitems(STaosQueue *queue) {
+  STaosQnode *pNode = atomic_exchange_ptr(&queue->inbox, NULL);
+  STaosQnode *pHead = NULL;
+  STaosQnode *pTail = pNode;
+  int32_t     num = 0;
+
+  while (pNode) {
+    STaosQnode *pNext = pNode->next;
+    pNode->next = pHead;
+    pHead = pNode;
+    pNode = pNext;
+    num++;
+  }
+
+  if (pHead == NULL) return;
+
+  if (queue->tail) {
+    queue->tail->next = pHead;
+  } else {
+    queue->head = pHead;
+  }
+
+  queue->tail = pTail;
+  queue->numOfReady += num;
+}
+
+static bool taosQueueIsEmpty(STaosQueue *queue) {
+  return queue->head == NULL && atomic_load_ptr(&queue->inbox) == NULL;
+}
+
+// wake up a sleeping reader, the writers do not make a system call while the readers are busy
+static void taosNotifyQset(STaosQset *qset) {
+  atomic_add_fetch_32(&qset->seq, 1);
+  if (atomic_load_32(&qset->numOfWaiters) > 0) tsem_post(&qset->sem);
+}
+
+static void taosWaitQset(STaosQset *qset, int32_t seq) {
+  atomic_add_fetch_32(&qset->numOfWaiters, 1);
+  if (atomic_load_32(&qset->seq) == seq) tsem_wait(&qset->sem);
+  atomic_sub_fetch_32(&qset->numOfWaiters, 1);
+}
+
+static bool taosConsumeQsetResume(STaosQset *qset) {
+  int32_t num = atomic_load_32(&qset->numOfResumes);
+
+  while (num > 0) {
+    if (atomic_val_compare_exchange_32(&qset->numOfResumes, num, num - 1) == num) return true;
+    num = atomic_load_32(&qset->numOfResumes);
+  }
+
+  return false;
 }
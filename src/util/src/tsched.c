@@ -15,31 +15,60 @@
 
 #include "os.h"
 #include "taosdef.h"
+#include "taoserror.h"
 #include "tutil.h"
 #include "tulog.h"
 #include "tsched.h"
 #include "ttimer.h"
 
 #define DUMP_SCHEDULER_TIME_WINDOW 30000 //every 30sec, take a snap shot of task queue.
+#define TAOS_SCHED_MIN_CAPACITY    16
+
+struct SSchedQueue;
+
+// tasks scheduled to a thread, the owner and the thieves all take the oldest task
+typedef struct {
+  pthread_mutex_t mutex;
+  SSchedMsg *     tasks;
+  int32_t         capacity;
+  int32_t         head;
+  int32_t         num;
+} SSchedDeque;
 
 typedef struct {
+  SSchedDeque         deque;
+  pthread_t           thread;
+  int32_t             workerId;
+  struct SSchedQueue *pSched;
+} SSchedWorker;
+
+typedef struct SSchedQueue {
   char            label[TSDB_LABEL_LEN];
-  tsem_t          emptySem;
-  tsem_t          fullSem;
-  pthread_mutex_t queueMutex;
-  int             fullSlot;
-  int             emptySlot;
   int             queueSize;
   int             numOfThreads;
-  pthread_t *     qthread;
-  SSchedMsg *     queue;
+  int             numOfWorkers;  // workers whose task queue is initialized
+  SSchedWorker *  workers;
   bool            stop;
+  int32_t         nextWorker;    // round robin for the tasks scheduled by other threads
+  int32_t         numOfPending;
+  int32_t         maxPending;
+  int64_t         numOfTasks;
+  int64_t         numOfSteals;
+  int64_t         numOfOverflows;
+  int32_t         seq;           // bumped when a task is scheduled, idle threads sleep only if it does not change
+  int32_t         numOfWaiters;  // idle threads sleeping on sem
+  tsem_t          sem;
   void*           pTmrCtrl;
   void*           pTimer;
 } SSchedQueue;
 
+// the worker of the current thread, the tasks scheduled by a task are kept in the same thread
+static threadlocal SSchedWorker *tsSchedWorker = NULL;
+
 static void *taosProcessSchedQueue(void *param);
 static void taosDumpSchedulerStatus(void *qhandle, void *tmrId);
+static int  taosPushSchedTask(SSchedDeque *pDeque, SSchedMsg *pMsg);
+static bool taosPopSchedTask(SSchedDeque *pDeque, SSchedMsg *pMsg);
 
 void *taosInitScheduler(int queueSize, int numOfThreads, const char *label) {
   SSchedQueue *pSched = (SSchedQueue *)calloc(sizeof(SSchedQueue), 1);
@@ -48,50 +77,48 @@ void *taosInitScheduler(int queueSize, int numOfThreads, const char *label) {
     return NULL;
   }
 
-  pSched->queue = (SSchedMsg *)calloc(sizeof(SSchedMsg), queueSize);
-  if (pSched->queue == NULL) {
-    uError("%s: no enough memory for queue", label);
-    taosCleanUpScheduler(pSched);
-    return NULL;
-  }
-
-  pSched->qthread = calloc(sizeof(pthread_t), numOfThreads);
-  if (pSched->qthread == NULL) {
-    uError("%s: no enough memory for qthread", label);
-    taosCleanUpScheduler(pSched);
+  pSched->workers = (SSchedWorker *)calloc(sizeof(SSchedWorker), numOfThreads);
+  if (pSched->workers == NULL) {
+    uError("%s: no enough memory for workers", label);
+    free(pSched);
     return NULL;
   }
 
   pSched->queueSize = queueSize;
   tstrncpy(pSched->label, label, sizeof(pSched->label)); // fix buffer overflow
 
-  pSched->fullSlot = 0;
-  pSched->emptySlot = 0;
-
-  if (pthread_mutex_init(&pSched->queueMutex, NULL) < 0) {
-    uError("init %s:queueMutex failed(%s)", label, strerror(errno));
-    taosCleanUpScheduler(pSched);
+  if (tsem_init(&pSched->sem, 0, 0) != 0) {
+    uError("init %s:semaphore failed(%s)", label, strerror(errno));
+    free(pSched->workers);
+    free(pSched);
     return NULL;
   }
 
-  if (tsem_init(&pSched->emptySem, 0, (unsigned int)pSched->queueSize) != 0) {
-    uError("init %s:empty semaphore failed(%s)", label, strerror(errno));
-    taosCleanUpScheduler(pSched);
-    return NULL;
-  }
-
-  if (tsem_init(&pSched->fullSem, 0, 0) != 0) {
-    uError("init %s:full semaphore failed(%s)", label, strerror(errno));
-    taosCleanUpScheduler(pSched);
-    return NULL;
+  int32_t capacity = MAX(queueSize / MAX(numOfThreads, 1), TAOS_SCHED_MIN_CAPACITY);
+  for (int i = 0; i < numOfThreads; ++i) {
+    SSchedWorker *pWorker = pSched->workers + i;
+    pWorker->workerId = i;
+    pWorker->pSched = pSched;
+
+    SSchedDeque *pDeque = &pWorker->deque;
+    pDeque->tasks = (SSchedMsg *)calloc(sizeof(SSchedMsg), capacity);
+    if (pDeque->tasks == NULL) {
+      uError("%s: no enough memory for queue", label);
+      taosCleanUpScheduler(pSched);
+      return NULL;
+    }
+    pDeque->capacity = capacity;
+    pthread_mutex_init(&pDeque->mutex, NULL);
+    ++pSched->numOfWorkers;
   }
 
   pSched->stop = false;
   for (int i = 0; i < numOfThreads; ++i) {
+    SSchedWorker *pWorker = pSched->workers + i;
     pthread_attr_t attr;
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    int code = pthread_create(pSched->qthread + i, &attr, taosProcessSchedQueue, (void *)pSched);
+    int code = pthread_create(&pWorker->thread, &attr, taosProcessSchedQueue, (void *)pWorker);
     pthread_attr_destroy(&attr);
     if (code != 0) {
       uError("%s: failed to create rpc thread(%s)", label, strerror(errno));
@@ -117,35 +144,51 @@ void *taosInitSchedulerWithInfo(int queueSize, int numOfThreads, const char *lab
   return pSched;
 }
 
+// take a task from the queue of the worker first, and then from the other workers
+static bool taosGetSchedTask(SSchedWorker *pWorker, SSchedMsg *pMsg) {
+  SSchedQueue *pSched = pWorker->pSched;
+
+  if (taosPopSchedTask(&pWorker->deque, pMsg)) return true;
+
+  for (int i = 1; i < pSched->numOfWorkers; ++i) {
+    SSchedWorker *pVictim = pSched->workers + (pWorker->workerId + i) % pSched->numOfWorkers;
+    if (taosPopSchedTask(&pVictim->deque, pMsg)) {
+      atomic_add_fetch_64(&pSched->numOfSteals, 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void *taosProcessSchedQueue(void *param) {
-  SSchedMsg    msg;
-  SSchedQueue *pSched = (SSchedQueue *)param;
+  SSchedMsg     msg;
+  SSchedWorker *pWorker = (SSchedWorker *)param;
+  SSchedQueue * pSched = pWorker->pSched;
+
+  tsSchedWorker = pWorker;
 
   while (1) {
-    if (tsem_wait(&pSched->fullSem) != 0) {
-      if (errno == EINTR) {
-        /* sem_wait is interrupted by interrupt, ignore and continue */
-        uDebug("wait %s fullSem was interrupted", pSched->label);
-        continue;
-      }
-      uError("wait %s fullSem failed(%s)", pSched->label, strerror(errno));
-    }
+    int32_t seq = atomic_load_32(&pSched->seq);
+
     if (pSched->stop) {
       break;
     }
 
-    if (pthread_mutex_lock(&pSched->queueMutex) != 0)
-      uError("lock %s queueMutex failed(%s)", pSched->label, strerror(errno));
-
-    msg = pSched->queue[pSched->fullSlot];
-    memset(pSched->queue + pSched->fullSlot, 0, sizeof(SSchedMsg));
-    pSched->fullSlot = (pSched->fullSlot + 1) % pSched->queueSize;
-
-    if (pthread_mutex_unlock(&pSched->queueMutex) != 0)
-      uError("unlock %s queueMutex failed(%s)", pSched->label, strerror(errno));
+    if (!taosGetSchedTask(pWorker, &msg)) {
+      atomic_add_fetch_32(&pSched->numOfWaiters, 1);
+      if (atomic_load_32(&pSched->seq) == seq && !pSched->stop) {
+        while (tsem_wait(&pSched->sem) != 0 && errno == EINTR) {
+          /* sem_wait is interrupted by interrupt, ignore and continue */
+          uDebug("wait %s sem was interrupted", pSched->label);
+        }
+      }
+      atomic_sub_fetch_32(&pSched->numOfWaiters, 1);
+      continue;
+    }
 
-    if (tsem_post(&pSched->emptySem) != 0)
-      uError("post %s emptySem failed(%s)", pSched->label, strerror(errno));
+    atomic_sub_fetch_32(&pSched->numOfPending, 1);
+    atomic_add_fetch_64(&pSched->numOfTasks, 1);
 
     if (msg.fp)
       (*(msg.fp))(&msg);
@@ -153,6 +196,7 @@ void *taosProcessSchedQueue(void *param) {
       (*(msg.tfp))(msg.ahandle, msg.thandle);
   }
 
+  tsSchedWorker = NULL;
   return NULL;
 }
 
@@ -163,55 +207,89 @@ int taosScheduleTask(void *qhandle, SSchedMsg *pMsg) {
     return 0;
   }
 
-  while (tsem_wait(&pSched->emptySem) != 0) {
-    if (errno != EINTR) {
-      uError("wait %s emptySem failed(%s)", pSched->label, strerror(errno));
-      break;
-    }
-    uDebug("wait %s emptySem was interrupted", pSched->label);
+  SSchedWorker *pWorker = tsSchedWorker;
+  if (pWorker == NULL || pWorker->pSched != pSched) {
+    uint32_t index = (uint32_t)atomic_fetch_add_32(&pSched->nextWorker, 1);
+    pWorker = pSched->workers + index % pSched->numOfWorkers;
   }
 
-  if (pthread_mutex_lock(&pSched->queueMutex) != 0)
-    uError("lock %s queueMutex failed(%s)", pSched->label, strerror(errno));
+  int32_t numOfPending = atomic_add_fetch_32(&pSched->numOfPending, 1);
+  if (taosPushSchedTask(&pWorker->deque, pMsg) != 0) {
+    atomic_sub_fetch_32(&pSched->numOfPending, 1);
+    uError("%s: no enough memory to schedule msg:%p", pSched->label, pMsg);
+    terrno = TSDB_CODE_COM_OUT_OF_MEMORY;
+    return -1;
+  }
 
-  pSched->queue[pSched->emptySlot] = *pMsg;
-  pSched->emptySlot = (pSched->emptySlot + 1) % pSched->queueSize;
+  // the producers are not blocked any more, the pressure is reported instead
+  int32_t maxPending = atomic_load_32(&pSched->maxPending);
+  while (numOfPending > maxPending) {
+    int32_t old = atomic_val_compare_exchange_32(&pSched->maxPending, maxPending, numOfPending);
+    if (old == maxPending) break;
+    maxPending = old;
+  }
 
-  if (pthread_mutex_unlock(&pSched->queueMutex) != 0)
-    uError("unlock %s queueMutex failed(%s)", pSched->label, strerror(errno));
+  if (numOfPending > pSched->queueSize) {
+    if (atomic_add_fetch_64(&pSched->numOfOverflows, 1) == 1) {
+      uWarn("%s: pending tasks:%d exceed the queue size:%d", pSched->label, numOfPending, pSched->queueSize);
+    }
+  }
 
-  if (tsem_post(&pSched->fullSem) != 0) 
-    uError("post %s fullSem failed(%s)", pSched->label, strerror(errno));
+  atomic_add_fetch_32(&pSched->seq, 1);
+  if (atomic_load_32(&pSched->numOfWaiters) > 0) {
+    if (tsem_post(&pSched->sem) != 0) 
+      uError("post %s sem failed(%s)", pSched->label, strerror(errno));
+  }
 
   return 0;
 }
 
+void taosGetSchedulerStatus(void *qhandle, SSchedStatus *pStatus) {
+  SSchedQueue *pSched = (SSchedQueue *)qhandle;
+
+  memset(pStatus, 0, sizeof(SSchedStatus));
+  if (pSched == NULL) return;
+
+  pStatus->numOfThreads = pSched->numOfThreads;
+  pStatus->numOfPending = atomic_load_32(&pSched->numOfPending);
+  pStatus->maxPending = atomic_load_32(&pSched->maxPending);
+  pStatus->numOfTasks = atomic_load_64(&pSched->numOfTasks);
+  pStatus->numOfSteals = atomic_load_64(&pSched->numOfSteals);
+  pStatus->numOfOverflows = atomic_load_64(&pSched->numOfOverflows);
+}
+
 void taosCleanUpScheduler(void *param) {
   SSchedQueue *pSched = (SSchedQueue *)param;
   if (pSched == NULL) return;
 
   pSched->stop = true;
+  atomic_add_fetch_32(&pSched->seq, 1);
   for (int i = 0; i < pSched->numOfThreads; ++i) {
-  if (taosCheckPthreadValid(pSched->qthread[i])) {
-      tsem_post(&pSched->fullSem);
+    if (taosCheckPthreadValid(pSched->workers[i].thread)) {
+      tsem_post(&pSched->sem);
     }
   }
   for (int i = 0; i < pSched->numOfThreads; ++i) {
-    if (taosCheckPthreadValid(pSched->qthread[i])) {
-      pthread_join(pSched->qthread[i], NULL);
+    if (taosCheckPthreadValid(pSched->workers[i].thread)) {
+      pthread_join(pSched->workers[i].thread, NULL);
     }
   }
 
-  tsem_destroy(&pSched->emptySem);
-  tsem_destroy(&pSched->fullSem);
-  pthread_mutex_destroy(&pSched->queueMutex);
+  tsem_destroy(&pSched->sem);
   
   if (pSched->pTimer) {
     taosTmrStopA(&pSched->pTimer);
   }
 
-  if (pSched->queue) free(pSched->queue);
-  if (pSched->qthread) free(pSched->qthread);
+  if (pSched->workers) {
+    // only the workers before the failed one are initialized if the scheduler is not created
+    for (int i = 0; i < pSched->numOfWorkers; ++i) {
+      pthread_mutex_destroy(&pSched->workers[i].deque.mutex);
+      taosTFree(pSched->workers[i].deque.tasks);
+    }
+    free(pSched->workers);
+  }
+
   free(pSched); // fix memory leak
 }
 
@@ -222,10 +300,59 @@ void taosDumpSchedulerStatus(void *qhandle, void *tmrId) {
     return;
   }
   
-  int32_t size = ((pSched->emptySlot - pSched->fullSlot) + pSched->queueSize) % pSched->queueSize;
-  if (size > 0) {
-    uDebug("scheduler:%s, current tasks in queue:%d, task thread:%d", pSched->label, size, pSched->numOfThreads);
+  SSchedStatus status;
+  taosGetSchedulerStatus(pSched, &status);
+  if (status.numOfPending > 0) {
+    uDebug("scheduler:%s, current tasks in queue:%d, task thread:%d, max pending:%d steals:%" PRId64
+           " overflows:%" PRId64,
+           pSched->label, status.numOfPending, status.numOfThreads, status.maxPending, status.numOfSteals,
+           status.numOfOverflows);
   }
   
   taosTmrReset(taosDumpSchedulerStatus, DUMP_SCHEDULER_TIME_WINDOW, pSched, pSched->pTmrCtrl, &pSched->pTimer);
 }
+
+static int taosPushSchedTask(SSchedDeque *pDeque, SSchedMsg *pMsg) {
+  pthread_mutex_lock(&pDeque->mutex);
+
+  if (pDeque->num == pDeque->capacity) {
+    int32_t    capacity = pDeque->capacity * 2;
+    SSchedMsg *tasks = (SSchedMsg *)calloc(sizeof(SSchedMsg), capacity);
+    if (tasks == NULL) {
+      pthread_mutex_unlock(&pDeque->mutex);
+      return -1;
+    }
+
+    for (int32_t i = 0; i < pDeque->num; ++i) {
+      tasks[i] = pDeque->tasks[(pDeque->head + i) % pDeque->capacity];
+    }
+
+    free(pDeque->tasks);
+    pDeque->tasks = tasks;
+    pDeque->capacity = capacity;
+    pDeque->head = 0;
+  }
+
+  pDeque->tasks[(pDeque->head + pDeque->num) % pDeque->capacity] = *pMsg;
+  atomic_add_fetch_32(&pDeque->num, 1);
+
+  pthread_mutex_unlock(&pDeque->mutex);
+  return 0;
+}
+
+static bool taosPopSchedTask(SSchedDeque *pDeque, SSchedMsg *pMsg) {
+  if (atomic_load_32(&pDeque->num) == 0) return false;
+
+  bool found = false;
+  pthread_mutex_lock(&pDeque->mutex);
+
+  if (pDeque->num > 0) {
+    *pMsg = pDeque->tasks[pDeque->head];
+    pDeque->head = (pDeque->head + 1) % pDeque->capacity;
+    atomic_sub_fetch_32(&pDeque->num, 1);
+    found = true;
+  }
+
+  pthread_mutex_unlock(&pDeque->mutex);
+  return found;
+}
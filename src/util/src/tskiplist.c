@@ -48,16 +48,14 @@ static FORCE_INLINE int32_t getSkipListNodeRandomHeight(SSkipList *pSkipList) {
 
 static FORCE_INLINE int32_t getSkipListRandLevel(SSkipList *pSkipList) {
   int32_t level = getSkipListNodeRandomHeight(pSkipList);
-  if (pSkipList->size == 0) {
-    level = 1;
-    pSkipList->level = 1;
-  } else {
-    if (level > pSkipList->level) {
-      if (pSkipList->level < pSkipList->maxLevel) {
-        level = (++pSkipList->level);
-      } else {
-        level = pSkipList->level;
-      }
+
+  // the level of the skip list grows by one at most. The size is not checked, since a batch of nodes is created
+  // before any of them is put, and the nodes would all get level 1 if they go to an empty skip list.
+  if (level > pSkipList->level) {
+    if (pSkipList->level < pSkipList->maxLevel) {
+      level = (++pSkipList->level);
+    } else {
+      level = pSkipList->level;
     }
   }
   
@@ -288,6 +286,110 @@ SSkipListNode *tSkipListPut(SSkipList *pSkipList, SSkipListNode *pNode) {
 
 
 
+int32_t tSkipListPutBatch(SSkipList *pSkipList, SSkipListNode **pNodes, int32_t num) {
+  if (pSkipList == NULL || pNodes == NULL || num <= 0) {
+    return 0;
+  }
+
+  if (pSkipList->lock) {
+    pthread_rwlock_wrlock(pSkipList->lock);
+  }
+
+  // forward[i] is the last node at level i whose key is less than (or equal to, if duplicated keys are allowed) the key
+  // of the node being inserted
+  SSkipListNode *forward[MAX_SKIP_LIST_LEVEL] = {0};
+  for (int32_t i = 0; i < pSkipList->level; ++i) {
+    forward[i] = pSkipList->pHead;
+  }
+
+  int32_t numOfInserted = 0;
+  for (int32_t n = 0; n < num; ++n) {
+    SSkipListNode *pNode = pNodes[n];
+    char *         newDatakey = SL_GET_NODE_KEY(pSkipList, pNode);
+
+    // the key is greater than the maximum key, the node is appended at the tail and the fingers keep valid
+    if (pSkipList->size + numOfInserted == 0 || pSkipList->comparFn(SL_GET_SL_MAX_KEY(pSkipList), newDatakey) < 0) {
+      DO_MEMSET_PTR_AREA(pNode);
+      for (int32_t i = 0; i < pNode->level; ++i) {
+        SSkipListNode *prev = SL_GET_BACKWARD_POINTER(pSkipList->pTail, i);
+
+        SL_GET_FORWARD_POINTER(prev, i) = pNode;
+        SL_GET_FORWARD_POINTER(pNode, i) = pSkipList->pTail;
+        SL_GET_BACKWARD_POINTER(pNode, i) = prev;
+        SL_GET_BACKWARD_POINTER(pSkipList->pTail, i) = pNode;
+        forward[i] = pNode;
+      }
+
+      pNodes[n] = NULL;
+      numOfInserted++;
+      continue;
+    }
+
+    // the run is not sorted, search from the head again. If duplicated keys are allowed, the node of an equal key
+    // stays a valid finger, so a sorted run of duplicated keys is linked one after another.
+    if (forward[0] != pSkipList->pHead) {
+      int32_t fret = pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, forward[0]), newDatakey);
+      if (fret > 0 || (fret == 0 && pSkipList->keyInfo.dupKey == 0)) {
+        for (int32_t i = 0; i < pSkipList->level; ++i) {
+          forward[i] = pSkipList->pHead;
+        }
+      }
+    }
+
+    // at each level, go on from the node found by the previous key or by the upper level, whichever is closer
+    SSkipListNode *px = pSkipList->pHead;
+    int32_t        ret = -1;
+    for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
+      if (px == pSkipList->pHead || (forward[i] != pSkipList->pHead &&
+                                     pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, forward[i]),
+                                                         SL_GET_NODE_KEY(pSkipList, px)) > 0)) {
+        px = forward[i];
+      }
+
+      SSkipListNode *p = SL_GET_FORWARD_POINTER(px, i);
+      while (p != pSkipList->pTail) {
+        ret = pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, p), newDatakey);
+        if (ret < 0) {
+          px = p;
+          p = SL_GET_FORWARD_POINTER(px, i);
+        } else {
+          break;
+        }
+      }
+
+      forward[i] = px;
+      ret = (p == pSkipList->pTail) ? -1 : ret;
+    }
+
+    if (pSkipList->keyInfo.dupKey == 0 && ret == 0) {
+      continue;
+    }
+
+    DO_MEMSET_PTR_AREA(pNode);
+    for (int32_t i = 0; i < pNode->level; ++i) {
+      SSkipListNode *x = forward[i];
+      SSkipListNode *next = SL_GET_FORWARD_POINTER(x, i);
+
+      SL_GET_BACKWARD_POINTER(pNode, i) = x;
+      SL_GET_FORWARD_POINTER(pNode, i) = next;
+      SL_GET_BACKWARD_POINTER(next, i) = pNode;
+      SL_GET_FORWARD_POINTER(x, i) = pNode;
+
+      forward[i] = pNode;
+    }
+
+    pNodes[n] = NULL;
+    numOfInserted++;
+  }
+
+  atomic_add_fetch_32(&pSkipList->size, numOfInserted);
+  if (pSkipList->lock) {
+    pthread_rwlock_unlock(pSkipList->lock);
+  }
+
+  return numOfInserted;
+}
+
 SArray* tSkipListGet(SSkipList *pSkipList, SSkipListKey key) {
   SArray* sa = taosArrayInit(1, POINTER_BYTES);
 
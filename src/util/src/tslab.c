@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tulog.h"
+#include "tslab.h"
+
+#define TAOS_SLAB_MIN_SHIFT    6                // the smallest size class is 64 bytes
+#define TAOS_SLAB_CLASSES      11               // blocks of 64 bytes to 64KB are pooled, the larger ones are not
+#define TAOS_SLAB_CACHE_BYTES  (256 * 1024)     // max bytes of a size class cached by one thread
+#define TAOS_SLAB_CACHE_MIN    4                // min blocks of a size class cached by one thread
+#define TAOS_SLAB_CACHE_MAX    64               // max blocks of a size class cached by one thread
+#define TAOS_SLAB_POOL_BYTES   (2 * 1024 * 1024)  // max bytes of a size class kept in the global pool
+
+#define TAOS_SLAB_CLASS_SIZE(c) (1 << (TAOS_SLAB_MIN_SHIFT + (c)))
+
+typedef struct SSlabNode {
+  int32_t  size;    // size requested by the module
+  int8_t   sclass;  // size class of the block, -1 if it is not pooled
+  int8_t   module;
+  int16_t  reserved;
+  union {
+    struct SSlabNode *next;  // link of the free lists, the data of a free block is not used
+    char              data[0];
+  };
+} SSlabNode;
+
+#define TAOS_SLAB_HEAD_SIZE ((int32_t)offsetof(SSlabNode, data))
+
+typedef struct {
+  pthread_mutex_t  mutex;
+  SSlabNode       *head;
+  int32_t          num;
+} SSlabPool;
+
+typedef struct SSlabCache {
+  SSlabNode         *head[TAOS_SLAB_CLASSES];
+  int32_t            num[TAOS_SLAB_CLASSES];
+  int64_t            liveBytes[TAOS_SLAB_MAX_MODULES];  // allocated minus freed by this thread, may be negative
+  struct SSlabCache *prev;
+  struct SSlabCache *next;
+} SSlabCache;
+
+static const char *tsSlabModuleNames[TAOS_SLAB_MAX_MODULES] = {"rpc", "queue"};
+
+static SSlabPool               tsSlabPool[TAOS_SLAB_CLASSES];
+static pthread_once_t          tsSlabInit = PTHREAD_ONCE_INIT;
+static pthread_key_t           tsSlabCacheKey;
+static threadlocal SSlabCache *tsSlabCache = NULL;
+
+// the caches are registered for the statistics, the bytes of the exited threads are kept in tsSlabRetiredBytes
+static pthread_mutex_t tsSlabCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static SSlabCache *    tsSlabCaches = NULL;
+static int64_t         tsSlabRetiredBytes[TAOS_SLAB_MAX_MODULES];
+
+static void taosFreeSlabNodes(SSlabNode *pNode) {
+  while (pNode) {
+    SSlabNode *pNext = pNode->next;
+    free(pNode);
+    pNode = pNext;
+  }
+}
+
+// the blocks are moved between the thread cache and the global pool in batch, so the pool mutex is seldom taken
+static void taosMoveSlabNodes(SSlabNode **pFrom, int32_t *fromNum, SSlabNode **pTo, int32_t *toNum, int32_t num) {
+  for (int32_t i = 0; i < num && *pFrom != NULL; ++i) {
+    SSlabNode *pNode = *pFrom;
+    *pFrom = pNode->next;
+    pNode->next = *pTo;
+    *pTo = pNode;
+    (*fromNum)--;
+    (*toNum)++;
+  }
+}
+
+// move the blocks into the global pool, the ones beyond its limit are freed
+static void taosReturnSlabNodes(int8_t sclass, SSlabNode *pNode, int32_t num) {
+  SSlabPool *pPool = tsSlabPool + sclass;
+  int32_t    maxNum = TAOS_SLAB_POOL_BYTES / TAOS_SLAB_CLASS_SIZE(sclass);
+
+  pthread_mutex_lock(&pPool->mutex);
+  if (pPool->num < maxNum) taosMoveSlabNodes(&pNode, &num, &pPool->head, &pPool->num, maxNum - pPool->num);
+  pthread_mutex_unlock(&pPool->mutex);
+
+  taosFreeSlabNodes(pNode);
+}
+
+static void taosFreeSlabCache(void *param) {
+  SSlabCache *pCache = (SSlabCache *)param;
+
+  for (int8_t c = 0; c < TAOS_SLAB_CLASSES; ++c) {
+    taosReturnSlabNodes(c, pCache->head[c], pCache->num[c]);
+  }
+
+  pthread_mutex_lock(&tsSlabCacheMutex);
+  for (int32_t m = 0; m < TAOS_SLAB_MAX_MODULES; ++m) {
+    tsSlabRetiredBytes[m] += pCache->liveBytes[m];
+  }
+
+  if (pCache->prev) {
+    pCache->prev->next = pCache->next;
+  } else {
+    tsSlabCaches = pCache->next;
+  }
+  if (pCache->next) pCache->next->prev = pCache->prev;
+  pthread_mutex_unlock(&tsSlabCacheMutex);
+
+  free(pCache);
+  tsSlabCache = NULL;
+}
+
+static void taosInitSlab() {
+  for (int32_t c = 0; c < TAOS_SLAB_CLASSES; ++c) {
+    pthread_mutex_init(&tsSlabPool[c].mutex, NULL);
+  }
+
+  pthread_key_create(&tsSlabCacheKey, taosFreeSlabCache);
+}
+
+static SSlabCache *taosGetSlabCache() {
+  if (tsSlabCache != NULL) return tsSlabCache;
+
+  pthread_once(&tsSlabInit, taosInitSlab);
+
+  SSlabCache *pCache = (SSlabCache *)calloc(1, sizeof(SSlabCache));
+  if (pCache == NULL) return NULL;
+
+  pthread_mutex_lock(&tsSlabCacheMutex);
+  pCache->next = tsSlabCaches;
+  if (tsSlabCaches) tsSlabCaches->prev = pCache;
+  tsSlabCaches = pCache;
+  pthread_mutex_unlock(&tsSlabCacheMutex);
+
+  pthread_setspecific(tsSlabCacheKey, pCache);
+  tsSlabCache = pCache;
+  return pCache;
+}
+
+static int8_t taosGetSlabClass(int32_t nodeSize) {
+  for (int8_t c = 0; c < TAOS_SLAB_CLASSES; ++c) {
+    if (nodeSize <= TAOS_SLAB_CLASS_SIZE(c)) return c;
+  }
+
+  return -1;
+}
+
+static FORCE_INLINE int32_t taosGetSlabCacheSize(int8_t sclass) {
+  int32_t num = TAOS_SLAB_CACHE_BYTES / TAOS_SLAB_CLASS_SIZE(sclass);
+  return MIN(MAX(num, TAOS_SLAB_CACHE_MIN), TAOS_SLAB_CACHE_MAX);
+}
+
+static void taosAccountSlab(SSlabCache *pCache, int8_t module, int64_t bytes) {
+  if (pCache != NULL) {
+    pCache->liveBytes[module] += bytes;
+  } else {
+    atomic_add_fetch_64(&tsSlabRetiredBytes[module], bytes);
+  }
+}
+
+void *taosSlabMalloc(int8_t module, int32_t size) {
+  int32_t     nodeSize = TAOS_SLAB_HEAD_SIZE + size;
+  int8_t      sclass = taosGetSlabClass(nodeSize);
+  SSlabCache *pCache = taosGetSlabCache();
+  SSlabNode * pNode = NULL;
+
+  assert(module >= 0 && module < TAOS_SLAB_MAX_MODULES && size >= 0);
+
+  if (sclass >= 0) {
+    if (pCache != NULL) {
+      if (pCache->head[sclass] == NULL) {
+        SSlabPool *pPool = tsSlabPool + sclass;
+        pthread_mutex_lock(&pPool->mutex);
+        taosMoveSlabNodes(&pPool->head, &pPool->num, &pCache->head[sclass], &pCache->num[sclass],
+                          taosGetSlabCacheSize(sclass) / 2);
+        pthread_mutex_unlock(&pPool->mutex);
+      }
+
+      pNode = pCache->head[sclass];
+      if (pNode != NULL) {
+        pCache->head[sclass] = pNode->next;
+        pCache->num[sclass]--;
+        memset(pNode, 0, nodeSize);
+      }
+    }
+
+    if (pNode == NULL) pNode = (SSlabNode *)calloc(1, TAOS_SLAB_CLASS_SIZE(sclass));
+  } else {
+    pNode = (SSlabNode *)calloc(1, nodeSize);
+  }
+
+  if (pNode == NULL) return NULL;
+
+  pNode->size = size;
+  pNode->sclass = sclass;
+  pNode->module = module;
+  taosAccountSlab(pCache, module, size);
+
+  return pNode->data;
+}
+
+void taosSlabFree(void *ptr) {
+  if (ptr == NULL) return;
+
+  SSlabNode * pNode = (SSlabNode *)((char *)ptr - TAOS_SLAB_HEAD_SIZE);
+  int8_t      sclass = pNode->sclass;
+  SSlabCache *pCache = taosGetSlabCache();
+
+  taosAccountSlab(pCache, pNode->module, -pNode->size);
+
+  if (sclass < 0 || pCache == NULL) {
+    free(pNode);
+    return;
+  }
+
+  pNode->next = pCache->head[sclass];
+  pCache->head[sclass] = pNode;
+  pCache->num[sclass]++;
+
+  // the buffers are usually allocated by the RPC threads and freed by the workers, return half of them to the pool
+  int32_t cacheSize = taosGetSlabCacheSize(sclass);
+  if (pCache->num[sclass] > cacheSize) {
+    SSlabNode *pFree = NULL;
+    int32_t    numOfFree = 0;
+
+    taosMoveSlabNodes(&pCache->head[sclass], &pCache->num[sclass], &pFree, &numOfFree, pCache->num[sclass] - cacheSize / 2);
+    taosReturnSlabNodes(sclass, pFree, numOfFree);
+  }
+}
+
+void *taosSlabRealloc(int8_t module, void *ptr, int32_t size) {
+  if (ptr == NULL) return taosSlabMalloc(module, size);
+
+  if (size == 0) {
+    taosSlabFree(ptr);
+    return NULL;
+  }
+
+  SSlabNode *pNode = (SSlabNode *)((char *)ptr - TAOS_SLAB_HEAD_SIZE);
+  int32_t    nodeSize = TAOS_SLAB_HEAD_SIZE + size;
+
+  // the block is large enough, or it is not pooled and it is resized by realloc
+  if (pNode->sclass >= 0 && nodeSize <= TAOS_SLAB_CLASS_SIZE(pNode->sclass)) {
+    taosAccountSlab(taosGetSlabCache(), pNode->module, (int64_t)size - pNode->size);
+    pNode->size = size;
+    return ptr;
+  }
+
+  if (pNode->sclass < 0 && taosGetSlabClass(nodeSize) < 0) {
+    int32_t    oldSize = pNode->size;
+    SSlabNode *pNew = (SSlabNode *)realloc(pNode, nodeSize);
+    if (pNew == NULL) return NULL;
+
+    pNew->size = size;
+    taosAccountSlab(taosGetSlabCache(), pNew->module, (int64_t)size - oldSize);
+    return pNew->data;
+  }
+
+  void *pNew = taosSlabMalloc(pNode->module, size);
+  if (pNew == NULL) return NULL;
+
+  memcpy(pNew, ptr, MIN(size, pNode->size));
+  taosSlabFree(ptr);
+  return pNew;
+}
+
+void taosSlabGetStatis(SSlabStatis *pStatis) {
+  memset(pStatis, 0, sizeof(SSlabStatis));
+
+  pthread_mutex_lock(&tsSlabCacheMutex);
+  for (int32_t m = 0; m < TAOS_SLAB_MAX_MODULES; ++m) {
+    pStatis->liveBytes[m] = atomic_load_64(&tsSlabRetiredBytes[m]);
+  }
+
+  // the counters of other threads are read without lock, the result is an estimation
+  for (SSlabCache *pCache = tsSlabCaches; pCache != NULL; pCache = pCache->next) {
+    for (int32_t m = 0; m < TAOS_SLAB_MAX_MODULES; ++m) {
+      pStatis->liveBytes[m] += pCache->liveBytes[m];
+    }
+  }
+  pthread_mutex_unlock(&tsSlabCacheMutex);
+
+  for (int32_t c = 0; c < TAOS_SLAB_CLASSES; ++c) {
+    pStatis->pooledBytes += (int64_t)atomic_load_32(&tsSlabPool[c].num) * TAOS_SLAB_CLASS_SIZE(c);
+  }
+}
+
+const char *taosSlabModuleName(int8_t module) {
+  if (module < 0 || module >= TAOS_SLAB_MAX_MODULES) return "unknown";
+  return tsSlabModuleNames[module];
+}
@@ -286,9 +286,16 @@ static void addToExpired(tmr_obj_t* head) {
     schedMsg.msg = NULL;
     schedMsg.ahandle = head;
     schedMsg.thandle = NULL;
-    taosScheduleTask(tmrQhandle, &schedMsg);
+    if (taosScheduleTask(tmrQhandle, &schedMsg) != 0) {
+      // the timer is put back to the wheel and fired by the next scan, instead of being lost
+      tmrError("%s timer[id=%" PRIuPTR "] failed to be added to queue since no enough memory, retry later",
+               head->ctrl->label, id);
+      addToWheel(head, wheels[0].resolution);
+      timerDecRef(head);
+    } else {
+      tmrDebug("timer[id=%" PRIuPTR "] has been added to queue.", id);
+    }
 
-    tmrDebug("timer[id=%" PRIuPTR "] has been added to queue.", id);
     head = next;
   }
 }
@@ -0,0 +1,44 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tarena.h"
+
+// the small buffers are bumped from the chunks, the large ones take chunks of their own
+TEST(testCase, arena_alloc) {
+  SArena *pArena = taosArenaInit(1024);
+  ASSERT_TRUE(pArena != NULL);
+
+  char *p1 = (char *)taosArenaMalloc(pArena, 10);
+  char *p2 = (char *)taosArenaMalloc(pArena, 10);
+  ASSERT_TRUE(p1 != NULL && p2 != NULL);
+  EXPECT_EQ(p2 - p1, 16);
+  EXPECT_EQ((uint64_t)p2 % 8, 0u);
+  EXPECT_EQ(pArena->totalBytes, 1024u);
+
+  // the large buffer does not waste the space left in the current chunk
+  char *pLarge = (char *)taosArenaMalloc(pArena, 4096);
+  ASSERT_TRUE(pLarge != NULL);
+  memset(pLarge, 1, 4096);
+  char *p3 = (char *)taosArenaMalloc(pArena, 8);
+  EXPECT_EQ(p3 - p2, 16);
+
+  for (int32_t i = 0; i < 1000; ++i) {
+    int64_t *p = (int64_t *)taosArenaCalloc(pArena, 4, sizeof(int64_t));
+    ASSERT_TRUE(p != NULL);
+    for (int32_t j = 0; j < 4; ++j) {
+      ASSERT_EQ(p[j], 0);
+    }
+    memset(p, 0xFF, 4 * sizeof(int64_t));
+  }
+  EXPECT_EQ(pArena->allocBytes, 16u + 16u + 4096u + 8u + 1000u * 32u);
+  EXPECT_GE(pArena->totalBytes, pArena->allocBytes);
+
+  // the first chunk is reused after reset
+  taosArenaReset(pArena);
+  EXPECT_EQ(pArena->allocBytes, 0u);
+  EXPECT_EQ(pArena->totalBytes, 1024u);
+  EXPECT_EQ(taosArenaMalloc(pArena, 10), p1);
+
+  taosArenaDestroy(pArena);
+}
@@ -132,4 +132,133 @@ TEST(testCase, cache_resize_test) {
   printf("retrieve %d object cost:%" PRIu64 " us,avg:%f\n", num, endTime - startTime, (endTime - startTime)/(double)num);
 
   taosCacheCleanup(pCache);
-}
\ No newline at end of file
+}
+// the elements not referenced are evicted by the size limit, the referenced and the frequently acquired ones are kept
+TEST(testCase, sharded_cache_evict_test) {
+  const int64_t MAX_SIZE = 64 * 1024;
+  SCacheObj* pCache = taosCacheInitSharded(TSDB_DATA_TYPE_BINARY, 3600, false, NULL, "test", MAX_SIZE);
+
+  char    key[32] = {0};
+  char    data[1024] = "abcdefghijk";
+  int32_t num = 2000;
+
+  char* pKept = (char*)taosCachePut(pCache, "kept", 4, data, sizeof(data), 3600);
+  char* pHot = (char*)taosCachePut(pCache, "hot", 3, data, sizeof(data), 3600);
+  taosCacheRelease(pCache, (void**)&pHot, false);
+
+  for (int32_t i = 0; i < num; ++i) {
+    int32_t len = sprintf(key, "abc_%7d", i);
+    char*   p = (char*)taosCachePut(pCache, key, len, data, sizeof(data), 3600);
+    ASSERT_TRUE(p != NULL);
+    taosCacheRelease(pCache, (void**)&p, false);
+
+    pHot = (char*)taosCacheAcquireByKey(pCache, "hot", 3);
+    ASSERT_TRUE(pHot != NULL);
+    taosCacheRelease(pCache, (void**)&pHot, false);
+  }
+
+  EXPECT_LE(taosCacheGetNumOfElems(pCache) * sizeof(data), (size_t)MAX_SIZE);
+  EXPECT_GT(taosCacheGetNumOfElems(pCache), 0);
+
+  char* p = (char*)taosCacheAcquireByKey(pCache, "kept", 4);
+  EXPECT_EQ(p, pKept);
+  taosCacheRelease(pCache, (void**)&p, false);
+  taosCacheRelease(pCache, (void**)&pKept, false);
+
+  EXPECT_TRUE(taosCacheAcquireByKey(pCache, "abc_      0", 11) == NULL);
+
+  SCacheStatis statis;
+  taosCacheGetStatis(pCache, &statis);
+  EXPECT_EQ(statis.evictCount, num + 2 - (int64_t)taosCacheGetNumOfElems(pCache));
+  EXPECT_EQ(statis.hitCount, num + 1);
+  EXPECT_EQ(statis.missCount, 1);
+  EXPECT_EQ(statis.totalAccess, num + 2);
+
+  // the removed element is freed at once if it is not referenced
+  p = (char*)taosCacheAcquireByKey(pCache, "hot", 3);
+  ASSERT_TRUE(p != NULL);
+  taosCacheRelease(pCache, (void**)&p, true);
+  EXPECT_TRUE(taosCacheAcquireByKey(pCache, "hot", 3) == NULL);
+
+  taosCacheCleanup(pCache);
+}
+
+// the keys of pointer values, as the query handles, are spread over the shards, so no shard exceeds its share of the
+// size limit and nothing is evicted
+TEST(testCase, sharded_cache_pointer_key_test) {
+  const int32_t num = 64;
+  char          data[1024] = "abcdefghijk";
+  SCacheObj*    pCache = taosCacheInitSharded(TSDB_DATA_TYPE_BIGINT, 3600, false, NULL, "test", 16 * 16 * 1280);
+
+  // the pointers to the objects allocated from one heap arena differ in the low bits only
+  for (int64_t i = 0; i < num; ++i) {
+    int64_t key = 0x7f3a12340000L + i * 0x1000;
+    char*   p = (char*)taosCachePut(pCache, &key, sizeof(key), data, sizeof(data), 3600);
+    ASSERT_TRUE(p != NULL);
+    taosCacheRelease(pCache, (void**)&p, false);
+  }
+
+  SCacheStatis statis;
+  taosCacheGetStatis(pCache, &statis);
+  EXPECT_EQ(statis.evictCount, 0);
+  EXPECT_EQ(taosCacheGetNumOfElems(pCache), (size_t)num);
+
+  taosCacheCleanup(pCache);
+}
+
+namespace {
+typedef struct {
+  SCacheObj* pCache;
+  int32_t    id;
+  int32_t    num;
+} SCacheThreadInfo;
+
+void* acquireCache(void* param) {
+  SCacheThreadInfo* pInfo = (SCacheThreadInfo*)param;
+  char              key[32] = {0};
+
+  for (int32_t i = 0; i < pInfo->num; ++i) {
+    int32_t len = sprintf(key, "key_%d", (i * 7 + pInfo->id) % 1000);
+    int64_t* p = (int64_t*)taosCacheAcquireByKey(pInfo->pCache, key, len);
+    if (p != NULL) {
+      EXPECT_EQ(*p, (i * 7 + pInfo->id) % 1000);
+      taosCacheRelease(pInfo->pCache, (void**)&p, false);
+    }
+  }
+
+  return NULL;
+}
+}  // namespace
+
+// the elements are acquired by several threads while they are replaced and evicted
+TEST(testCase, sharded_cache_multithreads_test) {
+  const int32_t numOfThreads = 4;
+  SCacheObj*    pCache = taosCacheInitSharded(TSDB_DATA_TYPE_BINARY, 3600, false, NULL, "test", 32 * 1024);
+
+  pthread_t        threads[numOfThreads];
+  SCacheThreadInfo info[numOfThreads];
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    info[i] = {pCache, i, 200000};
+    pthread_create(threads + i, NULL, acquireCache, info + i);
+  }
+
+  char key[32] = {0};
+  for (int64_t i = 0; i < 100000; ++i) {
+    int64_t value = i % 1000;
+    int32_t len = sprintf(key, "key_%" PRId64, value);
+    void*   p = taosCachePut(pCache, key, len, &value, sizeof(value), 3600);
+    taosCacheRelease(pCache, &p, (i % 10) == 0);
+  }
+
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  SCacheStatis statis;
+  taosCacheGetStatis(pCache, &statis);
+  EXPECT_EQ(statis.hitCount + statis.missCount, statis.totalAccess);
+  EXPECT_EQ(statis.totalAccess, numOfThreads * 200000);
+  EXPECT_GT(statis.evictCount, 0);
+
+  taosCacheCleanup(pCache);
+}
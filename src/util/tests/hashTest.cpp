@@ -132,8 +132,137 @@ void noLockPerformanceTest() {
   taosHashCleanup(hashTable);
 }
 
+// the concurrent hash table is resized incrementally while the entries are put, updated and removed
+void concurrentTest() {
+  auto* hashTable = (SHashObj*) taosHashInitConcurrent(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY));
+  ASSERT_EQ(taosHashGetSize(hashTable), 0);
+
+  char    key[128] = {0};
+  int32_t num = 100000;
+
+  for(int32_t i = 0; i < num; ++i) {
+    int32_t len = sprintf(key, "%d_1_%dabcefg_", i, i + 10);
+    taosHashPut(hashTable, key, len, (char*) &i, sizeof(int32_t));
+  }
+
+  // short keys are compared in the slot, and the updated value is returned
+  for(int32_t i = 0; i < num; i += 2) {
+    int32_t len = sprintf(key, "%d", i);
+    int32_t val = -i;
+    taosHashPut(hashTable, key, len, (char*) &val, sizeof(int32_t));
+    taosHashPut(hashTable, key, len, (char*) &i, sizeof(int32_t));
+  }
+
+  ASSERT_EQ(taosHashGetSize(hashTable), num + num / 2);
+
+  for(int32_t i = 0; i < num; ++i) {
+    int32_t len = sprintf(key, "%d_1_%dabcefg_", i, i + 10);
+    if (i % 3 == 0) taosHashRemove(hashTable, key, len);
+  }
+
+  for(int32_t i = 0; i < num; ++i) {
+    int32_t len = sprintf(key, "%d_1_%dabcefg_", i, i + 10);
+    char*   p = (char*) taosHashGet(hashTable, key, len);
+    if (i % 3 == 0) {
+      ASSERT_TRUE(p == nullptr);
+    } else {
+      ASSERT_TRUE(p != nullptr);
+      ASSERT_EQ(*reinterpret_cast<int32_t*>(p), i);
+    }
+
+    len = sprintf(key, "%d", i);
+    p = (char*) taosHashGet(hashTable, key, len);
+    ASSERT_EQ(p != nullptr, i % 2 == 0);
+    if (p != nullptr) ASSERT_EQ(*reinterpret_cast<int32_t*>(p), i);
+  }
+
+  size_t size = taosHashGetSize(hashTable);
+  ASSERT_EQ(size, num - (num + 2) / 3 + num / 2);
+
+  size_t count = 0;
+  SHashMutableIterator* pIter = taosHashCreateIter(hashTable);
+  while (taosHashIterNext(pIter)) {
+    ASSERT_TRUE(taosHashIterGet(pIter) != nullptr);
+    count++;
+  }
+  taosHashDestroyIter(pIter);
+  ASSERT_EQ(count, size);
+
+  printf("The maximum probe length in concurrent hash table is:%d\n", taosHashGetMaxOverflowLinkLength(hashTable));
+  taosHashCleanup(hashTable);
+}
+
+typedef struct {
+  SHashObj* hashTable;
+  int32_t   start;
+  int32_t   num;
+} SHashThreadInfo;
+
+void* putAndRemove(void* param) {
+  SHashThreadInfo* pInfo = (SHashThreadInfo*) param;
+
+  for (int32_t i = pInfo->start; i < pInfo->start + pInfo->num; ++i) {
+    taosHashPut(pInfo->hashTable, (const char*) &i, sizeof(int32_t), (char*) &i, sizeof(int32_t));
+    int32_t* p = (int32_t*) taosHashGet(pInfo->hashTable, (const char*) &i, sizeof(int32_t));
+    if (p == nullptr || *p != i) return param;
+    if (i % 2 == 1) taosHashRemove(pInfo->hashTable, (const char*) &i, sizeof(int32_t));
+  }
+
+  return nullptr;
+}
+
 void multithreadsTest() {
-  //todo
+  const int32_t numOfThreads = 4;
+  const int32_t num = 200000;
+
+  auto* hashTable = (SHashObj*) taosHashInitConcurrent(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT));
+
+  pthread_t       threads[numOfThreads];
+  SHashThreadInfo info[numOfThreads];
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    info[i] = {hashTable, i * num, num};
+    pthread_create(threads + i, NULL, putAndRemove, info + i);
+  }
+
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    void* ret = nullptr;
+    pthread_join(threads[i], &ret);
+    ASSERT_TRUE(ret == nullptr);
+  }
+
+  ASSERT_EQ(taosHashGetSize(hashTable), numOfThreads * num / 2);
+  for (int32_t i = 0; i < numOfThreads * num; ++i) {
+    int32_t* p = (int32_t*) taosHashGet(hashTable, (const char*) &i, sizeof(int32_t));
+    ASSERT_EQ(p != nullptr, i % 2 == 0);
+  }
+
+  taosHashCleanup(hashTable);
+}
+
+// the small integer keys, as the vgIds, are spread over the shards of a concurrent hash table
+void shardSpreadTest() {
+  auto* hashTable = (SHashObj*) taosHashInitConcurrent(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT));
+
+  for (int32_t i = 1; i <= 64; ++i) {
+    taosHashPut(hashTable, (const char*) &i, sizeof(int32_t), (char*) &i, sizeof(int32_t));
+  }
+
+  // the iterator walks the shards one by one, the shard of the current node is the one before shardIndex
+  int32_t count[HASH_CONCURRENT_SHARDS] = {0};
+  SHashMutableIterator* pIter = taosHashCreateIter(hashTable);
+  while (taosHashIterNext(pIter)) {
+    count[pIter->shardIndex - 1]++;
+  }
+  taosHashDestroyIter(pIter);
+
+  int32_t numOfUsed = 0;
+  for (int32_t i = 0; i < HASH_CONCURRENT_SHARDS; ++i) {
+    if (count[i] > 0) numOfUsed++;
+    ASSERT_LT(count[i], 64 / 2);
+  }
+  ASSERT_GT(numOfUsed, HASH_CONCURRENT_SHARDS / 2);
+
+  taosHashCleanup(hashTable);
 }
 
 // check the function robustness
@@ -152,5 +281,7 @@ TEST(testCase, hashTest) {
   simpleTest();
   stringKeyTest();
   noLockPerformanceTest();
+  concurrentTest();
   multithreadsTest();
+  shardSpreadTest();
 }
@@ -0,0 +1,103 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "hash.h"
+#include "tchecksum.h"
+#include "tkvstore.h"
+
+namespace {
+typedef std::map<uint64_t, std::string> SRecordMap;
+
+int restoreRecord(void* appH, void* cont, int contLen) {
+  SRecordMap* pMap = (SRecordMap*)appH;
+  uint64_t    uid = *(uint64_t*)cont;
+
+  EXPECT_TRUE(taosCheckChecksumWhole((uint8_t*)cont, contLen));
+  (*pMap)[uid] = std::string((char*)cont, contLen);
+  return 0;
+}
+
+// the content of a record is the uid, the payload and the checksum
+std::string makeRecord(uint64_t uid, int32_t version, int32_t len) {
+  std::string cont(len, (char)('a' + (uid + version) % 26));
+  memcpy(&cont[0], &uid, sizeof(uid));
+  taosCalcChecksumAppend(0, (uint8_t*)&cont[0], len);
+  return cont;
+}
+
+void putRecords(SKVStore* pStore, SRecordMap& expected, uint64_t start, uint64_t num, int32_t version) {
+  ASSERT_EQ(tdKVStoreStartCommit(pStore), 0);
+  for (uint64_t uid = start; uid < start + num; uid++) {
+    std::string cont = makeRecord(uid, version, 128 + uid % 64);
+    ASSERT_EQ(tdUpdateKVStoreRecord(pStore, uid, &cont[0], (int)cont.size()), 0);
+    expected[uid] = cont;
+  }
+  ASSERT_EQ(tdKVStoreEndCommit(pStore), 0);
+}
+
+bool fileExists(const char* fname) { return access(fname, F_OK) == 0; }
+}  // namespace
+
+// the records committed after the checkpoint are replayed from the store file on the checkpoint
+TEST(testCase, kvstore_checkpoint) {
+  const char* fname = "./kvstore_test";
+  const char* fckpt = "./kvstore_test.ckpt";
+  SRecordMap  expected, restored;
+
+  (void)remove(fname);
+  (void)remove(fckpt);
+  ASSERT_EQ(tdCreateKVStore((char*)fname), 0);
+
+  SKVStore* pStore = tdOpenKVStore((char*)fname, restoreRecord, NULL, &restored);
+  ASSERT_TRUE(pStore != NULL);
+
+  // more than 1MB is appended, a checkpoint is written
+  putRecords(pStore, expected, 1, 10000, 0);
+  EXPECT_TRUE(fileExists(fckpt));
+  EXPECT_EQ(pStore->ckptSize, pStore->info.size);
+
+  // update and drop some records after the checkpoint
+  putRecords(pStore, expected, 5000, 100, 1);
+  ASSERT_EQ(tdKVStoreStartCommit(pStore), 0);
+  for (uint64_t uid = 100; uid < 110; uid++) {
+    ASSERT_EQ(tdDropKVStoreRecord(pStore, uid), 0);
+    expected.erase(uid);
+  }
+  ASSERT_EQ(tdKVStoreEndCommit(pStore), 0);
+  putRecords(pStore, expected, 20000, 10, 0);
+
+  SStoreInfo info = pStore->info;
+  tdCloseKVStore(pStore);
+
+  pStore = tdOpenKVStore((char*)fname, restoreRecord, NULL, &restored);
+  ASSERT_TRUE(pStore != NULL);
+  EXPECT_LT(pStore->ckptSize, info.size);
+  EXPECT_EQ(pStore->info.size, info.size);
+  EXPECT_EQ(pStore->info.nRecords, info.nRecords);
+  EXPECT_EQ(pStore->info.magic, info.magic);
+  EXPECT_TRUE(restored == expected);
+  tdCloseKVStore(pStore);
+
+  // a checkpoint which does not belong to the store file is not used
+  ASSERT_EQ(rename(fckpt, "./kvstore_test.old"), 0);
+  ASSERT_EQ(tdDestroyKVStore((char*)fname), 0);
+  ASSERT_EQ(tdCreateKVStore((char*)fname), 0);
+  pStore = tdOpenKVStore((char*)fname, restoreRecord, NULL, &restored);
+  ASSERT_TRUE(pStore != NULL);
+  expected.clear();
+  putRecords(pStore, expected, 1, 20000, 2);
+  tdCloseKVStore(pStore);
+  ASSERT_EQ(rename("./kvstore_test.old", fckpt), 0);
+
+  restored.clear();
+  pStore = tdOpenKVStore((char*)fname, restoreRecord, NULL, &restored);
+  ASSERT_TRUE(pStore != NULL);
+  EXPECT_TRUE(restored == expected);
+  EXPECT_FALSE(fileExists(fckpt));
+  tdCloseKVStore(pStore);
+
+  tdDestroyKVStore((char*)fname);
+}
@@ -0,0 +1,81 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tlog.h"
+
+extern "C" {
+extern int32_t tsAsyncLog;
+extern int32_t tsBinaryLog;
+}
+
+namespace {
+const int32_t numOfLines = 200;
+
+void printLines(int32_t id) {
+  for (int32_t i = 0; i < numOfLines; ++i) {
+    taosPrintLog("TST ", DEBUG_FILE, "id:%d line:%d %s|%5.2f|%-6s|%.*s|%" PRId64 "|%zu|%c|%x|%%", id, i, "str", 3.14159,
+                 "ab", 3, "abcdef", (int64_t)i * 1000000000, (size_t)i, 'a' + i % 26, i);
+  }
+}
+
+void *printThread(void *param) {
+  printLines((int32_t)(int64_t)param);
+  return NULL;
+}
+
+std::string expectedLine(int32_t id, int32_t i) {
+  char buf[256] = {0};
+  snprintf(buf, sizeof(buf), "TST id:%d line:%d %s|%5.2f|%-6s|%.*s|%" PRId64 "|%zu|%c|%x|%%", id, i, "str", 3.14159,
+           "ab", 3, "abcdef", (int64_t)i * 1000000000, (size_t)i, 'a' + i % 26, i);
+  return buf;
+}
+}  // namespace
+
+// the lines are rendered by the log thread the same as they are formatted by the caller
+TEST(testCase, binary_log) {
+  const int32_t numOfThreads = 3;
+
+  (void)remove("./binaryLogTest.0");
+  (void)remove("./binaryLogTest.1");
+
+  tsAsyncLog = 1;
+  tsBinaryLog = 1;
+  ASSERT_EQ(taosInitLog((char *)"./binaryLogTest", 1000000, 1), 0);
+
+  pthread_t threads[numOfThreads];
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    pthread_create(threads + i, NULL, printThread, (void *)(int64_t)(i + 1));
+  }
+  printLines(0);
+
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  taosCloseLog();
+  tsBinaryLog = 0;
+
+  std::ifstream            fin("./binaryLogTest.0");
+  std::string              line;
+  std::vector<std::string> lines;
+  while (std::getline(fin, line)) {
+    size_t pos = line.find("TST ");
+    if (pos != std::string::npos) lines.push_back(line.substr(pos));
+  }
+
+  // the lines of each thread are in order, the ring of each thread is large enough for the lines
+  ASSERT_EQ(lines.size(), (size_t)numOfLines * (numOfThreads + 1));
+  int32_t next[numOfThreads + 1] = {0};
+  for (size_t i = 0; i < lines.size(); ++i) {
+    int32_t id = 0;
+    ASSERT_EQ(sscanf(lines[i].c_str(), "TST id:%d", &id), 1);
+    ASSERT_EQ(lines[i], expectedLine(id, next[id]));
+    next[id]++;
+  }
+
+  (void)remove("./binaryLogTest.0");
+}
@@ -0,0 +1,69 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tplacement.h"
+
+// the ranges and single cores are parsed in order, the duplicated cores are skipped
+TEST(testCase, placement_parse_core_list) {
+  int32_t cores[TAOS_MAX_CPU_CORES] = {0};
+
+  EXPECT_EQ(taosParseCoreList("", 8, cores), 0);
+  EXPECT_EQ(taosParseCoreList(NULL, 8, cores), 0);
+
+  ASSERT_EQ(taosParseCoreList("0-2, 5,1,7", 8, cores), 5);
+  EXPECT_EQ(cores[0], 0);
+  EXPECT_EQ(cores[1], 1);
+  EXPECT_EQ(cores[2], 2);
+  EXPECT_EQ(cores[3], 5);
+  EXPECT_EQ(cores[4], 7);
+
+  EXPECT_EQ(taosParseCoreList("8", 8, cores), -1);
+  EXPECT_EQ(taosParseCoreList("3-1", 8, cores), -1);
+  EXPECT_EQ(taosParseCoreList("1-", 8, cores), -1);
+  EXPECT_EQ(taosParseCoreList("a", 8, cores), -1);
+  EXPECT_EQ(taosParseCoreList("1;2", 8, cores), -1);
+}
+
+static void *placeThread(void *param) {
+  taosPlaceThread(*(int8_t *)param);
+  return NULL;
+}
+
+static void placeInThread(int8_t pool) {
+  pthread_t thread;
+  ASSERT_EQ(pthread_create(&thread, NULL, placeThread, &pool), 0);
+  pthread_join(thread, NULL);
+}
+
+// the read threads leave the cores of the rpc threads, and the write threads take all cores if they are pinned
+TEST(testCase, placement_pools) {
+  char                placement[TSDB_PLACEMENT_LEN] = {0};
+  SThreadPlacementCfg cfg = {{"0-1", "", "0-5", "", ""}, 8, 1, 1};
+
+  ASSERT_EQ(taosInitThreadPlacement(&cfg), 0);
+  taosGetThreadPlacement(placement, sizeof(placement));
+  EXPECT_STREQ(placement, "rpc:* write:*/pin read:* commit:* sync:*");
+  taosCleanupThreadPlacement();
+
+  taosGetThreadPlacement(placement, sizeof(placement));
+  EXPECT_STREQ(placement, "rpc:* write:* read:* commit:* sync:*");
+
+  cfg.cores[TAOS_THREAD_POOL_COMMIT] = "9";
+  EXPECT_EQ(taosInitThreadPlacement(&cfg), -1);
+  taosPlaceThread(TAOS_THREAD_POOL_COMMIT);
+}
+
+// the placement shows the cores the threads are bound to, and the threads failed to be bound to offline cores
+TEST(testCase, placement_effective) {
+  char                placement[TSDB_PLACEMENT_LEN] = {0};
+  SThreadPlacementCfg cfg = {{"0", "", "1000-1003", "", ""}, TAOS_MAX_CPU_CORES, 0, 1};
+
+  ASSERT_EQ(taosInitThreadPlacement(&cfg), 0);
+  placeInThread(TAOS_THREAD_POOL_RPC);
+  placeInThread(TAOS_THREAD_POOL_READ);
+
+  taosGetThreadPlacement(placement, sizeof(placement));
+  EXPECT_STREQ(placement, "rpc:0 write:* read:*/fail:1 commit:* sync:*");
+  taosCleanupThreadPlacement();
+}
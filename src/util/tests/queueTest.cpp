@@ -0,0 +1,141 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tqueue.h"
+
+namespace {
+void writeItems(taos_queue queue, int32_t start, int32_t num) {
+  for (int32_t i = start; i < start + num; ++i) {
+    int32_t* pItem = (int32_t*)taosAllocateQitem(sizeof(int32_t));
+    *pItem = i;
+    taosWriteQitem(queue, 0, pItem);
+  }
+}
+
+void freeItems(taos_qall qall, int32_t num, int32_t start) {
+  int   type = 0;
+  void* pItem = NULL;
+
+  for (int32_t i = 0; i < num; ++i) {
+    ASSERT_EQ(taosGetQitem(qall, &type, &pItem), 1);
+    ASSERT_EQ(*(int32_t*)pItem, start + i);
+    taosFreeQitem(pItem);
+  }
+}
+}  // namespace
+
+// a queue acquired by one reader is skipped by the other readers of the qset until it is released
+TEST(testCase, qset_acquire_queue) {
+  taos_qset  qset = taosOpenQset();
+  taos_queue queue1 = taosOpenQueue();
+  taos_queue queue2 = taosOpenQueue();
+  taos_qall  qall = taosAllocateQall();
+
+  int32_t handle1 = 1, handle2 = 2;
+  taosAddIntoQset(qset, queue1, &handle1);
+  taosAddIntoQset(qset, queue2, &handle2);
+
+  writeItems(queue1, 0, 10);
+
+  void*      handle = NULL;
+  taos_queue queue = NULL;
+  ASSERT_EQ(taosAcquireAllQitemsFromQset(qset, qall, &handle, &queue), 10);
+  EXPECT_EQ(handle, &handle1);
+  EXPECT_EQ(queue, queue1);
+  freeItems(qall, 10, 0);
+
+  // new items of the acquired queue are not read, the items of other queues are
+  writeItems(queue1, 10, 5);
+  writeItems(queue2, 100, 3);
+
+  int32_t num = 0;
+  while ((num = taosAcquireAllQitemsFromQset(qset, qall, &handle, &queue)) == 0) {
+  }
+
+  EXPECT_EQ(num, 3);
+  EXPECT_EQ(queue, queue2);
+  freeItems(qall, 3, 100);
+  taosReleaseQueue(queue2);
+
+  // the queue can be read again after it is released
+  taosReleaseQueue(queue1);
+  while ((num = taosAcquireAllQitemsFromQset(qset, qall, &handle, &queue)) == 0) {
+  }
+
+  EXPECT_EQ(num, 5);
+  EXPECT_EQ(queue, queue1);
+  freeItems(qall, 5, 10);
+  taosReleaseQueue(queue1);
+
+  EXPECT_EQ(taosGetQsetItemsNumber(qset), 0);
+
+  taosFreeQall(qall);
+  taosCloseQueue(queue1);
+  taosCloseQueue(queue2);
+  taosCloseQset(qset);
+}
+
+namespace {
+typedef struct {
+  taos_queue queue;
+  int32_t    writerId;
+  int32_t    num;
+} SWriterInfo;
+
+void *writeQueue(void *param) {
+  SWriterInfo *pInfo = (SWriterInfo *)param;
+
+  for (int32_t i = 0; i < pInfo->num; ++i) {
+    int64_t *pItem = (int64_t *)taosAllocateQitem(sizeof(int64_t));
+    *pItem = ((int64_t)pInfo->writerId << 32) | i;
+    taosWriteQitem(pInfo->queue, 0, pItem);
+  }
+
+  return NULL;
+}
+}  // namespace
+
+// the items written by each writer are read in order, and the reader returns 0 only when it is resumed
+TEST(testCase, qset_multiple_writers) {
+  const int32_t numOfWriters = 4;
+  const int32_t numOfItems = 100000;
+
+  taos_qset  qset = taosOpenQset();
+  taos_queue queue = taosOpenQueue();
+  int32_t    handle = 1;
+  taosAddIntoQset(qset, queue, &handle);
+
+  pthread_t   threads[numOfWriters];
+  SWriterInfo info[numOfWriters];
+  for (int32_t i = 0; i < numOfWriters; ++i) {
+    info[i] = {queue, i, numOfItems};
+    pthread_create(threads + i, NULL, writeQueue, info + i);
+  }
+
+  int32_t next[numOfWriters] = {0};
+  int     type = 0;
+  void *  pItem = NULL;
+  void *  ahandle = NULL;
+  for (int32_t i = 0; i < numOfWriters * numOfItems; ++i) {
+    ASSERT_EQ(taosReadQitemFromQset(qset, &type, &pItem, &ahandle), 1);
+    int64_t value = *(int64_t *)pItem;
+    int32_t writerId = (int32_t)(value >> 32);
+    ASSERT_EQ((int32_t)(value & 0xFFFFFFFF), next[writerId]);
+    next[writerId]++;
+    taosFreeQitem(pItem);
+  }
+
+  for (int32_t i = 0; i < numOfWriters; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  EXPECT_EQ(taosGetQsetItemsNumber(qset), 0);
+  EXPECT_EQ(taosGetQueueItemsNumber(queue), 0);
+
+  taosQsetThreadResume(qset);
+  EXPECT_EQ(taosReadQitemFromQset(qset, &type, &pItem, &ahandle), 0);
+
+  taosCloseQueue(queue);
+  taosCloseQset(qset);
+}
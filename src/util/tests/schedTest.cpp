@@ -0,0 +1,61 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tsched.h"
+
+namespace {
+typedef struct {
+  int32_t gate;      // the blocking task runs until it is set
+  int32_t count;
+} STaskInfo;
+
+void blockTask(SSchedMsg *pMsg) {
+  STaskInfo *pInfo = (STaskInfo *)pMsg->ahandle;
+  while (atomic_load_32(&pInfo->gate) == 0) {
+    taosMsleep(1);
+  }
+}
+
+void countTask(SSchedMsg *pMsg) {
+  STaskInfo *pInfo = (STaskInfo *)pMsg->ahandle;
+  atomic_add_fetch_32(&pInfo->count, 1);
+}
+
+void scheduleTask(void *qhandle, void (*fp)(SSchedMsg *), STaskInfo *pInfo) {
+  SSchedMsg msg = {0};
+  msg.fp = fp;
+  msg.ahandle = pInfo;
+  ASSERT_EQ(taosScheduleTask(qhandle, &msg), 0);
+}
+
+bool waitCount(STaskInfo *pInfo, int32_t count) {
+  for (int i = 0; i < 5000 && atomic_load_32(&pInfo->count) < count; ++i) {
+    taosMsleep(1);
+  }
+  return atomic_load_32(&pInfo->count) == count;
+}
+}  // namespace
+
+// the tasks behind a slow task are stolen by the idle thread, and the producer is not blocked by the queue size
+TEST(testCase, sched_steal_task) {
+  void *    qhandle = taosInitScheduler(4, 2, "test");
+  STaskInfo info = {0};
+
+  scheduleTask(qhandle, blockTask, &info);
+  for (int i = 0; i < 100; ++i) {
+    scheduleTask(qhandle, countTask, &info);
+  }
+
+  EXPECT_TRUE(waitCount(&info, 100));
+
+  SSchedStatus status;
+  taosGetSchedulerStatus(qhandle, &status);
+  EXPECT_EQ(status.numOfThreads, 2);
+  EXPECT_GT(status.numOfSteals, 0);
+  EXPECT_GT(status.numOfOverflows, 0);
+  EXPECT_GT(status.maxPending, 4);
+
+  atomic_store_32(&info.gate, 1);
+  taosCleanUpScheduler(qhandle);
+}
@@ -2,6 +2,7 @@
 #include <limits.h>
 #include <taosdef.h>
 #include <iostream>
+#include <vector>
 
 #include "os.h"
 #include "taosmsg.h"
@@ -375,3 +376,146 @@ TEST(testCase, skiplist_test) {
 
       free(pKeys);*/
 }
+
+namespace {
+SSkipListNode* newIntKeyNode(SSkipList* pSkipList, int32_t key) {
+  int32_t level, size;
+  tSkipListNewNodeInfo(pSkipList, &level, &size);
+  SSkipListNode* d = (SSkipListNode*)calloc(1, size + sizeof(int32_t));
+  d->level = level;
+  *(int32_t*)SL_GET_NODE_KEY(pSkipList, d) = key;
+  return d;
+}
+
+int32_t putIntKeyBatch(SSkipList* pSkipList, int32_t start, int32_t step, int32_t num, int32_t* numOfDiscarded) {
+  std::vector<SSkipListNode*> nodes;
+  for (int32_t i = 0; i < num; ++i) {
+    nodes.push_back(newIntKeyNode(pSkipList, start + i * step));
+  }
+
+  int32_t numOfInserted = tSkipListPutBatch(pSkipList, &nodes[0], num);
+
+  *numOfDiscarded = 0;
+  for (int32_t i = 0; i < num; ++i) {
+    if (nodes[i] != NULL) {
+      (*numOfDiscarded)++;
+      free(nodes[i]);
+    }
+  }
+
+  return numOfInserted;
+}
+}  // namespace
+
+// the sorted runs are linked in one pass, and the nodes of existing keys are given back to the caller
+TEST(testCase, skiplist_put_batch) {
+  SSkipList* pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_INT, sizeof(int32_t), 0, false, true, getkey);
+  int32_t    numOfDiscarded = 0;
+
+  // even keys [0, 2000)
+  EXPECT_EQ(putIntKeyBatch(pSkipList, 0, 2, 1000, &numOfDiscarded), 1000);
+  EXPECT_EQ(numOfDiscarded, 0);
+
+  // all keys in [500, 1500), the even ones exist
+  EXPECT_EQ(putIntKeyBatch(pSkipList, 500, 1, 1000, &numOfDiscarded), 500);
+  EXPECT_EQ(numOfDiscarded, 500);
+
+  // appended at the tail
+  EXPECT_EQ(putIntKeyBatch(pSkipList, 2000, 1, 1000, &numOfDiscarded), 1000);
+
+  // descending keys are not a sorted run, but they are still inserted
+  EXPECT_EQ(putIntKeyBatch(pSkipList, 1999, -2, 500, &numOfDiscarded), 250);
+  EXPECT_EQ(numOfDiscarded, 250);
+
+  EXPECT_EQ(tSkipListGetSize(pSkipList), 2750);
+
+  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+  int32_t            prev = -1, count = 0;
+  while (tSkipListIterNext(iter)) {
+    int32_t key = *(int32_t*)SL_GET_NODE_KEY(pSkipList, tSkipListIterGet(iter));
+    EXPECT_GT(key, prev);
+    prev = key;
+    count++;
+  }
+  tSkipListDestroyIter(iter);
+  EXPECT_EQ(count, 2750);
+
+  for (int32_t key = 0; key < 3000; key += 7) {
+    bool    exist = (key % 2 == 0) || (key >= 500 && key < 3000);
+    SArray* nodes = tSkipListGet(pSkipList, (char*)(&key));
+    EXPECT_EQ(taosArrayGetSize(nodes), exist ? 1 : 0);
+    taosArrayDestroy(nodes);
+  }
+
+  tSkipListDestroy(pSkipList);
+}
+
+// the sorted runs of duplicated keys, as the tag index is restored, are linked after the nodes of the same key
+TEST(testCase, skiplist_put_batch_dup_key) {
+  SSkipList* pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_INT, sizeof(int32_t), 1, false, true, getkey);
+
+  // ten nodes for each key in [0, 100), put in batches of 256 nodes
+  std::vector<SSkipListNode*> nodes;
+  for (int32_t key = 0; key < 100; ++key) {
+    for (int32_t j = 0; j < 10; ++j) {
+      nodes.push_back(newIntKeyNode(pSkipList, key));
+    }
+  }
+
+  for (size_t i = 0; i < nodes.size(); i += 256) {
+    int32_t num = (int32_t)std::min(nodes.size() - i, (size_t)256);
+    EXPECT_EQ(tSkipListPutBatch(pSkipList, &nodes[i], num), num);
+  }
+
+  // three more nodes for each key in [50, 60), and one for the max key
+  nodes.clear();
+  for (int32_t key = 50; key < 60; ++key) {
+    for (int32_t j = 0; j < 3; ++j) {
+      nodes.push_back(newIntKeyNode(pSkipList, key));
+    }
+  }
+  nodes.push_back(newIntKeyNode(pSkipList, 99));
+  EXPECT_EQ(tSkipListPutBatch(pSkipList, &nodes[0], (int32_t)nodes.size()), 31);
+
+  EXPECT_EQ(tSkipListGetSize(pSkipList), 1031);
+
+  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+  int32_t            prev = -1, count = 0;
+  while (tSkipListIterNext(iter)) {
+    int32_t key = *(int32_t*)SL_GET_NODE_KEY(pSkipList, tSkipListIterGet(iter));
+    EXPECT_GE(key, prev);
+    prev = key;
+    count++;
+  }
+  tSkipListDestroyIter(iter);
+  EXPECT_EQ(count, 1031);
+
+  for (int32_t key = 0; key < 100; ++key) {
+    SArray* res = tSkipListGet(pSkipList, (char*)(&key));
+    EXPECT_EQ(taosArrayGetSize(res), (key >= 50 && key < 60) ? 13 : ((key == 99) ? 11 : 10));
+    taosArrayDestroy(res);
+  }
+
+  tSkipListDestroy(pSkipList);
+}
+
+// the nodes created in batch before they are put into an empty skip list still get random levels
+TEST(testCase, skiplist_batch_node_level) {
+  SSkipList* pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_INT, sizeof(int32_t), 0, false, true, getkey);
+
+  int32_t maxLevel = 0;
+  for (int32_t i = 0; i < 1000; ++i) {
+    int32_t level = 0, headSize = 0;
+    tSkipListNewNodeInfo(pSkipList, &level, &headSize);
+
+    EXPECT_GE(level, 1);
+    EXPECT_LE(level, MAX_SKIP_LIST_LEVEL);
+    EXPECT_EQ(headSize, SL_NODE_HEADER_SIZE(level));
+    maxLevel = (level > maxLevel) ? level : maxLevel;
+  }
+
+  EXPECT_EQ(tSkipListGetSize(pSkipList), 0);
+  EXPECT_GT(maxLevel, 2);
+
+  tSkipListDestroy(pSkipList);
+}
@@ -0,0 +1,83 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "tslab.h"
+
+namespace {
+const int32_t numOfBuffers = 1000;
+
+typedef struct {
+  void *buffers[numOfBuffers];
+} SBufferInfo;
+
+void *freeBuffers(void *param) {
+  SBufferInfo *pInfo = (SBufferInfo *)param;
+  for (int32_t i = 0; i < numOfBuffers; ++i) {
+    taosSlabFree(pInfo->buffers[i]);
+  }
+  return NULL;
+}
+}  // namespace
+
+// the buffers are accounted to the module until they are freed, no matter which thread frees them
+TEST(testCase, slab_cross_thread_free) {
+  SSlabStatis statis;
+  taosSlabGetStatis(&statis);
+  int64_t liveBytes = statis.liveBytes[TAOS_SLAB_RPC];
+
+  SBufferInfo info;
+  for (int32_t i = 0; i < numOfBuffers; ++i) {
+    info.buffers[i] = taosSlabMalloc(TAOS_SLAB_RPC, 100 + i);
+    ASSERT_TRUE(info.buffers[i] != NULL);
+    memset(info.buffers[i], 'a', 100 + i);
+  }
+
+  taosSlabGetStatis(&statis);
+  EXPECT_EQ(statis.liveBytes[TAOS_SLAB_RPC] - liveBytes, numOfBuffers * 100 + numOfBuffers * (numOfBuffers - 1) / 2);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, freeBuffers, &info);
+  pthread_join(thread, NULL);
+
+  // the blocks cached by the exited thread are returned to the global pool, and reused by this thread zeroed
+  taosSlabGetStatis(&statis);
+  EXPECT_EQ(statis.liveBytes[TAOS_SLAB_RPC], liveBytes);
+  EXPECT_GT(statis.pooledBytes, 0);
+
+  char *pBuf = (char *)taosSlabMalloc(TAOS_SLAB_RPC, 500);
+  for (int32_t i = 0; i < 500; ++i) {
+    ASSERT_EQ(pBuf[i], 0);
+  }
+  taosSlabFree(pBuf);
+}
+
+// the block is kept if the new size fits its size class, the content is kept when it is moved
+TEST(testCase, slab_realloc) {
+  SSlabStatis statis;
+  taosSlabGetStatis(&statis);
+  int64_t liveBytes = statis.liveBytes[TAOS_SLAB_QUEUE];
+
+  char *pBuf = (char *)taosSlabRealloc(TAOS_SLAB_QUEUE, NULL, 10);
+  ASSERT_TRUE(pBuf != NULL);
+  memcpy(pBuf, "0123456789", 10);
+
+  EXPECT_EQ(taosSlabRealloc(TAOS_SLAB_QUEUE, pBuf, 40), pBuf);
+
+  pBuf = (char *)taosSlabRealloc(TAOS_SLAB_QUEUE, pBuf, 4000);
+  ASSERT_TRUE(pBuf != NULL);
+  EXPECT_EQ(memcmp(pBuf, "0123456789", 10), 0);
+
+  // the large buffers are not pooled
+  pBuf = (char *)taosSlabRealloc(TAOS_SLAB_QUEUE, pBuf, 1024 * 1024);
+  ASSERT_TRUE(pBuf != NULL);
+  EXPECT_EQ(memcmp(pBuf, "0123456789", 10), 0);
+  pBuf[1024 * 1024 - 1] = 1;
+
+  taosSlabGetStatis(&statis);
+  EXPECT_EQ(statis.liveBytes[TAOS_SLAB_QUEUE] - liveBytes, 1024 * 1024);
+
+  EXPECT_TRUE(taosSlabRealloc(TAOS_SLAB_QUEUE, pBuf, 0) == NULL);
+  taosSlabGetStatis(&statis);
+  EXPECT_EQ(statis.liveBytes[TAOS_SLAB_QUEUE], liveBytes);
+}
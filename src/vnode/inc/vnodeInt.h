@@ -45,6 +45,7 @@ typedef struct {
   int64_t      fversion;  // version on saved data file
   void        *wqueue;
   void        *rqueue;
+  void        *lqueue;  // read queue of the long queries, NULL if they share rqueue
   void        *wal;
   void        *tsdb;
   void        *sync;
@@ -58,6 +59,8 @@ typedef struct {
   char        *rootDir;
   tsem_t       sem;
   int8_t       dropped;
+  int8_t       throttled;       // the writes from clients are throttled for the buffer pressure of tsdb
+  int64_t      numOfThrottled;  // number of writes throttled since the throttling starts
   char         db[TSDB_DB_NAME_LEN];
 } SVnodeObj;
 
@@ -50,7 +50,12 @@ int32_t vnodeInitResources() {
   vnodeInitWriteFp();
   vnodeInitReadFp();
 
-  tsDnodeVnodesHash = taosHashInit(TSDB_MIN_VNODES, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true);
+  if (tsdbInitBufMgr((int64_t)tsMemtableBudget * 1024 * 1024) < 0) {
+    vError("failed to init memtable budget since %s", tstrerror(terrno));
+    return terrno;
+  }
+
+  tsDnodeVnodesHash = taosHashInitConcurrent(TSDB_MIN_VNODES, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT));
   if (tsDnodeVnodesHash == NULL) {
     vError("failed to init vnode list");
     return TSDB_CODE_VND_OUT_OF_MEMORY;
@@ -60,6 +65,7 @@ int32_t vnodeInitResources() {
 }
 
 void vnodeCleanupResources() {
+  tsdbCleanupBufMgr();
 
   if (tsDnodeVnodesHash != NULL) {
     taosHashCleanup(tsDnodeVnodesHash);
@@ -227,6 +233,7 @@ int32_t vnodeOpen(int32_t vnode, char *rootDir) {
   
   pVnode->wqueue = dnodeAllocateVnodeWqueue(pVnode);
   pVnode->rqueue = dnodeAllocateVnodeRqueue(pVnode);
+  pVnode->lqueue = dnodeAllocateVnodeLqueue(pVnode);
   if (pVnode->wqueue == NULL || pVnode->rqueue == NULL) {
     vnodeCleanUp(pVnode);
     return terrno;
@@ -258,6 +265,7 @@ int32_t vnodeOpen(int32_t vnode, char *rootDir) {
   }
 
   sprintf(temp, "%s/wal", rootDir);
+  pVnode->walCfg.groupCommit = (int8_t)tsWalGroupCommit;
   pVnode->wal = walOpen(temp, &pVnode->walCfg);
   if (pVnode->wal == NULL) { 
     vnodeCleanUp(pVnode);
@@ -346,6 +354,10 @@ void vnodeRelease(void *pVnodeRaw) {
   if (pVnode->rqueue) 
     dnodeFreeVnodeRqueue(pVnode->rqueue);
   pVnode->rqueue = NULL;
+
+  if (pVnode->lqueue)
+    dnodeFreeVnodeLqueue(pVnode->lqueue);
+  pVnode->lqueue = NULL;
  
   taosTFree(pVnode->rootDir);
 
@@ -73,8 +73,14 @@ static void vnodePutItemIntoReadQueue(SVnodeObj *pVnode, void *qhandle) {
   pRead->contLen = 0;
   pRead->rpcMsg.handle = NULL;
 
+  // the long queries are executed by their own threads, the new and short ones are not queued behind them
+  void *queue = pVnode->rqueue;
+  if (pVnode->lqueue != NULL && qIsLongQuery(qhandle)) {
+    queue = pVnode->lqueue;
+  }
+
   atomic_add_fetch_32(&pVnode->refCount, 1);
-  taosWriteQitem(pVnode->rqueue, TAOS_QTYPE_QUERY, pRead);
+  taosWriteQitem(queue, TAOS_QTYPE_QUERY, pRead);
 }
 
 static int32_t vnodeDumpQueryResult(SRspRet *pRet, void* pVnode, void* handle, bool* freeHandle) {
@@ -211,6 +217,9 @@ static int32_t vnodeProcessQueryMsg(SVnodeObj *pVnode, SReadMsg *pReadMsg) {
         if (code == TSDB_CODE_SUCCESS) {
           code = TSDB_CODE_QRY_HAS_RSP;
         }
+      } else if (qIsQueryYielded(*handle)) {
+        vDebug("vgId:%d, QInfo:%p, query yields, put it back into the read queue", pVnode->vgId, *handle);
+        vnodePutItemIntoReadQueue(pVnode, *handle);
       }
 
       qReleaseQInfo(pVnode->qMgmt, (void**) &handle, freehandle);
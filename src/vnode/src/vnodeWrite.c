@@ -34,6 +34,9 @@ static int32_t vnodeProcessDropTableMsg(SVnodeObj *pVnode, void *pMsg, SRspRet *
 static int32_t vnodeProcessAlterTableMsg(SVnodeObj *pVnode, void *pMsg, SRspRet *);
 static int32_t vnodeProcessDropStableMsg(SVnodeObj *pVnode, void *pMsg, SRspRet *);
 static int32_t vnodeProcessUpdateTagValMsg(SVnodeObj *pVnode, void *pCont, SRspRet *pRet);
+static int32_t vnodeCheckWritePressure(SVnodeObj *pVnode, SRspRet *pRet);
+
+static int32_t tsVnodeThrottledWriteNum = 0;
 
 void vnodeInitWriteFp(void) {
   vnodeProcessWriteMsgFp[TSDB_MSG_TYPE_SUBMIT]          = vnodeProcessSubmitMsg;
@@ -75,6 +78,13 @@ int32_t vnodeProcessWrite(void *param1, int qtype, void *param2, void *item) {
       return TSDB_CODE_RPC_NOT_READY;
     }
 
+    // reject the write from clients instead of blocking the write worker, the client retries after the suggested
+    // delay. the writes of CQ are not throttled since nobody resends them
+    if (pHead->msgType == TSDB_MSG_TYPE_SUBMIT && qtype == TAOS_QTYPE_RPC) {
+      code = vnodeCheckWritePressure(pVnode, item);
+      if (code != TSDB_CODE_SUCCESS) return code;
+    }
+
     // assign version
     pVnode->version++;
     pHead->version = pVnode->version;
@@ -103,6 +113,45 @@ int32_t vnodeProcessWrite(void *param1, int qtype, void *param2, void *item) {
   return syncCode;
 }
 
+int32_t vnodeGetThrottledWriteNum() { return atomic_exchange_32(&tsVnodeThrottledWriteNum, 0); }
+
+static int32_t vnodeCheckWritePressure(SVnodeObj *pVnode, SRspRet *pRet) {
+  STsdbBufPressure pressure;
+  tsdbGetBufPressure(pVnode->tsdb, &pressure);
+
+  if (pressure.level == TSDB_BUF_PRESSURE_NONE) {
+    if (pVnode->throttled) {
+      vInfo("vgId:%d, writes are not throttled any more, %" PRId64 " writes are throttled", pVnode->vgId,
+            pVnode->numOfThrottled);
+      pVnode->throttled = 0;
+      pVnode->numOfThrottled = 0;
+    }
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (!pVnode->throttled) {
+    vInfo("vgId:%d, writes are throttled, blocks free:%d total:%d mem:%d, extraBytes:%" PRId64 " committing:%d delay:%d",
+          pVnode->vgId, pressure.freeBlocks, pressure.totalBlocks, pressure.memBlocks, pressure.extraBytes,
+          pressure.committing, pressure.delay);
+    pVnode->throttled = 1;
+  }
+
+  pVnode->numOfThrottled++;
+  atomic_add_fetch_32(&tsVnodeThrottledWriteNum, 1);
+
+  if (pRet != NULL) {
+    SWriteThrottleRspMsg *pRsp = rpcMallocCont(sizeof(SWriteThrottleRspMsg));
+    if (pRsp != NULL) {
+      pRsp->delay = htonl(pressure.delay);
+      pRet->rsp = pRsp;
+      pRet->len = sizeof(SWriteThrottleRspMsg);
+    }
+  }
+
+  vTrace("vgId:%d, submit msg is throttled, delay:%d", pVnode->vgId, pressure.delay);
+  return TSDB_CODE_VND_WRITE_THROTTLED;
+}
+
 void vnodeConfirmForward(void *param, uint64_t version, int32_t code) {
   SVnodeObj *pVnode = (SVnodeObj *)param;
   syncConfirmForward(pVnode->sync, version, code);
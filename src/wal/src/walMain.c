@@ -33,6 +33,13 @@
 #define wDebug(...) { if (wDebugFlag & DEBUG_DEBUG) { taosPrintLog("WAL ", wDebugFlag, __VA_ARGS__); }}
 #define wTrace(...) { if (wDebugFlag & DEBUG_TRACE) { taosPrintLog("WAL ", wDebugFlag, __VA_ARGS__); }}
 
+#define WAL_MIN_BUFFER_SIZE (64 * 1024)       // initial size of the buffer keeping records of a batch
+#define WAL_MAX_BUFFER_SIZE (4 * 1024 * 1024) // the buffer is written into file once it is full
+#define WAL_PREALLOC_SIZE (16 * 1024 * 1024) // disk space allocated in advance for each wal file
+#define WAL_RESTORE_BUFFER_SIZE (4 * 1024 * 1024) // size of each read when wal file is restored
+
+struct SWalFlusher;
+
 typedef struct {
   uint64_t version;
   int      fd;
@@ -46,9 +53,37 @@ typedef struct {
   int      num;  // number of wal files
   char     path[TSDB_FILENAME_LEN];
   char     name[TSDB_FILENAME_LEN+16];
+  int8_t   groupCommit;
+  int8_t   fsyncPending;  // it is in the pending list of flusher
+  int32_t  fsyncCode;     // result of the last fsync by flusher
+  int32_t  bufLen;        // bytes of the records written by walWrite, but not written into file yet
+  int32_t  bufSize;
+  char    *buffer;        // the records are copied, since the caller may change them after walWrite
+  struct SWalFlusher *flusher;
   pthread_mutex_t mutex;
 } SWal;
 
+/*
+ * One flusher is shared by all the WALs in group commit mode on the same device. The fsync requests arriving while
+ * a round of fsync is in progress are collected and handled by the next round together, so the writers of all
+ * vnodes wait for one round instead of queuing their fsyncs one by one on the device.
+ */
+typedef struct SWalFlusher {
+  dev_t           dev;
+  pthread_t       thread;
+  int32_t         refCount;  // number of WALs using it
+  int8_t          stop;
+  uint64_t        round;     // the round collecting fsync requests
+  uint64_t        done;      // number of rounds finished
+  int32_t         num;       // number of WALs in pending list
+  int32_t         size;
+  SWal          **pending;
+  pthread_cond_t  reqCond;
+  pthread_cond_t  doneCond;
+  pthread_mutex_t mutex;
+  struct SWalFlusher *next;
+} SWalFlusher;
+
 static void    *walTmrCtrl = NULL;
 static int     tsWalNum = 0;
 static pthread_once_t walModuleInit = PTHREAD_ONCE_INIT;
@@ -58,6 +93,15 @@ static int  walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp);
 static int  walRemoveWalFiles(const char *path);
 static void walProcessFsyncTimer(void *param, void *tmrId);
 static void walRelease(SWal *pWal);
+static int  walFlushBuffer(SWal *pWal);
+static int  walBufferRecord(SWal *pWal, SWalHead *pHead, int32_t contLen);
+static void walTruncateUnused(SWal *pWal);
+static int  walRequestFsync(SWal *pWal);
+static SWalFlusher *walAcquireFlusher(const char *path);
+static void walReleaseFlusher(SWalFlusher *pFlusher);
+
+static SWalFlusher    *walFlushers = NULL;
+static pthread_mutex_t walFlusherMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void walModuleInitFunc() {
   walTmrCtrl = taosTmrInit(1000, 100, 300000, "WAL");
@@ -89,6 +133,7 @@ void *walOpen(const char *path, const SWalCfg *pCfg) {
   pWal->level = pCfg->walLevel;
   pWal->keep = pCfg->keep;
   pWal->fsyncPeriod = pCfg->fsyncPeriod;
+  pWal->groupCommit = pCfg->groupCommit;
   pWal->signature = pWal;
   tstrncpy(pWal->path, path, sizeof(pWal->path));
   pthread_mutex_init(&pWal->mutex, NULL);
@@ -106,7 +151,15 @@ void *walOpen(const char *path, const SWalCfg *pCfg) {
     terrno = TAOS_SYSTEM_ERROR(errno);
     wError("wal:%s, failed to create directory(%s)", path, strerror(errno));
     walRelease(pWal);
-    pWal = NULL;
+    return NULL;
+  }
+
+  if (pWal->groupCommit && pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0) {
+    pWal->flusher = walAcquireFlusher(path);
+    if (pWal->flusher == NULL) {
+      walRelease(pWal);
+      return NULL;
+    }
   }
      
   if (pCfg->keep == 1) return pWal;
@@ -129,9 +182,16 @@ void walClose(void *handle) {
   if (handle == NULL) return;
   
   SWal *pWal = handle;  
-  taosClose(pWal->fd);
   if (pWal->timer) taosTmrStopA(&pWal->timer);
 
+  pthread_mutex_lock(&pWal->mutex);
+  if (pWal->fd >= 0 && pWal->groupCommit) {
+    walFlushBuffer(pWal);
+    walTruncateUnused(pWal);
+  }
+  taosClose(pWal->fd);
+  pthread_mutex_unlock(&pWal->mutex);
+
   if (pWal->keep == 0) {
     // remove all files in the directory
     for (int i=0; i<pWal->num; ++i) {
@@ -158,6 +218,17 @@ int walRenew(void *handle) {
   pthread_mutex_lock(&pWal->mutex);
 
   if (pWal->fd >=0) {
+    walFlushBuffer(pWal);
+
+    // the records written by the last batch may not be synced by flusher yet
+    if (pWal->groupCommit) {
+      if (pWal->level == TAOS_WAL_FSYNC && fsync(pWal->fd) < 0) {
+        wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
+      }
+
+      walTruncateUnused(pWal);
+    }
+
     close(pWal->fd);
     pWal->id++;
     wDebug("wal:%s, it is closed", pWal->name);
@@ -174,6 +245,10 @@ int walRenew(void *handle) {
   } else {
     wDebug("wal:%s, it is created", pWal->name);
 
+    if (pWal->groupCommit && taosFallocate(pWal->fd, 0, WAL_PREALLOC_SIZE) < 0) {
+      wWarn("wal:%s, failed to allocate space(%s)", pWal->name, strerror(errno));
+    }
+
     if (pWal->num > pWal->max) {
       // remove the oldest wal file
       char name[TSDB_FILENAME_LEN * 3];
@@ -207,6 +282,14 @@ int walWrite(void *handle, SWalHead *pHead) {
   taosCalcChecksumAppend(0, (uint8_t *)pHead, sizeof(SWalHead));
   int contLen = pHead->len + sizeof(SWalHead);
 
+  // the record is copied into the buffer until walFsync is called, the records of a batch are written by one write
+  if (pWal->groupCommit) {
+    pthread_mutex_lock(&pWal->mutex);
+    walBufferRecord(pWal, pHead, contLen);
+    pthread_mutex_unlock(&pWal->mutex);
+    return terrno;
+  }
+
   if(taosTWrite(pWal->fd, pHead, contLen) != contLen) {
     wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -217,16 +300,31 @@ int walWrite(void *handle, SWalHead *pHead) {
   return terrno;
 }
 
-void walFsync(void *handle) {
-
+int walFsync(void *handle) {
   SWal *pWal = handle;
-  if (pWal == NULL || pWal->level != TAOS_WAL_FSYNC || pWal->fd < 0) return;
+  int   code = 0;
+
+  if (pWal == NULL) return 0;
+
+  if (pWal->groupCommit) {
+    pthread_mutex_lock(&pWal->mutex);
+    code = walFlushBuffer(pWal);
+    pthread_mutex_unlock(&pWal->mutex);
+    if (code != 0) return code;
+  }
+
+  if (pWal->level != TAOS_WAL_FSYNC || pWal->fd < 0) return 0;
 
   if (pWal->fsyncPeriod == 0) {
+    if (pWal->flusher) return walRequestFsync(pWal);
+
     if (fsync(pWal->fd) < 0) {
       wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
+      code = TAOS_SYSTEM_ERROR(errno);
     }
   }
+
+  return code;
 }
 
 int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int)) {
@@ -331,6 +429,8 @@ int walGetWalFile(void *handle, char *name, uint32_t *index) {
 
 static void walRelease(SWal *pWal) {
 
+  if (pWal->flusher) walReleaseFlusher(pWal->flusher);
+  taosTFree(pWal->buffer);
   pthread_mutex_destroy(&pWal->mutex);
   pWal->signature = NULL;
   free(pWal);
@@ -343,18 +443,25 @@ static void walRelease(SWal *pWal) {
   }
 }
 
+/*
+ * The file is read sequentially in large chunks, and the records are parsed in the buffer and passed to writeFp
+ * directly, instead of two reads for each record. A record not complete in the buffer is moved to the beginning
+ * of the buffer before the next chunk is read, and the buffer is enlarged if the record is larger than it.
+ */
 static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp) {
-  char *name = pWal->name;
+  char   *name = pWal->name;
+  int32_t size = WAL_RESTORE_BUFFER_SIZE;
+  int32_t start = 0, end = 0;  // the data not parsed yet is [start, end) in buffer
+  int32_t eof = 0;
+  int64_t count = 0, bytes = 0;
 
   terrno = 0;
-  char *buffer = malloc(1024000);  // size for one record
+  char *buffer = malloc(size);
   if (buffer == NULL) {
     terrno = TAOS_SYSTEM_ERROR(errno);   
     return terrno;
   }
 
-  SWalHead *pHead = (SWalHead *)buffer;
-
   int fd = open(name, O_RDONLY);
   if (fd < 0) {
     wError("wal:%s, failed to open for restore(%s)", name, strerror(errno));
@@ -363,38 +470,79 @@ static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp) {
     return terrno;
   }
 
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  int64_t st = taosGetTimestampUs();
   wDebug("wal:%s, start to restore", name);
 
   while (1) {
-    int ret = taosTRead(fd, pHead, sizeof(SWalHead));
-    if ( ret == 0)  break;  
+    SWalHead *pHead = (SWalHead *)(buffer + start);
+    int32_t   avail = end - start;
+    int32_t   need = sizeof(SWalHead);
 
-    if (ret != sizeof(SWalHead)) {
-      wWarn("wal:%s, failed to read head, skip, ret:%d(%s)", name, ret, strerror(errno));
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
+    if (avail >= (int32_t)sizeof(SWalHead)) {
+      if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead)) || pHead->len < 0) {
+        wWarn("wal:%s, cksum is messed up, skip the rest of file", name);
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        break;
+      }
+
+      need += pHead->len;
     }
 
-    if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead))) {
-      wWarn("wal:%s, cksum is messed up, skip the rest of file", name);
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
-    } 
+    if (avail < need) {
+      if (eof) {
+        if (avail > 0) {
+          wWarn("wal:%s, failed to read %s, skip, len:%d left:%d", name, (need == sizeof(SWalHead)) ? "head" : "body",
+                need, avail);
+          terrno = TAOS_SYSTEM_ERROR(errno);
+        }
+        break;
+      }
 
-    ret = taosTRead(fd, pHead->cont, pHead->len);
-    if ( ret != pHead->len) {
-      wWarn("wal:%s, failed to read body, skip, len:%d ret:%d", name, pHead->len, ret);
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
+      if (start > 0) {
+        memmove(buffer, buffer + start, avail);
+        start = 0;
+        end = avail;
+      }
+
+      if (need > size) {
+        char *tmp = realloc(buffer, need);
+        if (tmp == NULL) {
+          terrno = TAOS_SYSTEM_ERROR(errno);
+          break;
+        }
+
+        buffer = tmp;
+        size = need;
+      }
+
+      int32_t ret = (int32_t)taosTRead(fd, buffer + end, size - end);
+      if (ret < 0) {
+        wWarn("wal:%s, failed to read, skip the rest of file(%s)", name, strerror(errno));
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        break;
+      }
+
+      if (ret < size - end) eof = 1;
+      end += ret;
+      continue;
     }
 
     if (pWal->keep) pWal->version = pHead->version;
     (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL);
+
+    start += need;
+    bytes += need;
+    count++;
   }
 
   close(fd);
   free(buffer);
 
+  int64_t elapsed = taosGetTimestampUs() - st;
+  wDebug("wal:%s, %" PRId64 " records, %" PRId64 " bytes are restored in %" PRId64 " us", name, count, bytes, elapsed);
+
   return terrno;
 }
 
@@ -479,9 +627,252 @@ static void walProcessFsyncTimer(void *param, void *tmrId) {
   if (pWal->signature != pWal) return;
   if (pWal->fd < 0) return;
 
+  // the records kept by walWrite are written before fsync, otherwise they are not synced until the next batch
+  if (pWal->groupCommit) {
+    pthread_mutex_lock(&pWal->mutex);
+    walFlushBuffer(pWal);
+    pthread_mutex_unlock(&pWal->mutex);
+  }
+
   if (fsync(pWal->fd) < 0) {
     wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
   }
   
   pWal->timer = taosTmrStart(walProcessFsyncTimer, pWal->fsyncPeriod, pWal, walTmrCtrl);
 }
+
+// write the records kept by walWrite into file, it shall be called with the mutex of WAL locked
+static int walFlushBuffer(SWal *pWal) {
+  terrno = 0;
+  if (pWal->bufLen == 0) return 0;
+
+  int32_t len = pWal->bufLen;
+  pWal->bufLen = 0;
+
+  if (taosTWrite(pWal->fd, pWal->buffer, len) != len) {
+    wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+  }
+
+  return terrno;
+}
+
+// copy the record into the buffer, it shall be called with the mutex of WAL locked
+static int walBufferRecord(SWal *pWal, SWalHead *pHead, int32_t contLen) {
+  terrno = 0;
+
+  if (pWal->bufLen + contLen > pWal->bufSize && pWal->bufSize < WAL_MAX_BUFFER_SIZE) {
+    int32_t size = MAX(pWal->bufSize, WAL_MIN_BUFFER_SIZE);
+    while (size < pWal->bufLen + contLen && size < WAL_MAX_BUFFER_SIZE) size *= 2;
+
+    char *buffer = realloc(pWal->buffer, size);
+    if (buffer != NULL) {
+      pWal->buffer = buffer;
+      pWal->bufSize = size;
+    }
+  }
+
+  if (pWal->bufLen + contLen > pWal->bufSize && walFlushBuffer(pWal) != 0) return terrno;
+
+  if (contLen > pWal->bufSize) {
+    // the record is larger than the buffer, it is written directly
+    if (taosTWrite(pWal->fd, pHead, contLen) != contLen) {
+      wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      return terrno;
+    }
+  } else {
+    memcpy(pWal->buffer + pWal->bufLen, pHead, contLen);
+    pWal->bufLen += contLen;
+  }
+
+  pWal->version = pHead->version;
+  return 0;
+}
+
+// release the space allocated in advance but not used, so only the records are left in the closed file
+static void walTruncateUnused(SWal *pWal) {
+  off_t size = lseek(pWal->fd, 0, SEEK_CUR);
+  if (size >= 0 && taosFtruncate(pWal->fd, size) < 0) {
+    wWarn("wal:%s, failed to truncate(%s)", pWal->name, strerror(errno));
+  }
+}
+
+static int walRequestFsync(SWal *pWal) {
+  SWalFlusher *pFlusher = pWal->flusher;
+
+  pthread_mutex_lock(&pFlusher->mutex);
+
+  if (!pWal->fsyncPending) {
+    if (pFlusher->num >= pFlusher->size) {
+      int32_t size = (pFlusher->size == 0) ? 16 : pFlusher->size * 2;
+      SWal  **pending = realloc(pFlusher->pending, size * sizeof(SWal *));
+      if (pending == NULL) {
+        pthread_mutex_unlock(&pFlusher->mutex);
+        return TAOS_SYSTEM_ERROR(errno);
+      }
+
+      pFlusher->pending = pending;
+      pFlusher->size = size;
+    }
+
+    pFlusher->pending[pFlusher->num++] = pWal;
+    pWal->fsyncPending = 1;
+    pthread_cond_signal(&pFlusher->reqCond);
+  }
+
+  // wait until the round collecting this request is finished
+  uint64_t round = pFlusher->round;
+  while (pFlusher->done <= round) {
+    pthread_cond_wait(&pFlusher->doneCond, &pFlusher->mutex);
+  }
+
+  int code = pWal->fsyncCode;
+  pthread_mutex_unlock(&pFlusher->mutex);
+
+  return code;
+}
+
+static void *walProcessFsyncRequests(void *param) {
+  SWalFlusher *pFlusher = param;
+  SWal       **list = NULL;
+  int32_t      size = 0;
+
+  pthread_mutex_lock(&pFlusher->mutex);
+
+  while (1) {
+    while (pFlusher->num == 0 && !pFlusher->stop) {
+      pthread_cond_wait(&pFlusher->reqCond, &pFlusher->mutex);
+    }
+
+    if (pFlusher->num == 0) break;
+
+    // take the pending list, the requests arriving from now on are handled by the next round
+    SWal  **pending = pFlusher->pending;
+    int32_t pendingSize = pFlusher->size;
+    int32_t num = pFlusher->num;
+    pFlusher->pending = list;
+    pFlusher->size = size;
+    pFlusher->num = 0;
+    list = pending;
+    size = pendingSize;
+
+    uint64_t round = pFlusher->round++;
+    for (int32_t i = 0; i < num; ++i) list[i]->fsyncPending = 0;
+
+    pthread_mutex_unlock(&pFlusher->mutex);
+
+    for (int32_t i = 0; i < num; ++i) {
+      SWal *pWal = list[i];
+
+      // the WAL file may be renewed by commit thread, fsync the duplicated one
+      pthread_mutex_lock(&pWal->mutex);
+      int fd = dup(pWal->fd);
+      pthread_mutex_unlock(&pWal->mutex);
+
+      int code = 0;
+      if (fd < 0 || fdatasync(fd) < 0) {
+        wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
+        code = TAOS_SYSTEM_ERROR(errno);
+      }
+
+      if (fd >= 0) close(fd);
+      pWal->fsyncCode = code;
+    }
+
+    pthread_mutex_lock(&pFlusher->mutex);
+    pFlusher->done = round + 1;
+    pthread_cond_broadcast(&pFlusher->doneCond);
+
+    wTrace("wal flusher, round:%" PRIu64 " is finished, %d files are synced", round, num);
+  }
+
+  pthread_mutex_unlock(&pFlusher->mutex);
+  free(list);
+
+  return NULL;
+}
+
+static SWalFlusher *walAcquireFlusher(const char *path) {
+  struct stat fileStat;
+  if (stat(path, &fileStat) < 0) {
+    wError("wal:%s, failed to stat(%s)", path, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&walFlusherMutex);
+
+  SWalFlusher *pFlusher = walFlushers;
+  while (pFlusher && pFlusher->dev != fileStat.st_dev) pFlusher = pFlusher->next;
+
+  if (pFlusher) {
+    pFlusher->refCount++;
+    pthread_mutex_unlock(&walFlusherMutex);
+    return pFlusher;
+  }
+
+  pFlusher = calloc(1, sizeof(SWalFlusher));
+  if (pFlusher == NULL) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    pthread_mutex_unlock(&walFlusherMutex);
+    return NULL;
+  }
+
+  pFlusher->dev = fileStat.st_dev;
+  pFlusher->refCount = 1;
+  pthread_mutex_init(&pFlusher->mutex, NULL);
+  pthread_cond_init(&pFlusher->reqCond, NULL);
+  pthread_cond_init(&pFlusher->doneCond, NULL);
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  if (pthread_create(&pFlusher->thread, &thAttr, walProcessFsyncRequests, pFlusher) != 0) {
+    wError("wal:%s, failed to create flusher thread(%s)", path, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    pthread_cond_destroy(&pFlusher->reqCond);
+    pthread_cond_destroy(&pFlusher->doneCond);
+    pthread_mutex_destroy(&pFlusher->mutex);
+    taosTFree(pFlusher);
+  } else {
+    pFlusher->next = walFlushers;
+    walFlushers = pFlusher;
+    wDebug("wal flusher is created for device:%" PRIu64, (uint64_t)fileStat.st_dev);
+  }
+
+  pthread_attr_destroy(&thAttr);
+  pthread_mutex_unlock(&walFlusherMutex);
+
+  return pFlusher;
+}
+
+static void walReleaseFlusher(SWalFlusher *pFlusher) {
+  pthread_mutex_lock(&walFlusherMutex);
+
+  if (--pFlusher->refCount > 0) {
+    pthread_mutex_unlock(&walFlusherMutex);
+    return;
+  }
+
+  SWalFlusher **pp = &walFlushers;
+  while (*pp != pFlusher) pp = &(*pp)->next;
+  *pp = pFlusher->next;
+
+  pthread_mutex_unlock(&walFlusherMutex);
+
+  pthread_mutex_lock(&pFlusher->mutex);
+  pFlusher->stop = 1;
+  pthread_cond_signal(&pFlusher->reqCond);
+  pthread_mutex_unlock(&pFlusher->mutex);
+
+  pthread_join(pFlusher->thread, NULL);
+
+  wDebug("wal flusher is released for device:%" PRIu64, (uint64_t)pFlusher->dev);
+  pthread_cond_destroy(&pFlusher->reqCond);
+  pthread_cond_destroy(&pFlusher->doneCond);
+  pthread_mutex_destroy(&pFlusher->mutex);
+  free(pFlusher->pending);
+  free(pFlusher);
+}
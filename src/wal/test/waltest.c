@@ -84,6 +84,7 @@ int main(int argc, char *argv[]) {
   walCfg.walLevel = level;
   walCfg.wals = max;
   walCfg.keep = keep;
+  walCfg.groupCommit = 0;
 
   pWal = walOpen(path, &walCfg);
   if (pWal == NULL) {
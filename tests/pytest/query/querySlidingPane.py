@@ -0,0 +1,113 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import sys
+import taos
+from util.log import *
+from util.cases import *
+from util.sql import *
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.rowNum = 3000
+
+    def insertData(self, table, seed):
+        # the rows are 1s apart, with gaps longer than a window, and some null values
+        values = []
+        ts = self.ts
+        for i in range(self.rowNum):
+            ts += 1000 if (i + seed) % 211 != 0 else 95000
+            c1 = "null" if (i + seed) % 53 == 0 else str((i * 7 + seed) % 101 - 50)
+            values.append("(%d, %s, %f)" % (ts, c1, ((i + seed) % 37) * 0.25))
+            if len(values) == 200:
+                tdSql.execute("insert into %s values %s" % (table, " ".join(values)))
+                values = []
+
+        if len(values) > 0:
+            tdSql.execute("insert into %s values %s" % (table, " ".join(values)))
+
+    def queryResult(self, sql):
+        tdSql.query(sql)
+        return tdSql.queryResult
+
+    def checkSame(self, sql, result, expect, cols):
+        if len(result) != len(expect):
+            tdLog.exit("sql:%s, rows:%d != expect:%d" % (sql, len(result), len(expect)))
+
+        for i in range(len(result)):
+            for j in range(cols):
+                a, b = result[i][j], expect[i][j]
+                if isinstance(a, float) and isinstance(b, float):
+                    same = abs(a - b) <= 0.000001 * max(1.0, abs(b))
+                else:
+                    same = (a == b)
+
+                if not same:
+                    tdLog.exit("sql:%s, row:%d col:%d data:%s != expect:%s" % (sql, i, j, a, b))
+
+        tdLog.info("sql:%s, %d rows are the same as the expected ones" % (sql, len(result)))
+
+    def checkPaneQuery(self, table, interval, sliding, where):
+        funcs = "count(*), sum(c1), min(c1), max(c1), avg(c2), spread(c2)"
+        sql = "select %s from %s %s interval(%s) sliding(%s)" % (funcs, table, where, interval, sliding)
+
+        # first() is not merged by panes, so the query with it is evaluated window by window
+        result = self.queryResult(sql)
+        expect = self.queryResult("select %s, first(c1) from %s %s interval(%s) sliding(%s)" %
+                                  (funcs, table, where, interval, sliding))
+        if len(result) == 0:
+            tdLog.exit("sql:%s, no result" % sql)
+
+        self.checkSame(sql, result, expect, 7)
+
+    def checkPaneStddev(self, table, interval, sliding):
+        sql = "select stddev(c1) from %s interval(%ds) sliding(%ds)" % (table, interval, sliding)
+        result = self.queryResult(sql)
+
+        # the stddev of each window is checked against the aggregation of the rows in the window
+        for i in range(0, len(result), 17):
+            skey = int(result[i][0].timestamp() * 1000)
+            expect = self.queryResult("select stddev(c1) from %s where ts >= %d and ts < %d" %
+                                      (table, skey, skey + interval * 1000))
+            self.checkSame(sql, [[result[i][1]]], [[expect[0][0]]], 1)
+
+    def run(self):
+        tdSql.prepare()
+
+        tdSql.execute("create table st (ts timestamp, c1 int, c2 double) tags(t1 int)")
+        tdSql.execute("create table t1 using st tags(1)")
+        tdSql.execute("create table t2 using st tags(2)")
+        self.insertData("t1", 0)
+        self.insertData("t2", 5)
+
+        for table in ["t1", "st"]:
+            self.checkPaneQuery(table, "60s", "10s", "")
+            self.checkPaneQuery(table, "20s", "4s", "")
+            self.checkPaneQuery(table, "30s", "15s", "where c1 > 20")
+            self.checkPaneQuery(table, "1m", "5s", "where ts >= %d and ts < %d" % (self.ts + 500000, self.ts + 1800000))
+
+        self.checkPaneStddev("t1", 60, 10)
+        self.checkPaneStddev("t2", 20, 5)
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())